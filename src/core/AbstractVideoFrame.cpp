@@ -23,7 +23,8 @@
 
 VlcAbstractVideoFrame::VlcAbstractVideoFrame(int planeCount)
     : width(0),
-      height(0)
+      height(0),
+      timing()
 {
     planes.resize(planeCount);
     planeSizes.resize(planeCount);
@@ -54,8 +55,8 @@ void VlcAbstractVideoFrame::setPitchesAndLines(unsigned *pitches,
     for (size_t i = 0; i < planes.size(); i++) {
         if (i > 0)
             planes[i] = planes[i - 1] + planeSizes[i - 1];
-        else
-            planes[0] = frameBuffer.data();
+        else // constData() does not detach external raw data
+            planes[0] = const_cast<char *>(frameBuffer.constData());
 
         planeSizes[i] = pitches[i] * lines[i];
     }
@@ -67,7 +68,7 @@ void VlcAbstractVideoFrame::setPitchesAndLines(const std::shared_ptr<VlcAbstract
         if (i > 0)
             planes[i] = planes[i - 1] + planeSizes[i - 1];
         else
-            planes[0] = frameBuffer.data();
+            planes[0] = const_cast<char *>(frameBuffer.constData());
 
         planeSizes[i] = frame->planeSizes[i];
     }
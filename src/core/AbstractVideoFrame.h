@@ -28,6 +28,7 @@
 #include <QtCore/QByteArray>
 
 #include "Enums.h"
+#include "FrameTiming.h"
 #include "SharedExportCore.h"
 
 /*!
@@ -76,6 +77,8 @@ struct VLCQT_CORE_EXPORT VlcAbstractVideoFrame {
 
     std::vector<char *> planes;      /*!< planes */
     std::vector<quint32> planeSizes; /*!< plane sizes */
+
+    VlcFrameTiming timing; /*!< pipeline timestamps, since VLC-Qt 1.2 */
 };
 
 #endif // VLCQT_ABSTRACTVIDEOFRAME_H_
@@ -0,0 +1,565 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VLCQT_COLORCONVERTER_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VLCQT_COLORCONVERTER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define VLCQT_COLORCONVERTER_NEON
+#include <arm_neon.h>
+#endif
+
+#include "core/ColorConverter.h"
+
+namespace {
+
+typedef VlcColorConverter::Coefficients Coefficients;
+
+// Converts one row of pixels. Subsampled kernels read one chroma sample
+// per two luma samples (4:2:0 row), the others one chroma sample per pixel.
+typedef void (*RowFunction)(const quint8 *y,
+                            const quint8 *u,
+                            const quint8 *v,
+                            quint8 *dst,
+                            unsigned width,
+                            const Coefficients &c);
+
+struct Kernel {
+    RowFunction subsampled;
+    RowFunction full;
+};
+
+inline int saturate16(int value)
+{
+    return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+}
+
+inline quint8 descale(int value)
+{
+    value >>= 6;
+    return value < 0 ? 0 : (value > 255 ? 255 : quint8(value));
+}
+
+// Mirrors the SIMD kernels exactly: 16-bit products, saturating
+// accumulation, truncating shift and unsigned saturation.
+inline void convertPixel(int y,
+                         int u,
+                         int v,
+                         quint8 *dst,
+                         const Coefficients &c)
+{
+    y = (y - c.yOffset) * c.yScale + 32;
+    u -= 128;
+    v -= 128;
+
+    dst[0] = descale(saturate16(y + c.ub * u));
+    dst[1] = descale(saturate16(y - (c.ug * u + c.vg * v)));
+    dst[2] = descale(saturate16(y + c.vr * v));
+    dst[3] = 0xff;
+}
+
+template <bool Subsampled>
+void convertRowScalarFrom(const quint8 *y,
+                          const quint8 *u,
+                          const quint8 *v,
+                          quint8 *dst,
+                          unsigned from,
+                          unsigned width,
+                          const Coefficients &c)
+{
+    for (unsigned x = from; x < width; ++x) {
+        const unsigned chroma = Subsampled ? x / 2 : x;
+        convertPixel(y[x], u[chroma], v[chroma], dst + 4 * x, c);
+    }
+}
+
+template <bool Subsampled>
+void convertRowScalar(const quint8 *y,
+                      const quint8 *u,
+                      const quint8 *v,
+                      quint8 *dst,
+                      unsigned width,
+                      const Coefficients &c)
+{
+    convertRowScalarFrom<Subsampled>(y, u, v, dst, 0, width, c);
+}
+
+#ifdef VLCQT_COLORCONVERTER_SSE2
+struct Sse2Coefficients {
+    explicit Sse2Coefficients(const Coefficients &c)
+        : yOffset(_mm_set1_epi16(c.yOffset)),
+          yScale(_mm_set1_epi16(c.yScale)),
+          vr(_mm_set1_epi16(c.vr)),
+          ug(_mm_set1_epi16(c.ug)),
+          vg(_mm_set1_epi16(c.vg)),
+          ub(_mm_set1_epi16(c.ub)),
+          round(_mm_set1_epi16(32)),
+          bias(_mm_set1_epi16(128)) {}
+
+    __m128i yOffset;
+    __m128i yScale;
+    __m128i vr;
+    __m128i ug;
+    __m128i vg;
+    __m128i ub;
+    __m128i round;
+    __m128i bias;
+};
+
+inline void yuvToRgbSse2(__m128i y,
+                         __m128i u,
+                         __m128i v,
+                         const Sse2Coefficients &k,
+                         __m128i &b,
+                         __m128i &g,
+                         __m128i &r)
+{
+    y = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, k.yOffset), k.yScale), k.round);
+    u = _mm_sub_epi16(u, k.bias);
+    v = _mm_sub_epi16(v, k.bias);
+
+    b = _mm_srai_epi16(_mm_adds_epi16(y, _mm_mullo_epi16(u, k.ub)), 6);
+    g = _mm_srai_epi16(_mm_subs_epi16(y, _mm_add_epi16(_mm_mullo_epi16(u, k.ug), _mm_mullo_epi16(v, k.vg))), 6);
+    r = _mm_srai_epi16(_mm_adds_epi16(y, _mm_mullo_epi16(v, k.vr)), 6);
+}
+
+// Interleaves 16 pixels worth of B, G, R and A bytes into BGRA
+inline void storeBgraSse2(__m128i b,
+                          __m128i g,
+                          __m128i r,
+                          __m128i a,
+                          quint8 *dst)
+{
+    const __m128i bgLow = _mm_unpacklo_epi8(b, g);
+    const __m128i bgHigh = _mm_unpackhi_epi8(b, g);
+    const __m128i raLow = _mm_unpacklo_epi8(r, a);
+    const __m128i raHigh = _mm_unpackhi_epi8(r, a);
+
+    __m128i *out = reinterpret_cast<__m128i *>(dst);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(bgLow, raLow));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLow, raLow));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHigh, raHigh));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHigh, raHigh));
+}
+
+template <bool Subsampled>
+inline void loadChromaSse2(const quint8 *u,
+                           const quint8 *v,
+                           unsigned x,
+                           __m128i &u8,
+                           __m128i &v8)
+{
+    if (Subsampled) {
+        u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + x / 2));
+        v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + x / 2));
+        u8 = _mm_unpacklo_epi8(u8, u8);
+        v8 = _mm_unpacklo_epi8(v8, v8);
+    } else {
+        u8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x));
+        v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x));
+    }
+}
+
+template <bool Subsampled>
+void convertRowSse2(const quint8 *y,
+                    const quint8 *u,
+                    const quint8 *v,
+                    quint8 *dst,
+                    unsigned width,
+                    const Coefficients &c)
+{
+    const Sse2Coefficients k(c);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    unsigned x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+        __m128i u8, v8;
+        loadChromaSse2<Subsampled>(u, v, x, u8, v8);
+
+        __m128i bLow, gLow, rLow, bHigh, gHigh, rHigh;
+        yuvToRgbSse2(_mm_unpacklo_epi8(y8, zero), _mm_unpacklo_epi8(u8, zero), _mm_unpacklo_epi8(v8, zero),
+                     k, bLow, gLow, rLow);
+        yuvToRgbSse2(_mm_unpackhi_epi8(y8, zero), _mm_unpackhi_epi8(u8, zero), _mm_unpackhi_epi8(v8, zero),
+                     k, bHigh, gHigh, rHigh);
+
+        storeBgraSse2(_mm_packus_epi16(bLow, bHigh),
+                      _mm_packus_epi16(gLow, gHigh),
+                      _mm_packus_epi16(rLow, rHigh),
+                      alpha, dst + 4 * x);
+    }
+
+    convertRowScalarFrom<Subsampled>(y, u, v, dst, x, width, c);
+}
+#endif // VLCQT_COLORCONVERTER_SSE2
+
+#ifdef VLCQT_COLORCONVERTER_AVX2
+// Arithmetic is done on 16 pixels at once in 256-bit registers,
+// byte interleaving reuses the SSE2 store.
+template <bool Subsampled>
+__attribute__((target("avx2"))) void convertRowAvx2(const quint8 *y,
+                                                    const quint8 *u,
+                                                    const quint8 *v,
+                                                    quint8 *dst,
+                                                    unsigned width,
+                                                    const Coefficients &c)
+{
+    const __m256i yOffset = _mm256_set1_epi16(c.yOffset);
+    const __m256i yScale = _mm256_set1_epi16(c.yScale);
+    const __m256i vr = _mm256_set1_epi16(c.vr);
+    const __m256i ug = _mm256_set1_epi16(c.ug);
+    const __m256i vg = _mm256_set1_epi16(c.vg);
+    const __m256i ub = _mm256_set1_epi16(c.ub);
+    const __m256i round = _mm256_set1_epi16(32);
+    const __m256i bias = _mm256_set1_epi16(128);
+    const __m256i alpha = _mm256_set1_epi16(255);
+
+    unsigned x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i u8, v8;
+        loadChromaSse2<Subsampled>(u, v, x, u8, v8);
+
+        __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x)));
+        const __m256i uu = _mm256_sub_epi16(_mm256_cvtepu8_epi16(u8), bias);
+        const __m256i vv = _mm256_sub_epi16(_mm256_cvtepu8_epi16(v8), bias);
+        yy = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(yy, yOffset), yScale), round);
+
+        const __m256i b = _mm256_srai_epi16(_mm256_adds_epi16(yy, _mm256_mullo_epi16(uu, ub)), 6);
+        const __m256i g = _mm256_srai_epi16(_mm256_subs_epi16(yy, _mm256_add_epi16(_mm256_mullo_epi16(uu, ug), _mm256_mullo_epi16(vv, vg))), 6);
+        const __m256i r = _mm256_srai_epi16(_mm256_adds_epi16(yy, _mm256_mullo_epi16(vv, vr)), 6);
+
+        // packus works per 128-bit lane, restore pixel order afterwards
+        const __m256i bg = _mm256_permute4x64_epi64(_mm256_packus_epi16(b, g), 0xd8);
+        const __m256i ra = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, alpha), 0xd8);
+
+        storeBgraSse2(_mm256_castsi256_si128(bg), _mm256_extracti128_si256(bg, 1),
+                      _mm256_castsi256_si128(ra), _mm256_extracti128_si256(ra, 1),
+                      dst + 4 * x);
+    }
+
+    convertRowScalarFrom<Subsampled>(y, u, v, dst, x, width, c);
+}
+
+bool cpuSupportsAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif // VLCQT_COLORCONVERTER_AVX2
+
+#ifdef VLCQT_COLORCONVERTER_NEON
+struct NeonCoefficients {
+    explicit NeonCoefficients(const Coefficients &c)
+        : yOffset(vdupq_n_s16(c.yOffset)),
+          yScale(vdupq_n_s16(c.yScale)),
+          vr(vdupq_n_s16(c.vr)),
+          ug(vdupq_n_s16(c.ug)),
+          vg(vdupq_n_s16(c.vg)),
+          ub(vdupq_n_s16(c.ub)),
+          round(vdupq_n_s16(32)),
+          bias(vdupq_n_s16(128)) {}
+
+    int16x8_t yOffset;
+    int16x8_t yScale;
+    int16x8_t vr;
+    int16x8_t ug;
+    int16x8_t vg;
+    int16x8_t ub;
+    int16x8_t round;
+    int16x8_t bias;
+};
+
+inline void yuvToRgbNeon(uint8x8_t y8,
+                         uint8x8_t u8,
+                         uint8x8_t v8,
+                         const NeonCoefficients &k,
+                         uint8x8x4_t &pixels)
+{
+    int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(y8));
+    const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), k.bias);
+    const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), k.bias);
+    y = vaddq_s16(vmulq_s16(vsubq_s16(y, k.yOffset), k.yScale), k.round);
+
+    // vqshrun is a truncating shift with unsigned saturation, same as srai + packus
+    pixels.val[0] = vqshrun_n_s16(vqaddq_s16(y, vmulq_s16(u, k.ub)), 6);
+    pixels.val[1] = vqshrun_n_s16(vqsubq_s16(y, vaddq_s16(vmulq_s16(u, k.ug), vmulq_s16(v, k.vg))), 6);
+    pixels.val[2] = vqshrun_n_s16(vqaddq_s16(y, vmulq_s16(v, k.vr)), 6);
+}
+
+template <bool Subsampled>
+void convertRowNeon(const quint8 *y,
+                    const quint8 *u,
+                    const quint8 *v,
+                    quint8 *dst,
+                    unsigned width,
+                    const Coefficients &c)
+{
+    const NeonCoefficients k(c);
+
+    uint8x8x4_t pixels;
+    pixels.val[3] = vdup_n_u8(0xff);
+
+    unsigned x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t y8 = vld1q_u8(y + x);
+        uint8x8_t uLow, uHigh, vLow, vHigh;
+        if (Subsampled) {
+            const uint8x8_t u8 = vld1_u8(u + x / 2);
+            const uint8x8_t v8 = vld1_u8(v + x / 2);
+            const uint8x8x2_t uu = vzip_u8(u8, u8);
+            const uint8x8x2_t vv = vzip_u8(v8, v8);
+            uLow = uu.val[0];
+            uHigh = uu.val[1];
+            vLow = vv.val[0];
+            vHigh = vv.val[1];
+        } else {
+            const uint8x16_t u8 = vld1q_u8(u + x);
+            const uint8x16_t v8 = vld1q_u8(v + x);
+            uLow = vget_low_u8(u8);
+            uHigh = vget_high_u8(u8);
+            vLow = vget_low_u8(v8);
+            vHigh = vget_high_u8(v8);
+        }
+
+        yuvToRgbNeon(vget_low_u8(y8), uLow, vLow, k, pixels);
+        vst4_u8(dst + 4 * x, pixels);
+        yuvToRgbNeon(vget_high_u8(y8), uHigh, vHigh, k, pixels);
+        vst4_u8(dst + 4 * x + 32, pixels);
+    }
+
+    convertRowScalarFrom<Subsampled>(y, u, v, dst, x, width, c);
+}
+#endif // VLCQT_COLORCONVERTER_NEON
+
+Kernel kernel(VlcColorConverter::Implementation implementation)
+{
+    Kernel k;
+    switch (implementation) {
+#ifdef VLCQT_COLORCONVERTER_NEON
+    case VlcColorConverter::NEON:
+        k.subsampled = &convertRowNeon<true>;
+        k.full = &convertRowNeon<false>;
+        return k;
+#endif
+#ifdef VLCQT_COLORCONVERTER_AVX2
+    case VlcColorConverter::AVX2:
+        k.subsampled = &convertRowAvx2<true>;
+        k.full = &convertRowAvx2<false>;
+        return k;
+#endif
+#ifdef VLCQT_COLORCONVERTER_SSE2
+    case VlcColorConverter::SSE2:
+        k.subsampled = &convertRowSse2<true>;
+        k.full = &convertRowSse2<false>;
+        return k;
+#endif
+    default:
+        k.subsampled = &convertRowScalar<true>;
+        k.full = &convertRowScalar<false>;
+        return k;
+    }
+}
+
+qint16 fixedPoint(double value)
+{
+    return qint16(std::floor(value * 64.0 + 0.5));
+}
+
+// Nearest sample centre for destination index
+inline unsigned sourceIndex(unsigned index,
+                            unsigned size,
+                            unsigned dstSize)
+{
+    return unsigned(((2 * quint64(index) + 1) * size) / (2 * quint64(dstSize)));
+}
+
+} // namespace
+
+VlcColorConverter::VlcColorConverter(ColorMatrix matrix,
+                                     ColorRange range,
+                                     Implementation implementation)
+    : _matrix(matrix),
+      _range(range),
+      _implementation(implementation),
+      _columnsWidth(0),
+      _columnsDstWidth(0)
+{
+    if (_implementation == Auto || !isSupported(_implementation))
+        _implementation = bestImplementation();
+
+    updateCoefficients();
+}
+
+void VlcColorConverter::setMatrix(ColorMatrix matrix)
+{
+    _matrix = matrix;
+    updateCoefficients();
+}
+
+void VlcColorConverter::setRange(ColorRange range)
+{
+    _range = range;
+    updateCoefficients();
+}
+
+bool VlcColorConverter::isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Auto:
+    case Scalar:
+        return true;
+#ifdef VLCQT_COLORCONVERTER_SSE2
+    case SSE2:
+        return true;
+#endif
+#ifdef VLCQT_COLORCONVERTER_AVX2
+    case AVX2:
+        return cpuSupportsAvx2();
+#endif
+#ifdef VLCQT_COLORCONVERTER_NEON
+    case NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+VlcColorConverter::Implementation VlcColorConverter::bestImplementation()
+{
+    if (isSupported(NEON))
+        return NEON;
+    if (isSupported(AVX2))
+        return AVX2;
+    if (isSupported(SSE2))
+        return SSE2;
+    return Scalar;
+}
+
+void VlcColorConverter::convertI420ToBGRA(const quint8 *y,
+                                          const quint8 *u,
+                                          const quint8 *v,
+                                          unsigned pitchY,
+                                          unsigned pitchUV,
+                                          unsigned width,
+                                          unsigned height,
+                                          quint8 *dst,
+                                          unsigned dstPitch,
+                                          unsigned dstWidth,
+                                          unsigned dstHeight)
+{
+    if (!width || !height || !dstWidth || !dstHeight)
+        return;
+
+    const Kernel k = kernel(_implementation);
+    const bool scaleColumns = width != dstWidth;
+    if (scaleColumns)
+        updateColumns(width, dstWidth);
+
+    unsigned previousRow = height;
+    for (unsigned row = 0; row < dstHeight; ++row) {
+        quint8 *out = dst + size_t(row) * dstPitch;
+        const unsigned srcRow = sourceIndex(row, height, dstHeight);
+        if (srcRow == previousRow) {
+            // Upscaling repeats rows, copy the one already converted
+            memcpy(out, out - dstPitch, size_t(dstWidth) * 4);
+            continue;
+        }
+        previousRow = srcRow;
+
+        const quint8 *rowY = y + size_t(srcRow) * pitchY;
+        const quint8 *rowU = u + size_t(srcRow / 2) * pitchUV;
+        const quint8 *rowV = v + size_t(srcRow / 2) * pitchUV;
+
+        if (!scaleColumns) {
+            k.subsampled(rowY, rowU, rowV, out, dstWidth, _coefficients);
+            continue;
+        }
+
+        quint8 *cacheY = &_rowCache[0];
+        quint8 *cacheU = cacheY + dstWidth;
+        quint8 *cacheV = cacheU + dstWidth;
+        for (unsigned x = 0; x < dstWidth; ++x) {
+            cacheY[x] = rowY[_columns[x]];
+            cacheU[x] = rowU[_chromaColumns[x]];
+            cacheV[x] = rowV[_chromaColumns[x]];
+        }
+        k.full(cacheY, cacheU, cacheV, out, dstWidth, _coefficients);
+    }
+}
+
+void VlcColorConverter::convertYV12ToBGRA(const quint8 *y,
+                                          const quint8 *v,
+                                          const quint8 *u,
+                                          unsigned pitchY,
+                                          unsigned pitchUV,
+                                          unsigned width,
+                                          unsigned height,
+                                          quint8 *dst,
+                                          unsigned dstPitch,
+                                          unsigned dstWidth,
+                                          unsigned dstHeight)
+{
+    convertI420ToBGRA(y, u, v, pitchY, pitchUV, width, height,
+                      dst, dstPitch, dstWidth, dstHeight);
+}
+
+void VlcColorConverter::updateCoefficients()
+{
+    const double kr = _matrix == BT709 ? 0.2126 : 0.299;
+    const double kb = _matrix == BT709 ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    const bool limited = _range == LimitedRange;
+    const double yScale = limited ? 255.0 / 219.0 : 1.0;
+    const double cScale = limited ? 255.0 / 224.0 : 1.0;
+
+    _coefficients.yOffset = limited ? 16 : 0;
+    _coefficients.yScale = fixedPoint(yScale);
+    _coefficients.vr = fixedPoint(2.0 * (1.0 - kr) * cScale);
+    _coefficients.ug = fixedPoint(2.0 * (1.0 - kb) * kb / kg * cScale);
+    _coefficients.vg = fixedPoint(2.0 * (1.0 - kr) * kr / kg * cScale);
+    _coefficients.ub = fixedPoint(2.0 * (1.0 - kb) * cScale);
+}
+
+void VlcColorConverter::updateColumns(unsigned width,
+                                      unsigned dstWidth)
+{
+    if (width == _columnsWidth && dstWidth == _columnsDstWidth)
+        return;
+
+    _columns.resize(dstWidth);
+    _chromaColumns.resize(dstWidth);
+    for (unsigned x = 0; x < dstWidth; ++x) {
+        _columns[x] = sourceIndex(x, width, dstWidth);
+        _chromaColumns[x] = _columns[x] / 2;
+    }
+    _rowCache.resize(size_t(dstWidth) * 3);
+
+    _columnsWidth = width;
+    _columnsDstWidth = dstWidth;
+}
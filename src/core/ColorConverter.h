@@ -0,0 +1,215 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_COLORCONVERTER_H_
+#define VLCQT_COLORCONVERTER_H_
+
+#include <vector>
+
+#include "SharedExportCore.h"
+
+/*!
+    \class VlcColorConverter ColorConverter.h VLCQtCore/ColorConverter.h
+    \ingroup VLCQtCore
+    \brief Planar YUV to BGRA converter
+
+    VlcColorConverter converts planar 4:2:0 frames (I420 and YV12) to
+    32-bit BGRA, optionally scaling them with nearest neighbour sampling
+    in the same pass. Scalar, SSE2, AVX2 and NEON kernels are available;
+    all of them produce bit-identical output.
+
+    A converter caches its scaling tables between calls and is therefore
+    not safe to use from several threads at once.
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcColorConverter
+{
+public:
+    /*!
+        \enum ColorMatrix
+        \brief YUV to RGB colour matrix
+     */
+    enum ColorMatrix {
+        BT601,
+        BT709
+    };
+
+    /*!
+        \enum ColorRange
+        \brief YUV quantisation range
+     */
+    enum ColorRange {
+        LimitedRange,
+        FullRange
+    };
+
+    /*!
+        \enum Implementation
+        \brief Conversion kernel implementation
+     */
+    enum Implementation {
+        Auto,
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    /*!
+        \brief VlcColorConverter constructor
+        \param matrix colour matrix
+        \param range quantisation range
+        \param implementation conversion kernel, Auto selects the fastest supported one
+     */
+    explicit VlcColorConverter(ColorMatrix matrix = BT601,
+                               ColorRange range = LimitedRange,
+                               Implementation implementation = Auto);
+
+    /*!
+        \brief Get colour matrix
+        \return current colour matrix
+     */
+    ColorMatrix matrix() const { return _matrix; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Set colour matrix
+        \param matrix new colour matrix
+     */
+    void setMatrix(ColorMatrix matrix);
+
+    /*!
+        \brief Get quantisation range
+        \return current quantisation range
+     */
+    ColorRange range() const { return _range; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Set quantisation range
+        \param range new quantisation range
+     */
+    void setRange(ColorRange range);
+
+    /*!
+        \brief Get conversion kernel
+        \return kernel in use, never Auto
+     */
+    Implementation implementation() const { return _implementation; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Check if kernel can be used on this build and CPU
+        \param implementation kernel to check
+        \return true if supported
+     */
+    static bool isSupported(Implementation implementation);
+
+    /*!
+        \brief Get fastest kernel supported on this build and CPU
+        \return best implementation
+     */
+    static Implementation bestImplementation();
+
+    /*!
+        \brief Convert I420 frame to BGRA
+
+        Source is scaled to destination size with nearest neighbour sampling
+        when sizes differ.
+
+        \param y luma plane
+        \param u Cb plane
+        \param v Cr plane
+        \param pitchY luma plane pitch in bytes
+        \param pitchUV chroma planes pitch in bytes
+        \param width source width
+        \param height source height
+        \param dst destination pixels
+        \param dstPitch destination pitch in bytes
+        \param dstWidth destination width
+        \param dstHeight destination height
+     */
+    void convertI420ToBGRA(const quint8 *y,
+                           const quint8 *u,
+                           const quint8 *v,
+                           unsigned pitchY,
+                           unsigned pitchUV,
+                           unsigned width,
+                           unsigned height,
+                           quint8 *dst,
+                           unsigned dstPitch,
+                           unsigned dstWidth,
+                           unsigned dstHeight);
+
+    /*!
+        \brief Convert YV12 frame to BGRA
+
+        Same as convertI420ToBGRA with chroma planes in YV12 order.
+
+        \param y luma plane
+        \param v Cr plane
+        \param u Cb plane
+        \param pitchY luma plane pitch in bytes
+        \param pitchUV chroma planes pitch in bytes
+        \param width source width
+        \param height source height
+        \param dst destination pixels
+        \param dstPitch destination pitch in bytes
+        \param dstWidth destination width
+        \param dstHeight destination height
+     */
+    void convertYV12ToBGRA(const quint8 *y,
+                           const quint8 *v,
+                           const quint8 *u,
+                           unsigned pitchY,
+                           unsigned pitchUV,
+                           unsigned width,
+                           unsigned height,
+                           quint8 *dst,
+                           unsigned dstPitch,
+                           unsigned dstWidth,
+                           unsigned dstHeight);
+
+    /*!
+        \brief Fixed point conversion coefficients (6 fractional bits)
+     */
+    struct Coefficients {
+        qint16 yOffset;
+        qint16 yScale;
+        qint16 vr;
+        qint16 ug;
+        qint16 vg;
+        qint16 ub;
+    };
+
+private:
+    void updateCoefficients();
+    void updateColumns(unsigned width,
+                       unsigned dstWidth);
+
+    ColorMatrix _matrix;
+    ColorRange _range;
+    Implementation _implementation;
+    Coefficients _coefficients;
+
+    unsigned _columnsWidth;
+    unsigned _columnsDstWidth;
+    std::vector<unsigned> _columns;
+    std::vector<unsigned> _chromaColumns;
+    std::vector<quint8> _rowCache;
+};
+
+#endif // VLCQT_COLORCONVERTER_H_
@@ -41,6 +41,17 @@ QStringList VlcCommon::args()
     return args_list;
 }
 
+QStringList VlcCommon::statsArgs()
+{
+    QStringList args_list = args();
+    args_list.removeAll("--no-stats");
+
+    // Also after VLC_ARGS, the last occurrence wins
+    args_list << "--stats";
+
+    return args_list;
+}
+
 bool VlcCommon::setPluginPath(const QString &path)
 {
     if (qgetenv("VLC_PLUGIN_PATH").isEmpty()) {
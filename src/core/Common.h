@@ -42,6 +42,17 @@ namespace VlcCommon
 	*/
     VLCQT_CORE_EXPORT QStringList args();
 
+    /*!
+        \brief Common libvlc arguments with statistics enabled
+
+        libVLC reads the stats setting once when the instance is created,
+        instances sampled by VlcStatsMonitor need these arguments.
+
+        \return libvlc arguments (QStringList)
+        \since VLC-Qt 1.2
+    */
+    VLCQT_CORE_EXPORT QStringList statsArgs();
+
     /*!
         \brief Set plugin path
         \param path plugin path (QString)
@@ -77,10 +77,16 @@ public:
     /*!
         \enum RenderFormat
         \brief Frame format used for custom rendering
+
+        NV12Format, RV32Format and UYVYFormat since VLC-Qt 1.2.
+
         \since VLC-Qt 1.1
     */
     enum RenderFormat {
-        YUVFormat
+        YUVFormat,  /*!< planar I420, VlcYUVVideoFrame */
+        NV12Format, /*!< semi-planar NV12, VlcNV12VideoFrame */
+        RV32Format, /*!< packed 32-bit BGRA, VlcRV32VideoFrame */
+        UYVYFormat  /*!< packed 4:2:2 UYVY, VlcUYVYVideoFrame */
     };
 
     /*!
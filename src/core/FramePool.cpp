@@ -0,0 +1,135 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "core/FramePool.h"
+
+// Slabs start on a page boundary
+static const size_t SlabAlignment = 4096;
+
+VlcFramePool::VlcFramePool()
+    : _size(0),
+      _stride(0),
+      _slabCount(0)
+{
+    _stats.hits = 0;
+    _stats.growths = 0;
+    _stats.peak = 0;
+    _stats.capacity = 0;
+}
+
+VlcFramePool::~VlcFramePool()
+{
+    clear();
+}
+
+bool VlcFramePool::reserve(size_t size,
+                           int count)
+{
+    QMutexLocker locker(&_mutex);
+
+    const bool reuse = size == _size && !_buffers.empty();
+    if (!reuse) {
+        // Buffers still in use would be freed under their owners
+        Q_ASSERT(_free.size() == _buffers.size());
+        if (_free.size() != _buffers.size())
+            return false;
+
+        clear();
+        _size = size;
+        _stride = (size + Alignment - 1) & ~size_t(Alignment - 1);
+    }
+
+    _slabCount = qMax(count, 1);
+    if (int(_buffers.size()) < count)
+        grow(count - int(_buffers.size()));
+
+    return reuse;
+}
+
+int VlcFramePool::acquire()
+{
+    QMutexLocker locker(&_mutex);
+
+    if (!_stride)
+        return -1;
+
+    if (_free.empty()) {
+        grow(_slabCount);
+        _stats.growths++;
+    } else {
+        _stats.hits++;
+    }
+
+    const int index = _free.back();
+    _free.pop_back();
+
+    _stats.peak = qMax(_stats.peak, int(_buffers.size() - _free.size()));
+
+    return index;
+}
+
+void VlcFramePool::release(int index)
+{
+    QMutexLocker locker(&_mutex);
+
+    if (index < 0 || index >= int(_buffers.size()))
+        return; // LCOV_EXCL_LINE
+
+    _free.push_back(index);
+}
+
+int VlcFramePool::capacity() const
+{
+    QMutexLocker locker(&_mutex);
+    return int(_buffers.size());
+}
+
+VlcFramePool::Stats VlcFramePool::stats() const
+{
+    QMutexLocker locker(&_mutex);
+    return _stats;
+}
+
+void VlcFramePool::grow(int count)
+{
+    char *slab = static_cast<char *>(qMallocAligned(_stride * count, SlabAlignment));
+    Q_CHECK_PTR(slab);
+    _slabs.push_back(slab);
+
+    // Lowest index on top of the stack, so buffers are used in order
+    const int first = int(_buffers.size());
+    _buffers.reserve(first + count);
+    _free.reserve(first + count);
+    for (int i = 0; i < count; ++i)
+        _buffers.push_back(slab + i * _stride);
+    for (int i = count - 1; i >= 0; --i)
+        _free.push_back(first + i);
+
+    _stats.capacity = int(_buffers.size());
+}
+
+void VlcFramePool::clear()
+{
+    for (size_t i = 0; i < _slabs.size(); ++i)
+        qFreeAligned(_slabs[i]);
+
+    _slabs.clear();
+    _buffers.clear();
+    _free.clear();
+    _stats.capacity = 0;
+}
@@ -0,0 +1,136 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_FRAMEPOOL_H_
+#define VLCQT_FRAMEPOOL_H_
+
+#include <vector>
+
+#include <QtCore/QMutex>
+
+#include "SharedExportCore.h"
+
+/*!
+    \class VlcFramePool FramePool.h VLCQtCore/FramePool.h
+    \ingroup VLCQtCore
+    \brief Aligned frame buffer pool
+
+    VlcFramePool preallocates frame buffers of one size in slabs. Every
+    slab starts on a page boundary and every buffer on a 64-byte boundary,
+    so SIMD converters and the GPU driver get aligned rows. Free buffers
+    are kept on a stack, acquiring and releasing a buffer is O(1) and
+    never allocates unless the pool is exhausted, in which case it grows
+    by one slab.
+
+    acquire() and release() may be called from different threads.
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcFramePool
+{
+public:
+    /*!
+        \struct Stats
+        \brief Pool statistics for tuning the preallocated count
+     */
+    struct Stats {
+        quint64 hits;    /*!< acquisitions served without allocating */
+        quint64 growths; /*!< slabs allocated because the pool was exhausted */
+        int peak;        /*!< highest number of buffers in use at once */
+        int capacity;    /*!< buffers currently allocated */
+    };
+
+    /*!
+        \brief Buffer alignment in bytes
+     */
+    static const int Alignment = 64;
+
+    /*!
+        \brief VlcFramePool constructor
+     */
+    VlcFramePool();
+    ~VlcFramePool();
+
+    /*!
+        \brief Preallocate buffers
+
+        Buffers are kept when the size does not change, more are allocated
+        if count is higher than the current capacity. A different size
+        is only accepted while no buffer is in use.
+
+        \param size buffer size in bytes
+        \param count number of buffers to preallocate
+        \return true if the existing buffers were reused
+     */
+    bool reserve(size_t size,
+                 int count);
+
+    /*!
+        \brief Get a free buffer
+        \return buffer index, -1 if no size was reserved
+     */
+    int acquire();
+
+    /*!
+        \brief Return a buffer to the pool
+        \param index buffer index from acquire()
+     */
+    void release(int index);
+
+    /*!
+        \brief Get buffer memory
+        \param index buffer index
+        \return aligned buffer of bufferSize() bytes
+     */
+    char *buffer(int index) const { return _buffers[index]; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Get buffer size
+        \return buffer size in bytes
+     */
+    size_t bufferSize() const { return _size; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Get number of allocated buffers
+        \return capacity
+     */
+    int capacity() const;
+
+    /*!
+        \brief Get pool statistics
+        \return statistics since the pool was created
+     */
+    Stats stats() const;
+
+private:
+    void grow(int count);
+    void clear();
+
+    mutable QMutex _mutex;
+
+    size_t _size;
+    size_t _stride;
+    int _slabCount;
+    std::vector<void *> _slabs;
+    std::vector<char *> _buffers;
+    std::vector<int> _free;
+
+    Stats _stats;
+};
+
+#endif // VLCQT_FRAMEPOOL_H_
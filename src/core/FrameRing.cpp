@@ -0,0 +1,78 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "core/FrameRing.h"
+
+VlcFrameRing::VlcFrameRing()
+{
+    reset();
+}
+
+void VlcFrameRing::reset()
+{
+    _write = 0;
+    _shared.storeRelease(1);
+    _read = 2;
+    _hasFrame = false;
+
+    _published.storeRelease(0);
+    _dropped.storeRelease(0);
+}
+
+bool VlcFrameRing::publish()
+{
+    const int previous = _shared.fetchAndStoreAcqRel(_write | NewFrame);
+    _write = previous & SlotMask;
+
+    _published.ref();
+    if (previous & NewFrame) {
+        _dropped.ref();
+        return true;
+    }
+
+    return false;
+}
+
+bool VlcFrameRing::acquire()
+{
+    if (!(_shared.loadAcquire() & NewFrame)) {
+        return false;
+    }
+
+    // Only the producer can change the slot meanwhile, and it always sets NewFrame
+    const int newest = _shared.fetchAndStoreAcqRel(_read);
+    _read = newest & SlotMask;
+    _hasFrame = true;
+
+    return true;
+}
+
+bool VlcFrameRing::hasNewFrame() const
+{
+    return _shared.loadAcquire() & NewFrame;
+}
+
+int VlcFrameRing::published() const
+{
+    return _published.loadAcquire();
+}
+
+int VlcFrameRing::dropped() const
+{
+    return _dropped.loadAcquire();
+}
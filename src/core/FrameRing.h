@@ -0,0 +1,136 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_FRAMERING_H_
+#define VLCQT_FRAMERING_H_
+
+#include <QtCore/QAtomicInt>
+
+#include "SharedExportCore.h"
+
+/*!
+    \class VlcFrameRing FrameRing.h VLCQtCore/FrameRing.h
+    \ingroup VLCQtCore
+    \brief Lock-free single-producer/single-consumer frame ring
+
+    VlcFrameRing hands frames from the libvlc decoder thread to a renderer
+    without a mutex. It only manages slot indices, the caller keeps one
+    buffer per slot.
+
+    The producer always owns writeSlot() and the consumer always owns
+    readSlot(). The third slot holds the newest published frame and is
+    exchanged atomically. Publishing while the previous frame was not yet
+    acquired drops it, so the latest frame wins and neither side ever
+    waits for the other.
+
+    Exactly one thread may call the producer functions and exactly one
+    thread the consumer functions.
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcFrameRing
+{
+public:
+    /*!
+        \brief Number of slots, one buffer is needed for each
+     */
+    static const int Slots = 3;
+
+    /*!
+        \brief VlcFrameRing constructor
+     */
+    VlcFrameRing();
+
+    /*!
+        \brief Forget all published frames and statistics
+
+        Not thread-safe, call only while neither side uses the ring,
+        for example from the libvlc format callbacks.
+     */
+    void reset();
+
+    /*!
+        \brief Slot the producer may fill (producer)
+        \return slot index
+     */
+    int writeSlot() const { return _write; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Publish the filled write slot as the newest frame (producer)
+
+        The producer gets a new write slot, which is either the previously
+        published frame if it was never acquired, or the slot the consumer
+        released.
+
+        \return true if the previous frame was dropped without being acquired
+     */
+    bool publish();
+
+    /*!
+        \brief Switch to the newest published frame (consumer)
+        \return true if readSlot() now holds a frame not seen before
+     */
+    bool acquire();
+
+    /*!
+        \brief Slot the consumer may read (consumer)
+        \return slot index
+     */
+    int readSlot() const { return _read; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Check if the consumer has acquired any frame yet (consumer)
+        \return true if readSlot() holds a frame
+     */
+    bool hasFrame() const { return _hasFrame; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Check if a published frame is waiting (any thread)
+        \return true if acquire() would switch frames
+     */
+    bool hasNewFrame() const;
+
+    /*!
+        \brief Number of published frames since reset (any thread)
+        \return published frames
+     */
+    int published() const;
+
+    /*!
+        \brief Number of frames replaced before they were acquired (any thread)
+        \return dropped frames
+     */
+    int dropped() const;
+
+private:
+    enum {
+        SlotMask = 0x3,
+        NewFrame = 0x4
+    };
+
+    // Newest frame slot, NewFrame set until the consumer takes it
+    QAtomicInt _shared;
+    int _write;
+    int _read;
+    bool _hasFrame;
+
+    QAtomicInt _published;
+    QAtomicInt _dropped;
+};
+
+#endif // VLCQT_FRAMERING_H_
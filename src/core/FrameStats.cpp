@@ -0,0 +1,170 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "core/FrameStats.h"
+
+// Interval of updated() and of the fps measurement
+static const int UpdateIntervalMs = 1000;
+
+VlcFrameStats::VlcFrameStats(QObject *parent)
+    : QObject(parent)
+{
+    _clock.start();
+}
+
+VlcFrameStats::~VlcFrameStats() {}
+
+void VlcFrameStats::frameDelivered(const VlcFrameTiming &timing)
+{
+    _delivered.ref();
+
+    // libVLC may unlock only after display, then display ends decoding
+    const qint64 decoded = timing.unlock ? timing.unlock : timing.display;
+    if (timing.lock && decoded)
+        record(DecodeStage, decoded - timing.lock);
+}
+
+void VlcFrameStats::framePresented(const VlcFrameTiming &timing)
+{
+    _presented.ref();
+
+    if (timing.display && timing.presentStart)
+        record(QueueStage, timing.presentStart - timing.display);
+    if (timing.presentStart && timing.presentEnd)
+        record(PresentStage, timing.presentEnd - timing.presentStart);
+    if (timing.lock && timing.presentEnd)
+        record(TotalStage, timing.presentEnd - timing.lock);
+
+    update();
+}
+
+void VlcFrameStats::frameDropped()
+{
+    _dropped.ref();
+}
+
+int VlcFrameStats::percentile(Stage stage,
+                              int percent) const
+{
+    if (stage < 0 || stage >= StageCount)
+        return 0; // LCOV_EXCL_LINE
+
+    const QAtomicInt *histogram = _histogram[stage];
+
+    qint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i)
+        total += histogram[i].load();
+    if (!total)
+        return 0;
+
+    const qint64 rank = (total * qBound(0, percent, 100) + 99) / 100;
+    qint64 count = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        count += histogram[i].load();
+        if (count >= rank && count)
+            return int(bucketLimit(i));
+    }
+
+    return int(bucketLimit(BucketCount - 1)); // LCOV_EXCL_LINE
+}
+
+int VlcFrameStats::delivered() const
+{
+    return _delivered.load();
+}
+
+int VlcFrameStats::presented() const
+{
+    return _presented.load();
+}
+
+int VlcFrameStats::dropped() const
+{
+    return _dropped.load();
+}
+
+qreal VlcFrameStats::fps() const
+{
+    return _fps.load() / 100.;
+}
+
+void VlcFrameStats::reset()
+{
+    for (int stage = 0; stage < StageCount; ++stage) {
+        for (int i = 0; i < BucketCount; ++i)
+            _histogram[stage][i].store(0);
+    }
+
+    _delivered.store(0);
+    _presented.store(0);
+    _dropped.store(0);
+    _lastUpdate.store(int(_clock.elapsed()));
+    _lastPresented.store(0);
+    _fps.store(0);
+
+    emit updated();
+}
+
+int VlcFrameStats::bucket(qint64 us)
+{
+    if (us < 4)
+        return us > 0 ? int(us) : 0;
+
+    // Four buckets per power of two
+    int msb = 2;
+    while (msb < 62 && (us >> (msb + 1)))
+        ++msb;
+
+    return qMin(BucketCount - 1, 4 * (msb - 1) + int((us >> (msb - 2)) & 3));
+}
+
+qint64 VlcFrameStats::bucketLimit(int bucket)
+{
+    // Lower bound of the next bucket
+    const int next = bucket + 1;
+    if (next < 4)
+        return next;
+
+    const int msb = next / 4 + 1;
+    return qint64(4 + next % 4) << (msb - 2);
+}
+
+void VlcFrameStats::record(Stage stage,
+                           qint64 us)
+{
+    _histogram[stage][bucket(us)].ref();
+}
+
+void VlcFrameStats::update()
+{
+    const int now = int(_clock.elapsed());
+    const int last = _lastUpdate.load();
+    const int elapsed = now - last;
+    if (elapsed < UpdateIntervalMs)
+        return;
+
+    // One thread measures the interval, the others keep going
+    if (!_lastUpdate.testAndSetOrdered(last, now))
+        return;
+
+    const int presented = _presented.load();
+    const int frames = presented - _lastPresented.fetchAndStoreOrdered(presented);
+    _fps.store(int(qint64(frames) * 100000 / elapsed));
+
+    emit updated();
+}
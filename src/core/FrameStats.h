@@ -0,0 +1,174 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_FRAMESTATS_H_
+#define VLCQT_FRAMESTATS_H_
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+
+#include "FrameTiming.h"
+#include "SharedExportCore.h"
+
+/*!
+    \class VlcFrameStats FrameStats.h VLCQtCore/FrameStats.h
+    \ingroup VLCQtCore
+    \brief Video pipeline latency statistics
+
+    Collects VlcFrameTiming of delivered and presented frames into
+    per-stage latency histograms. Recording never allocates or locks and
+    may happen on the decoder and render threads at the same time.
+    Histograms have quarter-octave buckets, percentiles are reported as
+    the upper bucket bound, within 19% of the real value.
+
+    updated() is emitted at most once per second while frames are
+    presented, from the presenting thread.
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcFrameStats : public QObject
+{
+    Q_OBJECT
+
+    /*!
+        \brief Frames delivered by libVLC
+     */
+    Q_PROPERTY(int delivered READ delivered NOTIFY updated)
+
+    /*!
+        \brief Frames presented by the renderer
+     */
+    Q_PROPERTY(int presented READ presented NOTIFY updated)
+
+    /*!
+        \brief Frames replaced by a newer one before being presented
+     */
+    Q_PROPERTY(int dropped READ dropped NOTIFY updated)
+
+    /*!
+        \brief Presented frames per second over the last interval
+     */
+    Q_PROPERTY(qreal fps READ fps NOTIFY updated)
+
+public:
+    /*!
+        \enum Stage
+        \brief Pipeline stages with a latency histogram
+     */
+    enum Stage {
+        DecodeStage,  /*!< lock to unlock, or to display if unlocked later */
+        QueueStage,   /*!< display to present start */
+        PresentStage, /*!< present start to present end */
+        TotalStage    /*!< lock to present end */
+    };
+    Q_ENUMS(Stage)
+
+    /*!
+        \brief VlcFrameStats constructor
+        \param parent parent object
+     */
+    explicit VlcFrameStats(QObject *parent = 0);
+    ~VlcFrameStats();
+
+    /*!
+        \brief Record a frame libVLC displayed (any thread)
+        \param timing frame timing up to display
+     */
+    void frameDelivered(const VlcFrameTiming &timing);
+
+    /*!
+        \brief Record a presented frame (any thread)
+        \param timing frame timing including presentation
+     */
+    void framePresented(const VlcFrameTiming &timing);
+
+    /*!
+        \brief Record a frame dropped before presentation (any thread)
+     */
+    void frameDropped();
+
+    /*!
+        \brief Latency percentile of a stage
+        \param stage pipeline stage
+        \param percent percentile, e.g. 50, 95 or 99
+        \return latency in microseconds, 0 if nothing was recorded
+     */
+    Q_INVOKABLE int percentile(Stage stage,
+                               int percent) const;
+
+    /*!
+        \brief Number of frames delivered by libVLC
+        \return delivered frames
+     */
+    int delivered() const;
+
+    /*!
+        \brief Number of presented frames
+        \return presented frames
+     */
+    int presented() const;
+
+    /*!
+        \brief Number of dropped frames
+        \return dropped frames
+     */
+    int dropped() const;
+
+    /*!
+        \brief Effective frame rate
+        \return presented frames per second over the last interval
+     */
+    qreal fps() const;
+
+    /*!
+        \brief Clear all counters and histograms
+     */
+    Q_INVOKABLE void reset();
+
+signals:
+    /*!
+        \brief Statistics updated, coalesced to once per second
+     */
+    void updated();
+
+private:
+    static const int StageCount = TotalStage + 1;
+    static const int BucketCount = 100;
+
+    static int bucket(qint64 us);
+    static qint64 bucketLimit(int bucket);
+
+    void record(Stage stage,
+                qint64 us);
+    void update();
+
+    QAtomicInt _histogram[StageCount][BucketCount];
+
+    QAtomicInt _delivered;
+    QAtomicInt _presented;
+    QAtomicInt _dropped;
+
+    // fps interval, owned by the thread winning _lastUpdate
+    QElapsedTimer _clock;
+    QAtomicInt _lastUpdate;
+    QAtomicInt _lastPresented;
+    QAtomicInt _fps; // frames per 100 seconds
+};
+
+#endif // VLCQT_FRAMESTATS_H_
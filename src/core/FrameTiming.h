@@ -0,0 +1,67 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_FRAMETIMING_H_
+#define VLCQT_FRAMETIMING_H_
+
+#include <chrono>
+
+#include <QtCore/QtGlobal>
+
+/*!
+    \struct VlcFrameTiming FrameTiming.h VLCQtCore/FrameTiming.h
+    \ingroup VLCQtCore
+    \brief Timestamps of one frame through the video pipeline
+
+    All times are monotonic microseconds from now(), 0 if the stage was
+    not reached yet.
+
+    \see VlcFrameStats
+    \since VLC-Qt 1.2
+*/
+struct VlcFrameTiming {
+    quint64 sequence;    /*!< frame number within the stream */
+    qint64 lock;         /*!< libVLC locked the buffer for decoding */
+    qint64 unlock;       /*!< decoding finished */
+    qint64 display;      /*!< libVLC asked to display the frame */
+    qint64 presentStart; /*!< renderer started presenting the frame */
+    qint64 presentEnd;   /*!< frame was presented */
+
+    /*!
+        \brief Start timing a new frame at lock time
+        \param number frame number within the stream
+     */
+    void start(quint64 number)
+    {
+        sequence = number;
+        lock = now();
+        unlock = display = presentStart = presentEnd = 0;
+    }
+
+    /*!
+        \brief Monotonic clock used for all timestamps
+        \return microseconds
+     */
+    static qint64 now()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // VLCQT_FRAMETIMING_H_
@@ -121,10 +121,25 @@ public:
     /*!
         \brief Get media stats
 
-        \return VlcStats media stats object
+        Allocates a new stats object on every call, prefer getStats(VlcStats *)
+        or VlcStatsMonitor for periodic sampling.
+
+        \return VlcStats media stats object, owned by the caller
     */
     VlcStats *getStats();
 
+    /*!
+        \brief Get media stats without allocating
+
+        libVLC only collects stats when they are enabled with the --stats
+        argument or the :stats media option.
+
+        \param stats stats object to fill
+        \return true if libVLC returned valid stats
+        \since VLC-Qt 1.2
+    */
+    bool getStats(VlcStats *stats) const;
+
     /*!
         \brief Get media state
         \return current media state
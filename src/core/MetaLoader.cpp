@@ -0,0 +1,127 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtCore/QMetaObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include <vlc/vlc.h>
+
+#include "core/Media.h"
+#include "core/MetaLoader.h"
+
+namespace
+{
+class MetaTask : public QRunnable
+{
+public:
+    MetaTask(VlcMetaLoader *loader,
+             quint64 id,
+             libvlc_media_t *media)
+        : _loader(loader),
+          _id(id),
+          _media(media)
+    {
+        libvlc_media_retain(_media);
+    }
+
+    ~MetaTask()
+    {
+        libvlc_media_release(_media);
+    }
+
+    void run()
+    {
+        // Returns immediately if the media was already parsed
+        libvlc_media_parse(_media);
+
+        QMetaObject::invokeMethod(_loader, "complete", Qt::QueuedConnection,
+                                  Q_ARG(quint64, _id),
+                                  Q_ARG(VlcMetaSnapshot, VlcMetaSnapshot(_media)));
+    }
+
+private:
+    VlcMetaLoader *_loader;
+    quint64 _id;
+    libvlc_media_t *_media;
+};
+}
+
+VlcMetaLoader::VlcMetaLoader(QObject *parent)
+    : QObject(parent),
+      _pool(new QThreadPool(this)),
+      _nextId(0)
+{
+    qRegisterMetaType<VlcMetaSnapshot>();
+
+    _pool->setMaxThreadCount(2);
+}
+
+VlcMetaLoader::~VlcMetaLoader()
+{
+    // Tasks post back to this object, none may outlive it
+    _pool->clear();
+    _pool->waitForDone();
+}
+
+int VlcMetaLoader::maxThreads() const
+{
+    return _pool->maxThreadCount();
+}
+
+void VlcMetaLoader::setMaxThreads(int count)
+{
+    _pool->setMaxThreadCount(qMax(1, count));
+}
+
+void VlcMetaLoader::load(VlcMedia *media)
+{
+    if (!media)
+        return;
+
+    quint64 id = ++_nextId;
+    _requests.insert(id, media);
+    _pool->start(new MetaTask(this, id, media->core()));
+}
+
+void VlcMetaLoader::cancel()
+{
+    _pool->clear();
+
+    bool wasPending = !_requests.isEmpty();
+    _requests.clear();
+    if (wasPending)
+        emit finished();
+}
+
+void VlcMetaLoader::complete(quint64 id,
+                             const VlcMetaSnapshot &meta)
+{
+    QHash<quint64, QPointer<VlcMedia>>::iterator request = _requests.find(id);
+    if (request == _requests.end())
+        return;
+
+    QPointer<VlcMedia> media = request.value();
+    _requests.erase(request);
+
+    if (media)
+        emit loaded(media, meta);
+
+    if (_requests.isEmpty())
+        emit finished();
+}
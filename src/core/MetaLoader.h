@@ -0,0 +1,122 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_METALOADER_H_
+#define VLCQT_METALOADER_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+
+#include "MetaSnapshot.h"
+#include "SharedExportCore.h"
+
+class QThreadPool;
+
+class VlcMedia;
+
+/*!
+    \class VlcMetaLoader MetaLoader.h VLCQtCore/MetaLoader.h
+    \ingroup VLCQtCore
+    \brief Asynchronous media meta reader
+
+    Parses media on a small pool of worker threads and reads all of their
+    meta in one pass, so populating a list with many items does not block
+    the calling thread. Each result is delivered on the loader's thread
+    through loaded() as an immutable VlcMetaSnapshot.
+
+    \see VlcMetaManager for blocking access
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcMetaLoader : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+        \brief VlcMetaLoader constructor
+        \param parent parent object
+     */
+    explicit VlcMetaLoader(QObject *parent = 0);
+
+    /*!
+        \brief VlcMetaLoader destructor
+
+        Pending requests are dropped, a parse already running is waited for.
+     */
+    ~VlcMetaLoader();
+
+    /*!
+        \brief Maximum number of media parsed at the same time
+        \return thread count, 2 by default
+     */
+    int maxThreads() const;
+
+    /*!
+        \brief Set maximum number of media parsed at the same time
+        \param count thread count
+     */
+    void setMaxThreads(int count);
+
+    /*!
+        \brief Number of requests not delivered yet
+        \return pending count
+     */
+    int pending() const { return _requests.size(); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Queue meta reading of a media
+
+        The media must stay alive until loaded() is emitted for it, a
+        media deleted before that is silently skipped.
+
+        \param media media to read
+     */
+    void load(VlcMedia *media);
+
+    /*!
+        \brief Drop all requests that did not start yet
+
+        Requests already parsing complete, but are not delivered.
+     */
+    void cancel();
+
+signals:
+    /*!
+        \brief Signal sent when meta of a media was read
+        \param media media from the request
+        \param meta all meta of the media
+     */
+    void loaded(VlcMedia *media,
+                const VlcMetaSnapshot &meta);
+
+    /*!
+        \brief Signal sent when all queued requests were delivered
+     */
+    void finished();
+
+private slots:
+    void complete(quint64 id,
+                  const VlcMetaSnapshot &meta);
+
+private:
+    QThreadPool *_pool;
+    quint64 _nextId;
+    QHash<quint64, QPointer<VlcMedia>> _requests;
+};
+
+#endif // VLCQT_METALOADER_H_
@@ -184,3 +184,8 @@ bool VlcMetaManager::saveMeta() const
 {
     return libvlc_media_save_meta(_media->core());
 }
+
+VlcMetaSnapshot VlcMetaManager::snapshot() const
+{
+    return VlcMetaSnapshot(_media);
+}
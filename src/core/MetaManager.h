@@ -22,6 +22,7 @@
 #include <QtCore/QDate>
 #include <QtCore/QString>
 
+#include "MetaSnapshot.h"
 #include "SharedExportCore.h"
 
 class VlcMedia;
@@ -218,6 +219,13 @@ public:
     */
     bool saveMeta() const;
 
+    /*!
+        \brief Get all meta at once.
+        \return immutable copy of current meta (VlcMetaSnapshot)
+        \since VLC-Qt 1.2
+    */
+    VlcMetaSnapshot snapshot() const;
+
 private:
     VlcMedia *_media;
 };
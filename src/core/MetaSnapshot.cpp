@@ -0,0 +1,74 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtCore/QSharedData>
+
+#include <vlc/vlc.h>
+
+#include "core/Media.h"
+#include "core/MetaSnapshot.h"
+
+class VlcMetaSnapshotData : public QSharedData
+{
+public:
+    // Indexed by Vlc::Meta, which follows libvlc_meta_t
+    static const int Count = Vlc::TrackID + 1;
+
+    QString values[Count];
+};
+
+VlcMetaSnapshot::VlcMetaSnapshot() {}
+
+VlcMetaSnapshot::VlcMetaSnapshot(VlcMedia *media)
+    : VlcMetaSnapshot(media->core()) {}
+
+VlcMetaSnapshot::VlcMetaSnapshot(libvlc_media_t *media)
+    : d(new VlcMetaSnapshotData)
+{
+    for (int i = 0; i < VlcMetaSnapshotData::Count; ++i) {
+        char *value = libvlc_media_get_meta(media, libvlc_meta_t(i));
+        if (value) {
+            d->values[i] = QString::fromUtf8(value);
+            libvlc_free(value);
+        }
+    }
+}
+
+VlcMetaSnapshot::VlcMetaSnapshot(const VlcMetaSnapshot &other)
+    : d(other.d) {}
+
+VlcMetaSnapshot &VlcMetaSnapshot::operator=(const VlcMetaSnapshot &other)
+{
+    d = other.d;
+    return *this;
+}
+
+VlcMetaSnapshot::~VlcMetaSnapshot() {}
+
+bool VlcMetaSnapshot::isValid() const
+{
+    return d.constData() != 0;
+}
+
+QString VlcMetaSnapshot::value(Vlc::Meta meta) const
+{
+    if (!d || meta < 0 || meta >= VlcMetaSnapshotData::Count)
+        return QString();
+
+    return d->values[meta];
+}
@@ -0,0 +1,186 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_METASNAPSHOT_H_
+#define VLCQT_METASNAPSHOT_H_
+
+#include <QtCore/QMetaType>
+#include <QtCore/QSharedDataPointer>
+#include <QtCore/QString>
+
+#include "Enums.h"
+#include "SharedExportCore.h"
+
+class VlcMedia;
+class VlcMetaSnapshotData;
+
+struct libvlc_media_t;
+
+/*!
+    \class VlcMetaSnapshot MetaSnapshot.h VLCQtCore/MetaSnapshot.h
+    \ingroup VLCQtCore
+    \brief Immutable media meta information
+
+    All meta fields of a parsed media, fetched from libVLC in one pass.
+    Snapshots are implicitly shared, copying one is cheap and it may be
+    passed between threads.
+
+    \see VlcMetaLoader
+    \see VlcMetaTransaction
+    \since VLC-Qt 1.2
+*/
+class VLCQT_CORE_EXPORT VlcMetaSnapshot
+{
+public:
+    /*!
+        \brief Empty snapshot
+     */
+    VlcMetaSnapshot();
+
+    /*!
+        \brief Read all meta of a parsed media
+        \param media media, should already be parsed
+     */
+    explicit VlcMetaSnapshot(VlcMedia *media);
+
+    /*!
+        \brief Read all meta of a parsed libVLC media, from any thread
+        \param media libVLC media, should already be parsed
+     */
+    explicit VlcMetaSnapshot(libvlc_media_t *media);
+
+    VlcMetaSnapshot(const VlcMetaSnapshot &other);
+    VlcMetaSnapshot &operator=(const VlcMetaSnapshot &other);
+    ~VlcMetaSnapshot();
+
+    /*!
+        \brief Check if the snapshot was read from a media
+        \return false for an empty snapshot
+     */
+    bool isValid() const;
+
+    /*!
+        \brief Get meta value
+        \param meta meta type
+        \return value, empty if not set
+     */
+    QString value(Vlc::Meta meta) const;
+
+    /*!
+        \brief Track title
+        \return title
+     */
+    QString title() const { return value(Vlc::Title); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track artist
+        \return artist
+     */
+    QString artist() const { return value(Vlc::Artist); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track genre
+        \return genre
+     */
+    QString genre() const { return value(Vlc::Genre); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track copyright
+        \return copyright
+     */
+    QString copyright() const { return value(Vlc::Copyright); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track album
+        \return album
+     */
+    QString album() const { return value(Vlc::Album); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track number
+        \return number, 0 if not set
+     */
+    int number() const { return value(Vlc::TrackNumber).toInt(); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track description
+        \return description
+     */
+    QString description() const { return value(Vlc::Description); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track rating
+        \return rating
+     */
+    QString rating() const { return value(Vlc::Rating); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track year
+        \return year, 0 if not set
+     */
+    int year() const { return value(Vlc::Date).toInt(); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track setting
+        \return setting
+     */
+    QString setting() const { return value(Vlc::Setting); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track URL
+        \return URL
+     */
+    QString url() const { return value(Vlc::URL); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track language
+        \return language
+     */
+    QString language() const { return value(Vlc::Language); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track publisher
+        \return publisher
+     */
+    QString publisher() const { return value(Vlc::Publisher); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track encoder
+        \return encoder
+     */
+    QString encoder() const { return value(Vlc::EncodedBy); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track artwork URL
+        \return artwork URL
+     */
+    QString artwork() const { return value(Vlc::ArtworkURL); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Track ID
+        \return ID
+     */
+    QString id() const { return value(Vlc::TrackID); } // LCOV_EXCL_LINE
+
+private:
+    QSharedDataPointer<VlcMetaSnapshotData> d;
+};
+
+Q_DECLARE_METATYPE(VlcMetaSnapshot)
+
+#endif // VLCQT_METASNAPSHOT_H_
@@ -0,0 +1,61 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <vlc/vlc.h>
+
+#include "core/Media.h"
+#include "core/MetaTransaction.h"
+
+VlcMetaTransaction::VlcMetaTransaction(VlcMedia *media)
+    : _media(media) {}
+
+VlcMetaTransaction::~VlcMetaTransaction() {}
+
+void VlcMetaTransaction::set(Vlc::Meta meta,
+                             const QString &value)
+{
+    _changes.insert(meta, value);
+}
+
+void VlcMetaTransaction::setNumber(int number)
+{
+    set(Vlc::TrackNumber, QString::number(number));
+}
+
+void VlcMetaTransaction::setYear(int year)
+{
+    set(Vlc::Date, QString::number(year));
+}
+
+bool VlcMetaTransaction::commit()
+{
+    if (_changes.isEmpty())
+        return true;
+
+    for (QMap<int, QString>::const_iterator i = _changes.constBegin(); i != _changes.constEnd(); ++i) {
+        libvlc_media_set_meta(_media->core(), libvlc_meta_t(i.key()), i.value().toUtf8().data());
+    }
+    _changes.clear();
+
+    return libvlc_media_save_meta(_media->core());
+}
+
+void VlcMetaTransaction::rollback()
+{
+    _changes.clear();
+}
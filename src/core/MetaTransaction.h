@@ -0,0 +1,99 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_METATRANSACTION_H_
+#define VLCQT_METATRANSACTION_H_
+
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+#include "Enums.h"
+#include "SharedExportCore.h"
+
+class VlcMedia;
+
+/*!
+    \class VlcMetaTransaction MetaTransaction.h VLCQtCore/MetaTransaction.h
+    \ingroup VLCQtCore
+    \brief Batched media meta editor
+
+    Collects meta edits and applies them together on commit(), writing
+    the file only once. Nothing touches the media before that, so an
+    editor can drop all changes with rollback().
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcMetaTransaction
+{
+public:
+    /*!
+        \brief VlcMetaTransaction constructor
+        \param media media to edit, should already be parsed
+     */
+    explicit VlcMetaTransaction(VlcMedia *media);
+
+    /*!
+        \brief VlcMetaTransaction destructor
+
+        Uncommitted edits are dropped.
+     */
+    ~VlcMetaTransaction();
+
+    /*!
+        \brief Check for uncommitted edits
+        \return true if there is nothing to commit
+     */
+    bool isEmpty() const { return _changes.isEmpty(); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Queue a meta edit, replacing a previous edit of the same field
+        \param meta meta type
+        \param value new value
+     */
+    void set(Vlc::Meta meta,
+             const QString &value);
+
+    /*!
+        \brief Queue a track number edit
+        \param number new track number
+     */
+    void setNumber(int number);
+
+    /*!
+        \brief Queue a track year edit
+        \param year new track year
+     */
+    void setYear(int year);
+
+    /*!
+        \brief Apply all queued edits and save meta once
+        \return true if saved successfully or there was nothing to save
+     */
+    bool commit();
+
+    /*!
+        \brief Drop all queued edits
+     */
+    void rollback();
+
+private:
+    VlcMedia *_media;
+    QMap<int, QString> _changes;
+};
+
+#endif // VLCQT_METATRANSACTION_H_
@@ -0,0 +1,177 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <cstring>
+
+#include <QtCore/QTimer>
+
+#include <vlc/vlc.h>
+
+#include "core/Media.h"
+#include "core/MediaPlayer.h"
+#include "core/StatsMonitor.h"
+
+// Defaults, one sample per second for a minute
+static const int DefaultInterval = 1000;
+static const int DefaultHistorySize = 60;
+
+static bool sameRates(const VlcStatsMonitor::Rates &a,
+                      const VlcStatsMonitor::Rates &b)
+{
+    return qFuzzyCompare(1 + a.decodeFps, 1 + b.decodeFps)
+           && qFuzzyCompare(1 + a.displayFps, 1 + b.displayFps)
+           && qFuzzyCompare(1 + a.lostPictureRate, 1 + b.lostPictureRate)
+           && qFuzzyCompare(1 + a.demuxBitrate, 1 + b.demuxBitrate)
+           && a.audioUnderruns == b.audioUnderruns;
+}
+
+static void enableStats(libvlc_media_t *media)
+{
+    // Not enough on its own, the instance needs VlcCommon::statsArgs()
+    libvlc_media_add_option(media, ":stats");
+}
+
+VlcStatsMonitor::VlcStatsMonitor(VlcMediaPlayer *player,
+                                 QObject *parent)
+    : QObject(parent),
+      _player(player),
+      _timer(new QTimer(this)),
+      _next(0),
+      _count(0)
+{
+    memset(&_rates, 0, sizeof(_rates));
+
+    _clock.start();
+    _timer->setInterval(DefaultInterval);
+    connect(_timer, &QTimer::timeout, this, &VlcStatsMonitor::sampleStats);
+
+    setHistorySize(DefaultHistorySize);
+
+    // Emitted from the libVLC event thread before the new input starts
+    connect(_player, &VlcMediaPlayer::mediaChanged, this, [this](libvlc_media_t *media) {
+        _restart.storeRelease(1);
+        if (_active.loadAcquire() && media)
+            enableStats(media);
+    }, Qt::DirectConnection);
+}
+
+VlcStatsMonitor::~VlcStatsMonitor() {}
+
+int VlcStatsMonitor::interval() const
+{
+    return _timer->interval();
+}
+
+void VlcStatsMonitor::setInterval(int ms)
+{
+    _timer->setInterval(qMax(1, ms));
+}
+
+void VlcStatsMonitor::setHistorySize(int samples)
+{
+    _history.resize(qMax(2, samples));
+    _next = 0;
+    _count = 0;
+}
+
+void VlcStatsMonitor::start()
+{
+    _active.storeRelease(1);
+
+    libvlc_media_t *media = libvlc_media_player_get_media(_player->core());
+    if (media) {
+        enableStats(media);
+        libvlc_media_release(media);
+    }
+
+    _timer->start();
+}
+
+void VlcStatsMonitor::stop()
+{
+    _active.storeRelease(0);
+    _timer->stop();
+}
+
+bool VlcStatsMonitor::isActive() const
+{
+    return _timer->isActive();
+}
+
+const VlcStatsMonitor::Sample &VlcStatsMonitor::sample(int age) const
+{
+    Q_ASSERT(age >= 0 && age < _history.size());
+
+    const int size = _history.size();
+    return _history[(_next - 1 - age + 2 * size) % size];
+}
+
+VlcStatsMonitor::Rates VlcStatsMonitor::rates(const Sample &previous,
+                                              const Sample &current)
+{
+    Rates rates;
+    memset(&rates, 0, sizeof(rates));
+
+    const qint64 ms = current.time - previous.time;
+    if (ms <= 0)
+        return rates;
+
+    const VlcStats &a = previous.stats;
+    const VlcStats &b = current.stats;
+
+    const int decoded = qMax(0, b.decoded_video - a.decoded_video);
+    const int displayed = qMax(0, b.displayed_pictures - a.displayed_pictures);
+    const int lost = qMax(0, b.lost_pictures - a.lost_pictures);
+    const int demuxed = qMax(0, b.demux_read_bytes - a.demux_read_bytes);
+
+    rates.decodeFps = decoded * 1000. / ms;
+    rates.displayFps = displayed * 1000. / ms;
+    if (displayed + lost)
+        rates.lostPictureRate = qreal(lost) / (displayed + lost);
+    rates.demuxBitrate = demuxed * 8. / ms; // bits per ms is kbit/s
+    rates.audioUnderruns = qMax(0, b.lost_abuffers - a.lost_abuffers);
+
+    return rates;
+}
+
+void VlcStatsMonitor::sampleStats()
+{
+    Rates current;
+    memset(&current, 0, sizeof(current));
+
+    // Counters of a new input start from zero
+    if (_restart.fetchAndStoreAcquire(0))
+        _count = 0;
+
+    VlcMedia *media = _player->currentMedia();
+    Sample &sample = _history[_next];
+    if (media && media->getStats(&sample.stats)) {
+        sample.time = _clock.elapsed();
+        _next = (_next + 1) % _history.size();
+        _count = qMin(_count + 1, _history.size());
+
+        if (_count >= 2)
+            current = rates(this->sample(1), this->sample(0));
+    }
+
+    if (sameRates(current, _rates))
+        return;
+
+    _rates = current;
+    emit statsChanged();
+}
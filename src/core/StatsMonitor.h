@@ -0,0 +1,244 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_STATSMONITOR_H_
+#define VLCQT_STATSMONITOR_H_
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+
+#include "SharedExportCore.h"
+#include "Stats.h"
+
+class QTimer;
+
+class VlcMediaPlayer;
+
+/*!
+    \class VlcStatsMonitor StatsMonitor.h VLCQtCore/StatsMonitor.h
+    \ingroup VLCQtCore
+    \brief Periodic media statistics sampler
+
+    VlcStatsMonitor enables libVLC statistics for every media the player
+    opens while it is running and samples them on a fixed interval into a
+    preallocated history ring. Rates are derived from the last two
+    samples. Sampling does not allocate, and statsChanged() is emitted at
+    most once per interval and only when a rate changed.
+
+    libVLC counters start with the input, so stats are only available for
+    media opened after start() or not playing yet when it was called.
+
+    libVLC only counts when the instance was created with statistics
+    enabled, use VlcCommon::statsArgs() instead of VlcCommon::args().
+    The default arguments disable them and the counters stay at zero.
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcStatsMonitor : public QObject
+{
+    Q_OBJECT
+
+    /*!
+        \brief Decoded video frames per second
+     */
+    Q_PROPERTY(qreal decodeFps READ decodeFps NOTIFY statsChanged)
+
+    /*!
+        \brief Displayed video frames per second
+     */
+    Q_PROPERTY(qreal displayFps READ displayFps NOTIFY statsChanged)
+
+    /*!
+        \brief Share of lost pictures, from 0 to 1
+     */
+    Q_PROPERTY(qreal lostPictureRate READ lostPictureRate NOTIFY statsChanged)
+
+    /*!
+        \brief Demuxed input bitrate in kbit/s
+     */
+    Q_PROPERTY(qreal demuxBitrate READ demuxBitrate NOTIFY statsChanged)
+
+    /*!
+        \brief Audio buffers lost in the last interval
+     */
+    Q_PROPERTY(int audioUnderruns READ audioUnderruns NOTIFY statsChanged)
+
+public:
+    /*!
+        \struct Sample
+        \brief Stats sampled at one point in time
+     */
+    struct Sample {
+        qint64 time;    /*!< milliseconds since the monitor was created */
+        VlcStats stats; /*!< libVLC counters */
+    };
+
+    /*!
+        \struct Rates
+        \brief Rates derived from two samples
+     */
+    struct Rates {
+        qreal decodeFps;       /*!< decoded video frames per second */
+        qreal displayFps;      /*!< displayed video frames per second */
+        qreal lostPictureRate; /*!< lost pictures of all pictures, 0 to 1 */
+        qreal demuxBitrate;    /*!< demuxed input in kbit/s */
+        int audioUnderruns;    /*!< lost audio buffers */
+    };
+
+    /*!
+        \brief VlcStatsMonitor constructor
+        \param player media player to sample
+        \param parent parent object
+     */
+    explicit VlcStatsMonitor(VlcMediaPlayer *player,
+                             QObject *parent = 0);
+    ~VlcStatsMonitor();
+
+    /*!
+        \brief Sampling interval
+        \return interval in milliseconds
+     */
+    int interval() const;
+
+    /*!
+        \brief Set sampling interval, default is 1000 ms
+        \param ms interval in milliseconds
+     */
+    void setInterval(int ms);
+
+    /*!
+        \brief History size
+        \return number of samples kept
+     */
+    int historySize() const { return _history.size(); } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Set history size, default is 60 samples
+
+        Reallocates the history and clears it, call before start().
+
+        \param samples number of samples kept, at least 2
+     */
+    void setHistorySize(int samples);
+
+    /*!
+        \brief Start sampling and enable stats for opened media
+     */
+    void start();
+
+    /*!
+        \brief Stop sampling
+     */
+    void stop();
+
+    /*!
+        \brief Check if the monitor is sampling
+        \return true if running
+     */
+    bool isActive() const;
+
+    /*!
+        \brief Number of valid samples in the history
+        \return sample count
+     */
+    int sampleCount() const { return _count; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Get a sample from the history
+        \param age 0 for the newest sample, up to sampleCount() - 1
+        \return sample, valid until the next sampling
+     */
+    const Sample &sample(int age = 0) const;
+
+    /*!
+        \brief Current rates
+        \return rates of the last interval
+     */
+    Rates rates() const { return _rates; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Derive rates from two samples
+
+        Counters that went backwards, e.g. after a new input started,
+        count as zero.
+
+        \param previous older sample
+        \param current newer sample
+        \return rates between the samples
+     */
+    static Rates rates(const Sample &previous,
+                       const Sample &current);
+
+    /*!
+        \brief Decoded video frames per second
+        \return fps of the last interval
+     */
+    qreal decodeFps() const { return _rates.decodeFps; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Displayed video frames per second
+        \return fps of the last interval
+     */
+    qreal displayFps() const { return _rates.displayFps; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Share of lost pictures
+        \return lost pictures of all pictures in the last interval
+     */
+    qreal lostPictureRate() const { return _rates.lostPictureRate; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Demuxed input bitrate
+        \return kbit/s in the last interval
+     */
+    qreal demuxBitrate() const { return _rates.demuxBitrate; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Audio underruns
+        \return audio buffers lost in the last interval
+     */
+    int audioUnderruns() const { return _rates.audioUnderruns; } // LCOV_EXCL_LINE
+
+signals:
+    /*!
+        \brief Rates changed, at most once per interval
+     */
+    void statsChanged();
+
+private slots:
+    void sampleStats();
+
+private:
+    VlcMediaPlayer *_player;
+    QTimer *_timer;
+    QElapsedTimer _clock;
+
+    // Shared with the libVLC event thread
+    QAtomicInt _active;
+    QAtomicInt _restart;
+
+    QVector<Sample> _history;
+    int _next;
+    int _count;
+
+    Rates _rates;
+};
+
+#endif // VLCQT_STATSMONITOR_H_
@@ -0,0 +1,230 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_VIDEOFRAMELAYOUT_H_
+#define VLCQT_VIDEOFRAMELAYOUT_H_
+
+#include "AbstractVideoFrame.h"
+
+/*!
+    \struct VlcI420Layout VideoFrameLayout.h VLCQtCore/VideoFrameLayout.h
+    \ingroup VLCQtCore
+    \brief Planar 4:2:0 YUV layout with separate U and V planes
+    \since VLC-Qt 1.2
+*/
+struct VlcI420Layout {
+    static const char *chroma() { return "I420"; } /*!< libVLC chroma */
+    static constexpr unsigned planeCount = 3;      /*!< number of planes */
+    static constexpr unsigned alignment = 4;       /*!< pitch alignment in bytes */
+    static constexpr bool evenSize = true;         /*!< width and height rounded up to even */
+
+    /*! \brief Horizontal subsampling of a plane */
+    static constexpr unsigned widthDivisor(unsigned plane) { return plane ? 2 : 1; }
+    /*! \brief Vertical subsampling of a plane */
+    static constexpr unsigned heightDivisor(unsigned plane) { return plane ? 2 : 1; }
+    /*! \brief Bytes per sample of a plane */
+    static constexpr unsigned bytesPerPixel(unsigned) { return 1; }
+};
+
+/*!
+    \struct VlcNV12Layout VideoFrameLayout.h VLCQtCore/VideoFrameLayout.h
+    \ingroup VLCQtCore
+    \brief Semi-planar 4:2:0 YUV layout with interleaved UV plane
+
+    Suited for two-texture upload, luminance and luminance-alpha.
+
+    \since VLC-Qt 1.2
+*/
+struct VlcNV12Layout {
+    static const char *chroma() { return "NV12"; } /*!< libVLC chroma */
+    static constexpr unsigned planeCount = 2;      /*!< number of planes */
+    static constexpr unsigned alignment = 4;       /*!< pitch alignment in bytes */
+    static constexpr bool evenSize = true;         /*!< width and height rounded up to even */
+
+    /*! \brief Horizontal subsampling of a plane */
+    static constexpr unsigned widthDivisor(unsigned plane) { return plane ? 2 : 1; }
+    /*! \brief Vertical subsampling of a plane */
+    static constexpr unsigned heightDivisor(unsigned plane) { return plane ? 2 : 1; }
+    /*! \brief Bytes per sample of a plane */
+    static constexpr unsigned bytesPerPixel(unsigned plane) { return plane ? 2 : 1; }
+};
+
+/*!
+    \struct VlcRV32Layout VideoFrameLayout.h VLCQtCore/VideoFrameLayout.h
+    \ingroup VLCQtCore
+    \brief Packed 32-bit RGB layout, BGRA in memory on little endian
+
+    Suited for copying straight to a framebuffer.
+
+    \since VLC-Qt 1.2
+*/
+struct VlcRV32Layout {
+    static const char *chroma() { return "RV32"; } /*!< libVLC chroma */
+    static constexpr unsigned planeCount = 1;      /*!< number of planes */
+    static constexpr unsigned alignment = 16;      /*!< pitch alignment in bytes */
+    static constexpr bool evenSize = false;        /*!< width and height rounded up to even */
+
+    /*! \brief Horizontal subsampling of a plane */
+    static constexpr unsigned widthDivisor(unsigned) { return 1; }
+    /*! \brief Vertical subsampling of a plane */
+    static constexpr unsigned heightDivisor(unsigned) { return 1; }
+    /*! \brief Bytes per sample of a plane */
+    static constexpr unsigned bytesPerPixel(unsigned) { return 4; }
+};
+
+/*!
+    \struct VlcUYVYLayout VideoFrameLayout.h VLCQtCore/VideoFrameLayout.h
+    \ingroup VLCQtCore
+    \brief Packed 4:2:2 YUV layout, two bytes per pixel
+    \since VLC-Qt 1.2
+*/
+struct VlcUYVYLayout {
+    static const char *chroma() { return "UYVY"; } /*!< libVLC chroma */
+    static constexpr unsigned planeCount = 1;      /*!< number of planes */
+    static constexpr unsigned alignment = 4;       /*!< pitch alignment in bytes */
+    static constexpr bool evenSize = true;         /*!< width and height rounded up to even */
+
+    /*! \brief Horizontal subsampling of a plane */
+    static constexpr unsigned widthDivisor(unsigned) { return 1; }
+    /*! \brief Vertical subsampling of a plane */
+    static constexpr unsigned heightDivisor(unsigned) { return 1; }
+    /*! \brief Bytes per sample of a plane */
+    static constexpr unsigned bytesPerPixel(unsigned) { return 2; }
+};
+
+/*!
+    \struct VlcLayoutVideoFrame VideoFrameLayout.h VLCQtCore/VideoFrameLayout.h
+    \ingroup VLCQtCore
+    \brief Video frame data container for a compile-time plane layout
+
+    The layout describes plane count, subsampling, bytes per pixel and pitch
+    alignment as constants, so pitches, lines and planes are computed by
+    unrolled straight-line code.
+
+    \since VLC-Qt 1.2
+*/
+template <typename Layout>
+struct VlcLayoutVideoFrame : VlcAbstractVideoFrame {
+    /*!
+        \brief VlcLayoutVideoFrame constructor.
+        This construction ensures data is set and containers prepared.
+        \param width
+        \param height
+        \param pitches
+        \param lines
+    */
+    VlcLayoutVideoFrame(unsigned *width,
+                        unsigned *height,
+                        unsigned *pitches,
+                        unsigned *lines)
+        : VlcAbstractVideoFrame(Layout::planeCount)
+    {
+        frameBuffer.resize(bufferSize(width, height, pitches, lines));
+        setSize(*width, *height);
+        setPitchesAndLines(pitches, lines);
+    }
+
+    /*!
+        \brief VlcLayoutVideoFrame constructor.
+        This construction uses external memory, e.g. from VlcFramePool,
+        which must stay valid for the lifetime of the frame.
+        \param width
+        \param height
+        \param pitches
+        \param lines
+        \param buffer frame memory of at least bufferSize() bytes
+    */
+    VlcLayoutVideoFrame(unsigned *width,
+                        unsigned *height,
+                        unsigned *pitches,
+                        unsigned *lines,
+                        char *buffer)
+        : VlcAbstractVideoFrame(Layout::planeCount)
+    {
+        // Raw data is not copied, planes point into the external buffer
+        frameBuffer = QByteArray::fromRawData(buffer, bufferSize(width, height, pitches, lines));
+        setSize(*width, *height);
+        setPitchesAndLines(pitches, lines);
+    }
+
+    /*!
+        \brief Set pitches and lines for a frame size
+        \param width
+        \param height
+        \param pitches
+        \param lines
+        \return frame buffer size in bytes
+    */
+    static unsigned bufferSize(unsigned *width,
+                               unsigned *height,
+                               unsigned *pitches,
+                               unsigned *lines)
+    {
+        const unsigned w = Layout::evenSize ? *width + (*width & 1) : *width;
+        const unsigned h = Layout::evenSize ? *height + (*height & 1) : *height;
+
+        unsigned size = 0;
+        for (unsigned i = 0; i < Layout::planeCount; ++i) {
+            const unsigned pitch = w / Layout::widthDivisor(i) * Layout::bytesPerPixel(i);
+            pitches[i] = (pitch + Layout::alignment - 1) / Layout::alignment * Layout::alignment;
+            lines[i] = h / Layout::heightDivisor(i);
+            size += pitches[i] * lines[i];
+        }
+
+        return size;
+    }
+
+protected:
+    /*!
+        \brief Empty frame for subclasses that set up the buffer themselves
+    */
+    VlcLayoutVideoFrame()
+        : VlcAbstractVideoFrame(Layout::planeCount) {}
+
+    /*!
+        \brief Set frame size, rounded up to even if the layout requires it
+        \param width
+        \param height
+    */
+    void setSize(unsigned width,
+                 unsigned height)
+    {
+        this->width = Layout::evenSize ? width + (width & 1) : width;
+        this->height = Layout::evenSize ? height + (height & 1) : height;
+    }
+};
+
+/*!
+    \brief Semi-planar YUV 4:2:0 frame
+    \since VLC-Qt 1.2
+*/
+typedef VlcLayoutVideoFrame<VlcNV12Layout> VlcNV12VideoFrame;
+
+/*!
+    \brief Packed 32-bit RGB frame
+    \since VLC-Qt 1.2
+*/
+typedef VlcLayoutVideoFrame<VlcRV32Layout> VlcRV32VideoFrame;
+
+/*!
+    \brief Packed YUV 4:2:2 frame
+    \since VLC-Qt 1.2
+*/
+typedef VlcLayoutVideoFrame<VlcUYVYLayout> VlcUYVYVideoFrame;
+
+#endif // VLCQT_VIDEOFRAMELAYOUT_H_
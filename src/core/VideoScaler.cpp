@@ -0,0 +1,443 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VLCQT_VIDEOSCALER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define VLCQT_VIDEOSCALER_NEON
+#include <arm_neon.h>
+#endif
+
+#include "core/VideoScaler.h"
+
+namespace {
+
+// Taps are packed as source index << 8 | weight of the next sample.
+// Weights have 7 fractional bits, so a weight of 128 selects the next sample.
+const unsigned WeightBits = 7;
+const unsigned WeightOne = 1 << WeightBits;
+const unsigned InvalidRow = ~0u;
+
+inline unsigned tapIndex(quint32 tap) { return tap >> 8; }
+inline unsigned tapWeight(quint32 tap) { return tap & 0xff; }
+inline quint32 makeTap(unsigned index, unsigned weight) { return (index << 8) | weight; }
+
+// Blends pixels at index and index + 1 for every destination pixel
+typedef void (*HorizontalFunction)(const quint8 *src,
+                                   quint8 *dst,
+                                   const quint32 *taps,
+                                   unsigned width);
+
+// Blends two rows of bytes, weight applies to the second row
+typedef void (*VerticalFunction)(const quint8 *row0,
+                                 const quint8 *row1,
+                                 quint8 *dst,
+                                 unsigned bytes,
+                                 unsigned weight);
+
+struct Kernel {
+    HorizontalFunction horizontal;
+    VerticalFunction vertical;
+};
+
+inline quint8 blend(unsigned a,
+                    unsigned b,
+                    unsigned weight)
+{
+    return quint8((a * (WeightOne - weight) + b * weight + WeightOne / 2) >> WeightBits);
+}
+
+void horizontalNearest(const quint8 *src,
+                       quint8 *dst,
+                       const quint32 *taps,
+                       unsigned width)
+{
+    const quint32 *in = reinterpret_cast<const quint32 *>(src);
+    quint32 *out = reinterpret_cast<quint32 *>(dst);
+    for (unsigned x = 0; x < width; ++x)
+        out[x] = in[tapIndex(taps[x])];
+}
+
+void horizontalScalarFrom(const quint8 *src,
+                          quint8 *dst,
+                          const quint32 *taps,
+                          unsigned from,
+                          unsigned width)
+{
+    for (unsigned x = from; x < width; ++x) {
+        const quint8 *a = src + 4 * tapIndex(taps[x]);
+        const unsigned weight = tapWeight(taps[x]);
+        quint8 *out = dst + 4 * x;
+        out[0] = blend(a[0], a[4], weight);
+        out[1] = blend(a[1], a[5], weight);
+        out[2] = blend(a[2], a[6], weight);
+        out[3] = blend(a[3], a[7], weight);
+    }
+}
+
+void horizontalScalar(const quint8 *src,
+                      quint8 *dst,
+                      const quint32 *taps,
+                      unsigned width)
+{
+    horizontalScalarFrom(src, dst, taps, 0, width);
+}
+
+void verticalScalarFrom(const quint8 *row0,
+                        const quint8 *row1,
+                        quint8 *dst,
+                        unsigned from,
+                        unsigned bytes,
+                        unsigned weight)
+{
+    for (unsigned i = from; i < bytes; ++i)
+        dst[i] = blend(row0[i], row1[i], weight);
+}
+
+void verticalScalar(const quint8 *row0,
+                    const quint8 *row1,
+                    quint8 *dst,
+                    unsigned bytes,
+                    unsigned weight)
+{
+    verticalScalarFrom(row0, row1, dst, 0, bytes, weight);
+}
+
+#ifdef VLCQT_VIDEOSCALER_SSE2
+// Returns 4 32-bit sums, one per channel, of pixel pair at tap
+inline __m128i blendPairSse2(const quint8 *src,
+                             quint32 tap)
+{
+    const unsigned weight = tapWeight(tap);
+    __m128i pair = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + 4 * tapIndex(tap)));
+    pair = _mm_unpacklo_epi8(pair, _mm_srli_si128(pair, 4));
+    pair = _mm_unpacklo_epi8(pair, _mm_setzero_si128());
+    return _mm_madd_epi16(pair, _mm_set1_epi32(int((weight << 16) | (WeightOne - weight))));
+}
+
+void horizontalSse2(const quint8 *src,
+                    quint8 *dst,
+                    const quint32 *taps,
+                    unsigned width)
+{
+    const __m128i round = _mm_set1_epi32(WeightOne / 2);
+
+    unsigned x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i p0 = _mm_srli_epi32(_mm_add_epi32(blendPairSse2(src, taps[x]), round), WeightBits);
+        const __m128i p1 = _mm_srli_epi32(_mm_add_epi32(blendPairSse2(src, taps[x + 1]), round), WeightBits);
+        const __m128i p2 = _mm_srli_epi32(_mm_add_epi32(blendPairSse2(src, taps[x + 2]), round), WeightBits);
+        const __m128i p3 = _mm_srli_epi32(_mm_add_epi32(blendPairSse2(src, taps[x + 3]), round), WeightBits);
+        const __m128i pixels = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * x), pixels);
+    }
+
+    horizontalScalarFrom(src, dst, taps, x, width);
+}
+
+void verticalSse2(const quint8 *row0,
+                  const quint8 *row1,
+                  quint8 *dst,
+                  unsigned bytes,
+                  unsigned weight)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weight0 = _mm_set1_epi16(short(WeightOne - weight));
+    const __m128i weight1 = _mm_set1_epi16(short(weight));
+    const __m128i round = _mm_set1_epi16(WeightOne / 2);
+
+    unsigned i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + i));
+
+        __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), weight0),
+                                    _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), weight1));
+        __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), weight0),
+                                     _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), weight1));
+        low = _mm_srli_epi16(_mm_add_epi16(low, round), WeightBits);
+        high = _mm_srli_epi16(_mm_add_epi16(high, round), WeightBits);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(low, high));
+    }
+
+    verticalScalarFrom(row0, row1, dst, i, bytes, weight);
+}
+#endif // VLCQT_VIDEOSCALER_SSE2
+
+#ifdef VLCQT_VIDEOSCALER_NEON
+// Returns 4 16-bit sums, one per channel, of pixel pair at tap
+inline uint16x4_t blendPairNeon(const quint8 *src,
+                                quint32 tap)
+{
+    const unsigned weight = tapWeight(tap);
+    const uint8x8_t pair = vld1_u8(src + 4 * tapIndex(tap));
+    const uint8x8_t weights = vreinterpret_u8_u32(vset_lane_u32(weight * 0x01010101u,
+                                                                vdup_n_u32((WeightOne - weight) * 0x01010101u), 1));
+    const uint16x8_t products = vmull_u8(pair, weights);
+    return vadd_u16(vget_low_u16(products), vget_high_u16(products));
+}
+
+void horizontalNeon(const quint8 *src,
+                    quint8 *dst,
+                    const quint32 *taps,
+                    unsigned width)
+{
+    unsigned x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const uint16x8_t p01 = vcombine_u16(blendPairNeon(src, taps[x]), blendPairNeon(src, taps[x + 1]));
+        const uint16x8_t p23 = vcombine_u16(blendPairNeon(src, taps[x + 2]), blendPairNeon(src, taps[x + 3]));
+        vst1q_u8(dst + 4 * x, vcombine_u8(vrshrn_n_u16(p01, WeightBits), vrshrn_n_u16(p23, WeightBits)));
+    }
+
+    horizontalScalarFrom(src, dst, taps, x, width);
+}
+
+void verticalNeon(const quint8 *row0,
+                  const quint8 *row1,
+                  quint8 *dst,
+                  unsigned bytes,
+                  unsigned weight)
+{
+    const uint8x8_t weight0 = vdup_n_u8(quint8(WeightOne - weight));
+    const uint8x8_t weight1 = vdup_n_u8(quint8(weight));
+
+    unsigned i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const uint8x16_t a = vld1q_u8(row0 + i);
+        const uint8x16_t b = vld1q_u8(row1 + i);
+
+        const uint16x8_t low = vmlal_u8(vmull_u8(vget_low_u8(a), weight0), vget_low_u8(b), weight1);
+        const uint16x8_t high = vmlal_u8(vmull_u8(vget_high_u8(a), weight0), vget_high_u8(b), weight1);
+
+        vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(low, WeightBits), vrshrn_n_u16(high, WeightBits)));
+    }
+
+    verticalScalarFrom(row0, row1, dst, i, bytes, weight);
+}
+#endif // VLCQT_VIDEOSCALER_NEON
+
+Kernel kernel(VlcVideoScaler::Implementation implementation)
+{
+    Kernel k;
+    switch (implementation) {
+#ifdef VLCQT_VIDEOSCALER_NEON
+    case VlcVideoScaler::NEON:
+        k.horizontal = &horizontalNeon;
+        k.vertical = &verticalNeon;
+        return k;
+#endif
+#ifdef VLCQT_VIDEOSCALER_SSE2
+    case VlcVideoScaler::SSE2:
+        k.horizontal = &horizontalSse2;
+        k.vertical = &verticalSse2;
+        return k;
+#endif
+    default:
+        k.horizontal = &horizontalScalar;
+        k.vertical = &verticalScalar;
+        return k;
+    }
+}
+
+} // namespace
+
+VlcVideoScaler::VlcVideoScaler(Filter filter,
+                               Implementation implementation)
+    : _filter(filter),
+      _implementation(implementation),
+      _width(0),
+      _height(0),
+      _dstWidth(0),
+      _dstHeight(0)
+{
+    if (_implementation == Auto || !isSupported(_implementation))
+        _implementation = bestImplementation();
+
+    _cachedRows[0] = InvalidRow;
+    _cachedRows[1] = InvalidRow;
+}
+
+void VlcVideoScaler::setFilter(Filter filter)
+{
+    if (_filter == filter)
+        return;
+
+    _filter = filter;
+    _width = 0; // Rebuild tables on next scale
+}
+
+bool VlcVideoScaler::isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Auto:
+    case Scalar:
+        return true;
+#ifdef VLCQT_VIDEOSCALER_SSE2
+    case SSE2:
+        return true;
+#endif
+#ifdef VLCQT_VIDEOSCALER_NEON
+    case NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+VlcVideoScaler::Implementation VlcVideoScaler::bestImplementation()
+{
+    if (isSupported(NEON))
+        return NEON;
+    if (isSupported(SSE2))
+        return SSE2;
+    return Scalar;
+}
+
+void VlcVideoScaler::scale(const quint8 *src,
+                           unsigned srcPitch,
+                           unsigned width,
+                           unsigned height,
+                           quint8 *dst,
+                           unsigned dstPitch,
+                           unsigned dstWidth,
+                           unsigned dstHeight)
+{
+    if (!width || !height || !dstWidth || !dstHeight)
+        return;
+
+    updateTables(width, height, dstWidth, dstHeight);
+
+    // Source changes between calls, cached rows are only valid for one frame
+    _cachedRows[0] = InvalidRow;
+    _cachedRows[1] = InvalidRow;
+
+    const Kernel k = kernel(_implementation);
+    const size_t rowBytes = size_t(dstWidth) * 4;
+
+    for (unsigned y = 0; y < dstHeight; ++y) {
+        const unsigned index = tapIndex(_rows[y]);
+        const unsigned weight = tapWeight(_rows[y]);
+        quint8 *out = dst + size_t(y) * dstPitch;
+
+        const quint8 *row0 = cachedRow(src, srcPitch, index, weight ? index + 1 : index);
+        if (!weight) {
+            memcpy(out, row0, rowBytes);
+            continue;
+        }
+
+        const quint8 *row1 = cachedRow(src, srcPitch, index + 1, index);
+        k.vertical(row0, row1, out, unsigned(rowBytes), weight);
+    }
+}
+
+void VlcVideoScaler::updateTables(unsigned width,
+                                  unsigned height,
+                                  unsigned dstWidth,
+                                  unsigned dstHeight)
+{
+    if (width == _width && height == _height && dstWidth == _dstWidth && dstHeight == _dstHeight)
+        return;
+
+    buildTaps(_columns, width, dstWidth);
+    buildTaps(_rows, height, dstHeight);
+
+    // Rows selecting only the next sample are plain copies of it
+    for (size_t i = 0; i < _rows.size(); ++i) {
+        if (tapWeight(_rows[i]) == WeightOne)
+            _rows[i] = makeTap(tapIndex(_rows[i]) + 1, 0);
+    }
+
+    _rowCache[0].resize(size_t(dstWidth) * 4);
+    _rowCache[1].resize(size_t(dstWidth) * 4);
+
+    _width = width;
+    _height = height;
+    _dstWidth = dstWidth;
+    _dstHeight = dstHeight;
+}
+
+void VlcVideoScaler::buildTaps(std::vector<quint32> &taps,
+                               unsigned size,
+                               unsigned dstSize) const
+{
+    taps.resize(dstSize);
+
+    const quint64 scale = 2 * quint64(dstSize);
+    for (unsigned i = 0; i < dstSize; ++i) {
+        // Destination sample centre in source coordinates, in 1 / (2 * dstSize) units
+        const quint64 centre = (2 * quint64(i) + 1) * size;
+
+        if (_filter == Nearest || size < 2) {
+            taps[i] = makeTap(unsigned(centre / scale), 0);
+            continue;
+        }
+
+        // Position relative to source pixel centres
+        unsigned index = 0;
+        unsigned weight = 0;
+        if (centre > dstSize) {
+            const quint64 position = centre - dstSize;
+            index = unsigned(position / scale);
+            weight = _filter == Box && size > dstSize ? WeightOne / 2 : unsigned(((position % scale) * WeightOne + dstSize) / scale);
+            if (weight == WeightOne) {
+                ++index;
+                weight = 0;
+            }
+        }
+
+        // Both samples must be inside the source
+        if (index >= size - 1) {
+            index = size - 2;
+            weight = WeightOne;
+        }
+
+        taps[i] = makeTap(index, weight);
+    }
+}
+
+const quint8 *VlcVideoScaler::cachedRow(const quint8 *src,
+                                        unsigned srcPitch,
+                                        unsigned row,
+                                        unsigned keep)
+{
+    const quint8 *line = src + size_t(row) * srcPitch;
+    if (_width == _dstWidth)
+        return line;
+
+    if (_cachedRows[0] == row)
+        return &_rowCache[0][0];
+    if (_cachedRows[1] == row)
+        return &_rowCache[1][0];
+
+    const int slot = _cachedRows[0] == keep ? 1 : 0;
+    quint8 *out = &_rowCache[slot][0];
+    if (_filter == Nearest || _width < 2)
+        horizontalNearest(line, out, &_columns[0], _dstWidth);
+    else
+        kernel(_implementation).horizontal(line, out, &_columns[0], _dstWidth);
+
+    _cachedRows[slot] = row;
+    return out;
+}
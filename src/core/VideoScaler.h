@@ -0,0 +1,156 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_VIDEOSCALER_H_
+#define VLCQT_VIDEOSCALER_H_
+
+#include <vector>
+
+#include "SharedExportCore.h"
+
+/*!
+    \class VlcVideoScaler VideoScaler.h VLCQtCore/VideoScaler.h
+    \ingroup VLCQtCore
+    \brief 32-bit video frame scaler
+
+    VlcVideoScaler resizes frames with 4 bytes per pixel (BGRA, RGBA, ...).
+    Scaling is separable: every needed source row is scaled horizontally
+    once into a row cache using a precomputed column index and weight
+    table, destination rows are then blended from the cached rows.
+    Scalar, SSE2 and NEON kernels produce bit-identical output.
+
+    A scaler caches its tables between calls and is therefore
+    not safe to use from several threads at once.
+
+    \since VLC-Qt 1.2
+ */
+class VLCQT_CORE_EXPORT VlcVideoScaler
+{
+public:
+    /*!
+        \enum Filter
+        \brief Scaling filter
+     */
+    enum Filter {
+        Nearest,
+        Bilinear,
+        Box
+    };
+
+    /*!
+        \enum Implementation
+        \brief Scaling kernel implementation
+     */
+    enum Implementation {
+        Auto,
+        Scalar,
+        SSE2,
+        NEON
+    };
+
+    /*!
+        \brief VlcVideoScaler constructor
+        \param filter scaling filter
+        \param implementation scaling kernel, Auto selects the fastest supported one
+     */
+    explicit VlcVideoScaler(Filter filter = Bilinear,
+                            Implementation implementation = Auto);
+
+    /*!
+        \brief Get scaling filter
+        \return current scaling filter
+     */
+    Filter filter() const { return _filter; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Set scaling filter
+
+        When downscaling, Box filter averages two neighbouring pixels in
+        each direction, which is an exact area average for 2:1 downscaling.
+        It behaves as Bilinear otherwise.
+
+        \param filter new scaling filter
+     */
+    void setFilter(Filter filter);
+
+    /*!
+        \brief Get scaling kernel
+        \return kernel in use, never Auto
+     */
+    Implementation implementation() const { return _implementation; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Check if kernel can be used on this build and CPU
+        \param implementation kernel to check
+        \return true if supported
+     */
+    static bool isSupported(Implementation implementation);
+
+    /*!
+        \brief Get fastest kernel supported on this build and CPU
+        \return best implementation
+     */
+    static Implementation bestImplementation();
+
+    /*!
+        \brief Scale 32-bit frame
+        \param src source pixels
+        \param srcPitch source pitch in bytes
+        \param width source width
+        \param height source height
+        \param dst destination pixels
+        \param dstPitch destination pitch in bytes
+        \param dstWidth destination width
+        \param dstHeight destination height
+     */
+    void scale(const quint8 *src,
+               unsigned srcPitch,
+               unsigned width,
+               unsigned height,
+               quint8 *dst,
+               unsigned dstPitch,
+               unsigned dstWidth,
+               unsigned dstHeight);
+
+private:
+    void updateTables(unsigned width,
+                      unsigned height,
+                      unsigned dstWidth,
+                      unsigned dstHeight);
+    void buildTaps(std::vector<quint32> &taps,
+                   unsigned size,
+                   unsigned dstSize) const;
+    const quint8 *cachedRow(const quint8 *src,
+                            unsigned srcPitch,
+                            unsigned row,
+                            unsigned keep);
+
+    Filter _filter;
+    Implementation _implementation;
+
+    unsigned _width;
+    unsigned _height;
+    unsigned _dstWidth;
+    unsigned _dstHeight;
+    std::vector<quint32> _columns;
+    std::vector<quint32> _rows;
+    std::vector<quint8> _rowCache[2];
+    unsigned _cachedRows[2];
+};
+
+#endif // VLCQT_VIDEOSCALER_H_
@@ -19,15 +19,41 @@
 * along with this library. If not, see <http://www.gnu.org/licenses/>.
 *****************************************************************************/
 
-#include <functional>
+#include <algorithm>
+#include <cstring>
 
+#include "core/VideoFrameLayout.h"
 #include "core/VideoStream.h"
 #include "core/YUVVideoFrame.h"
 
+// Frames held by the render ring plus the ones libvlc keeps locked
+static const int PoolFrames = VlcFrameRing::Slots + 2;
+
+template <typename Frame, typename Layout>
+static unsigned negotiate(char *chroma,
+                          unsigned *width,
+                          unsigned *height,
+                          unsigned *pitches,
+                          unsigned *lines)
+{
+    qstrcpy(chroma, Layout::chroma());
+    return Frame::bufferSize(width, height, pitches, lines);
+}
+
 VlcVideoStream::VlcVideoStream(Vlc::RenderFormat format,
                                QObject *parent)
     : QObject(parent),
-      _format(format) {}
+      _format(format),
+      _player(0),
+      _width(0),
+      _height(0),
+      _frameStats(new VlcFrameStats(this)),
+      _sequence(0),
+      _presentTiming()
+{
+    memset(_pitches, 0, sizeof(_pitches));
+    memset(_lines, 0, sizeof(_lines));
+}
 
 VlcVideoStream::~VlcVideoStream()
 {
@@ -36,6 +62,18 @@ VlcVideoStream::~VlcVideoStream()
     }
 }
 
+QSize VlcVideoStream::maximumSize() const
+{
+    QMutexLocker locker(&_poolMutex);
+    return _maximumSize;
+}
+
+void VlcVideoStream::setMaximumSize(const QSize &size)
+{
+    QMutexLocker locker(&_poolMutex);
+    _maximumSize = size;
+}
+
 void VlcVideoStream::init(VlcMediaPlayer *player)
 {
     _player = player;
@@ -56,81 +94,207 @@ unsigned VlcVideoStream::formatCallback(char *chroma,
                                         unsigned *pitches,
                                         unsigned *lines)
 {
+    unsigned size = 0;
+
+    _poolMutex.lock();
+    const QSize maximum = _maximumSize;
+    _poolMutex.unlock();
+
+    // Fit into the limit, even sizes keep chroma subsampling exact
+    if (maximum.isValid() && (*width > unsigned(maximum.width()) || *height > unsigned(maximum.height()))) {
+        const QSize fitted = QSize(*width, *height).scaled(maximum, Qt::KeepAspectRatio);
+        *width = qMax(2, fitted.width() & ~1);
+        *height = qMax(2, fitted.height() & ~1);
+    }
+
     switch (_format) {
     case Vlc::YUVFormat:
-        qstrcpy(chroma, "I420");
-        _frames.emplace(_frames.end(), new VlcYUVVideoFrame(width, height, pitches, lines));
-        return 3;
+        size = negotiate<VlcYUVVideoFrame, VlcI420Layout>(chroma, width, height, pitches, lines);
+        break;
+    case Vlc::NV12Format:
+        size = negotiate<VlcNV12VideoFrame, VlcNV12Layout>(chroma, width, height, pitches, lines);
+        break;
+    case Vlc::RV32Format:
+        size = negotiate<VlcRV32VideoFrame, VlcRV32Layout>(chroma, width, height, pitches, lines);
+        break;
+    case Vlc::UYVYFormat:
+        size = negotiate<VlcUYVYVideoFrame, VlcUYVYLayout>(chroma, width, height, pitches, lines);
+        break;
+    }
+
+    if (!size)
+        return 0; // LCOV_EXCL_LINE
+
+    // Same geometry keeps the frames, same size keeps the memory
+    if (*width != _width || *height != _height
+        || memcmp(pitches, _pitches, sizeof(_pitches)) || memcmp(lines, _lines, sizeof(_lines))) {
+        _poolFrames.clear();
+        _width = *width;
+        _height = *height;
+        memcpy(_pitches, pitches, sizeof(_pitches));
+        memcpy(_lines, lines, sizeof(_lines));
+    }
+
+    QMutexLocker locker(&_poolMutex);
+    if (!_pool || _pool->bufferSize() != size) {
+        // Frames still held by the renderer keep the old pool alive
+        _pool = std::make_shared<VlcFramePool>();
+        _poolFrames.clear();
     }
+    _pool->reserve(size, PoolFrames);
+    locker.unlock();
 
-    return -1; // LCOV_EXCL_LINE
+    _lockedFrames.assign(_pool->capacity(), std::shared_ptr<VlcAbstractVideoFrame>());
+    _undisplayedFrames.clear();
+
+    return PoolFrames;
 }
 
 void VlcVideoStream::formatCleanUpCallback()
 {
-    _renderFrame.reset();
+    // Publish an empty frame so the renderer lets go of the old one
+    _renderFrames[_renderRing.writeSlot()].reset();
+    _renderRing.publish();
+    _renderFrames[_renderRing.writeSlot()].reset();
+
+    // Pool and frames stay for the next format of the same geometry
     _lockedFrames.clear();
-    _frames.clear();
+    _undisplayedFrames.clear();
 
     QMetaObject::invokeMethod(this, "frameUpdated");
 }
 
 void *VlcVideoStream::lockCallback(void **planes)
 {
-    auto frameIt = _frames.begin();
-    for (; frameIt != _frames.end() && frameIt->use_count() > 1; ++frameIt)
-        ;
+    // libVLC has at most PoolFrames pictures, with that many unlocked ones
+    // waiting for display the oldest was dropped without being displayed
+    while (_undisplayedFrames.size() >= size_t(PoolFrames)) {
+        _lockedFrames[_undisplayedFrames.front()].reset();
+        _undisplayedFrames.pop_front();
+    }
 
-    if (frameIt == _frames.end())
-        frameIt = _frames.emplace(_frames.end(), cloneFrame(_frames.front()));
+    const std::shared_ptr<VlcFramePool> pool = _pool;
+    const int index = pool->acquire();
+    if (index < 0) {
+        return 0; // LCOV_EXCL_LINE
+    }
+
+    if (size_t(index) >= _poolFrames.size()) {
+        // Pool grew
+        _poolFrames.resize(pool->capacity());
+        _lockedFrames.resize(_poolFrames.size());
+    }
+
+    std::shared_ptr<VlcAbstractVideoFrame> &frame = _poolFrames[index];
+    if (!frame)
+        frame = createFrame(pool->buffer(index));
 
-    std::shared_ptr<VlcAbstractVideoFrame> &frame = *frameIt;
     for (size_t i = 0; i < frame->planes.size(); i++) {
         planes[i] = frame->planes[i];
     }
 
-    _lockedFrames.emplace_back(frame);
+    frame->timing.start(++_sequence);
+
+    // The buffer returns to the pool when the last user lets go
+    std::shared_ptr<VlcAbstractVideoFrame> owner = frame;
+    _lockedFrames[index] = std::shared_ptr<VlcAbstractVideoFrame>(frame.get(), [pool, owner, index](VlcAbstractVideoFrame *) {
+        pool->release(index);
+    });
 
-    return reinterpret_cast<void *>(frameIt - _frames.begin());
+    return reinterpret_cast<void *>(size_t(index));
 }
 
 void VlcVideoStream::unlockCallback(void *picture, void *const *planes)
 {
     Q_UNUSED(planes)
 
-    auto frameNo = reinterpret_cast<decltype(_frames)::size_type>(picture);
-    if (frameNo >= _frames.size()) {
+    auto frameNo = reinterpret_cast<size_t>(picture);
+    if (frameNo >= _lockedFrames.size()) {
         return; // LCOV_EXCL_LINE
     }
 
-    std::shared_ptr<VlcAbstractVideoFrame> &frame = _frames[frameNo];
+    // libVLC 2.2 displays before it unlocks, the frame belongs to the renderer then
+    const std::shared_ptr<VlcAbstractVideoFrame> &frame = _lockedFrames[frameNo];
+    if (!frame)
+        return;
 
-    _lockedFrames.erase(std::find(_lockedFrames.begin(), _lockedFrames.end(), frame));
+    // libVLC 3.0 unlocks once decoded and displays later, keep the frame until then
+    frame->timing.unlock = VlcFrameTiming::now();
+    _undisplayedFrames.push_back(frameNo);
 }
 
 void VlcVideoStream::displayCallback(void *picture)
 {
-    auto frameNo = reinterpret_cast<decltype(_frames)::size_type>(picture);
-    if (frameNo >= _frames.size()) {
-        Q_ASSERT(false);
+    auto frameNo = reinterpret_cast<size_t>(picture);
+    if (frameNo >= _lockedFrames.size() || !_lockedFrames[frameNo]) {
         return; // LCOV_EXCL_LINE
     }
 
-    std::shared_ptr<VlcAbstractVideoFrame> &frame = _frames[frameNo];
+    std::shared_ptr<VlcAbstractVideoFrame> frame;
+    frame.swap(_lockedFrames[frameNo]);
+
+    const auto undisplayed = std::find(_undisplayedFrames.begin(), _undisplayedFrames.end(), frameNo);
+    if (undisplayed != _undisplayedFrames.end())
+        _undisplayedFrames.erase(undisplayed);
 
-    _renderFrame = frame;
+    frame->timing.display = VlcFrameTiming::now();
+    _frameStats->frameDelivered(frame->timing);
+
+    _renderFrames[_renderRing.writeSlot()] = frame;
+    if (_renderRing.publish())
+        _frameStats->frameDropped();
+
+    // Release a dropped frame right away so its buffer returns to the pool
+    _renderFrames[_renderRing.writeSlot()].reset();
 
     QMetaObject::invokeMethod(this, "frameUpdated");
 }
 
-std::shared_ptr<VlcAbstractVideoFrame> VlcVideoStream::cloneFrame(std::shared_ptr<VlcAbstractVideoFrame> frame)
+std::shared_ptr<const VlcAbstractVideoFrame> VlcVideoStream::acquireFrame()
+{
+    const bool newFrame = _renderRing.acquire();
+    const std::shared_ptr<VlcAbstractVideoFrame> &frame = _renderFrames[_renderRing.readSlot()];
+
+    // Only a frame seen for the first time is timed
+    if (newFrame && frame) {
+        _presentTiming = frame->timing;
+        _presentTiming.presentStart = VlcFrameTiming::now();
+    }
+
+    return frame;
+}
+
+void VlcVideoStream::framePresented()
+{
+    if (!_presentTiming.presentStart || _presentTiming.presentEnd)
+        return;
+
+    _presentTiming.presentEnd = VlcFrameTiming::now();
+    _frameStats->framePresented(_presentTiming);
+}
+
+VlcFramePool::Stats VlcVideoStream::poolStats() const
+{
+    QMutexLocker locker(&_poolMutex);
+    if (!_pool) {
+        VlcFramePool::Stats empty = { 0, 0, 0, 0 };
+        return empty;
+    }
+
+    return _pool->stats();
+}
+
+std::shared_ptr<VlcAbstractVideoFrame> VlcVideoStream::createFrame(char *buffer)
 {
     switch (_format) {
     case Vlc::YUVFormat:
-        std::shared_ptr<VlcYUVVideoFrame> from = std::dynamic_pointer_cast<VlcYUVVideoFrame>(frame);
-        if (from) {
-            return std::make_shared<VlcYUVVideoFrame>(from);
-        }
+        return std::make_shared<VlcYUVVideoFrame>(&_width, &_height, _pitches, _lines, buffer);
+    case Vlc::NV12Format:
+        return std::make_shared<VlcNV12VideoFrame>(&_width, &_height, _pitches, _lines, buffer);
+    case Vlc::RV32Format:
+        return std::make_shared<VlcRV32VideoFrame>(&_width, &_height, _pitches, _lines, buffer);
+    case Vlc::UYVYFormat:
+        return std::make_shared<VlcUYVYVideoFrame>(&_width, &_height, _pitches, _lines, buffer);
     }
 
     return 0; // LCOV_EXCL_LINE
@@ -23,14 +23,19 @@
 #define VLCQT_VIDEOSTREAM_H_
 
 #include <deque>
-#include <list>
 #include <memory>
+#include <vector>
 
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
+#include <QtCore/QSize>
 
 #include "AbstractVideoFrame.h"
 #include "AbstractVideoStream.h"
 #include "Enums.h"
+#include "FramePool.h"
+#include "FrameRing.h"
+#include "FrameStats.h"
 #include "SharedExportCore.h"
 
 class VlcMediaPlayer;
@@ -40,7 +45,7 @@ class VlcMediaPlayer;
     \ingroup VLCQtCore
     \brief Video memory stream
 
-    VlcVideoStream sets proper callbacks to get YUV frames from libVLC.
+    VlcVideoStream sets proper callbacks to get frames in the chosen Vlc::RenderFormat from libVLC.
     This class should be subclassed and implement frameUpdated to specify what to do with the frame.
 
     \see VlcQmlVideoStream
@@ -67,6 +72,25 @@ public:
      */
     Vlc::RenderFormat format() const { return _format; } // LCOV_EXCL_LINE
 
+    /*!
+        \brief Maximum frame size
+        \return maximum size, invalid if frames keep the video size
+        \since VLC-Qt 1.2
+     */
+    QSize maximumSize() const;
+
+    /*!
+        \brief Limit frame size
+
+        Larger video is scaled down by libVLC keeping its aspect ratio,
+        so small previews do not need full size frames. Applies from the
+        next format negotiation, set it before playback starts.
+
+        \param size maximum size, an invalid size removes the limit
+        \since VLC-Qt 1.2
+     */
+    void setMaximumSize(const QSize &size);
+
     /*!
         \brief Initialise video memory stream with player
         \param player media player
@@ -79,14 +103,45 @@ public:
     void deinit();
 
     /*!
-        \brief Get current frame
-        \return current frame
+        \brief Take the newest displayed frame
+
+        Advances the frame ring to the newest displayed frame, frames
+        displayed in between are dropped. The ring has a single consumer:
+        call only from one thread, normally from frameUpdated(). The
+        previous frame may be reused by the decoder once this returns.
+        Replaces the const renderFrame(), which advanced the ring as well.
+
+        \return newest frame, the previous one again if none was displayed since
+        \since VLC-Qt 1.2
      */
-    std::shared_ptr<const VlcAbstractVideoFrame> renderFrame() const { return _renderFrame; } // LCOV_EXCL_LINE
+    std::shared_ptr<const VlcAbstractVideoFrame> acquireFrame();
 
-private:
-    Q_INVOKABLE virtual void frameUpdated() = 0;
+    /*!
+        \brief Report the frame from acquireFrame() as presented
+
+        Call from the acquireFrame() thread once the frame is shown, so
+        presentation latency ends up in frameStats().
+
+        \since VLC-Qt 1.2
+     */
+    void framePresented();
 
+    /*!
+        \brief Get frame pipeline statistics
+        \return statistics object owned by the stream
+        \since VLC-Qt 1.2
+     */
+    VlcFrameStats *frameStats() const { return _frameStats; } // LCOV_EXCL_LINE
+
+    /*!
+        \brief Get frame pool statistics
+        \return statistics of the pool for the current video size
+        \since VLC-Qt 1.2
+     */
+    VlcFramePool::Stats poolStats() const;
+
+protected:
+    // libVLC callbacks, subclasses may drive them directly with synthetic frames
     unsigned formatCallback(char *chroma,
                             unsigned *width,
                             unsigned *height,
@@ -99,14 +154,42 @@ private:
                         void *const *planes);
     void displayCallback(void *picture);
 
-    std::shared_ptr<VlcAbstractVideoFrame> cloneFrame(std::shared_ptr<VlcAbstractVideoFrame> frame);
+private:
+    Q_INVOKABLE virtual void frameUpdated() = 0;
+
+    std::shared_ptr<VlcAbstractVideoFrame> createFrame(char *buffer);
 
     Vlc::RenderFormat _format;
     VlcMediaPlayer *_player;
 
-    std::deque<std::shared_ptr<VlcAbstractVideoFrame>> _frames;
-    std::list<std::shared_ptr<VlcAbstractVideoFrame>> _lockedFrames;
-    std::shared_ptr<VlcAbstractVideoFrame> _renderFrame;
+    // Read by the format callback, guarded by _poolMutex
+    QSize _maximumSize;
+
+    // Frame memory, replaced only when the buffer size changes
+    mutable QMutex _poolMutex;
+    std::shared_ptr<VlcFramePool> _pool;
+
+    // Current geometry, pool frames are kept while it does not change
+    unsigned _width;
+    unsigned _height;
+    unsigned _pitches[3];
+    unsigned _lines[3];
+
+    // Indexed by pool buffer, a locked frame is kept until it is displayed
+    std::vector<std::shared_ptr<VlcAbstractVideoFrame>> _poolFrames;
+    std::vector<std::shared_ptr<VlcAbstractVideoFrame>> _lockedFrames;
+
+    // Unlocked frames still waiting for display, oldest first
+    std::deque<size_t> _undisplayedFrames;
+
+    // Displayed frames handed to the renderer, a slot keeps its frame in use
+    VlcFrameRing _renderRing;
+    std::shared_ptr<VlcAbstractVideoFrame> _renderFrames[VlcFrameRing::Slots];
+
+    // Latency tracing, _presentTiming belongs to the acquireFrame() thread
+    VlcFrameStats *_frameStats;
+    quint64 _sequence;
+    VlcFrameTiming _presentTiming;
 };
 
 #endif // VLCQT_VIDEOSTREAM_H_
@@ -22,8 +22,8 @@
 #ifndef VLCQT_YUVVIDEOFRAME_H_
 #define VLCQT_YUVVIDEOFRAME_H_
 
-#include "AbstractVideoFrame.h"
 #include "SharedExportCore.h"
+#include "VideoFrameLayout.h"
 
 /*!
     \struct VlcYUVVideoFrame YUVVideoFrame.h VLCQtCore/YUVVideoFrame.h
@@ -31,7 +31,7 @@
     \brief Video YUV frame data container
     \since VLC-Qt 1.1
 */
-struct VLCQT_CORE_EXPORT VlcYUVVideoFrame : VlcAbstractVideoFrame {
+struct VLCQT_CORE_EXPORT VlcYUVVideoFrame : VlcLayoutVideoFrame<VlcI420Layout> {
     /*!
         \brief VlcVideoFrame constructor.
         This construction ensures data is set and containers prepared.
@@ -52,6 +52,23 @@ struct VLCQT_CORE_EXPORT VlcYUVVideoFrame : VlcAbstractVideoFrame {
     */
     VlcYUVVideoFrame(const std::shared_ptr<VlcYUVVideoFrame> &frame);
 
+    /*!
+        \brief VlcVideoFrame constructor.
+        This construction uses external memory, e.g. from VlcFramePool,
+        which must stay valid for the lifetime of the frame.
+        \param width
+        \param height
+        \param pitches
+        \param lines
+        \param buffer frame memory of at least bufferSize() bytes
+        \since VLC-Qt 1.2
+    */
+    VlcYUVVideoFrame(unsigned *width,
+                     unsigned *height,
+                     unsigned *pitches,
+                     unsigned *lines,
+                     char *buffer);
+
     ~VlcYUVVideoFrame();
 };
 
@@ -47,3 +47,8 @@ void VlcQmlSource::deregisterVideoOutput(VlcQmlVideoOutput *output)
 {
     _videoStream->deregisterVideoOutput(output);
 }
+
+VlcFrameStats *VlcQmlSource::frameStats() const
+{
+    return _videoStream->frameStats();
+}
@@ -22,6 +22,8 @@
 #include <QtCore/QObject>
 #include <QtQml/QQmlParserStatus>
 
+#include <VLCQtCore/FrameStats.h>
+
 #include "SharedExportQml.h"
 
 class VlcMediaPlayer;
@@ -47,6 +49,14 @@ class VLCQT_QML_EXPORT VlcQmlSource : public QObject,
 {
     Q_OBJECT
     Q_INTERFACES(QQmlParserStatus)
+
+    /*!
+        \brief Video pipeline statistics
+        \see frameStats
+        \since VLC-Qt 1.2
+     */
+    Q_PROPERTY(VlcFrameStats *frameStats READ frameStats CONSTANT)
+
 public:
     /*!
         \brief VlcQmlSource constructor
@@ -78,6 +88,16 @@ public:
      */
     virtual void deregisterVideoOutput(VlcQmlVideoOutput *output);
 
+    /*!
+        \brief Video pipeline statistics
+        \return latency and frame counters of the video stream
+
+        Used as property in QML.
+
+        \since VLC-Qt 1.2
+     */
+    VlcFrameStats *frameStats() const;
+
 private:
     // LCOV_EXCL_START
     void classBegin() override {}
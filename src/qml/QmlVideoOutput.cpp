@@ -24,9 +24,16 @@
 VlcQmlVideoOutput::VlcQmlVideoOutput()
     : _fillMode(Vlc::PreserveAspectFit),
       _source(0),
-      _frameUpdated(false)
+      _frameSource(0),
+      _frameGeneration(0),
+      _framePresentStart(0)
 {
     setFlag(QQuickItem::ItemHasContents, true);
+
+    _renderStats.frames = 0;
+    _renderStats.renders = 0;
+    _renderStats.uploads = 0;
+    _renderStats.dirtyMarks = 0;
 }
 
 VlcQmlVideoOutput::~VlcQmlVideoOutput()
@@ -106,6 +113,11 @@ void VlcQmlVideoOutput::setCropRatio(int cropRatio)
     emit cropRatioChanged();
 }
 
+VlcQmlVideoOutput::RenderStats VlcQmlVideoOutput::renderStats() const
+{
+    return _renderStats;
+}
+
 QSGNode *VlcQmlVideoOutput::updatePaintNode(QSGNode *oldNode,
                                             UpdatePaintNodeData *data)
 {
@@ -170,18 +182,33 @@ QSGNode *VlcQmlVideoOutput::updatePaintNode(QSGNode *oldNode,
         }
     }
 
-    if (_frameUpdated) {
-        node->setFrame(_frame);
-        _frameUpdated = false;
-    }
+    // Presentation ends when the render thread uploads the frame
+    node->setFrame(_frame, _frameSource, _frameGeneration,
+                   _source ? _source->frameStats() : 0, _framePresentStart);
     node->setRect(outRect, srcRect);
 
+    // The GUI thread is blocked while the scene graph synchronises
+    _renderStats.renders = node->videoMaterial().renders();
+    _renderStats.uploads = node->videoMaterial().uploads();
+    _renderStats.dirtyMarks = node->dirtyMarks();
+
     return node;
 }
 
 void VlcQmlVideoOutput::presentFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame)
+{
+    // Not shared, the output is its own stream
+    presentFrame(frame, this, _frameGeneration + 1);
+}
+
+void VlcQmlVideoOutput::presentFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame,
+                                     const void *stream,
+                                     quint64 generation)
 {
     _frame = frame;
-    _frameUpdated = true;
+    _frameSource = stream;
+    _frameGeneration = generation;
+    _framePresentStart = VlcFrameTiming::now();
+    _renderStats.frames++;
     update();
 }
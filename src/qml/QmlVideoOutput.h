@@ -77,6 +77,21 @@ class VLCQT_QML_EXPORT VlcQmlVideoOutput : public QQuickItem
     Q_PROPERTY(int cropRatio READ cropRatio WRITE setCropRatio NOTIFY cropRatioChanged)
 
 public:
+    /*!
+        \struct RenderStats
+        \brief Render counters of the video output
+
+        Counters other than frames restart when the video node is recreated.
+
+        \since VLC-Qt 1.2
+     */
+    struct RenderStats {
+        quint64 frames;     /*!< frames presented to the output */
+        quint64 renders;    /*!< render passes that drew the video */
+        quint64 uploads;    /*!< render passes that uploaded a new frame */
+        quint64 dirtyMarks; /*!< node updates for a new frame or geometry */
+    };
+
     VlcQmlVideoOutput();
     ~VlcQmlVideoOutput();
 
@@ -146,6 +161,13 @@ public:
      */
     void setCropRatio(int cropRatio);
 
+    /*!
+        \brief Render counters
+        \return counters as of the last scene graph synchronisation
+        \since VLC-Qt 1.2
+     */
+    RenderStats renderStats() const;
+
 public slots:
     /*!
         \brief Set frame which will be rendered in the output.
@@ -153,6 +175,22 @@ public slots:
      */
     void presentFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame);
 
+public:
+    /*!
+        \brief Set frame shared with other outputs of the same stream.
+
+        Outputs showing the same stream in one window upload each
+        generation once and sample the same textures.
+
+        \param frame
+        \param stream stream the frame comes from
+        \param generation frame number within the stream
+        \since VLC-Qt 1.2
+     */
+    void presentFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame,
+                      const void *stream,
+                      quint64 generation);
+
 signals:
     /*!
         \brief Source changed signal
@@ -184,8 +222,13 @@ private:
 
     QPointer<VlcQmlSource> _source;
 
-    bool _frameUpdated;
+    // Stream and frame number, the node uploads only new generations
+    const void *_frameSource;
+    quint64 _frameGeneration;
+    qint64 _framePresentStart;
     std::shared_ptr<const VlcYUVVideoFrame> _frame;
+
+    RenderStats _renderStats;
 };
 
 #endif // VLCQT_QMLVIDEOOUTPUT_H_
@@ -19,28 +19,38 @@
 * along with this library. If not, see <http://www.gnu.org/licenses/>.
 *****************************************************************************/
 
-#include <functional>
-
 #include "core/YUVVideoFrame.h"
 #include "qml/QmlVideoOutput.h"
 #include "qml/rendering/QmlVideoStream.h"
 
 VlcQmlVideoStream::VlcQmlVideoStream(QObject *parent)
-    : VlcVideoStream(Vlc::YUVFormat, parent) {}
+    : VlcVideoStream(Vlc::YUVFormat, parent),
+      _generation(0),
+      _sequence(0) {}
 
 VlcQmlVideoStream::~VlcQmlVideoStream() {}
 
 void VlcQmlVideoStream::frameUpdated()
 {
     // convert to shared pointer to const frame to avoid crash
-    std::shared_ptr<const VlcYUVVideoFrame> frame = std::dynamic_pointer_cast<const VlcYUVVideoFrame>(renderFrame());
+    std::shared_ptr<const VlcYUVVideoFrame> frame = std::dynamic_pointer_cast<const VlcYUVVideoFrame>(acquireFrame());
 
     if (!frame) {
         return; // LCOV_EXCL_LINE
     }
 
-    std::for_each(_attachedOutputs.begin(), _attachedOutputs.end(),
-                  std::bind2nd(std::mem_fun(&VlcQmlVideoOutput::presentFrame), frame));
+    // Queued updates after the newest frame get it again, it is
+    // neither uploaded nor presented twice
+    if (frame->timing.sequence == _sequence)
+        return;
+    _sequence = frame->timing.sequence;
+
+    // Outputs in the same window share one texture upload per generation
+    _generation++;
+    foreach (VlcQmlVideoOutput *output, _attachedOutputs)
+        output->presentFrame(frame, this, _generation);
+
+    // Presentation ends on the render thread, see VideoMaterial::bindPlanes()
 }
 
 void VlcQmlVideoStream::registerVideoOutput(VlcQmlVideoOutput *output)
@@ -42,6 +42,12 @@ private:
     Q_INVOKABLE virtual void frameUpdated();
 
     QList<VlcQmlVideoOutput *> _attachedOutputs;
+
+    // Frame number shared by all attached outputs
+    quint64 _generation;
+
+    // Stream sequence of the frame behind _generation
+    quint64 _sequence;
 };
 
 #endif // VLCQT_QMLRENDERING_QMLVIDEOSTREAM_H_
@@ -20,36 +20,26 @@
 * along with this library. If not, see <http://www.gnu.org/licenses/>.
 *****************************************************************************/
 
+#include "core/FrameStats.h"
 #include "core/YUVVideoFrame.h"
 
 #include "rendering/VideoMaterial.h"
 #include "rendering/VideoMaterialShader.h"
+#include "rendering/VideoTextures.h"
 
 VideoMaterial::VideoMaterial()
-    : _frame(0)
+    : _frame(0),
+      _source(0),
+      _generation(0),
+      _stats(0),
+      _timing(),
+      _renders(0),
+      _uploads(0)
 {
-    memset(_planeTexIds, 0, sizeof(_planeTexIds));
     setFlag(Blending, false);
-
-#if QT_VERSION < 0x050300
-#if defined(QT_OPENGL_ES_2)
-    _glF = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_ES2>();
-#else
-    _glF = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_1_3>();
-#endif
-    Q_ASSERT(_glF);
-
-    _glF->initializeOpenGLFunctions();
-#else
-    _glF = QOpenGLContext::currentContext()->functions();
-#endif
 }
 
-VideoMaterial::~VideoMaterial()
-{
-    if (_planeTexIds[0] || _planeTexIds[1] || _planeTexIds[2])
-        _glF->glDeleteTextures(3, _planeTexIds);
-}
+VideoMaterial::~VideoMaterial() {}
 
 QSGMaterialType *VideoMaterial::type() const
 {
@@ -65,59 +55,62 @@ QSGMaterialShader *VideoMaterial::createShader() const
 int VideoMaterial::compare(const QSGMaterial *other) const
 {
     const VideoMaterial *material = static_cast<const VideoMaterial *>(other);
-    const unsigned texCount = sizeof(_planeTexIds) / sizeof(_planeTexIds[0]);
 
-    for (unsigned i = 0; i < texCount; ++i) {
-        if (_planeTexIds[i] != material->_planeTexIds[i])
-            return _planeTexIds[i] - material->_planeTexIds[i];
-    }
+    // Sort by textures so shared ones bind once, but never report two
+    // materials as equal: each one still counts its own renders and ends
+    // its own frame's presentation in bindPlanes()
+    if (_textures != material->_textures)
+        return _textures < material->_textures ? -1 : 1;
+
+    if (this != material)
+        return this < material ? -1 : 1;
 
     return 0;
 }
 
-void VideoMaterial::setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame)
+bool VideoMaterial::setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame,
+                             const void *source,
+                             quint64 generation,
+                             VlcFrameStats *stats,
+                             qint64 presentStart)
 {
+    if (source == _source && generation == _generation)
+        return false;
+
+    if (source != _source)
+        _textures.reset();
+
     _frame = frame;
+    _source = source;
+    _generation = generation;
+
+    _stats = stats;
+    _timing = frame ? frame->timing : VlcFrameTiming();
+    _timing.presentStart = presentStart;
+    return true;
 }
 
 void VideoMaterial::bindPlanes()
 {
-    if (_planeTexIds[0] == 0 && _planeTexIds[1] == 0 && _planeTexIds[2] == 0)
-        _glF->glGenTextures(3, _planeTexIds);
+    _renders++;
+
+    if (!_textures)
+        _textures = VideoTextures::forSource(_source);
 
+    // Only a new frame is uploaded, re-renders just bind the textures
     std::shared_ptr<const VlcYUVVideoFrame> tmpFrame;
     _frame.swap(tmpFrame);
 
-    if (tmpFrame) {
-        Q_ASSERT((tmpFrame->width & 1) == 0 && (tmpFrame->height & 1) == 0); // width and height should be even
-        const quint16 tw = tmpFrame->width;
-        const quint16 th = tmpFrame->height;
-
-        bindPlane(GL_TEXTURE1, _planeTexIds[1], tmpFrame->planes[1], tw / 2, th / 2);
-        bindPlane(GL_TEXTURE2, _planeTexIds[2], tmpFrame->planes[2], tw / 2, th / 2);
-        bindPlane(GL_TEXTURE0, _planeTexIds[0], tmpFrame->planes[0], tw, th);
-    } else {
-        bindPlane(GL_TEXTURE1, _planeTexIds[1], 0, 0, 0);
-        bindPlane(GL_TEXTURE2, _planeTexIds[2], 0, 0, 0);
-        bindPlane(GL_TEXTURE0, _planeTexIds[0], 0, 0, 0);
-    }
-}
+    if (tmpFrame && _textures->update(tmpFrame.get(), _generation)) {
+        _uploads++;
 
-void VideoMaterial::bindPlane(GLenum texUnit,
-                              GLuint texId,
-                              const void *plane,
-                              quint16 width,
-                              quint16 height)
-{
-    _glF->glActiveTexture(texUnit);
-    _glF->glBindTexture(GL_TEXTURE_2D, texId);
-    if (plane) {
-        _glF->glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE,
-                           width, height, 0,
-                           GL_LUMINANCE, GL_UNSIGNED_BYTE, plane);
-        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // The frame is on the GPU, stamped here on the render thread
+        if (_stats && _timing.presentStart) {
+            _timing.presentEnd = VlcFrameTiming::now();
+            _stats->framePresented(_timing);
+        }
+        return; // planes are bound by the upload
     }
+
+    _textures->bind();
 }
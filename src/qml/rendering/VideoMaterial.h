@@ -26,17 +26,12 @@
 #include <memory>
 
 #include <QtQuick/QSGMaterial>
-#if QT_VERSION < 0x050300
-#if defined(QT_OPENGL_ES_2)
-#include <QtGui/QOpenGLFunctions_ES2>
-#else
-#include <QtGui/QOpenGLFunctions_1_3>
-#endif
-#else
-#include <QtGui/QOpenGLFunctions>
-#endif
 
+#include "core/FrameTiming.h"
+
+class VlcFrameStats;
 struct VlcYUVVideoFrame;
+class VideoTextures;
 
 class VideoMaterial : public QSGMaterial
 {
@@ -48,30 +43,32 @@ public:
     virtual QSGMaterialShader *createShader() const;
     virtual int compare(const QSGMaterial *other) const;
 
-    void setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame);
+    // Returns false if the generation is already set. Materials with the
+    // same source share textures, a generation is uploaded only once.
+    // The upload on the render thread ends the frame's presentation in stats.
+    bool setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame,
+                  const void *source,
+                  quint64 generation,
+                  VlcFrameStats *stats = 0,
+                  qint64 presentStart = 0);
 
     void bindPlanes();
 
-private:
-    void bindPlane(GLenum texUnit,
-                   GLuint texId,
-                   const void *plane,
-                   quint16 width,
-                   quint16 height);
+    // Render thread counters
+    quint64 renders() const { return _renders; }
+    quint64 uploads() const { return _uploads; }
 
 private:
-#if QT_VERSION < 0x050300
-#if defined(QT_OPENGL_ES_2)
-    QOpenGLFunctions_ES2 *_glF;
-#else
-    QOpenGLFunctions_1_3 *_glF;
-#endif
-#else
-    QOpenGLFunctions *_glF;
-#endif
-
     std::shared_ptr<const VlcYUVVideoFrame> _frame;
-    GLuint _planeTexIds[3];
+    const void *_source;
+    quint64 _generation;
+    std::shared_ptr<VideoTextures> _textures;
+
+    VlcFrameStats *_stats;
+    VlcFrameTiming _timing;
+
+    quint64 _renders;
+    quint64 _uploads;
 };
 
 #endif // VLCQT_QMLRENDERING_VIDEOMATERIAL_H_
@@ -23,6 +23,9 @@
 #include "rendering/VideoMaterial.h"
 #include "rendering/VideoMaterialShader.h"
 
+VideoMaterialShader::VideoMaterialShader()
+    : _constantsSet(false) {}
+
 char const *const *VideoMaterialShader::attributeNames() const
 {
     static const char *names[] = {
@@ -86,19 +89,22 @@ void VideoMaterialShader::updateState(const RenderState &state,
     if (state.isMatrixDirty())
         program()->setUniformValue(_positionMatrixId, state.combinedMatrix());
 
-    static const QMatrix4x4 colorMatrix(
-        1.164383561643836, 0.000000000000000, 1.792741071428571, -0.972945075016308,
-        1.164383561643836, -0.213248614273730, -0.532909328559444, 0.301482665475862,
-        1.164383561643836, 2.112401785714286, 0.000000000000000, -1.133402217873451,
-        0.000000000000000, 0.000000000000000, 0.000000000000000, 1.000000000000000);
+    if (!_constantsSet) {
+        static const QMatrix4x4 colorMatrix(
+            1.164383561643836, 0.000000000000000, 1.792741071428571, -0.972945075016308,
+            1.164383561643836, -0.213248614273730, -0.532909328559444, 0.301482665475862,
+            1.164383561643836, 2.112401785714286, 0.000000000000000, -1.133402217873451,
+            0.000000000000000, 0.000000000000000, 0.000000000000000, 1.000000000000000);
 
-    program()->setUniformValue(_colorMatrixId, colorMatrix);
+        program()->setUniformValue(_colorMatrixId, colorMatrix);
 
-    VideoMaterial *material = static_cast<VideoMaterial *>(newMaterial);
+        program()->setUniformValue(_texYId, 0);
+        program()->setUniformValue(_texUId, 1);
+        program()->setUniformValue(_texVId, 2);
 
-    program()->setUniformValue(_texYId, 0);
-    program()->setUniformValue(_texUId, 1);
-    program()->setUniformValue(_texVId, 2);
+        _constantsSet = true;
+    }
 
+    VideoMaterial *material = static_cast<VideoMaterial *>(newMaterial);
     material->bindPlanes();
 }
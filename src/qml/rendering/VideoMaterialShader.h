@@ -30,6 +30,8 @@
 class VideoMaterialShader : public QSGMaterialShader // LCOV_EXCL_LINE
 {
 public:
+    VideoMaterialShader();
+
     virtual char const *const *attributeNames() const;
     virtual const char *vertexShader() const;
     virtual const char *fragmentShader() const;
@@ -46,6 +48,9 @@ private:
     int _texYId;
     int _texUId;
     int _texVId;
+
+    // Colour matrix and samplers never change, set them once
+    bool _constantsSet;
 };
 
 #endif // VLCQT_QMLRENDERING_VIDEOMATERIALSHADER_H_
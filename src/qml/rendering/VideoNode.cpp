@@ -23,21 +23,36 @@
 #include "rendering/VideoNode.h"
 
 VideoNode::VideoNode()
-    : _geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4)
+    : _geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4),
+      _dirtyMarks(0)
 {
     setGeometry(&_geometry);
     setMaterial(&_material);
 }
 
-void VideoNode::setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame)
+void VideoNode::setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame,
+                         const void *source,
+                         quint64 generation,
+                         VlcFrameStats *stats,
+                         qint64 presentStart)
 {
-    _material.setFrame(frame);
+    if (!_material.setFrame(frame, source, generation, stats, presentStart))
+        return;
+
     markDirty(QSGNode::DirtyMaterial);
+    _dirtyMarks++;
 }
 
 void VideoNode::setRect(const QRectF &rect,
                         const QRectF &sourceRect)
 {
+    if (rect == _rect && sourceRect == _sourceRect)
+        return;
+
+    _rect = rect;
+    _sourceRect = sourceRect;
+
     QSGGeometry::updateTexturedRectGeometry(&_geometry, rect, sourceRect);
     markDirty(QSGNode::DirtyGeometry);
+    _dirtyMarks++;
 }
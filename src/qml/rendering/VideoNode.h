@@ -34,13 +34,26 @@ class VideoNode : public QSGGeometryNode // LCOV_EXCL_LINE
 public:
     VideoNode();
 
-    void setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame);
+    // Marks the node dirty only for a new frame generation or a new rect
+    void setFrame(const std::shared_ptr<const VlcYUVVideoFrame> &frame,
+                  const void *source,
+                  quint64 generation,
+                  VlcFrameStats *stats = 0,
+                  qint64 presentStart = 0);
     void setRect(const QRectF &rect,
                  const QRectF &sourceRect);
 
+    // Not material(), that would hide QSGGeometryNode::material()
+    const VideoMaterial &videoMaterial() const { return _material; }
+    quint64 dirtyMarks() const { return _dirtyMarks; }
+
 private:
     QSGGeometry _geometry;
     VideoMaterial _material;
+
+    QRectF _rect;
+    QRectF _sourceRect;
+    quint64 _dirtyMarks;
 };
 
 #endif // VLCQT_QMLRENDERING_VIDEONODE_H_
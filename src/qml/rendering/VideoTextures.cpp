@@ -0,0 +1,202 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+
+#include "core/YUVVideoFrame.h"
+
+#include "rendering/VideoTextures.h"
+
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+
+typedef QPair<QOpenGLContext *, const void *> TextureKey;
+
+// Render threads of different windows may look up at the same time
+static QMutex cacheMutex;
+static QHash<TextureKey, std::weak_ptr<VideoTextures>> cache;
+
+VideoTextures::VideoTextures()
+    : _generation(0),
+      _texWidth(0),
+      _texHeight(0),
+      _usePbo(false),
+      _pboIndex(0)
+{
+    memset(_pboIds, 0, sizeof(_pboIds));
+
+#if QT_VERSION < 0x050300
+#if defined(QT_OPENGL_ES_2)
+    _glF = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_ES2>();
+#else
+    _glF = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_1_3>();
+#endif
+    Q_ASSERT(_glF);
+
+    _glF->initializeOpenGLFunctions();
+#else
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    _glF = context->functions();
+
+    // Pixel unpack buffers need OpenGL 2.1 or OpenGL ES 3.0
+    const QPair<int, int> version = context->format().version();
+    if (context->isOpenGLES())
+        _usePbo = version.first >= 3;
+    else
+        _usePbo = version >= qMakePair(2, 1);
+#endif
+
+    _glF->glGenTextures(3, _planeTexIds);
+
+    // Parameters are part of the texture object, set them once
+    for (int i = 0; i < 3; ++i) {
+        _glF->glBindTexture(GL_TEXTURE_2D, _planeTexIds[i]);
+        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        _glF->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+#if QT_VERSION >= 0x050300
+    if (_usePbo)
+        _glF->glGenBuffers(PboCount, _pboIds);
+#endif
+}
+
+VideoTextures::~VideoTextures()
+{
+    _glF->glDeleteTextures(3, _planeTexIds);
+
+#if QT_VERSION >= 0x050300
+    if (_pboIds[0])
+        _glF->glDeleteBuffers(PboCount, _pboIds);
+#endif
+}
+
+std::shared_ptr<VideoTextures> VideoTextures::forSource(const void *source)
+{
+    const TextureKey key(QOpenGLContext::currentContext(), source);
+
+    QMutexLocker locker(&cacheMutex);
+
+    std::shared_ptr<VideoTextures> textures = cache.value(key).lock();
+    if (!textures) {
+        // Drop entries of sources nobody shows anymore
+        for (auto it = cache.begin(); it != cache.end();) {
+            if (it->expired())
+                it = cache.erase(it);
+            else
+                ++it;
+        }
+
+        textures = std::make_shared<VideoTextures>();
+        cache.insert(key, textures);
+    }
+
+    return textures;
+}
+
+bool VideoTextures::update(const VlcYUVVideoFrame *frame,
+                           quint64 generation)
+{
+    if (generation == _generation)
+        return false;
+
+    Q_ASSERT((frame->width & 1) == 0 && (frame->height & 1) == 0); // width and height should be even
+    if (frame->width != _texWidth || frame->height != _texHeight)
+        allocatePlanes(frame->width, frame->height);
+
+    const quint16 tw = frame->width;
+    const quint16 th = frame->height;
+    const char *planes[3] = {frame->planes[0], frame->planes[1], frame->planes[2]};
+
+#if QT_VERSION >= 0x050300
+    if (_usePbo) {
+        // Planes are contiguous, copy the whole frame into the next buffer
+        // and let the driver transfer it while the previous one is in use
+        const GLsizeiptr size = frame->planeSizes[0] + frame->planeSizes[1] + frame->planeSizes[2];
+
+        _glF->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pboIds[_pboIndex]);
+        _glF->glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW); // orphan
+        _glF->glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, frame->planes[0]);
+        _pboIndex = (_pboIndex + 1) % PboCount;
+
+        // Texture data now comes from offsets into the bound buffer
+        for (int i = 0; i < 3; ++i)
+            planes[i] = reinterpret_cast<const char *>(quintptr(frame->planes[i] - frame->planes[0]));
+    }
+#endif
+
+    uploadPlane(GL_TEXTURE1, _planeTexIds[1], planes[1], tw / 2, th / 2);
+    uploadPlane(GL_TEXTURE2, _planeTexIds[2], planes[2], tw / 2, th / 2);
+    uploadPlane(GL_TEXTURE0, _planeTexIds[0], planes[0], tw, th);
+
+#if QT_VERSION >= 0x050300
+    if (_usePbo)
+        _glF->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+
+    _generation = generation;
+    return true;
+}
+
+void VideoTextures::bind()
+{
+    bindPlane(GL_TEXTURE1, _planeTexIds[1]);
+    bindPlane(GL_TEXTURE2, _planeTexIds[2]);
+    bindPlane(GL_TEXTURE0, _planeTexIds[0]);
+}
+
+void VideoTextures::allocatePlanes(quint16 width,
+                                   quint16 height)
+{
+    const quint16 widths[3] = {width, quint16(width / 2), quint16(width / 2)};
+    const quint16 heights[3] = {height, quint16(height / 2), quint16(height / 2)};
+
+    for (int i = 0; i < 3; ++i) {
+        _glF->glBindTexture(GL_TEXTURE_2D, _planeTexIds[i]);
+        _glF->glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE,
+                           widths[i], heights[i], 0,
+                           GL_LUMINANCE, GL_UNSIGNED_BYTE, 0);
+    }
+
+    _texWidth = width;
+    _texHeight = height;
+}
+
+void VideoTextures::bindPlane(GLenum texUnit,
+                              GLuint texId)
+{
+    _glF->glActiveTexture(texUnit);
+    _glF->glBindTexture(GL_TEXTURE_2D, texId);
+}
+
+void VideoTextures::uploadPlane(GLenum texUnit,
+                                GLuint texId,
+                                const void *plane,
+                                quint16 width,
+                                quint16 height)
+{
+    bindPlane(texUnit, texId);
+    _glF->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                          width, height,
+                          GL_LUMINANCE, GL_UNSIGNED_BYTE, plane);
+}
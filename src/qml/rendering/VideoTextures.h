@@ -0,0 +1,94 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef VLCQT_QMLRENDERING_VIDEOTEXTURES_H_
+#define VLCQT_QMLRENDERING_VIDEOTEXTURES_H_
+
+#include <memory>
+
+#if QT_VERSION < 0x050300
+#if defined(QT_OPENGL_ES_2)
+#include <QtGui/QOpenGLFunctions_ES2>
+#else
+#include <QtGui/QOpenGLFunctions_1_3>
+#endif
+#else
+#include <QtGui/QOpenGLFunctions>
+#endif
+
+struct VlcYUVVideoFrame;
+
+// Plane textures of one video source in one GL context. Every material
+// showing the source shares them, so a frame is uploaded once no matter
+// how many outputs display it.
+class VideoTextures
+{
+public:
+    VideoTextures();
+    ~VideoTextures();
+
+    // Textures of a source in the current context, created on first use
+    static std::shared_ptr<VideoTextures> forSource(const void *source);
+
+    // Uploads the frame unless this generation is already uploaded,
+    // returns true if it was uploaded
+    bool update(const VlcYUVVideoFrame *frame,
+                quint64 generation);
+
+    // Binds the planes to texture units 0, 1 and 2
+    void bind();
+
+    GLuint textureId(int plane) const { return _planeTexIds[plane]; }
+
+private:
+    void allocatePlanes(quint16 width,
+                        quint16 height);
+    void bindPlane(GLenum texUnit,
+                   GLuint texId);
+    void uploadPlane(GLenum texUnit,
+                     GLuint texId,
+                     const void *plane,
+                     quint16 width,
+                     quint16 height);
+
+#if QT_VERSION < 0x050300
+#if defined(QT_OPENGL_ES_2)
+    QOpenGLFunctions_ES2 *_glF;
+#else
+    QOpenGLFunctions_1_3 *_glF;
+#endif
+#else
+    QOpenGLFunctions *_glF;
+#endif
+
+    GLuint _planeTexIds[3];
+    quint64 _generation;
+
+    // Size the texture storage was allocated for
+    quint16 _texWidth;
+    quint16 _texHeight;
+
+    // Pixel unpack buffers, filled in turn so an upload overlaps the
+    // previous frame still being transferred
+    static const int PboCount = 2;
+    bool _usePbo;
+    GLuint _pboIds[PboCount];
+    int _pboIndex;
+};
+
+#endif // VLCQT_QMLRENDERING_VIDEOTEXTURES_H_
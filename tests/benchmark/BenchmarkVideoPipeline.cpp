@@ -0,0 +1,582 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <new>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtTest/QtTest>
+
+#include "core/ColorConverter.h"
+#include "core/FrameRing.h"
+#include "core/VideoMemoryStream.h"
+#include "core/VideoScaler.h"
+#include "core/VideoStream.h"
+
+Q_DECLARE_METATYPE(Vlc::RenderFormat)
+
+/*
+    Drives the frame callbacks of the video streams and the webOS renderer
+    paths with synthetic frames, no libVLC decoding involved. Every row
+    reports throughput, CPU time and heap allocations per frame, and all
+    rows are written as JSON to $VLCQT_BENCHMARK_RESULTS or
+    BenchmarkVideoPipeline.json in the working directory.
+*/
+
+// Heap allocation counter, glibc lets the executable interpose malloc
+static std::atomic<quint64> allocations(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) __THROW
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) __THROW
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+// Elsewhere only C++ allocations are counted
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+namespace {
+
+// Frames run before measuring, fills the buffers and reaches steady state
+const int WarmupFrames = 16;
+// Each row runs at least this many frames and this long
+const int MinimumFrames = 30;
+const qint64 MinimumTimeNs = 300 * 1000 * 1000;
+
+// HP TouchPad panel, the webOS renderers scale to it
+const QSize Panel(1024, 768);
+
+struct Measurement {
+    qint64 frames;
+    qint64 wallNs;
+    qint64 cpuNs;
+    quint64 allocations;
+};
+
+Measurement measure(const std::function<void()> &frame)
+{
+    for (int i = 0; i < WarmupFrames; ++i)
+        frame();
+
+    Measurement result;
+    result.frames = 0;
+
+    QElapsedTimer timer;
+    const quint64 allocationsStart = allocations.load();
+    const std::clock_t cpuStart = std::clock();
+    timer.start();
+    do {
+        frame();
+        ++result.frames;
+    } while (result.frames < MinimumFrames || timer.nsecsElapsed() < MinimumTimeNs);
+
+    result.wallNs = timer.nsecsElapsed();
+    result.cpuNs = qint64(std::clock() - cpuStart) * 1000000000 / CLOCKS_PER_SEC;
+    result.allocations = allocations.load() - allocationsStart;
+    return result;
+}
+
+// Deterministic picture content so conversion does real work
+void fill(void *const *planes,
+          const unsigned *pitches,
+          const unsigned *lines,
+          int planeCount)
+{
+    for (int p = 0; p < planeCount; ++p) {
+        quint8 *plane = static_cast<quint8 *>(planes[p]);
+        for (unsigned y = 0; y < lines[p]; ++y) {
+            for (unsigned x = 0; x < pitches[p]; ++x)
+                plane[y * pitches[p] + x] = quint8(x * 3 + y * 7 + p * 50);
+        }
+    }
+}
+
+int planeCount(const char *chroma)
+{
+    if (!qstrcmp(chroma, "I420") || !qstrcmp(chroma, "YV12"))
+        return 3;
+    if (!qstrcmp(chroma, "NV12"))
+        return 2;
+    return 1;
+}
+
+QList<QPair<QString, QSize>> resolutions()
+{
+    return {
+        qMakePair(QString("480p"), QSize(854, 480)),
+        qMakePair(QString("720p"), QSize(1280, 720)),
+        qMakePair(QString("1080p"), QSize(1920, 1080))
+    };
+}
+
+QRect fitToPanel(const QSize &source)
+{
+    const QSize size = source.scaled(Panel, Qt::KeepAspectRatio);
+    return QRect(QPoint((Panel.width() - size.width()) / 2, (Panel.height() - size.height()) / 2), size);
+}
+
+// VlcVideoStream with a renderer that takes every displayed frame right away
+class SyntheticVideoStream : public VlcVideoStream
+{
+public:
+    explicit SyntheticVideoStream(Vlc::RenderFormat format)
+        : VlcVideoStream(format),
+          _planeCount(0),
+          _filled(0)
+    {
+        memset(_pitches, 0, sizeof(_pitches));
+        memset(_lines, 0, sizeof(_lines));
+    }
+
+    void setup(const QSize &size)
+    {
+        char chroma[5] = "I420";
+        unsigned width = size.width();
+        unsigned height = size.height();
+        formatCallback(chroma, &width, &height, _pitches, _lines);
+        _planeCount = planeCount(chroma);
+        _filled = 0;
+    }
+
+    void cleanup()
+    {
+        formatCleanUpCallback();
+    }
+
+    void frame()
+    {
+        void *planes[5] = { 0 };
+        void *picture = lockCallback(planes);
+        if (_filled < WarmupFrames) {
+            fill(planes, _pitches, _lines, _planeCount);
+            ++_filled;
+        }
+        // libVLC 3.0 unlocks once decoded and displays afterwards
+        unlockCallback(picture, planes);
+        displayCallback(picture);
+    }
+
+private:
+    void frameUpdated()
+    {
+        if (acquireFrame())
+            framePresented();
+    }
+
+    unsigned _pitches[5];
+    unsigned _lines[5];
+    int _planeCount;
+    int _filled;
+};
+
+// Single buffer YV12 stream the way deprecated VlcVideoMemoryStream users render
+class SyntheticMemoryStream : public VlcVideoMemoryStream
+{
+public:
+    void setup(const QSize &size)
+    {
+        char chroma[5] = "YV12";
+        unsigned width = size.width();
+        unsigned height = size.height();
+        const unsigned bufferSize = formatCallback(chroma, &width, &height, _pitches, _lines);
+        _buffer.fill(0, bufferSize);
+        _target = fitToPanel(size).size();
+        _image.fill(0, _target.width() * _target.height() * 4);
+
+        void *planes[5] = { 0 };
+        lockCallback(planes);
+        fill(planes, _pitches, _lines, 3);
+        unlockCallback(0, planes);
+    }
+
+    void frame()
+    {
+        void *planes[5] = { 0 };
+        void *picture = lockCallback(planes);
+        unlockCallback(picture, planes);
+        displayCallback(picture);
+
+        // Painter side, converts the shared buffer under the lock
+        QMutexLocker locker(&_mutex);
+        const quint8 *y = reinterpret_cast<const quint8 *>(_buffer.constData());
+        const quint8 *v = y + _pitches[0] * _lines[0];
+        const quint8 *u = v + _pitches[1] * _lines[1];
+        _converter.convertYV12ToBGRA(y, v, u, _pitches[0], _pitches[1], _width, _height,
+                                     reinterpret_cast<quint8 *>(_image.data()), _target.width() * 4,
+                                     _target.width(), _target.height());
+    }
+
+protected:
+    void *lockCallback(void **planes)
+    {
+        _mutex.lock();
+        char *buffer = _buffer.data();
+        for (int i = 0; i < 3; ++i) {
+            planes[i] = buffer;
+            buffer += _pitches[i] * _lines[i];
+        }
+        return 0;
+    }
+
+    void unlockCallback(void *picture,
+                        void *const *planes)
+    {
+        Q_UNUSED(picture)
+        Q_UNUSED(planes)
+        _mutex.unlock();
+    }
+
+    void displayCallback(void *picture)
+    {
+        Q_UNUSED(picture)
+    }
+
+    unsigned formatCallback(char *chroma,
+                            unsigned *width,
+                            unsigned *height,
+                            unsigned *pitches,
+                            unsigned *lines)
+    {
+        Q_UNUSED(chroma)
+        _width = *width;
+        _height = *height;
+
+        // 16 pixel aligned pitches, the buffer size is what libVLC gets back
+        pitches[0] = (_width + 15) & ~15u;
+        pitches[1] = pitches[2] = pitches[0] / 2;
+        lines[0] = (_height + 15) & ~15u;
+        lines[1] = lines[2] = lines[0] / 2;
+        return pitches[0] * lines[0] + 2 * pitches[1] * lines[1];
+    }
+
+    void formatCleanUpCallback() {}
+
+private:
+    QMutex _mutex;
+    QByteArray _buffer;
+    QByteArray _image;
+    QSize _target;
+    VlcColorConverter _converter;
+    unsigned _width;
+    unsigned _height;
+    unsigned _pitches[5];
+    unsigned _lines[5];
+};
+
+// The webOS widgets hand frames from their callbacks to the renderer through a ring
+class WebOSRenderer
+{
+public:
+    enum Path {
+        Framebuffer, // FBVideoWidget: I420, fused conversion and scaling into the page
+        Software,    // VideoWidget: RV32, filtered scaling into the widget image
+        GLES         // GLESVideoWidget: I420 planes handed to the GPU as they are
+    };
+
+    WebOSRenderer(Path path,
+                  const QSize &size)
+        : _path(path),
+          _size(size),
+          _target(fitToPanel(size)),
+          _page(Panel.width() * Panel.height() * 4, 0)
+    {
+        if (_path == Software) {
+            _pitches[0] = _size.width() * 4;
+            _lines[0] = _size.height();
+            _planeCount = 1;
+        } else {
+            _pitches[0] = (_size.width() + 7) & ~7u;
+            _pitches[1] = _pitches[2] = _pitches[0] / 2;
+            _lines[0] = _size.height();
+            _lines[1] = _lines[2] = _size.height() / 2;
+            _planeCount = 3;
+        }
+
+        unsigned bufferSize = 0;
+        for (int i = 0; i < _planeCount; ++i)
+            bufferSize += _pitches[i] * _lines[i];
+        for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+            _buffer[i].fill(0, bufferSize);
+            void *planes[3];
+            setPlanes(i, planes);
+            fill(planes, _pitches, _lines, _planeCount);
+        }
+    }
+
+    void frame()
+    {
+        // Decoder thread callbacks
+        void *planes[3];
+        setPlanes(_ring.writeSlot(), planes);
+        _ring.publish();
+
+        // Render thread
+        if (!_ring.acquire())
+            return;
+
+        setPlanes(_ring.readSlot(), planes);
+        const quint8 *const *src = reinterpret_cast<const quint8 *const *>(planes);
+        quint8 *dst = reinterpret_cast<quint8 *>(_page.data())
+                      + _target.y() * Panel.width() * 4 + _target.x() * 4;
+
+        switch (_path) {
+        case Framebuffer:
+            _converter.convertI420ToBGRA(src[0], src[1], src[2], _pitches[0], _pitches[1],
+                                         _size.width(), _size.height(),
+                                         dst, Panel.width() * 4, _target.width(), _target.height());
+            break;
+        case Software:
+            _scaler.scale(src[0], _pitches[0], _size.width(), _size.height(),
+                          dst, Panel.width() * 4, _target.width(), _target.height());
+            break;
+        case GLES:
+            // glTexSubImage2D reads the planes in place, there is no CPU work to time
+            break;
+        }
+    }
+
+private:
+    void setPlanes(int slot,
+                   void **planes)
+    {
+        char *buffer = _buffer[slot].data();
+        for (int i = 0; i < _planeCount; ++i) {
+            planes[i] = buffer;
+            buffer += _pitches[i] * _lines[i];
+        }
+    }
+
+    Path _path;
+    QSize _size;
+    QRect _target;
+    QByteArray _page;
+    QByteArray _buffer[VlcFrameRing::Slots];
+    VlcFrameRing _ring;
+    VlcColorConverter _converter;
+    VlcVideoScaler _scaler;
+    unsigned _pitches[3];
+    unsigned _lines[3];
+    int _planeCount;
+};
+
+} // namespace
+
+Q_DECLARE_METATYPE(WebOSRenderer::Path)
+
+class BenchmarkVideoPipeline : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanupTestCase();
+
+    void videoStream_data();
+    void videoStream();
+    void memoryStream_data();
+    void memoryStream();
+    void webOSRenderer_data();
+    void webOSRenderer();
+
+private:
+    void report(const QString &suite,
+                const QSize &size,
+                const QString &format,
+                const Measurement &measurement);
+
+    QJsonArray _results;
+};
+
+void BenchmarkVideoPipeline::report(const QString &suite,
+                                    const QSize &size,
+                                    const QString &format,
+                                    const Measurement &measurement)
+{
+    const qreal fps = measurement.frames * 1e9 / measurement.wallNs;
+    const qreal cpuUs = measurement.cpuNs / 1e3 / measurement.frames;
+    const qreal allocationsPerFrame = qreal(measurement.allocations) / measurement.frames;
+
+    QJsonObject result;
+    result.insert("suite", suite);
+    result.insert("format", format);
+    result.insert("width", size.width());
+    result.insert("height", size.height());
+    result.insert("frames", qreal(measurement.frames));
+    result.insert("fps", fps);
+    result.insert("wallUsPerFrame", measurement.wallNs / 1e3 / measurement.frames);
+    result.insert("cpuUsPerFrame", cpuUs);
+    result.insert("allocationsPerFrame", allocationsPerFrame);
+    _results.append(result);
+
+    qDebug("%s %s %dx%d: %.1f fps, %.1f us CPU/frame, %.2f allocations/frame",
+           qPrintable(suite), qPrintable(format), size.width(), size.height(),
+           fps, cpuUs, allocationsPerFrame);
+    QTest::setBenchmarkResult(fps, QTest::FramesPerSecond);
+}
+
+void BenchmarkVideoPipeline::cleanupTestCase()
+{
+    QString path = QString::fromLocal8Bit(qgetenv("VLCQT_BENCHMARK_RESULTS"));
+    if (path.isEmpty())
+        path = "BenchmarkVideoPipeline.json";
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Could not write benchmark results to %s", qPrintable(path));
+        return;
+    }
+
+    file.write(QJsonDocument(_results).toJson());
+    qDebug("Benchmark results written to %s", qPrintable(path));
+}
+
+void BenchmarkVideoPipeline::videoStream_data()
+{
+    QTest::addColumn<Vlc::RenderFormat>("format");
+    QTest::addColumn<QSize>("size");
+
+    const QList<QPair<QString, Vlc::RenderFormat>> formats = {
+        qMakePair(QString("I420"), Vlc::YUVFormat),
+        qMakePair(QString("NV12"), Vlc::NV12Format),
+        qMakePair(QString("RV32"), Vlc::RV32Format),
+        qMakePair(QString("UYVY"), Vlc::UYVYFormat)
+    };
+
+    const QList<QPair<QString, QSize>> sizes = resolutions();
+    for (int f = 0; f < formats.size(); ++f) {
+        for (int i = 0; i < sizes.size(); ++i) {
+            const QString name = QString("%1 %2").arg(formats[f].first, sizes[i].first);
+            QTest::newRow(name.toLatin1().constData()) << formats[f].second << sizes[i].second;
+        }
+    }
+}
+
+void BenchmarkVideoPipeline::videoStream()
+{
+    QFETCH(Vlc::RenderFormat, format);
+    QFETCH(QSize, size);
+
+    SyntheticVideoStream stream(format);
+    stream.setup(size);
+
+    const Measurement measurement = measure([&stream] { stream.frame(); });
+    stream.cleanup();
+
+    report("VlcVideoStream", size, QString(QTest::currentDataTag()).section(' ', 0, 0), measurement);
+}
+
+void BenchmarkVideoPipeline::memoryStream_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    const QList<QPair<QString, QSize>> sizes = resolutions();
+    for (int i = 0; i < sizes.size(); ++i) {
+        const QString name = QString("YV12 %1").arg(sizes[i].first);
+        QTest::newRow(name.toLatin1().constData()) << sizes[i].second;
+    }
+}
+
+void BenchmarkVideoPipeline::memoryStream()
+{
+    QFETCH(QSize, size);
+
+    SyntheticMemoryStream stream;
+    stream.setup(size);
+
+    report("VlcVideoMemoryStream", size, "YV12", measure([&stream] { stream.frame(); }));
+}
+
+void BenchmarkVideoPipeline::webOSRenderer_data()
+{
+    QTest::addColumn<WebOSRenderer::Path>("path");
+    QTest::addColumn<QSize>("size");
+
+    const QList<QPair<QString, WebOSRenderer::Path>> paths = {
+        qMakePair(QString("Framebuffer"), WebOSRenderer::Framebuffer),
+        qMakePair(QString("Software"), WebOSRenderer::Software),
+        qMakePair(QString("GLES"), WebOSRenderer::GLES)
+    };
+
+    const QList<QPair<QString, QSize>> sizes = resolutions();
+    for (int p = 0; p < paths.size(); ++p) {
+        for (int i = 0; i < sizes.size(); ++i) {
+            const QString name = QString("%1 %2").arg(paths[p].first, sizes[i].first);
+            QTest::newRow(name.toLatin1().constData()) << paths[p].second << sizes[i].second;
+        }
+    }
+}
+
+void BenchmarkVideoPipeline::webOSRenderer()
+{
+    QFETCH(WebOSRenderer::Path, path);
+    QFETCH(QSize, size);
+
+    WebOSRenderer renderer(path, size);
+    const QString name = QString(QTest::currentDataTag()).section(' ', 0, 0);
+
+    report("webOS " + name, size, path == WebOSRenderer::Software ? "RV32" : "I420",
+           measure([&renderer] { renderer.frame(); }));
+}
+
+QTEST_MAIN(BenchmarkVideoPipeline)
+#include "BenchmarkVideoPipeline.moc"
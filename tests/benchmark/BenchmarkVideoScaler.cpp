@@ -0,0 +1,99 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "core/VideoScaler.h"
+
+Q_DECLARE_METATYPE(VlcVideoScaler::Filter)
+Q_DECLARE_METATYPE(VlcVideoScaler::Implementation)
+
+class BenchmarkVideoScaler : public QObject
+{
+    Q_OBJECT
+private slots:
+    void scale_data();
+    void scale();
+};
+
+void BenchmarkVideoScaler::scale_data()
+{
+    QTest::addColumn<VlcVideoScaler::Implementation>("implementation");
+    QTest::addColumn<VlcVideoScaler::Filter>("filter");
+    QTest::addColumn<QSize>("source");
+    QTest::addColumn<QSize>("destination");
+
+    const QList<QPair<QString, VlcVideoScaler::Implementation>> implementations = {
+        qMakePair(QString("Scalar"), VlcVideoScaler::Scalar),
+        qMakePair(QString("SSE2"), VlcVideoScaler::SSE2),
+        qMakePair(QString("NEON"), VlcVideoScaler::NEON)
+    };
+    const QList<QPair<QString, VlcVideoScaler::Filter>> filters = {
+        qMakePair(QString("nearest"), VlcVideoScaler::Nearest),
+        qMakePair(QString("bilinear"), VlcVideoScaler::Bilinear),
+        qMakePair(QString("box"), VlcVideoScaler::Box)
+    };
+    // Typical webOS cases: reduced decode upscaled to the 1024x768 panel and 2:1 downscale
+    const QList<QPair<QSize, QSize>> sizes = {
+        qMakePair(QSize(320, 240), QSize(1024, 768)),
+        qMakePair(QSize(640, 360), QSize(1024, 576)),
+        qMakePair(QSize(1280, 720), QSize(640, 360))
+    };
+
+    for (int i = 0; i < implementations.size(); ++i) {
+        if (!VlcVideoScaler::isSupported(implementations[i].second))
+            continue;
+
+        for (int f = 0; f < filters.size(); ++f) {
+            for (int s = 0; s < sizes.size(); ++s) {
+                const QString name = QString("%1 %2 %3x%4->%5x%6")
+                                         .arg(implementations[i].first, filters[f].first)
+                                         .arg(sizes[s].first.width())
+                                         .arg(sizes[s].first.height())
+                                         .arg(sizes[s].second.width())
+                                         .arg(sizes[s].second.height());
+                QTest::newRow(name.toLatin1().constData())
+                    << implementations[i].second << filters[f].second << sizes[s].first << sizes[s].second;
+            }
+        }
+    }
+}
+
+void BenchmarkVideoScaler::scale()
+{
+    QFETCH(VlcVideoScaler::Implementation, implementation);
+    QFETCH(VlcVideoScaler::Filter, filter);
+    QFETCH(QSize, source);
+    QFETCH(QSize, destination);
+
+    QByteArray src(source.width() * source.height() * 4, 0);
+    for (int i = 0; i < src.size(); ++i)
+        src[i] = char(qrand() & 0xff);
+    QByteArray dst(destination.width() * destination.height() * 4, 0);
+
+    VlcVideoScaler scaler(filter, implementation);
+    QBENCHMARK {
+        scaler.scale(reinterpret_cast<const quint8 *>(src.constData()), source.width() * 4,
+                     source.width(), source.height(),
+                     reinterpret_cast<quint8 *>(dst.data()), destination.width() * 4,
+                     destination.width(), destination.height());
+    }
+}
+
+QTEST_MAIN(BenchmarkVideoScaler)
+#include "BenchmarkVideoScaler.moc"
@@ -0,0 +1,213 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "core/ColorConverter.h"
+
+Q_DECLARE_METATYPE(VlcColorConverter::ColorMatrix)
+Q_DECLARE_METATYPE(VlcColorConverter::ColorRange)
+Q_DECLARE_METATYPE(VlcColorConverter::Implementation)
+
+class TestColorConverter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void knownValues_data();
+    void knownValues();
+    void matchesScalar_data();
+    void matchesScalar();
+    void yv12();
+};
+
+namespace {
+
+struct Frame {
+    Frame(unsigned w, unsigned h)
+        : width(w),
+          height(h),
+          pitchY(w + 7),
+          pitchUV((w + 1) / 2 + 5),
+          y(pitchY * h, 0),
+          u(pitchUV * ((h + 1) / 2), 0),
+          v(pitchUV * ((h + 1) / 2), 0) {}
+
+    void randomize()
+    {
+        for (int i = 0; i < y.size(); ++i)
+            y[i] = char(qrand() & 0xff);
+        for (int i = 0; i < u.size(); ++i) {
+            u[i] = char(qrand() & 0xff);
+            v[i] = char(qrand() & 0xff);
+        }
+    }
+
+    const quint8 *planeY() const { return reinterpret_cast<const quint8 *>(y.constData()); }
+    const quint8 *planeU() const { return reinterpret_cast<const quint8 *>(u.constData()); }
+    const quint8 *planeV() const { return reinterpret_cast<const quint8 *>(v.constData()); }
+
+    unsigned width;
+    unsigned height;
+    unsigned pitchY;
+    unsigned pitchUV;
+    QByteArray y;
+    QByteArray u;
+    QByteArray v;
+};
+
+QByteArray convert(VlcColorConverter &converter,
+                   const Frame &frame,
+                   unsigned dstWidth,
+                   unsigned dstHeight)
+{
+    // Padded destination pitch, filled so untouched bytes are detected
+    const unsigned dstPitch = dstWidth * 4 + 12;
+    QByteArray dst(int(dstPitch * dstHeight), char(0x5a));
+    converter.convertI420ToBGRA(frame.planeY(), frame.planeU(), frame.planeV(),
+                                frame.pitchY, frame.pitchUV, frame.width, frame.height,
+                                reinterpret_cast<quint8 *>(dst.data()), dstPitch, dstWidth, dstHeight);
+    return dst;
+}
+
+} // namespace
+
+void TestColorConverter::knownValues_data()
+{
+    QTest::addColumn<VlcColorConverter::ColorMatrix>("matrix");
+    QTest::addColumn<VlcColorConverter::ColorRange>("range");
+    QTest::addColumn<int>("y");
+    QTest::addColumn<int>("u");
+    QTest::addColumn<int>("v");
+    QTest::addColumn<int>("red");
+    QTest::addColumn<int>("green");
+    QTest::addColumn<int>("blue");
+
+    QTest::newRow("601 black") << VlcColorConverter::BT601 << VlcColorConverter::LimitedRange << 16 << 128 << 128 << 0 << 0 << 0;
+    QTest::newRow("601 white") << VlcColorConverter::BT601 << VlcColorConverter::LimitedRange << 235 << 128 << 128 << 255 << 255 << 255;
+    QTest::newRow("601 red") << VlcColorConverter::BT601 << VlcColorConverter::LimitedRange << 81 << 90 << 240 << 255 << 0 << 0;
+    QTest::newRow("601 green") << VlcColorConverter::BT601 << VlcColorConverter::LimitedRange << 145 << 54 << 34 << 0 << 255 << 0;
+    QTest::newRow("601 blue") << VlcColorConverter::BT601 << VlcColorConverter::LimitedRange << 41 << 240 << 110 << 0 << 0 << 255;
+    QTest::newRow("709 red") << VlcColorConverter::BT709 << VlcColorConverter::LimitedRange << 63 << 102 << 240 << 255 << 0 << 0;
+    QTest::newRow("709 blue") << VlcColorConverter::BT709 << VlcColorConverter::LimitedRange << 32 << 240 << 118 << 0 << 0 << 255;
+    QTest::newRow("full black") << VlcColorConverter::BT601 << VlcColorConverter::FullRange << 0 << 128 << 128 << 0 << 0 << 0;
+    QTest::newRow("full white") << VlcColorConverter::BT601 << VlcColorConverter::FullRange << 255 << 128 << 128 << 255 << 255 << 255;
+}
+
+void TestColorConverter::knownValues()
+{
+    QFETCH(VlcColorConverter::ColorMatrix, matrix);
+    QFETCH(VlcColorConverter::ColorRange, range);
+    QFETCH(int, y);
+    QFETCH(int, u);
+    QFETCH(int, v);
+    QFETCH(int, red);
+    QFETCH(int, green);
+    QFETCH(int, blue);
+
+    Frame frame(2, 2);
+    frame.y.fill(char(y));
+    frame.u.fill(char(u));
+    frame.v.fill(char(v));
+
+    VlcColorConverter converter(matrix, range, VlcColorConverter::Scalar);
+    const QByteArray dst = convert(converter, frame, 2, 2);
+    const quint8 *pixel = reinterpret_cast<const quint8 *>(dst.constData());
+
+    QVERIFY(qAbs(int(pixel[0]) - blue) <= 2);
+    QVERIFY(qAbs(int(pixel[1]) - green) <= 2);
+    QVERIFY(qAbs(int(pixel[2]) - red) <= 2);
+    QCOMPARE(int(pixel[3]), 255);
+}
+
+void TestColorConverter::matchesScalar_data()
+{
+    QTest::addColumn<VlcColorConverter::Implementation>("implementation");
+    QTest::addColumn<VlcColorConverter::ColorMatrix>("matrix");
+    QTest::addColumn<VlcColorConverter::ColorRange>("range");
+
+    const QList<QPair<QString, VlcColorConverter::Implementation>> implementations = {
+        qMakePair(QString("Scalar"), VlcColorConverter::Scalar),
+        qMakePair(QString("SSE2"), VlcColorConverter::SSE2),
+        qMakePair(QString("AVX2"), VlcColorConverter::AVX2),
+        qMakePair(QString("NEON"), VlcColorConverter::NEON)
+    };
+
+    for (int i = 0; i < implementations.size(); ++i) {
+        if (!VlcColorConverter::isSupported(implementations[i].second))
+            continue;
+
+        const QByteArray name = implementations[i].first.toLatin1();
+        QTest::newRow((name + " 601 limited").constData()) << implementations[i].second << VlcColorConverter::BT601 << VlcColorConverter::LimitedRange;
+        QTest::newRow((name + " 709 limited").constData()) << implementations[i].second << VlcColorConverter::BT709 << VlcColorConverter::LimitedRange;
+        QTest::newRow((name + " 601 full").constData()) << implementations[i].second << VlcColorConverter::BT601 << VlcColorConverter::FullRange;
+        QTest::newRow((name + " 709 full").constData()) << implementations[i].second << VlcColorConverter::BT709 << VlcColorConverter::FullRange;
+    }
+}
+
+void TestColorConverter::matchesScalar()
+{
+    QFETCH(VlcColorConverter::Implementation, implementation);
+    QFETCH(VlcColorConverter::ColorMatrix, matrix);
+    QFETCH(VlcColorConverter::ColorRange, range);
+
+    VlcColorConverter reference(matrix, range, VlcColorConverter::Scalar);
+    VlcColorConverter converter(matrix, range, implementation);
+    QCOMPARE(converter.implementation(), implementation);
+
+    // Source size, destination size
+    const int sizes[][4] = {
+        { 64, 48, 64, 48 },
+        { 37, 21, 37, 21 },
+        { 16, 2, 16, 2 },
+        { 15, 3, 15, 3 },
+        { 320, 240, 100, 75 },
+        { 640, 360, 1024, 576 },
+        { 17, 9, 33, 19 },
+        { 1280, 720, 1024, 576 }
+    };
+
+    qsrand(1);
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        Frame frame(sizes[i][0], sizes[i][1]);
+        frame.randomize();
+
+        const QByteArray expected = convert(reference, frame, sizes[i][2], sizes[i][3]);
+        const QByteArray actual = convert(converter, frame, sizes[i][2], sizes[i][3]);
+        QVERIFY2(actual == expected, qPrintable(QString("%1x%2 -> %3x%4").arg(sizes[i][0]).arg(sizes[i][1]).arg(sizes[i][2]).arg(sizes[i][3])));
+    }
+}
+
+void TestColorConverter::yv12()
+{
+    qsrand(2);
+    Frame frame(48, 32);
+    frame.randomize();
+
+    VlcColorConverter converter;
+    const QByteArray i420 = convert(converter, frame, 48, 32);
+
+    QByteArray yv12(i420.size(), char(0x5a));
+    converter.convertYV12ToBGRA(frame.planeY(), frame.planeV(), frame.planeU(),
+                                frame.pitchY, frame.pitchUV, frame.width, frame.height,
+                                reinterpret_cast<quint8 *>(yv12.data()), 48 * 4 + 12, 48, 32);
+
+    QCOMPARE(yv12, i420);
+}
+
+QTEST_MAIN(TestColorConverter)
+#include "TestColorConverter.moc"
@@ -0,0 +1,101 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+#include <QtTest/QtTest>
+
+#include "core/FramePool.h"
+
+class TestFramePool : public QObject
+{
+    Q_OBJECT
+private slots:
+    void alignment();
+    void freeList();
+    void growth();
+    void reuse();
+};
+
+void TestFramePool::alignment()
+{
+    VlcFramePool pool;
+    QVERIFY(!pool.reserve(1001, 4));
+    QCOMPARE(pool.capacity(), 4);
+    QCOMPARE(pool.bufferSize(), size_t(1001));
+
+    for (int i = 0; i < pool.capacity(); ++i) {
+        QCOMPARE(quintptr(pool.buffer(i)) % VlcFramePool::Alignment, quintptr(0));
+    }
+    QVERIFY(pool.buffer(1) - pool.buffer(0) >= 1001);
+}
+
+void TestFramePool::freeList()
+{
+    VlcFramePool pool;
+    QCOMPARE(pool.acquire(), -1);
+
+    pool.reserve(64, 2);
+    const int first = pool.acquire();
+    const int second = pool.acquire();
+    QVERIFY(first != second);
+
+    // Last released is handed out next
+    pool.release(first);
+    QCOMPARE(pool.acquire(), first);
+
+    const VlcFramePool::Stats stats = pool.stats();
+    QCOMPARE(stats.hits, quint64(3));
+    QCOMPARE(stats.growths, quint64(0));
+    QCOMPARE(stats.peak, 2);
+}
+
+void TestFramePool::growth()
+{
+    VlcFramePool pool;
+    pool.reserve(128, 2);
+    pool.acquire();
+    pool.acquire();
+
+    const int third = pool.acquire();
+    QVERIFY(third >= 2);
+    QCOMPARE(pool.capacity(), 4);
+    QCOMPARE(quintptr(pool.buffer(third)) % VlcFramePool::Alignment, quintptr(0));
+
+    const VlcFramePool::Stats stats = pool.stats();
+    QCOMPARE(stats.growths, quint64(1));
+    QCOMPARE(stats.peak, 3);
+    QCOMPARE(stats.capacity, 4);
+}
+
+void TestFramePool::reuse()
+{
+    VlcFramePool pool;
+    pool.reserve(256, 2);
+    char *buffer = pool.buffer(0);
+
+    // Same size keeps the memory, more frames are added
+    QVERIFY(pool.reserve(256, 3));
+    QCOMPARE(pool.buffer(0), buffer);
+    QCOMPARE(pool.capacity(), 3);
+
+    // New size starts over
+    QVERIFY(!pool.reserve(512, 2));
+    QCOMPARE(pool.capacity(), 2);
+    QCOMPARE(pool.bufferSize(), size_t(512));
+}
+
+QTEST_MAIN(TestFramePool)
+#include "TestFramePool.moc"
@@ -0,0 +1,141 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "core/FrameRing.h"
+
+class TestFrameRing : public QObject
+{
+    Q_OBJECT
+private slots:
+    void empty();
+    void latestWins();
+    void slotsStayDistinct();
+    void threaded();
+};
+
+namespace {
+
+class Producer : public QThread
+{
+public:
+    Producer(VlcFrameRing *ring,
+             quint32 *frames,
+             quint32 count)
+        : _ring(ring),
+          _frames(frames),
+          _count(count) {}
+
+protected:
+    void run()
+    {
+        for (quint32 i = 1; i <= _count; ++i) {
+            _frames[_ring->writeSlot()] = i;
+            _ring->publish();
+        }
+    }
+
+private:
+    VlcFrameRing *_ring;
+    quint32 *_frames;
+    quint32 _count;
+};
+
+} // namespace
+
+void TestFrameRing::empty()
+{
+    VlcFrameRing ring;
+
+    QVERIFY(!ring.hasFrame());
+    QVERIFY(!ring.hasNewFrame());
+    QVERIFY(!ring.acquire());
+    QCOMPARE(ring.published(), 0);
+    QCOMPARE(ring.dropped(), 0);
+}
+
+void TestFrameRing::latestWins()
+{
+    VlcFrameRing ring;
+    int frames[VlcFrameRing::Slots] = { 0, 0, 0 };
+
+    for (int i = 1; i <= 3; ++i) {
+        frames[ring.writeSlot()] = i;
+        ring.publish();
+    }
+
+    QVERIFY(ring.hasNewFrame());
+    QVERIFY(ring.acquire());
+    QVERIFY(ring.hasFrame());
+    QCOMPARE(frames[ring.readSlot()], 3);
+    QCOMPARE(ring.published(), 3);
+    QCOMPARE(ring.dropped(), 2);
+
+    // Nothing new, the consumer keeps its frame
+    QVERIFY(!ring.acquire());
+    QCOMPARE(frames[ring.readSlot()], 3);
+
+    ring.reset();
+    QVERIFY(!ring.hasFrame());
+    QVERIFY(!ring.acquire());
+    QCOMPARE(ring.published(), 0);
+}
+
+void TestFrameRing::slotsStayDistinct()
+{
+    VlcFrameRing ring;
+
+    for (int i = 0; i < 20; ++i) {
+        QVERIFY(ring.writeSlot() != ring.readSlot());
+        QVERIFY(ring.writeSlot() >= 0 && ring.writeSlot() < VlcFrameRing::Slots);
+        ring.publish();
+        QVERIFY(ring.writeSlot() != ring.readSlot());
+        if (i % 3 == 0)
+            ring.acquire();
+    }
+}
+
+void TestFrameRing::threaded()
+{
+    VlcFrameRing ring;
+    quint32 frames[VlcFrameRing::Slots] = { 0, 0, 0 };
+    const quint32 count = 200000;
+
+    Producer producer(&ring, frames, count);
+    producer.start();
+
+    // Frames must arrive in order and never change while they are read
+    quint32 last = 0;
+    while (last < count) {
+        if (!ring.acquire())
+            continue;
+
+        const quint32 frame = frames[ring.readSlot()];
+        QVERIFY(frame > last);
+        QCOMPARE(frames[ring.readSlot()], frame);
+        last = frame;
+    }
+
+    QVERIFY(producer.wait());
+    QCOMPARE(ring.published(), int(count));
+    QVERIFY(ring.dropped() < int(count));
+}
+
+QTEST_MAIN(TestFrameRing)
+#include "TestFrameRing.moc"
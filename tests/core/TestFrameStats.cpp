@@ -0,0 +1,139 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "core/FrameStats.h"
+
+class TestFrameStats : public QObject
+{
+    Q_OBJECT
+private slots:
+    void empty();
+    void counters();
+    void percentiles();
+    void unlockAfterDisplay();
+    void reset();
+};
+
+namespace {
+
+VlcFrameTiming frame(qint64 decode,
+                     qint64 queue,
+                     qint64 present)
+{
+    VlcFrameTiming timing;
+    timing.sequence = 1;
+    timing.lock = 1000;
+    timing.unlock = timing.lock + decode;
+    timing.display = timing.unlock;
+    timing.presentStart = timing.display + queue;
+    timing.presentEnd = timing.presentStart + present;
+    return timing;
+}
+
+} // namespace
+
+void TestFrameStats::empty()
+{
+    VlcFrameStats stats;
+
+    QCOMPARE(stats.delivered(), 0);
+    QCOMPARE(stats.presented(), 0);
+    QCOMPARE(stats.dropped(), 0);
+    QCOMPARE(stats.percentile(VlcFrameStats::TotalStage, 50), 0);
+}
+
+void TestFrameStats::counters()
+{
+    VlcFrameStats stats;
+
+    for (int i = 0; i < 10; ++i)
+        stats.frameDelivered(frame(100, 10, 10));
+    for (int i = 0; i < 7; ++i)
+        stats.framePresented(frame(100, 10, 10));
+    for (int i = 0; i < 3; ++i)
+        stats.frameDropped();
+
+    QCOMPARE(stats.delivered(), 10);
+    QCOMPARE(stats.presented(), 7);
+    QCOMPARE(stats.dropped(), 3);
+}
+
+void TestFrameStats::percentiles()
+{
+    VlcFrameStats stats;
+
+    // 90 fast frames and 10 slow ones
+    for (int i = 0; i < 90; ++i) {
+        stats.frameDelivered(frame(1000, 200, 50));
+        stats.framePresented(frame(1000, 200, 50));
+    }
+    for (int i = 0; i < 10; ++i) {
+        stats.frameDelivered(frame(20000, 200, 50));
+        stats.framePresented(frame(20000, 200, 50));
+    }
+
+    // Upper bucket bound, at most a quarter octave above the value
+    const int p50 = stats.percentile(VlcFrameStats::DecodeStage, 50);
+    QVERIFY(p50 > 1000 && p50 <= 1190);
+    const int p99 = stats.percentile(VlcFrameStats::DecodeStage, 99);
+    QVERIFY(p99 > 20000 && p99 <= 23800);
+
+    const int queue = stats.percentile(VlcFrameStats::QueueStage, 50);
+    QVERIFY(queue > 200 && queue <= 238);
+    const int present = stats.percentile(VlcFrameStats::PresentStage, 95);
+    QVERIFY(present > 50 && present <= 60);
+
+    const int total = stats.percentile(VlcFrameStats::TotalStage, 50);
+    QVERIFY(total > 1250 && total <= 1488);
+}
+
+void TestFrameStats::unlockAfterDisplay()
+{
+    VlcFrameStats stats;
+
+    // Decoding ends at display when libVLC unlocks later
+    VlcFrameTiming timing = frame(0, 0, 0);
+    timing.unlock = 0;
+    timing.display = timing.lock + 500;
+    stats.frameDelivered(timing);
+
+    const int decode = stats.percentile(VlcFrameStats::DecodeStage, 50);
+    QVERIFY(decode > 500 && decode <= 595);
+}
+
+void TestFrameStats::reset()
+{
+    VlcFrameStats stats;
+    QSignalSpy spy(&stats, SIGNAL(updated()));
+
+    stats.frameDelivered(frame(100, 10, 10));
+    stats.framePresented(frame(100, 10, 10));
+    stats.frameDropped();
+    stats.reset();
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(stats.delivered(), 0);
+    QCOMPARE(stats.presented(), 0);
+    QCOMPARE(stats.dropped(), 0);
+    QCOMPARE(stats.percentile(VlcFrameStats::DecodeStage, 50), 0);
+}
+
+QTEST_MAIN(TestFrameStats)
+#include "TestFrameStats.moc"
@@ -22,14 +22,20 @@
 #include "TestsCommon.h"
 
 #include "core/Media.h"
+#include "core/MetaLoader.h"
 #include "core/MetaManager.h"
+#include "core/MetaSnapshot.h"
+#include "core/MetaTransaction.h"
 
 class TestMetaManager : public TestsCommon
 {
     Q_OBJECT
 private slots:
     void reading();
+    void snapshot();
+    void loader();
     void writing();
+    void transaction();
     void reset();
 };
 
@@ -56,6 +62,61 @@ void TestMetaManager::reading()
     delete media;
 }
 
+void TestMetaManager::snapshot()
+{
+    VlcMedia *media = new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, _instance);
+    VlcMetaManager *meta = new VlcMetaManager(media);
+
+    VlcMetaSnapshot snapshot = meta->snapshot();
+    QVERIFY(snapshot.isValid());
+    QVERIFY(!VlcMetaSnapshot().isValid());
+
+    QCOMPARE(snapshot.title(), meta->title());
+    QCOMPARE(snapshot.artist(), meta->artist());
+    QCOMPARE(snapshot.album(), meta->album());
+    QCOMPARE(snapshot.number(), meta->number());
+    QCOMPARE(snapshot.year(), meta->year());
+    QCOMPARE(snapshot.value(Vlc::Publisher), meta->publisher());
+
+    // Snapshot does not follow later edits
+    meta->setTitle("TitleTest");
+    QCOMPARE(snapshot.title(), QString("Noise"));
+
+    delete meta;
+    delete media;
+
+    // and outlives its media
+    QCOMPARE(snapshot.encoder(), QString("Encoder"));
+}
+
+void TestMetaManager::loader()
+{
+    VlcMetaLoader loader;
+    QSignalSpy loaded(&loader, SIGNAL(loaded(VlcMedia *, VlcMetaSnapshot)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+
+    QList<VlcMedia *> medias;
+    for (int i = 0; i < 4; ++i) {
+        medias << new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, _instance);
+        loader.load(medias.last());
+    }
+    QCOMPARE(loader.pending(), 4);
+
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(loaded.count(), 4);
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(loader.pending(), 0);
+
+    for (int i = 0; i < loaded.count(); ++i) {
+        QVERIFY(medias.contains(loaded.at(i).at(0).value<VlcMedia *>()));
+        VlcMetaSnapshot meta = loaded.at(i).at(1).value<VlcMetaSnapshot>();
+        QCOMPARE(meta.title(), QString("Noise"));
+        QCOMPARE(meta.year(), 2016);
+    }
+
+    qDeleteAll(medias);
+}
+
 void TestMetaManager::writing()
 {
     VlcMedia *media = new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, _instance);
@@ -109,6 +170,55 @@ void TestMetaManager::writing()
     delete media;
 }
 
+void TestMetaManager::transaction()
+{
+    // A copy of the untouched sample, independent of writing()
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + "/sample.mp3";
+    QVERIFY(QFile::copy(QString(SAMPLES_DIR) + "sample.mp3", path));
+    QVERIFY(QFile::setPermissions(path, QFile::permissions(path) | QFile::WriteOwner));
+
+    VlcMedia *media = new VlcMedia(path, true, _instance);
+    VlcMetaManager *meta = new VlcMetaManager(media);
+
+    VlcMetaTransaction transaction(media);
+    QVERIFY(transaction.isEmpty());
+    QVERIFY(transaction.commit());
+
+    transaction.set(Vlc::Title, "Dropped");
+    transaction.rollback();
+    QVERIFY(transaction.isEmpty());
+
+    transaction.set(Vlc::Title, "First");
+    transaction.set(Vlc::Title, "TransactionTest");
+    transaction.set(Vlc::Album, "AlbumTransaction");
+    transaction.setNumber(7);
+    transaction.setYear(2001);
+
+    // Nothing is applied before commit
+    QCOMPARE(meta->title(), QString("Noise"));
+
+    QVERIFY(transaction.commit());
+    QVERIFY(transaction.isEmpty());
+
+    delete meta;
+    delete media;
+
+    media = new VlcMedia(path, true, _instance);
+    meta = new VlcMetaManager(media);
+
+    VlcMetaSnapshot snapshot = meta->snapshot();
+    QCOMPARE(snapshot.title(), QString("TransactionTest"));
+    QCOMPARE(snapshot.album(), QString("AlbumTransaction"));
+    QCOMPARE(snapshot.number(), 7);
+    QCOMPARE(snapshot.year(), 2001);
+    QCOMPARE(snapshot.artist(), QString("Toine Heuvelmans"));
+
+    delete meta;
+    delete media;
+}
+
 void TestMetaManager::reset()
 {
     VlcMedia *media = new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, _instance);
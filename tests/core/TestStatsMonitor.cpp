@@ -0,0 +1,169 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <cstring>
+
+#include <QtTest/QtTest>
+
+#include "TestsConfig.h"
+#include "TestsCommon.h"
+
+#include "core/Audio.h"
+#include "core/Common.h"
+#include "core/Instance.h"
+#include "core/Media.h"
+#include "core/MediaPlayer.h"
+#include "core/StatsMonitor.h"
+
+class TestStatsMonitor : public TestsCommon
+{
+    Q_OBJECT
+private slots:
+    void rates();
+    void noTime();
+    void countersReset();
+    void sampling();
+    void restart();
+};
+
+namespace {
+
+VlcStatsMonitor::Sample sample(qint64 time,
+                               int decoded,
+                               int displayed,
+                               int lost,
+                               int demuxBytes,
+                               int lostAudio)
+{
+    VlcStatsMonitor::Sample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.time = time;
+    sample.stats.valid = true;
+    sample.stats.decoded_video = decoded;
+    sample.stats.displayed_pictures = displayed;
+    sample.stats.lost_pictures = lost;
+    sample.stats.demux_read_bytes = demuxBytes;
+    sample.stats.lost_abuffers = lostAudio;
+    return sample;
+}
+
+} // namespace
+
+void TestStatsMonitor::rates()
+{
+    // Two seconds of 25 fps with one lost picture in ten
+    const VlcStatsMonitor::Rates rates = VlcStatsMonitor::rates(sample(1000, 100, 90, 10, 1000000, 2),
+                                                                sample(3000, 150, 135, 15, 1500000, 5));
+
+    QCOMPARE(rates.decodeFps, 25.);
+    QCOMPARE(rates.displayFps, 22.5);
+    QCOMPARE(rates.lostPictureRate, 0.1);
+    QCOMPARE(rates.demuxBitrate, 2000.);
+    QCOMPARE(rates.audioUnderruns, 3);
+}
+
+void TestStatsMonitor::noTime()
+{
+    const VlcStatsMonitor::Rates rates = VlcStatsMonitor::rates(sample(1000, 100, 90, 10, 1000000, 2),
+                                                                sample(1000, 150, 135, 15, 1500000, 5));
+
+    QCOMPARE(rates.decodeFps, 0.);
+    QCOMPARE(rates.displayFps, 0.);
+    QCOMPARE(rates.audioUnderruns, 0);
+}
+
+void TestStatsMonitor::countersReset()
+{
+    // A new input restarts the counters
+    const VlcStatsMonitor::Rates rates = VlcStatsMonitor::rates(sample(1000, 100, 90, 10, 1000000, 2),
+                                                                sample(2000, 20, 20, 0, 50000, 0));
+
+    QCOMPARE(rates.decodeFps, 0.);
+    QCOMPARE(rates.displayFps, 0.);
+    QCOMPARE(rates.lostPictureRate, 0.);
+    QCOMPARE(rates.demuxBitrate, 0.);
+    QCOMPARE(rates.audioUnderruns, 0);
+}
+
+void TestStatsMonitor::sampling()
+{
+    VlcInstance *instance = new VlcInstance(VlcCommon::statsArgs() << "--aout=adummy", this);
+    VlcMediaPlayer *player = new VlcMediaPlayer(instance);
+    player->audio()->setVolume(0);
+
+    VlcStatsMonitor *monitor = new VlcStatsMonitor(player);
+    QSignalSpy changed(monitor, SIGNAL(statsChanged()));
+    monitor->setInterval(100);
+    monitor->start();
+    QVERIFY(monitor->isActive());
+
+    // Opened after start(), counters run from the beginning
+    VlcMedia *media = new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, instance);
+    player->open(media);
+
+    QTRY_VERIFY_WITH_TIMEOUT(monitor->sampleCount() >= 2 && monitor->demuxBitrate() > 0, 10000);
+    QVERIFY(changed.count() > 0);
+    QVERIFY(monitor->sample().stats.demux_read_bytes > 0);
+    QVERIFY(monitor->sample().stats.decoded_audio > 0);
+    QVERIFY(monitor->sample().time > monitor->sample(1).time);
+
+    monitor->stop();
+    QVERIFY(!monitor->isActive());
+    const int count = monitor->sampleCount();
+    QTest::qWait(300);
+    QCOMPARE(monitor->sampleCount(), count);
+
+    player->stop();
+    delete monitor;
+    delete player;
+    delete media;
+    delete instance;
+}
+
+void TestStatsMonitor::restart()
+{
+    VlcInstance *instance = new VlcInstance(VlcCommon::statsArgs() << "--aout=adummy", this);
+    VlcMediaPlayer *player = new VlcMediaPlayer(instance);
+    player->audio()->setVolume(0);
+
+    VlcStatsMonitor *monitor = new VlcStatsMonitor(player);
+    monitor->setInterval(100);
+    monitor->start();
+
+    VlcMedia *first = new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, instance);
+    player->open(first);
+    QTRY_VERIFY_WITH_TIMEOUT(monitor->sampleCount() >= 3, 10000);
+
+    // A new input drops the samples of the old one and counts again,
+    // a longer interval keeps the single sample around to be seen
+    monitor->setInterval(1000);
+    VlcMedia *second = new VlcMedia(QString(SAMPLES_DIR) + "sample.mp3", true, instance);
+    player->open(second);
+    QTRY_COMPARE_WITH_TIMEOUT(monitor->sampleCount(), 1, 5000);
+    QTRY_VERIFY_WITH_TIMEOUT(monitor->sampleCount() >= 2 && monitor->sample().stats.demux_read_bytes > 0, 5000);
+
+    player->stop();
+    delete monitor;
+    delete player;
+    delete first;
+    delete second;
+    delete instance;
+}
+
+QTEST_MAIN(TestStatsMonitor)
+#include "TestStatsMonitor.moc"
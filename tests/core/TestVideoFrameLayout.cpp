@@ -0,0 +1,95 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+#include <QtTest/QtTest>
+
+#include "core/VideoFrameLayout.h"
+#include "core/YUVVideoFrame.h"
+
+class TestVideoFrameLayout : public QObject
+{
+    Q_OBJECT
+private slots:
+    void i420();
+    void nv12();
+    void rv32();
+    void uyvy();
+    void externalBuffer();
+};
+
+void TestVideoFrameLayout::i420()
+{
+    unsigned width = 641, height = 361;
+    unsigned pitches[3], lines[3];
+
+    VlcYUVVideoFrame frame(&width, &height, pitches, lines);
+    QCOMPARE(frame.width, quint16(642));
+    QCOMPARE(frame.height, quint16(362));
+    QCOMPARE(pitches[0], 644u);
+    QCOMPARE(pitches[1], 324u);
+    QCOMPARE(pitches[2], 324u);
+    QCOMPARE(lines[0], 362u);
+    QCOMPARE(lines[1], 181u);
+    QCOMPARE(frame.frameBuffer.size(), int(644 * 362 + 2 * 324 * 181));
+    QCOMPARE(frame.planes[2], frame.planes[1] + 324 * 181);
+}
+
+void TestVideoFrameLayout::nv12()
+{
+    unsigned width = 640, height = 360;
+    unsigned pitches[2], lines[2];
+
+    QCOMPARE(VlcNV12VideoFrame::bufferSize(&width, &height, pitches, lines), 640u * 360 * 3 / 2);
+    QCOMPARE(pitches[1], 640u);
+    QCOMPARE(lines[1], 180u);
+}
+
+void TestVideoFrameLayout::rv32()
+{
+    unsigned width = 641, height = 361;
+    unsigned pitches[1], lines[1];
+
+    VlcRV32VideoFrame frame(&width, &height, pitches, lines);
+    QCOMPARE(frame.width, quint16(641));
+    QCOMPARE(frame.height, quint16(361));
+    QCOMPARE(pitches[0] % VlcRV32Layout::alignment, 0u);
+    QVERIFY(pitches[0] >= 641u * 4);
+    QCOMPARE(frame.planes.size(), size_t(1));
+}
+
+void TestVideoFrameLayout::uyvy()
+{
+    unsigned width = 641, height = 361;
+    unsigned pitches[1], lines[1];
+
+    QCOMPARE(VlcUYVYVideoFrame::bufferSize(&width, &height, pitches, lines), 1284u * 362);
+}
+
+void TestVideoFrameLayout::externalBuffer()
+{
+    unsigned width = 64, height = 32;
+    unsigned pitches[2], lines[2];
+    QByteArray memory(VlcNV12VideoFrame::bufferSize(&width, &height, pitches, lines), 0);
+
+    VlcNV12VideoFrame frame(&width, &height, pitches, lines, memory.data());
+    QCOMPARE(frame.planes[0], memory.data());
+    QCOMPARE(frame.planes[1], memory.data() + 64 * 32);
+    QCOMPARE(frame.frameBuffer.constData(), memory.constData());
+}
+
+QTEST_MAIN(TestVideoFrameLayout)
+#include "TestVideoFrameLayout.moc"
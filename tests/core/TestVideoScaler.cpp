@@ -0,0 +1,185 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "core/VideoScaler.h"
+
+Q_DECLARE_METATYPE(VlcVideoScaler::Filter)
+Q_DECLARE_METATYPE(VlcVideoScaler::Implementation)
+
+class TestVideoScaler : public QObject
+{
+    Q_OBJECT
+private slots:
+    void identity_data();
+    void identity();
+    void nearest();
+    void box();
+    void matchesScalar_data();
+    void matchesScalar();
+};
+
+namespace {
+
+QByteArray randomFrame(unsigned pitch,
+                       unsigned height)
+{
+    QByteArray frame(int(pitch * height), 0);
+    for (int i = 0; i < frame.size(); ++i)
+        frame[i] = char(qrand() & 0xff);
+    return frame;
+}
+
+QByteArray scale(VlcVideoScaler &scaler,
+                 const QByteArray &src,
+                 unsigned srcPitch,
+                 unsigned width,
+                 unsigned height,
+                 unsigned dstWidth,
+                 unsigned dstHeight)
+{
+    // Padded destination pitch, filled so untouched bytes are detected
+    const unsigned dstPitch = dstWidth * 4 + 12;
+    QByteArray dst(int(dstPitch * dstHeight), char(0x5a));
+    scaler.scale(reinterpret_cast<const quint8 *>(src.constData()), srcPitch, width, height,
+                 reinterpret_cast<quint8 *>(dst.data()), dstPitch, dstWidth, dstHeight);
+    return dst;
+}
+
+const quint8 *pixel(const QByteArray &frame,
+                    unsigned pitch,
+                    unsigned x,
+                    unsigned y)
+{
+    return reinterpret_cast<const quint8 *>(frame.constData()) + y * pitch + x * 4;
+}
+
+} // namespace
+
+void TestVideoScaler::identity_data()
+{
+    QTest::addColumn<VlcVideoScaler::Filter>("filter");
+
+    QTest::newRow("nearest") << VlcVideoScaler::Nearest;
+    QTest::newRow("bilinear") << VlcVideoScaler::Bilinear;
+    QTest::newRow("box") << VlcVideoScaler::Box;
+}
+
+void TestVideoScaler::identity()
+{
+    QFETCH(VlcVideoScaler::Filter, filter);
+
+    qsrand(1);
+    const QByteArray src = randomFrame(37 * 4, 21);
+
+    VlcVideoScaler scaler(filter);
+    const QByteArray dst = scale(scaler, src, 37 * 4, 37, 21, 37, 21);
+
+    for (unsigned y = 0; y < 21; ++y)
+        QVERIFY(memcmp(pixel(dst, 37 * 4 + 12, 0, y), pixel(src, 37 * 4, 0, y), 37 * 4) == 0);
+}
+
+void TestVideoScaler::nearest()
+{
+    qsrand(2);
+    const QByteArray src = randomFrame(16 * 4, 8);
+
+    VlcVideoScaler scaler(VlcVideoScaler::Nearest);
+    const QByteArray dst = scale(scaler, src, 16 * 4, 16, 8, 32, 16);
+
+    for (unsigned y = 0; y < 16; ++y) {
+        for (unsigned x = 0; x < 32; ++x)
+            QVERIFY(memcmp(pixel(dst, 32 * 4 + 12, x, y), pixel(src, 16 * 4, x / 2, y / 2), 4) == 0);
+    }
+}
+
+void TestVideoScaler::box()
+{
+    qsrand(3);
+    const QByteArray src = randomFrame(32 * 4, 16);
+
+    VlcVideoScaler scaler(VlcVideoScaler::Box);
+    const QByteArray dst = scale(scaler, src, 32 * 4, 32, 16, 16, 8);
+
+    for (unsigned y = 0; y < 8; ++y) {
+        for (unsigned x = 0; x < 16; ++x) {
+            for (unsigned c = 0; c < 4; ++c) {
+                const int sum = pixel(src, 32 * 4, 2 * x, 2 * y)[c] + pixel(src, 32 * 4, 2 * x + 1, 2 * y)[c]
+                                + pixel(src, 32 * 4, 2 * x, 2 * y + 1)[c] + pixel(src, 32 * 4, 2 * x + 1, 2 * y + 1)[c];
+                QVERIFY(qAbs(pixel(dst, 16 * 4 + 12, x, y)[c] - (sum + 2) / 4) <= 1);
+            }
+        }
+    }
+}
+
+void TestVideoScaler::matchesScalar_data()
+{
+    QTest::addColumn<VlcVideoScaler::Implementation>("implementation");
+    QTest::addColumn<VlcVideoScaler::Filter>("filter");
+
+    const QList<QPair<QString, VlcVideoScaler::Implementation>> implementations = {
+        qMakePair(QString("Scalar"), VlcVideoScaler::Scalar),
+        qMakePair(QString("SSE2"), VlcVideoScaler::SSE2),
+        qMakePair(QString("NEON"), VlcVideoScaler::NEON)
+    };
+
+    for (int i = 0; i < implementations.size(); ++i) {
+        if (!VlcVideoScaler::isSupported(implementations[i].second))
+            continue;
+
+        const QByteArray name = implementations[i].first.toLatin1();
+        QTest::newRow((name + " nearest").constData()) << implementations[i].second << VlcVideoScaler::Nearest;
+        QTest::newRow((name + " bilinear").constData()) << implementations[i].second << VlcVideoScaler::Bilinear;
+        QTest::newRow((name + " box").constData()) << implementations[i].second << VlcVideoScaler::Box;
+    }
+}
+
+void TestVideoScaler::matchesScalar()
+{
+    QFETCH(VlcVideoScaler::Implementation, implementation);
+    QFETCH(VlcVideoScaler::Filter, filter);
+
+    VlcVideoScaler reference(filter, VlcVideoScaler::Scalar);
+    VlcVideoScaler scaler(filter, implementation);
+    QCOMPARE(scaler.implementation(), implementation);
+
+    // Source size, destination size
+    const int sizes[][4] = {
+        { 320, 240, 1024, 768 },
+        { 640, 360, 1024, 576 },
+        { 1280, 720, 640, 360 },
+        { 100, 75, 3, 2 },
+        { 17, 9, 33, 19 },
+        { 2, 1, 7, 4 },
+        { 1, 1, 5, 3 }
+    };
+
+    qsrand(4);
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        const unsigned srcPitch = sizes[i][0] * 4 + 8;
+        const QByteArray src = randomFrame(srcPitch, sizes[i][1]);
+
+        const QByteArray expected = scale(reference, src, srcPitch, sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3]);
+        const QByteArray actual = scale(scaler, src, srcPitch, sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3]);
+        QVERIFY2(actual == expected, qPrintable(QString("%1x%2 -> %3x%4").arg(sizes[i][0]).arg(sizes[i][1]).arg(sizes[i][2]).arg(sizes[i][3])));
+    }
+}
+
+QTEST_MAIN(TestVideoScaler)
+#include "TestVideoScaler.moc"
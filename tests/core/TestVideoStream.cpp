@@ -0,0 +1,173 @@
+/****************************************************************************
+* VLC-Qt - Qt and libvlc connector library
+* Copyright (C) 2016 Tadej Novak <tadej@tano.si>
+*
+* This library is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "core/VideoStream.h"
+
+class TestVideoStream : public QObject
+{
+    Q_OBJECT
+private slots:
+    void maximumSize_data();
+    void maximumSize();
+    void callbackOrder_data();
+    void callbackOrder();
+    void undisplayedFrames();
+};
+
+namespace {
+
+class Stream : public VlcVideoStream
+{
+public:
+    Stream()
+        : VlcVideoStream(Vlc::RV32Format) {}
+
+    QSize negotiate(const QSize &source)
+    {
+        char chroma[5] = {};
+        unsigned width = source.width();
+        unsigned height = source.height();
+        unsigned pitches[3] = {};
+        unsigned lines[3] = {};
+        formatCallback(chroma, &width, &height, pitches, lines);
+        formatCleanUpCallback();
+
+        return QSize(width, height);
+    }
+
+    void start(const QSize &size)
+    {
+        char chroma[5] = {};
+        unsigned width = size.width();
+        unsigned height = size.height();
+        unsigned pitches[3] = {};
+        unsigned lines[3] = {};
+        formatCallback(chroma, &width, &height, pitches, lines);
+    }
+
+    // libVLC 2.2 displays before it unlocks, 3.0 unlocks first
+    void *frame(bool unlockFirst, void **planes)
+    {
+        void *picture = lockCallback(planes);
+        if (unlockFirst) {
+            unlockCallback(picture, planes);
+            displayCallback(picture);
+        } else {
+            displayCallback(picture);
+            unlockCallback(picture, planes);
+        }
+        return picture;
+    }
+
+    // Decoded but dropped by libVLC, never displayed
+    void droppedFrame()
+    {
+        void *planes[3] = {};
+        unlockCallback(lockCallback(planes), planes);
+    }
+
+    using VlcVideoStream::formatCleanUpCallback;
+
+private:
+    void frameUpdated() {}
+};
+
+}
+
+void TestVideoStream::maximumSize_data()
+{
+    QTest::addColumn<QSize>("maximum");
+    QTest::addColumn<QSize>("source");
+    QTest::addColumn<QSize>("frame");
+
+    QTest::newRow("unlimited") << QSize() << QSize(1920, 1080) << QSize(1920, 1080);
+    QTest::newRow("smaller") << QSize(320, 180) << QSize(160, 90) << QSize(160, 90);
+    QTest::newRow("wide") << QSize(320, 180) << QSize(1920, 1080) << QSize(320, 180);
+    QTest::newRow("square") << QSize(320, 180) << QSize(1000, 1000) << QSize(180, 180);
+    QTest::newRow("even") << QSize(320, 180) << QSize(1280, 534) << QSize(320, 132);
+    QTest::newRow("tiny") << QSize(2, 2) << QSize(1920, 200) << QSize(2, 2);
+}
+
+void TestVideoStream::maximumSize()
+{
+    QFETCH(QSize, maximum);
+    QFETCH(QSize, source);
+    QFETCH(QSize, frame);
+
+    Stream stream;
+    stream.setMaximumSize(maximum);
+    QCOMPARE(stream.maximumSize(), maximum);
+    QCOMPARE(stream.negotiate(source), frame);
+}
+
+void TestVideoStream::callbackOrder_data()
+{
+    QTest::addColumn<bool>("unlockFirst");
+
+    QTest::newRow("display, unlock") << false;
+    QTest::newRow("unlock, display") << true;
+}
+
+void TestVideoStream::callbackOrder()
+{
+    QFETCH(bool, unlockFirst);
+
+    Stream stream;
+    stream.start(QSize(64, 32));
+
+    for (int i = 0; i < 20; i++) {
+        void *planes[3] = {};
+        stream.frame(unlockFirst, planes);
+
+        std::shared_ptr<const VlcAbstractVideoFrame> frame = stream.acquireFrame();
+        QVERIFY(frame);
+        QCOMPARE(static_cast<void *>(frame->planes[0]), planes[0]);
+        QCOMPARE(frame->width, quint16(64));
+        QVERIFY(frame->timing.display);
+    }
+
+    // Frames return to the pool, none are allocated on the way
+    QCOMPARE(stream.poolStats().growths, quint64(0));
+
+    stream.formatCleanUpCallback();
+}
+
+void TestVideoStream::undisplayedFrames()
+{
+    Stream stream;
+    stream.start(QSize(64, 32));
+
+    // Dropped frames must not hold their buffers forever
+    for (int i = 0; i < 50; i++) {
+        stream.droppedFrame();
+    }
+    QCOMPARE(stream.poolStats().growths, quint64(0));
+
+    // A frame unlocked some time before its display is still shown
+    void *planes[3] = {};
+    stream.frame(true, planes);
+    QVERIFY(stream.acquireFrame());
+    QCOMPARE(static_cast<void *>(stream.acquireFrame()->planes[0]), planes[0]);
+
+    stream.formatCleanUpCallback();
+}
+
+QTEST_MAIN(TestVideoStream)
+#include "TestVideoStream.moc"
@@ -4,6 +4,12 @@
  *
  * When playing: Qt UI is hidden, video renders fullscreen
  * When paused: Qt UI is shown, video clears
+ *
+ * Zero-copy mode: when the framebuffer has room for more than one page
+ * libvlc is asked for BGRA with the framebuffer stride and decodes
+ * straight into an off-screen page, which is then shown with
+ * FBIOPAN_DISPLAY from the vout thread. Otherwise frames are decoded
+ * into m_buffer and copied on the render thread.
  */
 
 #include "FBVideoWidget.h"
@@ -11,6 +17,7 @@
 #include <QDebug>
 #include <QFile>
 #include <QTextStream>
+#include <QElapsedTimer>
 
 #include <sys/ioctl.h>
 
@@ -39,32 +46,38 @@ static void logMsg(const char *fmt, ...) {
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "MediaPlayer.h"
+#include "ResolutionGovernor.h"
+
+// Set to 1 to use I420 with our own YUV->RGB conversion (VlcColorConverter, NEON)
+// Set to 0 to use BGRA from VLC's swscale
+#define USE_I420_CONVERSION 1
+
+// Pages used for flipping inside yres_virtual (3 = triple buffering)
+#define FB_MAX_PAGES 3
 
-// Scale factors for reduced resolution based on source size
-// 480p and below: scale by 2 (~240x180)
-// 720p: scale by 5 (~256x144)
-// 1080p+: scale by 8 (~240x135)
-#define VIDEO_SCALE_FACTOR_SD 2
-#define VIDEO_SCALE_FACTOR_HD 5
-#define VIDEO_SCALE_FACTOR_FHD 8
+// Set to 1 to wait for vsync after a flip when only two pages are available
+#define FB_WAIT_FOR_VSYNC 1
 
-// Set to 1 to use I420 with our own YUV->RGB conversion
-// Set to 0 to use BGRA from VLC's swscale (faster - swscale is NEON optimized)
-#define USE_I420_CONVERSION 0
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+
+// Set to 1 to let libvlc decode straight into an off-screen FB page
+// when the governor's size fills the screen (needs yres_virtual >= 2 * yres)
+#define USE_ZERO_COPY 1
 
 FBVideoWidget::FBVideoWidget(QWidget *parent)
     : QWidget(parent),
       m_player(nullptr),
-      m_writeBuffer(0),
-      m_readBuffer(1),
       m_videoWidth(0),
       m_videoHeight(0),
       m_videoPitchY(0),
       m_videoPitchUV(0),
-      m_hasFrame(false),
+      m_hasFrame(0),
       m_useI420(USE_I420_CONVERSION),
       m_fbFd(-1),
       m_fbMem(nullptr),
@@ -74,24 +87,45 @@ FBVideoWidget::FBVideoWidget(QWidget *parent)
       m_fbStride(0),
       m_fbBpp(32),
       m_fbOpen(false),
+      m_fbPages(1),
+      m_savedYOffset(0),
+      m_displayPage(0),
+      m_cleanPages(0),
+      m_waitForVsync(FB_WAIT_FOR_VSYNC),
+      m_zeroCopy(false),
+      m_zeroCopyOffset(0),
+      m_convertUs(-1),
+      m_governor(new ResolutionGovernor(this)),
+      m_renderThread(new RenderThread(this, this)),
       m_screenX(0),
       m_screenY(0),
       m_renderWidth(0),
       m_renderHeight(0),
-      m_isPlaying(false),
+      m_isPlaying(0),
       m_firstFrameRendered(false)
 {
+    memset(&m_fbVar, 0, sizeof(m_fbVar));
+
     setAttribute(Qt::WA_OpaquePaintEvent);
     setAttribute(Qt::WA_NoSystemBackground);
     setAutoFillBackground(false);
 
     openFramebuffer();
 
+    // Decode size is picked at runtime from FB size and measured render cost
+    m_governor->setDisplaySize(m_fbWidth, m_fbHeight);
+
     // When playing, we render fullscreen - set render region to full FB
     m_screenX = 0;
     m_screenY = 0;
     m_renderWidth = m_fbWidth;
     m_renderHeight = m_fbHeight;
+
+    // The newest frame is always copied, one queued frame is enough
+    m_renderThread->setQueueLimit(1);
+    connect(m_renderThread, &RenderThread::firstFramePresented,
+            this, &FBVideoWidget::onFirstFramePresented);
+    m_renderThread->start();
 }
 
 FBVideoWidget::~FBVideoWidget()
@@ -100,6 +134,7 @@ FBVideoWidget::~FBVideoWidget()
         libvlc_video_set_callbacks(m_player->core(), nullptr, nullptr, nullptr, nullptr);
         libvlc_video_set_format_callbacks(m_player->core(), nullptr, nullptr);
     }
+    m_renderThread->stop();
     clearVideoRegion();
     closeFramebuffer();
 }
@@ -134,13 +169,23 @@ bool FBVideoWidget::openFramebuffer()
     m_fbBpp = vinfo.bits_per_pixel;
     m_fbStride = finfo.line_length;
     m_fbSize = finfo.smem_len;
+    m_fbVar = vinfo;
+
+    // Pages available for flipping, limited by the virtual size and the mapping
+    m_fbPages = 1;
+    if (m_fbHeight && m_fbStride) {
+        m_fbPages = qMax(1u, qMin(vinfo.yres_virtual / m_fbHeight,
+                                  (unsigned)(m_fbSize / (m_fbStride * m_fbHeight))));
+        m_fbPages = qMin(m_fbPages, (unsigned)FB_MAX_PAGES);
+    }
 
     logMsg( "FBVideoWidget: FB info: %ux%u, %u bpp, stride=%u, size=%zu\n",
             m_fbWidth, m_fbHeight, m_fbBpp, m_fbStride, m_fbSize);
     logMsg( "FBVideoWidget: FB virtual: %ux%u, offset: %u,%u\n",
             vinfo.xres_virtual, vinfo.yres_virtual,
             vinfo.xoffset, vinfo.yoffset);
-    
+    logMsg( "FBVideoWidget: %u page(s) available for flipping\n", m_fbPages);
+
     m_fbMem = (unsigned char *)mmap(nullptr, m_fbSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fbFd, 0);
     if (m_fbMem == MAP_FAILED) {
         logMsg( "FBVideoWidget: mmap failed: %s\n", strerror(errno));
@@ -176,6 +221,7 @@ void FBVideoWidget::setMediaPlayer(VlcMediaPlayer *player)
     }
 
     m_player = player;
+    m_governor->setPlayer(player);
 
     if (m_player) {
         libvlc_media_player_t *mp = m_player->core();
@@ -219,7 +265,7 @@ void FBVideoWidget::mousePressEvent(QMouseEvent *event)
     Q_UNUSED(event);
 
     // If playing, user tapped - emit signal so MainWindow can pause and show UI
-    if (m_isPlaying) {
+    if (m_isPlaying.loadAcquire()) {
         logMsg( "FBVideoWidget: Tapped during playback\n");
                 emit tapped();
     }
@@ -245,81 +291,149 @@ void FBVideoWidget::clearVideoRegion()
     
     // Clear entire framebuffer to black
     memset(m_fbMem, 0, m_fbSize);
+    m_cleanPages.storeRelease(0);
+}
+
+void FBVideoWidget::clearPage(int page)
+{
+    // Black bars are written once per page and geometry
+    const int bit = 1 << page;
+    if (!(m_cleanPages.fetchAndOrOrdered(bit) & bit)) {
+        memset(pageMemory(page), 0, m_fbHeight * m_fbStride);
+    }
+}
+
+QRect FBVideoWidget::targetRect(unsigned width, unsigned height) const
+{
+    // Aspect-correct target rectangle (fullscreen)
+    float videoAspect = (float)width / (float)height;
+    float screenAspect = (float)m_fbWidth / (float)m_fbHeight;
+
+    if (videoAspect > screenAspect) {
+        const int targetH = (int)(m_fbWidth / videoAspect);
+        return QRect(0, (m_fbHeight - targetH) / 2, m_fbWidth, targetH);
+    } else {
+        const int targetW = (int)(m_fbHeight * videoAspect);
+        return QRect((m_fbWidth - targetW) / 2, 0, targetW, m_fbHeight);
+    }
+}
+
+unsigned char *FBVideoWidget::pageMemory(int page) const
+{
+    return m_fbMem + (size_t)page * m_fbHeight * m_fbStride;
+}
+
+int FBVideoWidget::backPage() const
+{
+    // Without a second page we can only draw into the visible one
+    const int displayPage = m_displayPage.loadAcquire();
+    if (m_fbPages < 2) {
+        return displayPage;
+    }
+    return (displayPage + 1) % m_fbPages;
+}
+
+bool FBVideoWidget::panToPage(int page)
+{
+    QMutexLocker locker(&m_panMutex);
+    m_fbVar.xoffset = 0;
+    m_fbVar.yoffset = page * m_fbHeight;
+    if (ioctl(m_fbFd, FBIOPAN_DISPLAY, &m_fbVar) < 0) {
+        logMsg("FBVideoWidget: FBIOPAN_DISPLAY to page %d failed: %s\n", page, strerror(errno));
+        return false;
+    }
+    m_displayPage.storeRelease(page);
+    return true;
+}
+
+void FBVideoWidget::flipToPage(int page)
+{
+    if (page != m_displayPage.loadAcquire() && panToPage(page)) {
+        waitForVsync();
+    }
 }
 
-// Inline clamp for YUV->RGB conversion
-static inline int clamp255(int v) {
-    return (v < 0) ? 0 : ((v > 255) ? 255 : v);
+void FBVideoWidget::waitForVsync()
+{
+    // With only two pages the next frame goes into the page that was just
+    // replaced, so wait until the pan has latched. Three pages never reuse it.
+    if (m_waitForVsync && m_fbPages == 2) {
+        __u32 crtc = 0;
+        if (ioctl(m_fbFd, FBIO_WAITFORVSYNC, &crtc) < 0) {
+            logMsg("FBVideoWidget: FBIO_WAITFORVSYNC not supported, disabled\n");
+            m_waitForVsync = false;
+        }
+    }
 }
 
-void FBVideoWidget::renderToFramebuffer()
+bool FBVideoWidget::presentFrame()
+{
+    // Only render when playing - prevents flickering when paused
+    if (!m_isPlaying.loadAcquire()) {
+        return false;
+    }
+    return renderToFramebuffer();
+}
+
+bool FBVideoWidget::renderToFramebuffer()
 {
     static int renderCount = 0;
 
     if (!m_fbOpen || !m_fbMem) {
         if (renderCount < 5) logMsg("FBVideoWidget: renderToFB - FB not open\n");
-        return;
+        return false;
     }
-    if (!m_hasFrame) {
+    if (!m_hasFrame.loadAcquire()) {
         if (renderCount < 5) logMsg("FBVideoWidget: renderToFB - no frame yet\n");
-        return;
+        return false;
     }
+
+    QElapsedTimer renderTimer;
+    renderTimer.start();
+
+    // The negotiated format is published by formatCallback under m_mutex
+    m_mutex.lock();
+
     if (m_videoWidth == 0 || m_videoHeight == 0) {
+        m_mutex.unlock();
         if (renderCount < 5) logMsg("FBVideoWidget: renderToFB - video size 0\n");
-        return;
+        return false;
     }
-
-    // Get current display page offset (for triple buffering)
-    struct fb_var_screeninfo vinfo;
-    unsigned int pageYOffset = 0;
-    if (ioctl(m_fbFd, FBIOGET_VSCREENINFO, &vinfo) == 0) {
-        pageYOffset = vinfo.yoffset;
-        if (renderCount < 5) {
-            logMsg("FBVideoWidget: FB yoffset=%u (page %u)\n",
-                   pageYOffset, pageYOffset / m_fbHeight);
-        }
+    if (m_zeroCopy) {
+        // libvlc already wrote the frame into the page shown by displayCallback
+        m_mutex.unlock();
+        return false;
     }
 
+    // Render into the back page, the one on screen is left alone
+    const int page = backPage();
+
     renderCount++;
     if (renderCount <= 10 || renderCount % 100 == 0) {
-        logMsg("FBVideoWidget: renderToFB #%d, video %ux%u -> FB %ux%u (yoff=%u) %s\n",
-               renderCount, m_videoWidth, m_videoHeight, m_fbWidth, m_fbHeight, pageYOffset,
+        logMsg("FBVideoWidget: renderToFB #%d, video %ux%u -> FB %ux%u (page %d/%u) %s\n",
+               renderCount, m_videoWidth, m_videoHeight, m_fbWidth, m_fbHeight, page, m_fbPages,
                m_useI420 ? "I420" : "BGRA");
     }
 
-    m_mutex.lock();
-
-    const unsigned char *src = reinterpret_cast<const unsigned char*>(m_buffer[m_readBuffer].constData());
+    // Newest decoded frame, older ones were dropped by the ring
+    if (m_ring.acquire()) {
+        m_tracer.presentStarted(m_ring.readSlot());
+    }
+    const unsigned char *src = reinterpret_cast<const unsigned char*>(m_buffer[m_ring.readSlot()].constData());
     unsigned srcWidth = m_videoWidth;
     unsigned srcHeight = m_videoHeight;
 
     // Calculate aspect-correct target rectangle (fullscreen)
-    float videoAspect = (float)srcWidth / (float)srcHeight;
-    float screenAspect = (float)m_fbWidth / (float)m_fbHeight;
+    const QRect target = targetRect(srcWidth, srcHeight);
 
-    int targetW, targetH, targetX, targetY;
-    if (videoAspect > screenAspect) {
-        targetW = m_fbWidth;
-        targetH = (int)(m_fbWidth / videoAspect);
-        targetX = 0;
-        targetY = (m_fbHeight - targetH) / 2;
-    } else {
-        targetH = m_fbHeight;
-        targetW = (int)(m_fbHeight * videoAspect);
-        targetX = (m_fbWidth - targetW) / 2;
-        targetY = 0;
+    // Letterbox/pillarbox bars only need clearing when the geometry changes
+    if (target != m_lastTarget) {
+        m_lastTarget = target;
+        m_cleanPages.storeRelease(0);
     }
+    clearPage(page);
 
-    // Adjust for current page offset (triple buffering)
-    targetY += pageYOffset;
-
-    // Fixed-point scale factors (16.16 format for speed)
-    unsigned int scaleX_fp = (srcWidth << 16) / targetW;
-    unsigned int scaleY_fp = (srcHeight << 16) / targetH;
-
-    // Page bounds for triple buffering
-    int pageTop = pageYOffset;
-    int pageBottom = pageYOffset + m_fbHeight;
+    unsigned char *dst = pageMemory(page) + target.y() * m_fbStride + target.x() * 4;
 
     if (m_useI420) {
         // I420 format: Y plane, then U plane (1/4 size), then V plane (1/4 size)
@@ -327,140 +441,79 @@ void FBVideoWidget::renderToFramebuffer()
         const unsigned char *planeU = src + m_videoPitchY * srcHeight;
         const unsigned char *planeV = planeU + m_videoPitchUV * (srcHeight / 2);
 
-        // Render with YUV->RGB conversion and scaling
-        for (int y = 0; y < targetH; y++) {
-            int fbY = targetY + y;
-            if (fbY < pageTop || fbY >= pageBottom) continue;
-
-            unsigned int *dstRow = (unsigned int *)(m_fbMem + fbY * m_fbStride + targetX * 4);
-            int srcY = (y * scaleY_fp) >> 16;
-            if (srcY >= (int)srcHeight) srcY = srcHeight - 1;
-
-            const unsigned char *yRow = planeY + srcY * m_videoPitchY;
-            const unsigned char *uRow = planeU + (srcY / 2) * m_videoPitchUV;
-            const unsigned char *vRow = planeV + (srcY / 2) * m_videoPitchUV;
-
-            unsigned int srcX_fp = 0;
-            for (int x = 0; x < targetW; x++) {
-                int srcX = srcX_fp >> 16;
-
-                // Get YUV values (U and V are subsampled 2x2)
-                int Y = yRow[srcX];
-                int U = uRow[srcX / 2];
-                int V = vRow[srcX / 2];
-
-                // Fast YUV to RGB conversion (BT.601)
-                // R = Y + 1.402*(V-128)
-                // G = Y - 0.344*(U-128) - 0.714*(V-128)
-                // B = Y + 1.772*(U-128)
-                int C = Y;
-                int D = U - 128;
-                int E = V - 128;
-
-                int R = clamp255(C + ((359 * E) >> 8));
-                int G = clamp255(C - ((88 * D + 183 * E) >> 8));
-                int B = clamp255(C + ((454 * D) >> 8));
-
-                // BGRA format for framebuffer
-                dstRow[x] = (0xFF << 24) | (R << 16) | (G << 8) | B;
-                srcX_fp += scaleX_fp;
-            }
-        }
+        // Fused YUV->RGB conversion and scaling (NEON on the device)
+        m_converter.convertI420ToBGRA(planeY, planeU, planeV,
+                                      m_videoPitchY, m_videoPitchUV,
+                                      srcWidth, srcHeight,
+                                      dst, m_fbStride,
+                                      target.width(), target.height());
     } else {
-        // BGRA format from VLC's swscale
-        unsigned srcStride = srcWidth * 4;
-
-        for (int y = 0; y < targetH; y++) {
-            int fbY = targetY + y;
-            if (fbY < pageTop || fbY >= pageBottom) continue;
-
-            unsigned int *dstRow = (unsigned int *)(m_fbMem + fbY * m_fbStride + targetX * 4);
-            int srcY = (y * scaleY_fp) >> 16;
-            if (srcY >= (int)srcHeight) srcY = srcHeight - 1;
-            const unsigned int *srcRow = (const unsigned int *)(src + srcY * srcStride);
-
-            unsigned int srcX_fp = 0;
-            for (int x = 0; x < targetW; x++) {
-                int srcX = srcX_fp >> 16;
-                dstRow[x] = srcRow[srcX];
-                srcX_fp += scaleX_fp;
-            }
-        }
-    }
-
-    // Fill black bars (letterbox/pillarbox) - adjusted for page offset
-    // Top bar
-    for (int y = pageTop; y < targetY && y < pageBottom; y++) {
-        memset(m_fbMem + y * m_fbStride, 0, m_fbWidth * 4);
-    }
-    // Bottom bar
-    for (int y = targetY + targetH; y < pageBottom; y++) {
-        memset(m_fbMem + y * m_fbStride, 0, m_fbWidth * 4);
-    }
-    // Left bar
-    if (targetX > 0) {
-        for (int y = targetY; y < targetY + targetH && y < pageBottom; y++) {
-            if (y >= pageTop) memset(m_fbMem + y * m_fbStride, 0, targetX * 4);
-        }
-    }
-    // Right bar
-    if (targetX + targetW < (int)m_fbWidth) {
-        for (int y = targetY; y < targetY + targetH && y < pageBottom; y++) {
-            if (y >= pageTop) memset(m_fbMem + y * m_fbStride + (targetX + targetW) * 4, 0, (m_fbWidth - targetX - targetW) * 4);
-        }
+        // BGRA format from VLC's swscale, filtered scaling straight into the FB
+        m_scaler.scale(src, srcWidth * 4, srcWidth, srcHeight,
+                       dst, m_fbStride,
+                       target.width(), target.height());
     }
 
     m_mutex.unlock();
-}
 
-static int frameCount = 0;
+    m_governor->frameRendered(renderTimer.nsecsElapsed() / 1000);
 
-void FBVideoWidget::onFrameReady()
-{
-    frameCount++;
+    // Show the finished page
+    flipToPage(page);
+    m_tracer.presentFinished();
+    return true;
+}
 
-    // Only render when playing - prevents flickering when paused
-    if (m_isPlaying) {
-        renderToFramebuffer();
-
-        // Emit firstFrameReady after we've actually rendered a frame
-        if (!m_firstFrameRendered && m_hasFrame) {
-            m_firstFrameRendered = true;
-            logMsg("FBVideoWidget: First frame rendered - emitting firstFrameReady\n");
-            emit firstFrameReady();
-        }
+void FBVideoWidget::onFirstFramePresented()
+{
+    // Emit firstFrameReady after we've actually rendered a frame
+    if (m_isPlaying.loadAcquire() && !m_firstFrameRendered) {
+        m_firstFrameRendered = true;
+        logMsg("FBVideoWidget: First frame rendered - emitting firstFrameReady\n");
+        emit firstFrameReady();
     }
+}
 
-    if (frameCount <= 10 || frameCount % 100 == 0) {
-        logMsg("FBVideoWidget: onFrameReady %d, isPlaying=%d, hasFrame=%d\n",
-               frameCount, m_isPlaying, m_hasFrame);
-    }
+bool FBVideoWidget::isRestarting() const
+{
+    return m_governor->isRestarting();
+}
+
+void FBVideoWidget::endRestart()
+{
+    m_governor->endRestart();
 }
 
 void FBVideoWidget::onPlaybackStarted()
 {
     logMsg("FBVideoWidget: Playback started - entering fullscreen video mode\n");
-    m_isPlaying = true;
     m_firstFrameRendered = false;  // Reset for new playback
 
+    // Remember the page Qt shows, playback pans away from it
+    struct fb_var_screeninfo vinfo;
+    if (m_fbOpen && ioctl(m_fbFd, FBIOGET_VSCREENINFO, &vinfo) == 0) {
+        m_savedYOffset = vinfo.yoffset;
+        m_displayPage.storeRelease(m_fbHeight ? vinfo.yoffset / m_fbHeight : 0);
+    }
+    // Qt drew into the pages while paused, bars need clearing again
+    m_cleanPages.storeRelease(0);
+    m_isPlaying.storeRelease(1);
+
     // Set fullscreen render region
     updateRenderPosition();
+    m_governor->start();
 
     // Render current frame if we have one (and trigger firstFrameReady if so)
-    if (m_hasFrame) {
-        renderToFramebuffer();
-        if (!m_firstFrameRendered) {
-            m_firstFrameRendered = true;
-            logMsg("FBVideoWidget: First frame rendered (immediate) - emitting firstFrameReady\n");
-            emit firstFrameReady();
-        }
+    m_renderThread->resetFirstFrame();
+    if (m_hasFrame.loadAcquire()) {
+        m_renderThread->requestPresent();
     }
 }
 
 void FBVideoWidget::forceSeek()
 {
     // Force a micro-seek to kick-start VLC frame delivery
-    if (m_player && m_isPlaying) {
+    if (m_player && m_isPlaying.loadAcquire()) {
         logMsg("FBVideoWidget: Executing micro-seek to kick-start frames\n");
         float pos = m_player->position();
         if (pos < 0.001f) pos = 0.001f;
@@ -472,7 +525,20 @@ void FBVideoWidget::forceSeek()
 void FBVideoWidget::onPlaybackStopped()
 {
     logMsg( "FBVideoWidget: Playback stopped - clearing FB for Qt UI\n");
-        m_isPlaying = false;
+        m_isPlaying.storeRelease(0);
+    m_governor->stop();
+
+    // Let a frame that is being copied finish before Qt gets the screen back
+    m_renderThread->waitForIdle();
+
+    // Give the page Qt draws into back to the display
+    if (m_fbOpen && m_displayPage.loadAcquire() * m_fbHeight != m_savedYOffset) {
+        QMutexLocker locker(&m_panMutex);
+        m_fbVar.xoffset = 0;
+        m_fbVar.yoffset = m_savedYOffset;
+        ioctl(m_fbFd, FBIOPAN_DISPLAY, &m_fbVar);
+        m_displayPage.storeRelease(m_fbHeight ? m_savedYOffset / m_fbHeight : 0);
+    }
 
     // Clear the framebuffer so Qt can paint
     clearVideoRegion();
@@ -483,7 +549,28 @@ void FBVideoWidget::onPlaybackStopped()
 void *FBVideoWidget::lockCallback(void *opaque, void **planes)
 {
     FBVideoWidget *self = static_cast<FBVideoWidget*>(opaque);
-    unsigned char *buffer = reinterpret_cast<unsigned char*>(self->m_buffer[self->m_writeBuffer].data());
+    unsigned char *buffer = reinterpret_cast<unsigned char*>(self->m_buffer[self->m_ring.writeSlot()].data());
+    self->m_tracer.frameLocked(self->m_ring.writeSlot());
+
+    if (self->m_zeroCopy) {
+        // Not shown while paused, keep the frame off the framebuffer
+        if (!self->m_isPlaying.loadAcquire()) {
+            planes[0] = buffer;
+            return nullptr;
+        }
+
+        // Decode into the page after the one on screen
+        const int page = self->backPage();
+        self->clearPage(page);
+        planes[0] = self->pageMemory(page) + self->m_zeroCopyOffset;
+
+        // libvlc converts into the page until unlock or display
+        self->m_convertTimer.start();
+        self->m_convertUs = -1;
+
+        // Page index is passed on to displayCallback, 0 means no page
+        return reinterpret_cast<void *>(intptr_t(page + 1));
+    }
 
     if (self->m_useI420) {
         // I420: 3 planes - Y, then U, then V
@@ -508,22 +595,61 @@ void FBVideoWidget::unlockCallback(void *opaque, void *picture, void *const *pla
 
     FBVideoWidget *self = static_cast<FBVideoWidget*>(opaque);
 
+    // Zero-copy frames are shown by displayCallback, nothing to copy.
+    // libVLC 3.0 unlocks once the page is converted.
+    if (self->m_zeroCopy) {
+        if (picture && self->m_convertUs < 0) {
+            self->m_convertUs = self->m_convertTimer.nsecsElapsed() / 1000;
+        }
+        return;
+    }
+
     if (self->m_videoWidth > 0 && self->m_videoHeight > 0) {
-        self->m_mutex.lock();
-        int temp = self->m_writeBuffer;
-        self->m_writeBuffer = self->m_readBuffer;
-        self->m_readBuffer = temp;
-        self->m_hasFrame = true;
-        self->m_mutex.unlock();
+        self->m_tracer.frameDecoded(self->m_ring.writeSlot());
+        if (self->m_ring.publish()) {
+            self->m_tracer.frameDropped();
+        }
+        self->m_hasFrame.storeRelease(1);
     }
 
-    QMetaObject::invokeMethod(self, "onFrameReady", Qt::QueuedConnection);
+    self->m_renderThread->frameReady();
 }
 
 void FBVideoWidget::displayCallback(void *opaque, void *picture)
 {
-    Q_UNUSED(opaque);
-    Q_UNUSED(picture);
+    FBVideoWidget *self = static_cast<FBVideoWidget*>(opaque);
+
+    if (!self->m_zeroCopy || !picture || !self->m_isPlaying.loadAcquire()) {
+        return;
+    }
+
+    // libVLC 2.2 displays before it unlocks, the conversion ends here
+    if (self->m_convertUs < 0) {
+        self->m_convertUs = self->m_convertTimer.nsecsElapsed() / 1000;
+    }
+
+    QElapsedTimer panTimer;
+    panTimer.start();
+
+    // Zero-copy frames skip the ring, the write slot only carries the timing
+    const int slot = self->m_ring.writeSlot();
+    self->m_tracer.frameDecoded(slot);
+    self->m_tracer.presentStarted(slot);
+
+    const int page = int(reinterpret_cast<intptr_t>(picture)) - 1;
+    const bool panned = self->panToPage(page);
+    self->m_hasFrame.storeRelease(1);
+
+    // The render cost of a zero-copy frame is the conversion by libvlc and the pan
+    self->m_governor->frameRendered(self->m_convertUs + panTimer.nsecsElapsed() / 1000);
+
+    if (panned) {
+        self->waitForVsync();
+    }
+    self->m_tracer.presentFinished();
+
+    // Counted like a rendered frame, the first one hides the Qt UI
+    self->m_renderThread->framePresented();
 }
 
 unsigned FBVideoWidget::formatCallback(void **opaque, char *chroma,
@@ -534,49 +660,66 @@ unsigned FBVideoWidget::formatCallback(void **opaque, char *chroma,
 
     logMsg( "FBVideoWidget::formatCallback %ux%u incoming chroma=%.4s\n", *width, *height, chroma);
 
-    // Choose scale factor based on source resolution
-    // Higher resolution = more aggressive scaling to maintain performance
+    // Decode size chosen by the resolution governor
+    unsigned sourceWidth = *width;
     unsigned sourceHeight = *height;
-    unsigned scaleFactor;
-    if (sourceHeight > 900) {
-        scaleFactor = VIDEO_SCALE_FACTOR_FHD;  // 1080p+ -> /8
-    } else if (sourceHeight > 600) {
-        scaleFactor = VIDEO_SCALE_FACTOR_HD;   // 720p -> /5
-    } else {
-        scaleFactor = VIDEO_SCALE_FACTOR_SD;   // 480p and below -> /2
-    }
+    const QSize size = self->m_governor->negotiate(*width, *height);
+    unsigned scaledWidth = size.width();
+    unsigned scaledHeight = size.height();
 
-    unsigned scaledWidth = *width / scaleFactor;
-    unsigned scaledHeight = *height / scaleFactor;
+    *width = scaledWidth;
+    *height = scaledHeight;
 
-    // Ensure dimensions are even (required for YUV formats)
-    scaledWidth = (scaledWidth / 2) * 2;
-    scaledHeight = (scaledHeight / 2) * 2;
+    unsigned bufferSize;
+    unsigned pitchY;
+    unsigned pitchUV;
+    unsigned zeroCopyOffset = 0;
+    VlcColorConverter::ColorMatrix matrix = VlcColorConverter::BT601;
+
+    // Zero-copy when the governor's size already fills the screen: libvlc
+    // writes BGRA with the framebuffer stride into an off-screen page.
+    // A smaller size is kept and scaled up by the copy path, so the
+    // governor's choice is what libvlc converts either way.
+    const QRect target = self->targetRect(sourceWidth, sourceHeight);
+    const bool zeroCopy = USE_ZERO_COPY && self->m_fbOpen && self->m_fbPages >= 2
+                          && self->m_fbBpp == 32
+                          && qAbs(target.width() - size.width()) <= 2
+                          && qAbs(target.height() - size.height()) <= 2;
+
+    if (zeroCopy) {
+        memcpy(chroma, "BGRA", 4);
 
-    // Minimum size to avoid degenerate cases
-    if (scaledWidth < 160) scaledWidth = 160;
-    if (scaledHeight < 90) scaledHeight = 90;
+        // Centered like the target, the size may differ by the rounding
+        const int x = (int(self->m_fbWidth) - int(scaledWidth)) / 2;
+        const int y = (int(self->m_fbHeight) - int(scaledHeight)) / 2;
+        zeroCopyOffset = y * self->m_fbStride + x * 4;
 
-    *width = scaledWidth;
-    *height = scaledHeight;
+        pitchY = self->m_fbStride;
+        pitchUV = 0;
 
-    self->m_videoWidth = scaledWidth;
-    self->m_videoHeight = scaledHeight;
+        pitches[0] = pitchY;
+        lines[0] = scaledHeight;
 
-    unsigned bufferSize;
+        // Only used as a scratch frame while paused
+        bufferSize = pitches[0] * lines[0];
 
-    if (self->m_useI420) {
+        logMsg("FBVideoWidget: Zero-copy BGRA at %ux%u+%d+%d (stride %u, %u pages)\n",
+               scaledWidth, scaledHeight, x, y, self->m_fbStride, self->m_fbPages);
+    } else if (self->m_useI420) {
         // Request I420 format (YUV 4:2:0 planar)
         // This avoids VLC's swscale overhead - we do YUV->RGB ourselves
         memcpy(chroma, "I420", 4);
 
+        // HD sources are normally BT.709, SD ones BT.601
+        matrix = sourceHeight > 576 ? VlcColorConverter::BT709 : VlcColorConverter::BT601;
+
         // I420 has 3 planes: Y (full res), U (1/4), V (1/4)
-        self->m_videoPitchY = scaledWidth;
-        self->m_videoPitchUV = scaledWidth / 2;
+        pitchY = scaledWidth;
+        pitchUV = scaledWidth / 2;
 
-        pitches[0] = self->m_videoPitchY;   // Y plane pitch
-        pitches[1] = self->m_videoPitchUV;  // U plane pitch
-        pitches[2] = self->m_videoPitchUV;  // V plane pitch
+        pitches[0] = pitchY;                // Y plane pitch
+        pitches[1] = pitchUV;               // U plane pitch
+        pitches[2] = pitchUV;               // V plane pitch
 
         lines[0] = scaledHeight;            // Y plane lines
         lines[1] = scaledHeight / 2;        // U plane lines
@@ -585,30 +728,45 @@ unsigned FBVideoWidget::formatCallback(void **opaque, char *chroma,
         // Total buffer: Y + U + V = w*h + w*h/4 + w*h/4 = w*h*1.5
         bufferSize = scaledWidth * scaledHeight * 3 / 2;
 
-        logMsg("FBVideoWidget: Requested I420 at %ux%u (1/%d for %up), buffer=%u bytes\n",
-               scaledWidth, scaledHeight, scaleFactor, sourceHeight, bufferSize);
+        logMsg("FBVideoWidget: Requested I420 at %ux%u (level %d for %up), buffer=%u bytes\n",
+               scaledWidth, scaledHeight, self->m_governor->level(), sourceHeight, bufferSize);
     } else {
         // Request BGRA format (VLC does YUV->RGB via swscale)
         memcpy(chroma, "BGRA", 4);
 
-        self->m_videoPitchY = scaledWidth * 4;
-        self->m_videoPitchUV = 0;
+        pitchY = scaledWidth * 4;
+        pitchUV = 0;
 
-        pitches[0] = scaledWidth * 4;
+        pitches[0] = pitchY;
         lines[0] = scaledHeight;
 
         bufferSize = pitches[0] * lines[0];
 
-        logMsg("FBVideoWidget: Requested BGRA at %ux%u (1/%d for %up), buffer=%u bytes\n",
-               scaledWidth, scaledHeight, scaleFactor, sourceHeight, bufferSize);
+        logMsg("FBVideoWidget: Requested BGRA at %ux%u (level %d for %up), buffer=%u bytes\n",
+               scaledWidth, scaledHeight, self->m_governor->level(), sourceHeight, bufferSize);
     }
 
-    self->m_buffer[0].resize(bufferSize);
-    self->m_buffer[0].fill(0);
-    self->m_buffer[1].resize(bufferSize);
-    self->m_buffer[1].fill(0);
-    self->m_writeBuffer = 0;
-    self->m_readBuffer = 1;
+    // The renderer reads the format and the buffers under m_mutex,
+    // a renegotiation is published at once so it never sees a mix
+    self->m_mutex.lock();
+    self->m_zeroCopy = zeroCopy;
+    self->m_videoWidth = scaledWidth;
+    self->m_videoHeight = scaledHeight;
+    self->m_videoPitchY = pitchY;
+    self->m_videoPitchUV = pitchUV;
+    self->m_zeroCopyOffset = zeroCopyOffset;
+    if (self->m_useI420 && !zeroCopy) {
+        self->m_converter.setMatrix(matrix);
+    }
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].resize(bufferSize);
+        self->m_buffer[i].fill(0);
+    }
+    self->m_ring.reset();
+    if (zeroCopy) {
+        self->m_cleanPages.storeRelease(0);
+    }
+    self->m_mutex.unlock();
 
     self->updateRenderPosition();
 
@@ -627,9 +785,12 @@ void FBVideoWidget::formatCleanupCallback(void *opaque)
     FBVideoWidget *self = static_cast<FBVideoWidget*>(opaque);
 
     self->m_mutex.lock();
-    self->m_buffer[0].clear();
-    self->m_buffer[1].clear();
-    self->m_hasFrame = false;
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].clear();
+    }
+    self->m_ring.reset();
+    self->m_hasFrame.storeRelease(0);
+    self->m_zeroCopy = false;
     self->m_videoWidth = 0;
     self->m_videoHeight = 0;
     self->m_mutex.unlock();
@@ -7,15 +7,27 @@
 #define FBVIDEOWIDGET_H
 
 #include <QWidget>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QByteArray>
 #include <QMouseEvent>
+#include <QRect>
+
+#include <linux/fb.h>
 
 #include <vlc/vlc.h>
 
+#include "ColorConverter.h"
+#include "FrameRing.h"
+#include "FrameTracer.h"
+#include "RenderThread.h"
+#include "VideoScaler.h"
+
 class VlcMediaPlayer;
+class ResolutionGovernor;
 
-class FBVideoWidget : public QWidget
+class FBVideoWidget : public QWidget, public FramePresenter
 {
     Q_OBJECT
 
@@ -25,6 +37,14 @@ public:
 
     void setMediaPlayer(VlcMediaPlayer *player);
 
+    // Per-frame latency and frame counters
+    VlcFrameStats *frameStats() { return m_tracer.stats(); }
+
+    // The input is restarted for a new decode size, the player's
+    // playing, paused and stopped events are not user visible meanwhile
+    bool isRestarting() const;
+    void endRestart();
+
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
@@ -41,17 +61,29 @@ public slots:
     void onPlaybackStopped();
 
 private slots:
-    void onFrameReady();
+    void onFirstFramePresented();
     void forceSeek();
 
 private:
     void updateRenderPosition();
 
+    // FramePresenter, called on the render thread
+    bool presentFrame() override;
+
     // Framebuffer management
     bool openFramebuffer();
     void closeFramebuffer();
-    void renderToFramebuffer();
+    bool renderToFramebuffer();
     void clearVideoRegion();
+    QRect targetRect(unsigned width, unsigned height) const;
+    void clearPage(int page);
+
+    // Page flipping inside the virtual framebuffer
+    unsigned char *pageMemory(int page) const;
+    int backPage() const;
+    bool panToPage(int page);
+    void flipToPage(int page);
+    void waitForVsync();
 
     // Static callbacks for libvlc
     static void *lockCallback(void *opaque, void **planes);
@@ -65,16 +97,17 @@ private:
     VlcMediaPlayer *m_player;
     QMutex m_mutex;
 
-    // Double buffering for VLC frames (I420 format: Y, U, V planes)
-    QByteArray m_buffer[2];
-    int m_writeBuffer;
-    int m_readBuffer;
+    // Frame buffers for VLC (I420 format: Y, U, V planes), one per ring slot
+    QByteArray m_buffer[VlcFrameRing::Slots];
+    VlcFrameRing m_ring;      // Hands frames from the decoder to the renderer
     unsigned m_videoWidth;
     unsigned m_videoHeight;
     unsigned m_videoPitchY;   // Pitch for Y plane
     unsigned m_videoPitchUV;  // Pitch for U and V planes
-    bool m_hasFrame;
+    QAtomicInt m_hasFrame;    // Set by the vout thread, read by the others
     bool m_useI420;           // True = I420 with our YUV->RGB, False = BGRA from VLC
+    VlcColorConverter m_converter;
+    VlcVideoScaler m_scaler;  // Used for BGRA frames
 
     // Framebuffer
     int m_fbFd;
@@ -85,6 +118,27 @@ private:
     unsigned m_fbStride;
     unsigned m_fbBpp;
     bool m_fbOpen;
+    QMutex m_panMutex;        // Pans come from the GUI, render and vout threads
+    struct fb_var_screeninfo m_fbVar;  // Screen info used for panning, under m_panMutex
+    unsigned m_fbPages;       // Pages that fit in yres_virtual and the mapping
+    unsigned m_savedYOffset;  // Page shown by Qt before playback
+    QAtomicInt m_displayPage; // Page currently on screen
+    QAtomicInt m_cleanPages;  // Bit per page with black bars for this geometry
+    QRect m_lastTarget;       // Geometry the bars were cleared for
+    bool m_waitForVsync;
+
+    // Zero-copy mode: libvlc writes BGRA straight into an off-screen page
+    bool m_zeroCopy;
+    unsigned m_zeroCopyOffset;  // Byte offset of the video inside a page
+    QElapsedTimer m_convertTimer;  // libvlc conversion of the locked page
+    qint64 m_convertUs;            // -1 until the locked page was converted
+
+    // Picks the decode size negotiated in formatCallback
+    ResolutionGovernor *m_governor;
+
+    // Copies decoded frames into the framebuffer off the GUI thread
+    RenderThread *m_renderThread;
+    FrameTracer m_tracer;
 
     // Widget position on screen (for direct FB rendering)
     int m_screenX;
@@ -92,8 +146,8 @@ private:
     int m_renderWidth;
     int m_renderHeight;
 
-    // Playback state
-    bool m_isPlaying;
+    // Playback state, read by the render and vout threads
+    QAtomicInt m_isPlaying;
     bool m_firstFrameRendered;
 };
 
@@ -0,0 +1,75 @@
+/**
+ * Frame Tracer - per-frame latency timestamps for the video widgets
+ *
+ * Keeps one VlcFrameTiming per frame ring slot. The decoder thread stamps
+ * the write slot in the libvlc callbacks, the render thread copies the
+ * read slot when it starts presenting, so neither side touches the
+ * other's slot. Results go to a VlcFrameStats that the GUI can read.
+ */
+
+#ifndef FRAMETRACER_H
+#define FRAMETRACER_H
+
+#include "FrameRing.h"
+#include "FrameStats.h"
+#include "FrameTiming.h"
+
+class FrameTracer
+{
+public:
+    FrameTracer()
+        : m_sequence(0),
+          m_present()
+    {
+        for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+            m_timing[i] = VlcFrameTiming();
+        }
+    }
+
+    // Decoder thread: a buffer was locked for decoding
+    void frameLocked(int slot)
+    {
+        m_timing[slot].start(++m_sequence);
+    }
+
+    // Decoder thread: the frame is complete and about to be published
+    void frameDecoded(int slot)
+    {
+        VlcFrameTiming &timing = m_timing[slot];
+        timing.unlock = timing.display = VlcFrameTiming::now();
+        m_stats.frameDelivered(timing);
+    }
+
+    // Decoder thread: publishing replaced a frame that was never presented
+    void frameDropped()
+    {
+        m_stats.frameDropped();
+    }
+
+    // Render thread: started presenting the frame in a newly acquired slot
+    void presentStarted(int slot)
+    {
+        m_present = m_timing[slot];
+        m_present.presentStart = VlcFrameTiming::now();
+    }
+
+    // Render thread: the frame from presentStarted() is on screen
+    void presentFinished()
+    {
+        if (!m_present.presentStart || m_present.presentEnd) {
+            return;
+        }
+        m_present.presentEnd = VlcFrameTiming::now();
+        m_stats.framePresented(m_present);
+    }
+
+    VlcFrameStats *stats() { return &m_stats; }
+
+private:
+    VlcFrameTiming m_timing[VlcFrameRing::Slots];
+    quint64 m_sequence;
+    VlcFrameTiming m_present;
+    VlcFrameStats m_stats;
+};
+
+#endif // FRAMETRACER_H
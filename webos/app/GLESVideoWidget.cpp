@@ -1,6 +1,17 @@
 /**
  * OpenGL ES 2.0 Video Widget for webOS
  * Uses EGL with libeglwebos.so for hardware-accelerated rendering
+ *
+ * The EGL context is created on the GUI thread and then made current on
+ * the render thread, which does all texture uploads and buffer swaps.
+ *
+ * libvlc decodes to I420 at full resolution. The planes are uploaded
+ * into three luminance textures with glTexSubImage2D and the fragment
+ * shader converts to RGB while the quad is scaled to the viewport.
+ * That is 1.5 bytes per source pixel, about 50% more upload than the
+ * half resolution RGBA frames before (1 byte per source pixel), in
+ * exchange for full resolution and no colour conversion or scaling on
+ * the CPU.
  */
 
 #include "GLESVideoWidget.h"
@@ -17,10 +28,17 @@
 // OpenGL ES 2.0 constants
 #define GL_TEXTURE_2D         0x0DE1
 #define GL_RGBA               0x1908
+#define GL_LUMINANCE          0x1909
 #define GL_UNSIGNED_BYTE      0x1401
 #define GL_TEXTURE_MIN_FILTER 0x2801
 #define GL_TEXTURE_MAG_FILTER 0x2800
 #define GL_LINEAR             0x2601
+#define GL_TEXTURE_WRAP_S     0x2802
+#define GL_TEXTURE_WRAP_T     0x2803
+#define GL_CLAMP_TO_EDGE      0x812F
+#define GL_TEXTURE0           0x84C0
+#define GL_ARRAY_BUFFER       0x8892
+#define GL_STATIC_DRAW        0x88E4
 #define GL_NEAREST            0x2600
 #define GL_FRAGMENT_SHADER    0x8B30
 #define GL_VERTEX_SHADER      0x8B31
@@ -80,6 +98,12 @@ typedef void (*PFNGLDELETEPROGRAMPROC)(GLuint);
 typedef void (*PFNGLDELETETEXTURESPROC)(GLint, const GLuint*);
 typedef void (*PFNGLACTIVETEXTUREPROC)(GLenum);
 typedef void (*PFNGLTEXSUBIMAGE2DPROC)(GLenum, GLint, GLint, GLint, GLint, GLint, GLenum, GLenum, const void*);
+typedef void (*PFNGLGENBUFFERSPROC)(GLint, GLuint*);
+typedef void (*PFNGLBINDBUFFERPROC)(GLenum, GLuint);
+typedef void (*PFNGLBUFFERDATAPROC)(GLenum, long, const void*, GLenum);
+typedef void (*PFNGLDELETEBUFFERSPROC)(GLint, const GLuint*);
+typedef void (*PFNGLUNIFORM2FPROC)(GLint, GLfloat, GLfloat);
+typedef void (*PFNGLUNIFORM4FPROC)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
 
 // GLES function pointers
 static PFNGLVIEWPORTPROC glViewport = nullptr;
@@ -110,50 +134,84 @@ static PFNGLDELETEPROGRAMPROC glDeleteProgram = nullptr;
 static PFNGLDELETETEXTURESPROC glDeleteTextures = nullptr;
 static PFNGLACTIVETEXTUREPROC glActiveTexture = nullptr;
 static PFNGLTEXSUBIMAGE2DPROC glTexSubImage2D = nullptr;
-
-// Vertex shader - simple passthrough
+static PFNGLGENBUFFERSPROC glGenBuffers = nullptr;
+static PFNGLBINDBUFFERPROC glBindBuffer = nullptr;
+static PFNGLBUFFERDATAPROC glBufferData = nullptr;
+static PFNGLDELETEBUFFERSPROC glDeleteBuffers = nullptr;
+static PFNGLUNIFORM2FPROC glUniform2f = nullptr;
+static PFNGLUNIFORM4FPROC glUniform4f = nullptr;
+
+// Vertex shader - scales the static quad to the video aspect and crops
+// the texture coordinates to the visible part of the pitch
 static const char *vertexShaderSource =
-    "attribute vec4 a_position;\n"
+    "attribute vec2 a_position;\n"
     "attribute vec2 a_texCoord;\n"
+    "uniform vec2 u_scale;\n"
+    "uniform vec2 u_texScale;\n"
     "varying vec2 v_texCoord;\n"
     "void main() {\n"
-    "    gl_Position = a_position;\n"
-    "    v_texCoord = a_texCoord;\n"
+    "    gl_Position = vec4(a_position * u_scale, 0.0, 1.0);\n"
+    "    v_texCoord = a_texCoord * u_texScale;\n"
     "}\n";
 
-// Fragment shader - simple texture lookup
+// Fragment shader - limited range YUV to RGB, u_yuv holds the matrix
+// coefficients (R from V, G from U, G from V, B from U)
 static const char *fragmentShaderSource =
     "precision mediump float;\n"
     "varying vec2 v_texCoord;\n"
-    "uniform sampler2D u_texture;\n"
+    "uniform sampler2D u_texY;\n"
+    "uniform sampler2D u_texU;\n"
+    "uniform sampler2D u_texV;\n"
+    "uniform vec4 u_yuv;\n"
     "void main() {\n"
-    "    gl_FragColor = texture2D(u_texture, v_texCoord);\n"
+    "    float y = 1.164 * (texture2D(u_texY, v_texCoord).r - 0.0625);\n"
+    "    float u = texture2D(u_texU, v_texCoord).r - 0.5;\n"
+    "    float v = texture2D(u_texV, v_texCoord).r - 0.5;\n"
+    "    gl_FragColor = vec4(y + u_yuv.x * v,\n"
+    "                        y - u_yuv.y * u - u_yuv.z * v,\n"
+    "                        y + u_yuv.w * u,\n"
+    "                        1.0);\n"
     "}\n";
 
-// Scale factor for reduced resolution
-#define VIDEO_SCALE_FACTOR 2
+// Coefficients for u_yuv, HD video uses BT.709 like FBVideoWidget
+static const GLfloat yuvBT601[4] = { 1.596f, 0.391f, 0.813f, 2.018f };
+static const GLfloat yuvBT709[4] = { 1.793f, 0.213f, 0.533f, 2.112f };
+
+// Full screen quad as a triangle strip, position and texture coordinates
+static const GLfloat quadVertices[] = {
+    -1.0f, -1.0f,   0.0f, 1.0f,  // bottom-left
+     1.0f, -1.0f,   1.0f, 1.0f,  // bottom-right
+    -1.0f,  1.0f,   0.0f, 0.0f,  // top-left
+     1.0f,  1.0f,   1.0f, 0.0f,  // top-right
+};
+
+// Luma pitch alignment, keeps the chroma pitch at exactly half of it
+// and every row at the default GL_UNPACK_ALIGNMENT of 4
+#define PITCH_ALIGN 8
 
 GLESVideoWidget::GLESVideoWidget(QWidget *parent)
     : QWidget(parent),
       m_player(nullptr),
-      m_writeBuffer(0),
-      m_readBuffer(1),
       m_videoWidth(0),
       m_videoHeight(0),
-      m_hasFrame(false),
-      m_textureNeedsUpdate(false),
+      m_hasFrame(0),
+      m_renderThread(new RenderThread(this, this)),
       m_eglDisplay(EGL_NO_DISPLAY),
       m_eglSurface(EGL_NO_SURFACE),
       m_eglContext(EGL_NO_CONTEXT),
       m_eglConfig(nullptr),
       m_eglInitialized(false),
-      m_texture(0),
+      m_vertexBuffer(0),
       m_program(0),
       m_vertexShader(0),
       m_fragmentShader(0),
       m_positionAttr(0),
       m_texCoordAttr(0),
-      m_textureUniform(0),
+      m_scaleUniform(-1),
+      m_texScaleUniform(-1),
+      m_yuvUniform(-1),
+      m_texWidth(0),
+      m_texHeight(0),
       m_eglLib(nullptr),
       m_eglWebosLib(nullptr),
       m_glesLib(nullptr),
@@ -169,6 +227,14 @@ GLESVideoWidget::GLESVideoWidget(QWidget *parent)
       eglTerminate(nullptr),
       eglGetError(nullptr)
 {
+    memset(m_pitches, 0, sizeof(m_pitches));
+    memset(m_lines, 0, sizeof(m_lines));
+    memset(m_textures, 0, sizeof(m_textures));
+    m_scale[0] = m_scale[1] = 0.0f;
+    m_texScale[0] = m_texScale[1] = 0.0f;
+    m_hd = false;
+    m_yuvMatrix = -1;
+
     // Make widget suitable for OpenGL
     setAttribute(Qt::WA_OpaquePaintEvent);
     setAttribute(Qt::WA_NoSystemBackground);
@@ -185,6 +251,10 @@ GLESVideoWidget::GLESVideoWidget(QWidget *parent)
     if (!initEGL()) {
         fprintf(stderr, "GLESVideoWidget: EGL initialization failed, falling back to software\n");
         fflush(stderr);
+    } else {
+        // Hand the context over to the render thread
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        m_renderThread->start();
     }
 }
 
@@ -194,9 +264,32 @@ GLESVideoWidget::~GLESVideoWidget()
         libvlc_video_set_callbacks(m_player->core(), nullptr, nullptr, nullptr, nullptr);
         libvlc_video_set_format_callbacks(m_player->core(), nullptr, nullptr);
     }
+    m_renderThread->stop();
     cleanupEGL();
 }
 
+void GLESVideoWidget::attachRenderThread()
+{
+    if (eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext) != EGL_TRUE) {
+        fprintf(stderr, "GLESVideoWidget: eglMakeCurrent on render thread failed: 0x%x\n", eglGetError ? eglGetError() : -1);
+        fflush(stderr);
+    }
+}
+
+void GLESVideoWidget::detachRenderThread()
+{
+    eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+bool GLESVideoWidget::presentFrame()
+{
+    if (!m_eglInitialized || !m_hasFrame.loadAcquire()) {
+        return false;
+    }
+    renderFrame();
+    return true;
+}
+
 bool GLESVideoWidget::initEGL()
 {
     fprintf(stderr, "GLESVideoWidget: Loading EGL libraries...\n");
@@ -281,6 +374,12 @@ bool GLESVideoWidget::initEGL()
     LOAD_GLES(glDeleteTextures);
     LOAD_GLES(glActiveTexture);
     LOAD_GLES(glTexSubImage2D);
+    LOAD_GLES(glGenBuffers);
+    LOAD_GLES(glBindBuffer);
+    LOAD_GLES(glBufferData);
+    LOAD_GLES(glDeleteBuffers);
+    LOAD_GLES(glUniform2f);
+    LOAD_GLES(glUniform4f);
 
     #undef LOAD_GLES
 
@@ -412,13 +511,35 @@ bool GLESVideoWidget::initShaders()
     // Get attribute/uniform locations
     m_positionAttr = glGetAttribLocation(m_program, "a_position");
     m_texCoordAttr = glGetAttribLocation(m_program, "a_texCoord");
-    m_textureUniform = glGetUniformLocation(m_program, "u_texture");
+    m_scaleUniform = glGetUniformLocation(m_program, "u_scale");
+    m_texScaleUniform = glGetUniformLocation(m_program, "u_texScale");
+    m_yuvUniform = glGetUniformLocation(m_program, "u_yuv");
 
-    // Create texture
-    glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Samplers never change, the program stays in use
+    glUseProgram(m_program);
+    glUniform1i(glGetUniformLocation(m_program, "u_texY"), 0);
+    glUniform1i(glGetUniformLocation(m_program, "u_texU"), 1);
+    glUniform1i(glGetUniformLocation(m_program, "u_texV"), 2);
+
+    // Static quad, attributes point into the buffer from now on
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(m_positionAttr);
+    glEnableVertexAttribArray(m_texCoordAttr);
+    glVertexAttribPointer(m_positionAttr, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (const void *)0);
+    glVertexAttribPointer(m_texCoordAttr, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (const void *)(2 * sizeof(GLfloat)));
+
+    // Create plane textures, one per texture unit, storage follows the video size
+    glGenTextures(3, m_textures);
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
 
     fprintf(stderr, "GLESVideoWidget: Shaders initialized\n");
     fflush(stderr);
@@ -428,11 +549,18 @@ bool GLESVideoWidget::initShaders()
 void GLESVideoWidget::cleanupEGL()
 {
     if (m_eglDisplay != EGL_NO_DISPLAY) {
-        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        // The render thread has released the context, take it back to delete objects
+        if (m_eglContext != EGL_NO_CONTEXT) {
+            eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
+        }
 
-        if (m_texture) {
-            glDeleteTextures(1, &m_texture);
-            m_texture = 0;
+        if (m_textures[0]) {
+            glDeleteTextures(3, m_textures);
+            memset(m_textures, 0, sizeof(m_textures));
+        }
+        if (m_vertexBuffer) {
+            glDeleteBuffers(1, &m_vertexBuffer);
+            m_vertexBuffer = 0;
         }
         if (m_program) {
             glDeleteProgram(m_program);
@@ -447,6 +575,8 @@ void GLESVideoWidget::cleanupEGL()
             m_fragmentShader = 0;
         }
 
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
         if (m_eglContext != EGL_NO_CONTEXT) {
             eglDestroyContext(m_eglDisplay, m_eglContext);
         }
@@ -492,8 +622,8 @@ void GLESVideoWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
 
-    if (m_eglInitialized && m_hasFrame) {
-        renderFrame();
+    if (m_eglInitialized && m_hasFrame.loadAcquire()) {
+        m_renderThread->requestPresent();
     } else {
         // Fallback to black fill
         QPainter painter(this);
@@ -503,32 +633,31 @@ void GLESVideoWidget::paintEvent(QPaintEvent *event)
 
 void GLESVideoWidget::renderFrame()
 {
-    if (!m_eglInitialized || !m_hasFrame || m_videoWidth == 0 || m_videoHeight == 0) {
+    if (!m_eglInitialized || !m_hasFrame.loadAcquire() || m_videoWidth == 0 || m_videoHeight == 0) {
         return;
     }
 
-    // Make context current
-    eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
-
-    // Update texture if needed
-    if (m_textureNeedsUpdate) {
-        updateTexture();
-        m_textureNeedsUpdate = false;
+    // Upload planes if a new frame was decoded
+    updateTextures();
+    if (!m_texWidth) {
+        return;
     }
 
     // Set viewport
-    glViewport(0, 0, width(), height());
+    const int viewWidth = m_viewportWidth.load();
+    const int viewHeight = m_viewportHeight.load();
+    if (viewWidth <= 0 || viewHeight <= 0) {
+        return;
+    }
+    glViewport(0, 0, viewWidth, viewHeight);
 
     // Clear
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Use program
-    glUseProgram(m_program);
-
-    // Calculate aspect ratio correct coordinates
+    // Calculate aspect ratio correct scale of the quad
     float videoAspect = (float)m_videoWidth / (float)m_videoHeight;
-    float widgetAspect = (float)width() / (float)height();
+    float widgetAspect = (float)viewWidth / (float)viewHeight;
 
     float scaleX = 1.0f, scaleY = 1.0f;
     if (videoAspect > widgetAspect) {
@@ -537,44 +666,62 @@ void GLESVideoWidget::renderFrame()
         scaleX = videoAspect / widgetAspect;
     }
 
-    // Vertex data (position + texcoord interleaved)
-    GLfloat vertices[] = {
-        // Position         // TexCoord
-        -scaleX, -scaleY,   0.0f, 1.0f,  // bottom-left
-         scaleX, -scaleY,   1.0f, 1.0f,  // bottom-right
-        -scaleX,  scaleY,   0.0f, 0.0f,  // top-left
-         scaleX,  scaleY,   1.0f, 0.0f,  // top-right
-    };
-
-    // Bind texture
-    glActiveTexture(0x84C0); // GL_TEXTURE0
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    glUniform1i(m_textureUniform, 0);
-
-    // Set up vertex attributes
-    glEnableVertexAttribArray(m_positionAttr);
-    glEnableVertexAttribArray(m_texCoordAttr);
-    glVertexAttribPointer(m_positionAttr, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices);
-    glVertexAttribPointer(m_texCoordAttr, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices + 2);
+    if (scaleX != m_scale[0] || scaleY != m_scale[1]) {
+        m_scale[0] = scaleX;
+        m_scale[1] = scaleY;
+        glUniform2f(m_scaleUniform, scaleX, scaleY);
+    }
 
-    // Draw
+    // Program, vertex buffer and textures stay bound
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-    // Cleanup
-    glDisableVertexAttribArray(m_positionAttr);
-    glDisableVertexAttribArray(m_texCoordAttr);
-
     // Swap buffers
     eglSwapBuffers(m_eglDisplay, m_eglSurface);
+    m_tracer.presentFinished();
 }
 
-void GLESVideoWidget::updateTexture()
+void GLESVideoWidget::updateTextures()
 {
     m_mutex.lock();
-    const unsigned char *src = reinterpret_cast<const unsigned char*>(m_buffer[m_readBuffer].constData());
-    
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_videoWidth, m_videoHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, src);
+
+    // Only upload when a new frame was decoded
+    if (!m_ring.acquire()) {
+        m_mutex.unlock();
+        return;
+    }
+    m_tracer.presentStarted(m_ring.readSlot());
+
+    // Textures are as wide as the pitch, the shader crops the padding
+    if (m_pitches[0] != m_texWidth || m_lines[0] != m_texHeight) {
+        for (int i = 0; i < 3; ++i) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, m_pitches[i], m_lines[i], 0,
+                         GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
+        }
+        m_texWidth = m_pitches[0];
+        m_texHeight = m_lines[0];
+    }
+
+    const GLfloat texScaleX = (GLfloat)m_videoWidth / m_texWidth;
+    if (texScaleX != m_texScale[0]) {
+        m_texScale[0] = texScaleX;
+        m_texScale[1] = 1.0f;
+        glUniform2f(m_texScaleUniform, m_texScale[0], m_texScale[1]);
+    }
+
+    if (int(m_hd) != m_yuvMatrix) {
+        m_yuvMatrix = m_hd;
+        const GLfloat *yuv = m_hd ? yuvBT709 : yuvBT601;
+        glUniform4f(m_yuvUniform, yuv[0], yuv[1], yuv[2], yuv[3]);
+    }
+
+    const char *plane = m_buffer[m_ring.readSlot()].constData();
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_pitches[i], m_lines[i],
+                        GL_LUMINANCE, GL_UNSIGNED_BYTE, plane);
+        plane += m_pitches[i] * m_lines[i];
+    }
 
     m_mutex.unlock();
 }
@@ -582,9 +729,12 @@ void GLESVideoWidget::updateTexture()
 void GLESVideoWidget::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
+
+    // The viewport is set on the render thread with the next frame
+    m_viewportWidth.store(width());
+    m_viewportHeight.store(height());
     if (m_eglInitialized) {
-        eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
-        glViewport(0, 0, width(), height());
+        m_renderThread->requestPresent();
     }
 }
 
@@ -598,26 +748,17 @@ void GLESVideoWidget::hideEvent(QHideEvent *event)
     QWidget::hideEvent(event);
 }
 
-static int frameCount = 0;
-
-void GLESVideoWidget::onFrameReady()
-{
-    frameCount++;
-    m_textureNeedsUpdate = true;
-    update();
-
-    if (frameCount <= 5 || frameCount % 100 == 0) {
-        fprintf(stderr, "GLESVideoWidget: onFrameReady %d\n", frameCount);
-        fflush(stderr);
-    }
-}
-
 // Static callbacks
 
 void *GLESVideoWidget::lockCallback(void *opaque, void **planes)
 {
     GLESVideoWidget *self = static_cast<GLESVideoWidget*>(opaque);
-    planes[0] = self->m_buffer[self->m_writeBuffer].data();
+    char *plane = self->m_buffer[self->m_ring.writeSlot()].data();
+    self->m_tracer.frameLocked(self->m_ring.writeSlot());
+    for (int i = 0; i < 3; ++i) {
+        planes[i] = plane;
+        plane += self->m_pitches[i] * self->m_lines[i];
+    }
     return nullptr;
 }
 
@@ -629,15 +770,14 @@ void GLESVideoWidget::unlockCallback(void *opaque, void *picture, void *const *p
     GLESVideoWidget *self = static_cast<GLESVideoWidget*>(opaque);
 
     if (self->m_videoWidth > 0 && self->m_videoHeight > 0) {
-        self->m_mutex.lock();
-        int temp = self->m_writeBuffer;
-        self->m_writeBuffer = self->m_readBuffer;
-        self->m_readBuffer = temp;
-        self->m_hasFrame = true;
-        self->m_mutex.unlock();
+        self->m_tracer.frameDecoded(self->m_ring.writeSlot());
+        if (self->m_ring.publish()) {
+            self->m_tracer.frameDropped();
+        }
+        self->m_hasFrame.storeRelease(1);
     }
 
-    QMetaObject::invokeMethod(self, "onFrameReady", Qt::QueuedConnection);
+    self->m_renderThread->frameReady();
 }
 
 void GLESVideoWidget::displayCallback(void *opaque, void *picture)
@@ -655,34 +795,36 @@ unsigned GLESVideoWidget::formatCallback(void **opaque, char *chroma,
     fprintf(stderr, "GLESVideoWidget::formatCallback %ux%u incoming chroma=%.4s\n", *width, *height, chroma);
     fflush(stderr);
 
-    // Request RGBA format for OpenGL ES
-    memcpy(chroma, "RGBA", 4);
-
-    // Scale down resolution
-    unsigned scaledWidth = *width / VIDEO_SCALE_FACTOR;
-    unsigned scaledHeight = *height / VIDEO_SCALE_FACTOR;
-    scaledWidth = (scaledWidth / 2) * 2;
-    scaledHeight = (scaledHeight / 2) * 2;
+    // Request planar YUV, the GPU converts and scales
+    memcpy(chroma, "I420", 4);
 
-    *width = scaledWidth;
-    *height = scaledHeight;
+    const unsigned evenWidth = (*width + 1) & ~1u;
+    const unsigned evenHeight = (*height + 1) & ~1u;
 
-    self->m_videoWidth = scaledWidth;
-    self->m_videoHeight = scaledHeight;
+    self->m_videoWidth = evenWidth;
+    self->m_videoHeight = evenHeight;
 
-    *pitches = scaledWidth * 4;
-    *lines = scaledHeight;
+    pitches[0] = (evenWidth + PITCH_ALIGN - 1) & ~(PITCH_ALIGN - 1);
+    pitches[1] = pitches[2] = pitches[0] / 2;
+    lines[0] = evenHeight;
+    lines[1] = lines[2] = evenHeight / 2;
 
-    unsigned bufferSize = (*pitches) * (*lines);
-    self->m_buffer[0].resize(bufferSize);
-    self->m_buffer[0].fill(0);
-    self->m_buffer[1].resize(bufferSize);
-    self->m_buffer[1].fill(0);
-    self->m_writeBuffer = 0;
-    self->m_readBuffer = 1;
+    unsigned bufferSize = pitches[0] * lines[0] + 2 * pitches[1] * lines[1];
+    // The renderer only reads the buffers under m_mutex
+    self->m_mutex.lock();
+    memcpy(self->m_pitches, pitches, sizeof(self->m_pitches));
+    memcpy(self->m_lines, lines, sizeof(self->m_lines));
+    // Taller than PAL is HD, the shader switches to BT.709
+    self->m_hd = *height > 576;
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].resize(bufferSize);
+        self->m_buffer[i].fill(0);
+    }
+    self->m_ring.reset();
+    self->m_mutex.unlock();
 
-    fprintf(stderr, "GLESVideoWidget: Requested RGBA at %ux%u, buffer=%u bytes\n",
-            scaledWidth, scaledHeight, bufferSize);
+    fprintf(stderr, "GLESVideoWidget: Requested I420 at %ux%u, buffer=%u bytes\n",
+            evenWidth, evenHeight, bufferSize);
     fflush(stderr);
 
     return bufferSize;
@@ -693,9 +835,11 @@ void GLESVideoWidget::formatCleanupCallback(void *opaque)
     GLESVideoWidget *self = static_cast<GLESVideoWidget*>(opaque);
 
     self->m_mutex.lock();
-    self->m_buffer[0].clear();
-    self->m_buffer[1].clear();
-    self->m_hasFrame = false;
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].clear();
+    }
+    self->m_ring.reset();
+    self->m_hasFrame.storeRelease(0);
     self->m_videoWidth = 0;
     self->m_videoHeight = 0;
     self->m_mutex.unlock();
@@ -1,6 +1,7 @@
 /**
  * OpenGL ES 2.0 Video Widget for webOS
- * Uses EGL for hardware-accelerated rendering
+ * Uses EGL for hardware-accelerated rendering, decodes to I420 and
+ * converts and scales on the GPU
  */
 
 #ifndef GLESVIDEOWIDGET_H
@@ -9,9 +10,14 @@
 #include <QWidget>
 #include <QMutex>
 #include <QByteArray>
+#include <QAtomicInt>
 
 #include <vlc/vlc.h>
 
+#include "FrameRing.h"
+#include "FrameTracer.h"
+#include "RenderThread.h"
+
 // EGL/GLES types
 typedef void *EGLDisplay;
 typedef void *EGLSurface;
@@ -27,7 +33,7 @@ typedef unsigned int GLenum;
 
 class VlcMediaPlayer;
 
-class GLESVideoWidget : public QWidget
+class GLESVideoWidget : public QWidget, public FramePresenter
 {
     Q_OBJECT
 
@@ -37,21 +43,26 @@ public:
 
     void setMediaPlayer(VlcMediaPlayer *player);
 
+    // Per-frame latency and frame counters
+    VlcFrameStats *frameStats() { return m_tracer.stats(); }
+
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
     void showEvent(QShowEvent *event) override;
     void hideEvent(QHideEvent *event) override;
 
-private slots:
-    void onFrameReady();
-
 private:
+    // FramePresenter, called on the render thread which owns the EGL context
+    void attachRenderThread() override;
+    void detachRenderThread() override;
+    bool presentFrame() override;
+
     bool initEGL();
     void cleanupEGL();
     bool initShaders();
     void renderFrame();
-    void updateTexture();
+    void updateTextures();
 
     // Static callbacks for libvlc
     static void *lockCallback(void *opaque, void **planes);
@@ -65,14 +76,21 @@ private:
     VlcMediaPlayer *m_player;
     QMutex m_mutex;
 
-    // Double buffering for VLC frames
-    QByteArray m_buffer[2];
-    int m_writeBuffer;
-    int m_readBuffer;
+    // Frame buffers for VLC, one per ring slot
+    QByteArray m_buffer[VlcFrameRing::Slots];
+    VlcFrameRing m_ring;      // Hands frames from the decoder to the renderer
     unsigned m_videoWidth;
     unsigned m_videoHeight;
-    bool m_hasFrame;
-    bool m_textureNeedsUpdate;
+    unsigned m_pitches[3];    // I420 plane layout, set in formatCallback
+    unsigned m_lines[3];
+    bool m_hd;                // BT.709 rather than BT.601 colours
+    QAtomicInt m_hasFrame;    // Set by the vout thread, read by the GL thread
+
+    // Uploads and draws frames off the GUI thread
+    RenderThread *m_renderThread;
+    FrameTracer m_tracer;
+    QAtomicInt m_viewportWidth;
+    QAtomicInt m_viewportHeight;
 
     // EGL handles
     EGLDisplay m_eglDisplay;
@@ -82,13 +100,23 @@ private:
     bool m_eglInitialized;
 
     // OpenGL ES handles
-    GLuint m_texture;
+    GLuint m_textures[3];     // Y, U and V luminance textures
+    GLuint m_vertexBuffer;    // Static full screen quad
     GLuint m_program;
     GLuint m_vertexShader;
     GLuint m_fragmentShader;
     GLuint m_positionAttr;
     GLuint m_texCoordAttr;
-    GLuint m_textureUniform;
+    GLint m_scaleUniform;
+    GLint m_texScaleUniform;
+    GLint m_yuvUniform;
+
+    // Render thread state, uniforms and storage change only with the geometry
+    unsigned m_texWidth;
+    unsigned m_texHeight;
+    GLfloat m_scale[2];
+    GLfloat m_texScale[2];
+    int m_yuvMatrix;          // m_hd as last set in u_yuv, -1 before
 
     // Dynamic library handles
     void *m_eglLib;
@@ -31,14 +31,11 @@ static const char* fragmentShaderSource =
 GLVideoWidget::GLVideoWidget(QWidget *parent)
     : QOpenGLWidget(parent),
       m_player(nullptr),
-      m_writeBuffer(0),
-      m_readBuffer(1),
       m_width(0),
       m_height(0),
       m_textureWidth(0),
       m_textureHeight(0),
       m_hasFrame(false),
-      m_textureNeedsUpdate(false),
       m_textureAllocated(false),
       m_textureId(0),
       m_program(0),
@@ -241,7 +238,9 @@ void GLVideoWidget::paintGL()
     // Update texture if needed
     m_mutex.lock();
 
-    if (m_textureNeedsUpdate && m_buffer[m_readBuffer].size() > 0) {
+    // Upload only when a new frame was decoded, older ones were dropped by the ring
+    if (m_ring.acquire() && m_buffer[m_ring.readSlot()].size() > 0) {
+        m_tracer.presentStarted(m_ring.readSlot());
         glBindTexture(GL_TEXTURE_2D, m_textureId);
 
         // Check if we need to reallocate texture (size changed or first time)
@@ -253,14 +252,14 @@ void GLVideoWidget::paintGL()
             }
             // First time or size changed - allocate with glTexImage2D
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0,
-                         GL_RGBA, GL_UNSIGNED_BYTE, m_buffer[m_readBuffer].constData());
+                         GL_RGBA, GL_UNSIGNED_BYTE, m_buffer[m_ring.readSlot()].constData());
             m_textureWidth = m_width;
             m_textureHeight = m_height;
             m_textureAllocated = true;
         } else {
             // Same size - use faster glTexSubImage2D
             glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height,
-                            GL_RGBA, GL_UNSIGNED_BYTE, m_buffer[m_readBuffer].constData());
+                            GL_RGBA, GL_UNSIGNED_BYTE, m_buffer[m_ring.readSlot()].constData());
         }
 
         GLenum err = glGetError();
@@ -269,7 +268,6 @@ void GLVideoWidget::paintGL()
             fflush(stderr);
         }
 
-        m_textureNeedsUpdate = false;
 
         if (glPaintCount <= 20 || glPaintCount % 30 == 1) {
             fprintf(stderr, "paintGL %d: texture updated\n", glPaintCount);
@@ -306,6 +304,7 @@ void GLVideoWidget::paintGL()
 
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
+    m_tracer.presentFinished();
 
     if (glPaintCount <= 20 || glPaintCount % 30 == 1) {
         fprintf(stderr, "paintGL %d: draw complete\n", glPaintCount);
@@ -330,7 +329,7 @@ void GLVideoWidget::onFrameReady()
         return;
     }
 
-    // m_textureNeedsUpdate is already set in unlockCallback
+    // The new frame is picked up from the ring in paintGL
     update();  // Request Qt repaint
 }
 
@@ -340,7 +339,8 @@ static int frameCount = 0;
 void *GLVideoWidget::lockCallback(void *opaque, void **planes)
 {
     GLVideoWidget *self = static_cast<GLVideoWidget*>(opaque);
-    planes[0] = self->m_buffer[self->m_writeBuffer].data();
+    planes[0] = self->m_buffer[self->m_ring.writeSlot()].data();
+    self->m_tracer.frameLocked(self->m_ring.writeSlot());
     return nullptr;
 }
 
@@ -353,7 +353,7 @@ void GLVideoWidget::unlockCallback(void *opaque, void *picture, void *const *pla
     frameCount++;
 
     if (frameCount <= 5) {
-        const unsigned char* data = reinterpret_cast<const unsigned char*>(self->m_buffer[self->m_writeBuffer].constData());
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(self->m_buffer[self->m_ring.writeSlot()].constData());
         fprintf(stderr, "GL unlockCallback: frame=%d w=%d h=%d first8bytes: %02x%02x%02x%02x %02x%02x%02x%02x\n",
                 frameCount, self->m_width, self->m_height,
                 data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7]);
@@ -361,13 +361,11 @@ void GLVideoWidget::unlockCallback(void *opaque, void *picture, void *const *pla
     }
 
     if (self->m_width > 0 && self->m_height > 0) {
-        self->m_mutex.lock();
-        int temp = self->m_writeBuffer;
-        self->m_writeBuffer = self->m_readBuffer;
-        self->m_readBuffer = temp;
+        self->m_tracer.frameDecoded(self->m_ring.writeSlot());
+        if (self->m_ring.publish()) {
+            self->m_tracer.frameDropped();
+        }
         self->m_hasFrame = true;
-        self->m_textureNeedsUpdate = true;  // Set here to avoid race condition
-        self->m_mutex.unlock();
 
         if (frameCount % 30 == 1) {
             fprintf(stderr, "GL Frame %d: %dx%d swapped\n", frameCount, self->m_width, self->m_height);
@@ -407,14 +405,16 @@ unsigned GLVideoWidget::formatCallback(void **opaque, char *chroma,
     *lines = self->m_height;
 
     unsigned bufferSize = (*pitches) * (*lines);
-    self->m_buffer[0].resize(bufferSize);
-    self->m_buffer[0].fill(0);
-    self->m_buffer[1].resize(bufferSize);
-    self->m_buffer[1].fill(0);
-    self->m_writeBuffer = 0;
-    self->m_readBuffer = 1;
-
-    fprintf(stderr, "GL Requested chroma=RGBA, double buffer=%u bytes each\n", bufferSize);
+    // paintGL only reads the buffers under m_mutex
+    self->m_mutex.lock();
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].resize(bufferSize);
+        self->m_buffer[i].fill(0);
+    }
+    self->m_ring.reset();
+    self->m_mutex.unlock();
+
+    fprintf(stderr, "GL Requested chroma=RGBA, %d buffers of %u bytes each\n", VlcFrameRing::Slots, bufferSize);
     fflush(stderr);
 
     return bufferSize;
@@ -428,10 +428,11 @@ void GLVideoWidget::formatCleanupCallback(void *opaque)
     fflush(stderr);
 
     self->m_mutex.lock();
-    self->m_buffer[0].clear();
-    self->m_buffer[1].clear();
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].clear();
+    }
+    self->m_ring.reset();
     self->m_hasFrame = false;
-    self->m_textureNeedsUpdate = false;
     self->m_textureAllocated = false;  // Force texture reallocation on next video
     self->m_width = 0;
     self->m_height = 0;
@@ -12,6 +12,9 @@
 
 #include <vlc/vlc.h>
 
+#include "FrameRing.h"
+#include "FrameTracer.h"
+
 class VlcMediaPlayer;
 
 class GLVideoWidget : public QOpenGLWidget, protected QOpenGLFunctions
@@ -24,6 +27,9 @@ public:
 
     void setMediaPlayer(VlcMediaPlayer *player);
 
+    // Per-frame latency and frame counters
+    VlcFrameStats *frameStats() { return m_tracer.stats(); }
+
 protected:
     void initializeGL() override;
     void paintGL() override;
@@ -44,16 +50,15 @@ private:
 
     VlcMediaPlayer *m_player;
     QMutex m_mutex;
-    QByteArray m_buffer[2];
-    int m_writeBuffer;
-    int m_readBuffer;
+    QByteArray m_buffer[VlcFrameRing::Slots];
+    VlcFrameRing m_ring;       // Hands frames from the decoder to paintGL
     unsigned m_width;
     unsigned m_height;
     unsigned m_textureWidth;   // Allocated texture size
     unsigned m_textureHeight;
     bool m_hasFrame;
-    bool m_textureNeedsUpdate;
     bool m_textureAllocated;   // True after first glTexImage2D
+    FrameTracer m_tracer;
 
     // OpenGL
     GLuint m_textureId;
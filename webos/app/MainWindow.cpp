@@ -33,17 +33,19 @@ static void logMsg(const char *fmt, ...) {
 #include "Media.h"
 #include "MediaPlayer.h"
 #include "Audio.h"
+#include "FrameStats.h"
 
 #include "VideoWidget.h"
 #include "GLVideoWidget.h"
 #include "FBVideoWidget.h"
 #include "GLESVideoWidget.h"
-<<<<<<< HEAD
 // NOTE: SDLVideoWidget removed from build - SDL video conflicts with Qt on webOS
-=======
 #include "VideoProber.h"
+#include "MediaLibrary.h"
+#include "Thumbnailer.h"
+#include "TranscodeQueue.h"
+#include "ProgressiveTranscoder.h"
 #include "TranscodeDialog.h"
->>>>>>> d8b4b3134a42e56737b93421ed68964cf4b7e198
 
 // Video rendering mode:
 // 0 = Software (VideoWidget with QPainter)
@@ -58,14 +60,35 @@ MainWindow::MainWindow(QWidget *parent)
       m_instance(nullptr),
       m_media(nullptr),
       m_player(nullptr),
+      m_prober(new VideoProber(this)),
+      m_library(new MediaLibrary(m_prober, this)),
+      m_thumbnailer(nullptr),
+      m_transcodeQueue(new TranscodeQueue(this)),
+      m_progressive(nullptr),
+      m_segment(-1),
+      m_segmentOffsetMs(0),
+      m_segmentWaiting(false),
       m_fbVideoWidget(nullptr),
       m_sdlVideoWidget(nullptr),
+      m_frameStats(nullptr),
       m_seeking(false)
 {
     setupVLC();
+    m_prober->setInstance(m_instance);
+    m_thumbnailer = new Thumbnailer(m_instance, m_prober, this);
+    m_progressive = new ProgressiveTranscoder(m_instance, this);
     setupUI();
     setupConnections();
 
+    // Loads the saved index right away, scanning and probing run in the background
+    m_library->setInstance(m_instance);
+    m_library->setRoots(QStringList() << "/media/internal");
+    m_library->start();
+
+    // Resumes jobs interrupted by the last exit
+    m_transcodeQueue->setInstance(m_instance);
+    m_transcodeQueue->start();
+
     // Position update timer
     m_positionTimer = new QTimer(this);
     connect(m_positionTimer, &QTimer::timeout, this, &MainWindow::updatePosition);
@@ -77,6 +100,11 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // These hold media and players of the instance
+    delete m_library;
+    delete m_thumbnailer;
+    delete m_transcodeQueue;
+    delete m_progressive;
     delete m_media;
     delete m_player;
     delete m_instance;
@@ -140,6 +168,7 @@ void MainWindow::setupUI()
     SDLVideoWidget *videoWidget = new SDLVideoWidget(this);
     videoWidget->setMediaPlayer(m_player);
     m_videoWidget = videoWidget;
+    m_frameStats = videoWidget->frameStats();
     m_sdlVideoWidget = videoWidget;  // Keep reference for state connections
 #elif VIDEO_RENDER_MODE == 3
     // OpenGL ES 2.0 with EGL - hardware accelerated but has touch flicker
@@ -147,12 +176,14 @@ void MainWindow::setupUI()
     GLESVideoWidget *videoWidget = new GLESVideoWidget(this);
     videoWidget->setMediaPlayer(m_player);
     m_videoWidget = videoWidget;
+    m_frameStats = videoWidget->frameStats();
 #elif VIDEO_RENDER_MODE == 2
     // Direct framebuffer rendering - bypasses Qt
     logMsg("MainWindow: Using FBVideoWidget (framebuffer)\n");
     FBVideoWidget *videoWidget = new FBVideoWidget(this);
     videoWidget->setMediaPlayer(m_player);
     m_videoWidget = videoWidget;
+    m_frameStats = videoWidget->frameStats();
     m_fbVideoWidget = videoWidget;  // Keep reference for state connections
 #elif VIDEO_RENDER_MODE == 1
     // GPU-accelerated rendering via OpenGL ES 2.0
@@ -160,12 +191,14 @@ void MainWindow::setupUI()
     GLVideoWidget *videoWidget = new GLVideoWidget(this);
     videoWidget->setMediaPlayer(m_player);
     m_videoWidget = videoWidget;
+    m_frameStats = videoWidget->frameStats();
 #else
     // Software rendering for webOS
     logMsg("MainWindow: Using VideoWidget (software)\n");
     VideoWidget *videoWidget = new VideoWidget(this);
     videoWidget->setMediaPlayer(m_player);
     m_videoWidget = videoWidget;
+    m_frameStats = videoWidget->frameStats();
 #endif
     m_videoWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     mainLayout->addWidget(m_videoWidget, 1);
@@ -236,6 +269,12 @@ void MainWindow::setupConnections()
     });
     connect(m_volumeSlider, &QSlider::valueChanged, this, &MainWindow::onVolumeChanged);
 
+    // Probe results, cached files arrive before probeAsync() returns
+    connect(m_prober, &VideoProber::probed, this, &MainWindow::onProbed);
+
+    connect(m_progressive, &ProgressiveTranscoder::segmentReady, this, &MainWindow::onSegmentReady);
+    connect(m_progressive, &ProgressiveTranscoder::segmentFailed, this, &MainWindow::onSegmentFailed);
+
     // VLC connections - detailed logging for debugging
     connect(m_player, &VlcMediaPlayer::stateChanged, this, &MainWindow::updateState);
     connect(m_player, &VlcMediaPlayer::error, this, &MainWindow::onVlcError);
@@ -248,21 +287,41 @@ void MainWindow::setupConnections()
     connect(m_player, static_cast<void(VlcMediaPlayer::*)(int)>(&VlcMediaPlayer::buffering),
             this, &MainWindow::onVlcBuffering);
 
+    // Background transcodes yield the CPU while a video plays, onVlcEnd() covers the end.
+    // Playback state reactions skip the events of a restart for a new decode size.
+    connect(m_player, &VlcMediaPlayer::playing, this, [this]() {
+        if (!isRestartingInput()) m_transcodeQueue->setPlaybackActive(true);
+    });
+    connect(m_player, &VlcMediaPlayer::paused, this, [this]() {
+        if (!isRestartingInput()) m_transcodeQueue->setPlaybackActive(false);
+    });
+    connect(m_player, &VlcMediaPlayer::stopped, this, [this]() {
+        if (!isRestartingInput()) m_transcodeQueue->setPlaybackActive(false);
+    });
+
     // SDLVideoWidget connections removed - SDL video conflicts with Qt on webOS
 
     // FBVideoWidget playback state connections - hide/show UI based on playback
     if (m_fbVideoWidget) {
-        connect(m_player, &VlcMediaPlayer::playing, m_fbVideoWidget, &FBVideoWidget::onPlaybackStarted);
-        connect(m_player, &VlcMediaPlayer::paused, m_fbVideoWidget, &FBVideoWidget::onPlaybackStopped);
-        connect(m_player, &VlcMediaPlayer::stopped, m_fbVideoWidget, &FBVideoWidget::onPlaybackStopped);
-        connect(m_player, &VlcMediaPlayer::end, m_fbVideoWidget, &FBVideoWidget::onPlaybackStopped);
+        connect(m_player, &VlcMediaPlayer::playing, this, [this]() {
+            if (!isRestartingInput()) m_fbVideoWidget->onPlaybackStarted();
+        });
+        connect(m_player, &VlcMediaPlayer::paused, this, [this]() {
+            if (!isRestartingInput()) m_fbVideoWidget->onPlaybackStopped();
+        });
+        connect(m_player, &VlcMediaPlayer::stopped, this, [this]() {
+            if (!isRestartingInput()) m_fbVideoWidget->onPlaybackStopped();
+        });
 
         // Hide Qt UI only after first video frame is rendered (avoids black screen)
         connect(m_fbVideoWidget, &FBVideoWidget::firstFrameReady, this, &MainWindow::hideForPlayback);
-        // Show Qt UI when stopped/paused
-        connect(m_player, &VlcMediaPlayer::paused, this, &MainWindow::showForUI);
-        connect(m_player, &VlcMediaPlayer::stopped, this, &MainWindow::showForUI);
-        connect(m_player, &VlcMediaPlayer::end, this, &MainWindow::showForUI);
+        // Show Qt UI when stopped/paused, or at the end in onVlcEnd()
+        connect(m_player, &VlcMediaPlayer::paused, this, [this]() {
+            if (!isRestartingInput()) showForUI();
+        });
+        connect(m_player, &VlcMediaPlayer::stopped, this, [this]() {
+            if (!isRestartingInput()) showForUI();
+        });
 
         // When user taps during playback, pause and show UI
         connect(m_fbVideoWidget, &FBVideoWidget::tapped, this, &MainWindow::onVideoTapped);
@@ -276,8 +335,18 @@ void MainWindow::openFile(const QString &path)
 {
     logMsg("MainWindow::openFile: %s\n", path.toStdString().c_str());
 
-    // Probe video to check resolution
-    VideoProber::VideoInfo info = VideoProber::probe(path);
+    // Probe video to check resolution, onProbed() continues
+    m_probingPath = path;
+    m_prober->probeAsync(path);
+}
+
+void MainWindow::onProbed(const QString &path, const VideoProber::VideoInfo &info)
+{
+    // Another file was opened while this one was probed
+    if (path != m_probingPath) {
+        return;
+    }
+    m_probingPath.clear();
 
     if (info.valid && VideoProber::isHD(info)) {
         logMsg("MainWindow: HD video detected (%dx%d)\n", info.width, info.height);
@@ -291,36 +360,79 @@ void MainWindow::openFile(const QString &path)
             return;
         }
 
-        // Offer transcoding
-        TranscodeDialog dialog(this);
-        dialog.showOffer(info, path);
-
-        int result = dialog.exec();
-        if (result == TranscodeDialog::Transcode || result == TranscodeDialog::TranscodeComplete) {
-            // User completed transcoding, play the 480p version
-            logMsg("MainWindow: Transcode complete, playing 480p version\n");
-            playFile(dialog.outputPath());
-        } else if (result == TranscodeDialog::PlayAnyway) {
-            // User chose to play HD version anyway
-            logMsg("MainWindow: User chose to play HD version anyway\n");
-            playFile(path);
+        offerTranscode(path, info);
+    } else if (TranscodeEngine::needsConversion(path, info)) {
+        // SD video in MKV, AVI and the like, a converted copy plays better
+        const QString converted = VideoProber::get480pPath(path);
+        if (VideoProber::has480pVersion(path)) {
+            logMsg("MainWindow: Converted version exists, playing: %s\n",
+                   converted.toStdString().c_str());
+            playFile(converted);
+            return;
         }
-        // Cancelled: do nothing
+
+        // Converting uses storage and CPU, the user decides
+        logMsg("MainWindow: Offering %s conversion of SD video\n",
+               TranscodeEngine::modeString(TranscodeEngine::chooseMode(info)).toStdString().c_str());
+        offerTranscode(path, info);
     } else {
-        // SD video or probe failed - play directly
+        // SD video in MP4 or probe failed - play directly
         playFile(path);
     }
 }
 
-void MainWindow::playFile(const QString &path)
+void MainWindow::offerTranscode(const QString &path, const VideoProber::VideoInfo &info)
+{
+    TranscodeDialog dialog(this);
+    dialog.setInstance(m_instance);
+    dialog.showOffer(info, path);
+
+    // Poster frame, grabbed while the offer is shown unless it is cached
+    dialog.setPoster(m_thumbnailer->thumbnail(path));
+    connect(m_thumbnailer, &Thumbnailer::thumbnailReady, &dialog,
+            [&dialog, path](const QString &filePath, const QImage &image) {
+        if (filePath == path) {
+            dialog.setPoster(image);
+        }
+    });
+
+    int result = dialog.exec();
+    if (result == TranscodeDialog::Transcode || result == TranscodeDialog::TranscodeComplete) {
+        // User completed transcoding, play the converted version
+        logMsg("MainWindow: Transcode complete, playing converted version\n");
+        playFile(dialog.outputPath());
+    } else if (result == TranscodeDialog::PlayProgressive) {
+        logMsg("MainWindow: Playing while converting to 480p\n");
+        startProgressive(path, info);
+    } else if (result == TranscodeDialog::TranscodeLater) {
+        logMsg("MainWindow: Queued transcode, playing original version\n");
+        m_transcodeQueue->enqueue(path, VideoProber::get480pPath(path), info.durationMs, 0,
+                                  TranscodeEngine::chooseMode(info));
+        playFile(path);
+    } else if (result == TranscodeDialog::PlayAnyway) {
+        // User chose to play the original anyway
+        logMsg("MainWindow: User chose to play original version anyway\n");
+        playFile(path);
+    }
+    // Cancelled: do nothing
+}
+
+void MainWindow::playFile(const QString &path, int startMs)
 {
     logMsg("MainWindow::playFile: %s\n", path.toStdString().c_str());
 
+    // Any other file ends progressive playback
+    stopProgressive();
+
     if (m_media) {
         delete m_media;
     }
 
+    endInputRestart();
     m_media = new VlcMedia(path, true, m_instance);
+    if (startMs > 0) {
+        m_media->setOption(QString(":start-time=%1").arg(startMs / 1000.0));
+    }
     logMsg("MainWindow: VlcMedia created, opening with player\n");
 
     m_player->open(m_media);
@@ -334,6 +446,114 @@ void MainWindow::playFile(const QString &path)
     m_titleLabel->setText(fileInfo.fileName());
 }
 
+void MainWindow::startProgressive(const QString &path, const VideoProber::VideoInfo &info)
+{
+    m_player->stop();
+
+    QFileInfo fileInfo(path);
+    m_titleLabel->setText(fileInfo.fileName());
+    m_timeLabel->setText("Converting...");
+
+    // Set first, a failure is reported from within start()
+    m_segment = 0;
+    m_segmentOffsetMs = 0;
+    m_segmentWaiting = true;
+    m_progressive->start(path, info.durationMs);
+}
+
+void MainWindow::stopProgressive()
+{
+    if (m_segment < 0) {
+        return;
+    }
+
+    logMsg("MainWindow: Progressive playback stopped\n");
+    m_progressive->stop();
+    m_segment = -1;
+    m_segmentOffsetMs = 0;
+    m_segmentWaiting = false;
+}
+
+void MainWindow::playSegment(int index, int offsetMs)
+{
+    logMsg("MainWindow: Playing segment %d at %d ms\n", index, offsetMs);
+
+    m_segment = index;
+    m_segmentOffsetMs = 0;
+    m_segmentWaiting = false;
+    m_progressive->setPosition(index * ProgressiveTranscoder::segmentDurationMs() + offsetMs);
+
+    // A failure reported from within setPosition() plays the HD file already
+    if (m_segment != index) {
+        return;
+    }
+
+    if (m_media) {
+        delete m_media;
+    }
+
+    endInputRestart();
+    m_media = new VlcMedia(m_progressive->segmentPath(index), true, m_instance);
+    if (offsetMs > 0) {
+        m_media->setOption(QString(":start-time=%1").arg(offsetMs / 1000.0));
+    }
+    m_player->open(m_media);
+}
+
+void MainWindow::waitForSegment(int index, int offsetMs)
+{
+    logMsg("MainWindow: Waiting for segment %d\n", index);
+
+    // Converting this segment comes first now
+    m_segment = index;
+    m_segmentOffsetMs = offsetMs;
+    m_segmentWaiting = true;
+    m_progressive->setPosition(index * ProgressiveTranscoder::segmentDurationMs() + offsetMs);
+
+    // Played the HD file after a failure reported from within setPosition()
+    if (m_segment != index) {
+        return;
+    }
+
+    // Failed before, it is not converted again
+    if (m_progressive->isFailed(index)) {
+        logMsg("MainWindow: Segment %d failed before, playing the HD file\n", index);
+        playInputForSegment();
+        return;
+    }
+
+    m_timeLabel->setText("Converting...");
+}
+
+void MainWindow::onSegmentReady(int index, const QString &path)
+{
+    Q_UNUSED(path)
+
+    if (m_segmentWaiting && index == m_segment) {
+        playSegment(index, m_segmentOffsetMs);
+    }
+}
+
+void MainWindow::onSegmentFailed(int index, const QString &message)
+{
+    // Segments further ahead are dealt with once playback gets there
+    if (m_segment < 0 || index != m_segment) {
+        return;
+    }
+
+    logMsg("MainWindow: Segment %d failed (%s), playing the HD file\n",
+           index, message.toStdString().c_str());
+    playInputForSegment();
+}
+
+void MainWindow::playInputForSegment()
+{
+    // Playback would stop at this segment, continue with the original instead
+    int timeMs = m_segment * ProgressiveTranscoder::segmentDurationMs();
+    timeMs += m_segmentWaiting ? m_segmentOffsetMs : qMax(0, m_player->time());
+    playFile(m_progressive->inputPath(), timeMs);
+}
+
 void MainWindow::onOpenFile()
 {
     // Default to internal storage on webOS
@@ -357,6 +577,7 @@ void MainWindow::onPlayPause()
 {
     if (!m_player) return;
 
+    endInputRestart();
     if (m_player->state() == Vlc::Playing) {
         m_player->pause();
     } else {
@@ -366,13 +587,39 @@ void MainWindow::onPlayPause()
 
 void MainWindow::onStop()
 {
+    endInputRestart();
     if (m_player) {
         m_player->stop();
     }
+
+    // Segments are not needed anymore, nor converted further
+    stopProgressive();
 }
 
 void MainWindow::onSeek(int position)
 {
+    // The slider spans the whole file, the player only the current segment
+    if (m_segment >= 0 && m_progressive->durationMs() > 0) {
+        const int segmentMs = ProgressiveTranscoder::segmentDurationMs();
+        const int target = static_cast<int>(qint64(position) * m_progressive->durationMs() / 1000);
+        const int index = m_progressive->segmentAt(target);
+        const int offsetMs = target - index * segmentMs;
+
+        const Vlc::State state = m_player->state();
+        if (index == m_segment && !m_segmentWaiting
+                && (state == Vlc::Playing || state == Vlc::Paused)) {
+            m_player->setTime(offsetMs);
+            m_progressive->setPosition(target);
+        } else if (m_progressive->isReady(index)) {
+            playSegment(index, offsetMs);
+        } else {
+            endInputRestart();
+            m_player->stop();
+            waitForSegment(index, offsetMs);
+        }
+        return;
+    }
+
     if (m_player && m_player->length() > 0) {
         float pos = position / 1000.0f;
         m_player->setPosition(pos);
@@ -390,9 +637,18 @@ void MainWindow::updatePosition()
 {
     if (!m_player || m_seeking) return;
 
+    // Keeps showing that the next segment is being converted
+    if (m_segmentWaiting) return;
+
     int length = m_player->length();
     int time = m_player->time();
 
+    // Segment times are relative to the segment
+    if (m_segment >= 0 && m_progressive->durationMs() > 0) {
+        time += m_segment * ProgressiveTranscoder::segmentDurationMs();
+        length = m_progressive->durationMs();
+    }
+
     if (length > 0) {
         int pos = static_cast<int>((time * 1000.0) / length);
         m_seekSlider->setValue(pos);
@@ -405,7 +661,8 @@ void MainWindow::updatePosition()
 
 void MainWindow::updateState()
 {
-    if (!m_player) return;
+    // A restart for a new decode size passes through stopped
+    if (!m_player || isRestartingInput()) return;
 
     Vlc::State state = m_player->state();
 
@@ -457,12 +714,35 @@ void MainWindow::onVideoTapped()
 {
     logMsg( "MainWindow: Video tapped - pausing and showing UI\n");
     
+    endInputRestart();
     if (m_player && m_player->state() == Vlc::Playing) {
         m_player->pause();
     }
     // showForUI will be called by the paused signal
 }
 
+void MainWindow::logFrameStats()
+{
+    if (!m_frameStats || !m_frameStats->delivered()) {
+        return;
+    }
+
+    // Latency of the video widget since the last report, in microseconds
+    logMsg("Frames: %d delivered, %d presented, %d dropped, %.1f fps\n",
+           m_frameStats->delivered(), m_frameStats->presented(),
+           m_frameStats->dropped(), m_frameStats->fps());
+    logMsg("Latency p50/p95: decode %d/%d, queue %d/%d, present %d/%d, total %d/%d us\n",
+           m_frameStats->percentile(VlcFrameStats::DecodeStage, 50),
+           m_frameStats->percentile(VlcFrameStats::DecodeStage, 95),
+           m_frameStats->percentile(VlcFrameStats::QueueStage, 50),
+           m_frameStats->percentile(VlcFrameStats::QueueStage, 95),
+           m_frameStats->percentile(VlcFrameStats::PresentStage, 50),
+           m_frameStats->percentile(VlcFrameStats::PresentStage, 95),
+           m_frameStats->percentile(VlcFrameStats::TotalStage, 50),
+           m_frameStats->percentile(VlcFrameStats::TotalStage, 95));
+    m_frameStats->reset();
+}
+
 QString MainWindow::formatTime(int ms) const
 {
     int seconds = ms / 1000;
@@ -474,6 +754,19 @@ QString MainWindow::formatTime(int ms) const
         .arg(seconds, 2, 10, QChar('0'));
 }
 
+bool MainWindow::isRestartingInput() const
+{
+    return m_fbVideoWidget && m_fbVideoWidget->isRestarting();
+}
+
+void MainWindow::endInputRestart()
+{
+    // A user action, the events of the player are wanted again
+    if (m_fbVideoWidget) {
+        m_fbVideoWidget->endRestart();
+    }
+}
+
 void MainWindow::onVlcError()
 {
     logMsg("*** VLC ERROR: Playback error occurred ***\n");
@@ -501,12 +794,34 @@ void MainWindow::onVlcPaused()
 
 void MainWindow::onVlcStopped()
 {
-    logMsg("VLC signal: stopped\n");
+    logMsg("VLC signal: stopped%s\n", isRestartingInput() ? " (decode size restart)" : "");
+    if (!isRestartingInput()) {
+        logFrameStats();
+    }
 }
 
 void MainWindow::onVlcEnd()
 {
     logMsg("VLC signal: end reached\n");
+
+    // The end of a segment, not of the video
+    if (m_segment >= 0 && m_segment + 1 < m_progressive->segmentCount()) {
+        const int next = m_segment + 1;
+        if (m_progressive->isReady(next)) {
+            playSegment(next, 0);
+            return;
+        }
+        // Playback caught up with the conversion
+        waitForSegment(next, 0);
+    }
+
+    m_transcodeQueue->setPlaybackActive(false);
+    logFrameStats();
+
+    if (m_fbVideoWidget) {
+        m_fbVideoWidget->onPlaybackStopped();
+        showForUI();
+    }
 }
 
 void MainWindow::onVlcBuffering(int percent)
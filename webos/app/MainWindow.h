@@ -11,16 +11,20 @@
 #include <QLabel>
 #include <QTimer>
 
+#include "VideoProber.h"
+
 // Forward declarations
 class VlcInstance;
 class VlcMedia;
 class VlcMediaPlayer;
+class MediaLibrary;
+class Thumbnailer;
+class TranscodeQueue;
+class ProgressiveTranscoder;
 class FBVideoWidget;
-<<<<<<< HEAD
 class SDLVideoWidget;
-=======
 class TranscodeDialog;
->>>>>>> d8b4b3134a42e56737b93421ed68964cf4b7e198
+class VlcFrameStats;
 
 class MainWindow : public QMainWindow
 {
@@ -54,12 +58,24 @@ private slots:
     void onVlcStopped();
     void onVlcEnd();
     void onVlcBuffering(int percent);
+    void onProbed(const QString &path, const VideoProber::VideoInfo &info);
+    void onSegmentReady(int index, const QString &path);
+    void onSegmentFailed(int index, const QString &message);
 
 private:
     void setupUI();
     void setupVLC();
     void setupConnections();
-    void playFile(const QString &path);  // Actually start playback
+    void playFile(const QString &path, int startMs = 0);  // Actually start playback
+    void offerTranscode(const QString &path, const VideoProber::VideoInfo &info);
+    void startProgressive(const QString &path, const VideoProber::VideoInfo &info);
+    void stopProgressive();
+    void playSegment(int index, int offsetMs);
+    void waitForSegment(int index, int offsetMs);
+    void playInputForSegment();
+    void logFrameStats();
+    bool isRestartingInput() const;
+    void endInputRestart();
     QString formatTime(int ms) const;
 
     // VLC components
@@ -67,10 +83,31 @@ private:
     VlcMedia *m_media;
     VlcMediaPlayer *m_player;
 
+    // Media probing, m_probingPath is the file waiting for its result
+    VideoProber *m_prober;
+    QString m_probingPath;
+
+    // Indexes /media/internal in the background
+    MediaLibrary *m_library;
+
+    // Poster frames, created once the VLC instance exists
+    Thumbnailer *m_thumbnailer;
+
+    // Background 480p conversions, kept across restarts
+    TranscodeQueue *m_transcodeQueue;
+
+    // HD files played from 480p segments converted just ahead. m_segment is
+    // the segment played or waited for, -1 without progressive playback.
+    ProgressiveTranscoder *m_progressive;
+    int m_segment;
+    int m_segmentOffsetMs;   // Start position in m_segment once it is ready
+    bool m_segmentWaiting;
+
     // UI components
     QWidget *m_videoWidget;
     FBVideoWidget *m_fbVideoWidget;    // For FB mode state connections
     SDLVideoWidget *m_sdlVideoWidget;  // For SDL mode state connections
+    VlcFrameStats *m_frameStats;       // Of the video widget, logged after playback
     QWidget *m_controlsWidget;
     QPushButton *m_playButton;
     QPushButton *m_stopButton;
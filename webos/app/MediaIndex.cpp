@@ -0,0 +1,380 @@
+/**
+ * Media Index - compact on-disk index of the media library
+ */
+
+#include "MediaIndex.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+
+#include <string.h>
+
+// 'VLIX', bump the version when Record changes
+#define INDEX_MAGIC 0x58494c56
+#define INDEX_VERSION 1
+
+// Entry flags
+#define INDEX_FLAG_VALID 0x1
+
+struct MediaIndex::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 count;
+    quint32 stringsSize;
+};
+
+// Strings are offsets into a table of NUL terminated UTF-8, offset 0 is ""
+struct MediaIndex::Record {
+    quint32 path;
+    quint32 codec;
+    quint32 audioCodec;
+    quint32 title;
+    quint32 artist;
+    quint32 album;
+    qint64 size;
+    qint64 modified;
+    qint32 durationMs;
+    qint32 bitrate;
+    float frameRate;
+    quint32 flags;
+    quint16 width;
+    quint16 height;
+    quint16 sarNum;
+    quint16 sarDen;
+};
+
+namespace {
+
+// Byte order of the UTF-8 paths, the records are sorted by it
+bool pathLess(const QByteArray &a, const QByteArray &b)
+{
+    return qstrcmp(a, b) < 0;
+}
+
+// Collects the string table, codec names and artists repeat a lot
+class StringTable
+{
+public:
+    StringTable() : m_data(1, '\0') {}
+
+    quint32 add(const QString &string)
+    {
+        if (string.isEmpty()) {
+            return 0;
+        }
+
+        const QByteArray utf8 = string.toUtf8();
+        const auto it = m_offsets.constFind(utf8);
+        if (it != m_offsets.constEnd()) {
+            return it.value();
+        }
+
+        const quint32 offset = m_data.size();
+        m_data.append(utf8.constData(), utf8.size() + 1);
+        m_offsets.insert(utf8, offset);
+        return offset;
+    }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    QByteArray m_data;
+    QHash<QByteArray, quint32> m_offsets;
+};
+
+} // namespace
+
+MediaIndex::MediaIndex()
+    : m_map(nullptr),
+      m_count(0),
+      m_strings(nullptr),
+      m_stringsSize(0),
+      m_added(0)
+{
+}
+
+MediaIndex::~MediaIndex()
+{
+    unmap();
+}
+
+void MediaIndex::unmap()
+{
+    if (m_map) {
+        m_file.unmap(const_cast<uchar *>(m_map));
+    }
+    m_file.close();
+
+    m_map = nullptr;
+    m_count = 0;
+    m_strings = nullptr;
+    m_stringsSize = 0;
+}
+
+bool MediaIndex::open(const QString &filePath)
+{
+    unmap();
+    m_changed.clear();
+    m_removed.clear();
+    m_added = 0;
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(Header))) {
+        m_file.close();
+        return false;
+    }
+
+    const uchar *map = m_file.map(0, fileSize);
+    if (!map) {
+        m_file.close();
+        return false;
+    }
+
+    // Anything unexpected is treated as no index, the library rebuilds it
+    Header header;
+    memcpy(&header, map, sizeof(header));
+    const qint64 expected = qint64(sizeof(Header)) + qint64(header.count) * sizeof(Record) + header.stringsSize;
+    if (header.magic != INDEX_MAGIC || header.version != INDEX_VERSION
+            || expected != fileSize || !header.stringsSize || map[fileSize - 1] != '\0') {
+        m_file.unmap(const_cast<uchar *>(map));
+        m_file.close();
+        return false;
+    }
+
+    m_map = map;
+    m_count = header.count;
+    m_strings = map + sizeof(Header) + header.count * sizeof(Record);
+    m_stringsSize = header.stringsSize;
+    return true;
+}
+
+bool MediaIndex::save()
+{
+    const QString filePath = m_file.fileName();
+    if (filePath.isEmpty()) {
+        return false;
+    }
+
+    QVector<Entry> all = entries();
+    QVector<QByteArray> keys;
+    keys.reserve(all.size());
+    for (int i = 0; i < all.size(); ++i) {
+        keys.append(all[i].path.toUtf8());
+    }
+
+    QVector<int> order(all.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&keys](int a, int b) {
+        return pathLess(keys[a], keys[b]);
+    });
+
+    StringTable strings;
+    QVector<Record> records(all.size());
+    for (int i = 0; i < order.size(); ++i) {
+        const Entry &entry = all[order[i]];
+        Record &record = records[i];
+        memset(&record, 0, sizeof(record));
+
+        record.path = strings.add(entry.path);
+        record.codec = strings.add(entry.info.codec);
+        record.audioCodec = strings.add(entry.info.audioCodec);
+        record.title = strings.add(entry.title);
+        record.artist = strings.add(entry.artist);
+        record.album = strings.add(entry.album);
+        record.size = entry.size;
+        record.modified = entry.modified;
+        record.durationMs = entry.info.durationMs;
+        record.bitrate = entry.info.bitrate;
+        record.frameRate = entry.info.frameRate;
+        record.flags = entry.info.valid ? INDEX_FLAG_VALID : 0;
+        record.width = quint16(entry.info.width);
+        record.height = quint16(entry.info.height);
+        record.sarNum = quint16(entry.info.sarNum);
+        record.sarDen = quint16(entry.info.sarDen);
+    }
+
+    Header header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.count = records.size();
+    header.stringsSize = strings.data().size();
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    // Written aside and renamed, the old file stays mapped until then
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(records.constData()), records.size() * sizeof(Record));
+    file.write(strings.data());
+    if (!file.commit()) {
+        return false;
+    }
+
+    return open(filePath);
+}
+
+int MediaIndex::count() const
+{
+    return int(m_count) - m_removed.size() + m_added;
+}
+
+bool MediaIndex::contains(const QString &path) const
+{
+    if (m_changed.contains(path)) {
+        return true;
+    }
+    return !m_removed.contains(path) && mappedFind(path) >= 0;
+}
+
+bool MediaIndex::find(const QString &path, Entry *entry) const
+{
+    const auto it = m_changed.constFind(path);
+    if (it != m_changed.constEnd()) {
+        *entry = it.value();
+        return true;
+    }
+
+    if (m_removed.contains(path)) {
+        return false;
+    }
+
+    const int index = mappedFind(path);
+    if (index < 0) {
+        return false;
+    }
+    *entry = mappedEntry(index);
+    return true;
+}
+
+void MediaIndex::insert(const Entry &entry)
+{
+    if (!m_changed.contains(entry.path) && !m_removed.remove(entry.path)
+            && mappedFind(entry.path) < 0) {
+        ++m_added;
+    }
+    m_changed.insert(entry.path, entry);
+}
+
+bool MediaIndex::remove(const QString &path)
+{
+    const bool changed = m_changed.remove(path);
+    const bool mapped = !m_removed.contains(path) && mappedFind(path) >= 0;
+
+    if (mapped) {
+        m_removed.insert(path);
+    } else if (changed) {
+        --m_added;
+    }
+    return changed || mapped;
+}
+
+QStringList MediaIndex::paths() const
+{
+    QStringList result;
+    result.reserve(count());
+
+    for (quint32 i = 0; i < m_count; ++i) {
+        const QString path = mappedString(record(i)->path);
+        if (!m_removed.contains(path) && !m_changed.contains(path)) {
+            result.append(path);
+        }
+    }
+    for (auto it = m_changed.constBegin(); it != m_changed.constEnd(); ++it) {
+        result.append(it.key());
+    }
+    return result;
+}
+
+QVector<MediaIndex::Entry> MediaIndex::entries() const
+{
+    QVector<Entry> result;
+    result.reserve(count());
+
+    for (quint32 i = 0; i < m_count; ++i) {
+        const QString path = mappedString(record(i)->path);
+        if (!m_removed.contains(path) && !m_changed.contains(path)) {
+            result.append(mappedEntry(i));
+        }
+    }
+    for (auto it = m_changed.constBegin(); it != m_changed.constEnd(); ++it) {
+        result.append(it.value());
+    }
+    return result;
+}
+
+const MediaIndex::Record *MediaIndex::record(int index) const
+{
+    return reinterpret_cast<const Record *>(m_map + sizeof(Header)) + index;
+}
+
+int MediaIndex::mappedFind(const QString &path) const
+{
+    if (!m_count) {
+        return -1;
+    }
+
+    const QByteArray key = path.toUtf8();
+    int low = 0;
+    int high = int(m_count) - 1;
+    while (low <= high) {
+        const int middle = (low + high) / 2;
+        const quint32 offset = record(middle)->path;
+        const int compare = offset < m_stringsSize
+            ? qstrcmp(reinterpret_cast<const char *>(m_strings) + offset, key.constData())
+            : -1;
+        if (compare < 0) {
+            low = middle + 1;
+        } else if (compare > 0) {
+            high = middle - 1;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+MediaIndex::Entry MediaIndex::mappedEntry(int index) const
+{
+    const Record *r = record(index);
+
+    Entry entry;
+    entry.path = mappedString(r->path);
+    entry.size = r->size;
+    entry.modified = r->modified;
+    entry.title = mappedString(r->title);
+    entry.artist = mappedString(r->artist);
+    entry.album = mappedString(r->album);
+    entry.info.width = r->width;
+    entry.info.height = r->height;
+    entry.info.durationMs = r->durationMs;
+    entry.info.codec = mappedString(r->codec);
+    entry.info.frameRate = r->frameRate;
+    entry.info.bitrate = r->bitrate;
+    entry.info.audioCodec = mappedString(r->audioCodec);
+    entry.info.sarNum = r->sarNum ? r->sarNum : 1;
+    entry.info.sarDen = r->sarDen ? r->sarDen : 1;
+    entry.info.valid = r->flags & INDEX_FLAG_VALID;
+    return entry;
+}
+
+QString MediaIndex::mappedString(quint32 offset) const
+{
+    // The table ends with a NUL, so every offset inside it is terminated
+    if (!offset || offset >= m_stringsSize) {
+        return QString();
+    }
+    return QString::fromUtf8(reinterpret_cast<const char *>(m_strings) + offset);
+}
@@ -0,0 +1,84 @@
+/**
+ * Media Index - compact on-disk index of the media library
+ *
+ * The index file is memory mapped and read in place: opening it only
+ * checks the header, lookups binary search the path sorted records and
+ * decode a single entry. Edits are kept in memory on top of the mapped
+ * file until save() writes a new one and maps it again.
+ *
+ * The file uses native byte order, it never leaves the device.
+ */
+
+#ifndef MEDIAINDEX_H
+#define MEDIAINDEX_H
+
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "VideoProber.h"
+
+class MediaIndex
+{
+public:
+    struct Entry {
+        QString path;
+        qint64 size;
+        qint64 modified;            // ms since epoch
+        VideoProber::VideoInfo info;
+        QString title;
+        QString artist;
+        QString album;
+
+        Entry() : size(0), modified(0) {}
+    };
+
+    MediaIndex();
+    ~MediaIndex();
+
+    // Map an index file, starts empty if it is missing or unreadable
+    bool open(const QString &filePath);
+
+    // Write all entries to the file opened before and map it again
+    bool save();
+
+    // Edits not saved yet
+    bool isDirty() const { return !m_changed.isEmpty() || !m_removed.isEmpty(); }
+
+    int count() const;
+    bool contains(const QString &path) const;
+    bool find(const QString &path, Entry *entry) const;
+
+    // Add an entry or replace the one with the same path
+    void insert(const Entry &entry);
+    bool remove(const QString &path);
+
+    QStringList paths() const;
+    QVector<Entry> entries() const;
+
+private:
+    struct Header;
+    struct Record;
+
+    void unmap();
+    int mappedFind(const QString &path) const;
+    Entry mappedEntry(int index) const;
+    QString mappedString(quint32 offset) const;
+    const Record *record(int index) const;
+
+    QFile m_file;
+    const uchar *m_map;
+    quint32 m_count;                // Records in the mapped file
+    const uchar *m_strings;
+    quint32 m_stringsSize;
+
+    // Edits on top of the mapped file, m_removed only holds mapped paths
+    QHash<QString, Entry> m_changed;
+    QSet<QString> m_removed;
+    int m_added;                    // Entries of m_changed not in the mapped file
+};
+
+#endif // MEDIAINDEX_H
@@ -0,0 +1,566 @@
+/**
+ * Media Library - indexes the media files under a set of roots
+ */
+
+#include "MediaLibrary.h"
+
+#include <QDateTime>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QRunnable>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "Instance.h"
+#include "Media.h"
+#include "MetaLoader.h"
+#include "MetaSnapshot.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Debug logging to file
+static FILE *s_libraryLogFile = nullptr;
+static void logLibrary(const char *fmt, ...) {
+    if (!s_libraryLogFile) {
+        s_libraryLogFile = fopen("/media/internal/vlcplayer.log", "a");
+    }
+    if (s_libraryLogFile) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(s_libraryLogFile, "[MediaLibrary] ");
+        vfprintf(s_libraryLogFile, fmt, args);
+        va_end(args);
+        fflush(s_libraryLogFile);
+    }
+}
+
+// Files probed at the same time, playback keeps priority on the CPU
+#define LIBRARY_MAX_PROBES 2
+
+// Copies close a file more than once, wait for them to settle
+#define LIBRARY_CHANGE_DELAY_MS 1000
+
+// Index writes are batched while scanning
+#define LIBRARY_SAVE_DELAY_MS 5000
+
+#define LIBRARY_WATCH_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_DELETE_SELF \
+                            | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+namespace {
+
+bool isHidden(const QString &path)
+{
+    const int slash = path.lastIndexOf('/');
+    return path.length() > slash + 1 && path.at(slash + 1) == '.';
+}
+
+// Walks directories on an idle priority pool thread
+class ScanTask : public QRunnable
+{
+public:
+    ScanTask(const QStringList &dirs, const QFutureInterface<MediaLibrary::ScanResult> &result)
+        : m_dirs(dirs),
+          m_result(result)
+    {
+    }
+
+    void run() override
+    {
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+
+        MediaLibrary::ScanResult result;
+        for (const QString &root : m_dirs) {
+            result.dirs.append(root);
+
+            // Hidden files and directories are skipped like in the file dialog
+            QDirIterator it(root, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot,
+                            QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                if (m_result.isCanceled()) {
+                    m_result.reportFinished();
+                    return;
+                }
+
+                const QString path = it.next();
+                const QFileInfo info = it.fileInfo();
+                if (info.isDir()) {
+                    result.dirs.append(path);
+                } else if (MediaLibrary::isMediaFile(path)) {
+                    MediaLibrary::FileStamp stamp;
+                    stamp.path = path;
+                    stamp.size = info.size();
+                    stamp.modified = info.lastModified().toMSecsSinceEpoch();
+                    result.files.append(stamp);
+                }
+            }
+        }
+
+        m_result.reportResult(result);
+        m_result.reportFinished();
+    }
+
+private:
+    QStringList m_dirs;
+    QFutureInterface<MediaLibrary::ScanResult> m_result;
+};
+
+} // namespace
+
+MediaLibrary::MediaLibrary(VideoProber *prober, QObject *parent)
+    : QObject(parent),
+      m_prober(prober),
+      m_instance(nullptr),
+      m_metaLoader(new VlcMetaLoader(this)),
+      m_scanPool(new QThreadPool(this)),
+      m_scans(0),
+      m_processing(false),
+      m_inotify(-1),
+      m_notifier(nullptr),
+      m_changeTimer(new QTimer(this)),
+      m_saveTimer(new QTimer(this))
+{
+    m_scanPool->setMaxThreadCount(1);
+    m_metaLoader->setMaxThreads(1);
+
+    m_changeTimer->setSingleShot(true);
+    m_changeTimer->setInterval(LIBRARY_CHANGE_DELAY_MS);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(LIBRARY_SAVE_DELAY_MS);
+
+    connect(m_prober, &VideoProber::probed, this, &MediaLibrary::onProbed);
+    connect(m_prober, &VideoProber::metaRead, this, &MediaLibrary::onProbeMeta);
+    connect(m_metaLoader, &VlcMetaLoader::loaded, this, &MediaLibrary::onMetaLoaded);
+    connect(m_changeTimer, &QTimer::timeout, this, &MediaLibrary::flushChanges);
+    connect(m_saveTimer, &QTimer::timeout, this, &MediaLibrary::save);
+}
+
+MediaLibrary::~MediaLibrary()
+{
+    // Stop walking directories, the result is not needed anymore
+    const auto watchers = findChildren<QFutureWatcher<ScanResult> *>();
+    for (QFutureWatcher<ScanResult> *watcher : watchers) {
+        watcher->cancel();
+    }
+    m_scanPool->waitForDone();
+
+    // Waits for a running parse, which holds its own media reference
+    delete m_metaLoader;
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        delete it->media;
+    }
+
+    save();
+
+    if (m_inotify >= 0) {
+        close(m_inotify);
+    }
+}
+
+void MediaLibrary::setInstance(VlcInstance *instance)
+{
+    m_instance = instance;
+}
+
+void MediaLibrary::setRoots(const QStringList &roots)
+{
+    m_roots.clear();
+    for (const QString &root : roots) {
+        m_roots.append(QFileInfo(root).absoluteFilePath());
+    }
+}
+
+bool MediaLibrary::isMediaFile(const QString &path)
+{
+    static const QSet<QString> extensions = QSet<QString>()
+        << "mp4" << "m4v" << "mkv" << "avi" << "mov" << "webm" << "wmv" << "flv" << "3gp"
+        << "mpg" << "mpeg" << "ts" << "mp3" << "flac" << "wav" << "ogg" << "m4a";
+
+    if (isHidden(path)) {
+        return false;
+    }
+    const int dot = path.lastIndexOf('.');
+    return dot > path.lastIndexOf('/') && extensions.contains(path.mid(dot + 1).toLower());
+}
+
+void MediaLibrary::start()
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_index.open(indexPath());
+    logLibrary("Index loaded: %d entries in %lld ms\n", m_index.count(), timer.elapsed());
+
+    if (m_inotify < 0) {
+        m_inotify = inotify_init();
+        if (m_inotify >= 0) {
+            fcntl(m_inotify, F_SETFL, fcntl(m_inotify, F_GETFL) | O_NONBLOCK);
+            fcntl(m_inotify, F_SETFD, FD_CLOEXEC);
+            m_notifier = new QSocketNotifier(m_inotify, QSocketNotifier::Read, this);
+            connect(m_notifier, &QSocketNotifier::activated, this, &MediaLibrary::onInotify);
+        } else {
+            logLibrary("inotify unavailable (%d), changes are picked up on the next start\n", errno);
+        }
+    }
+
+    QStringList roots;
+    for (const QString &root : m_roots) {
+        if (QFileInfo(root).isDir()) {
+            roots.append(root);
+        }
+    }
+    scan(roots, true);
+}
+
+bool MediaLibrary::isBusy() const
+{
+    return m_scans || !m_queue.isEmpty() || !m_pending.isEmpty();
+}
+
+bool MediaLibrary::find(const QString &path, MediaIndex::Entry *entry) const
+{
+    return m_index.find(QFileInfo(path).absoluteFilePath(), entry);
+}
+
+void MediaLibrary::scan(const QStringList &dirs, bool full)
+{
+    ++m_scans;
+
+    QFutureInterface<ScanResult> result;
+    result.reportStarted();
+
+    QFutureWatcher<ScanResult> *watcher = new QFutureWatcher<ScanResult>(this);
+    connect(watcher, &QFutureWatcher<ScanResult>::finished, this, [this, watcher, full]() {
+        const QFuture<ScanResult> future = watcher->future();
+        watcher->deleteLater();
+        --m_scans;
+
+        if (!future.isCanceled() && future.resultCount()) {
+            applyScan(full, future.result());
+        }
+        if (!m_scans) {
+            emit scanFinished();
+        }
+        checkIdle();
+    });
+    watcher->setFuture(result.future());
+
+    m_scanPool->start(new ScanTask(dirs, result));
+}
+
+void MediaLibrary::applyScan(bool full, const ScanResult &result)
+{
+    logLibrary("Scanned %d directories, %d media files\n", result.dirs.size(), result.files.size());
+
+    for (const QString &dir : result.dirs) {
+        watch(dir);
+    }
+
+    QSet<QString> found;
+    for (const FileStamp &stamp : result.files) {
+        if (full) {
+            found.insert(stamp.path);
+        }
+        enqueue(stamp);
+    }
+
+    // Everything a full scan did not see is gone, or outside the roots now
+    if (full) {
+        const QStringList paths = m_index.paths();
+        for (const QString &path : paths) {
+            if (!found.contains(path)) {
+                removePath(path);
+            }
+        }
+    }
+
+    processNext();
+}
+
+void MediaLibrary::enqueue(const FileStamp &stamp)
+{
+    if (m_queued.contains(stamp.path) || m_pending.contains(stamp.path)) {
+        return;
+    }
+
+    MediaIndex::Entry entry;
+    if (m_index.find(stamp.path, &entry) && entry.size == stamp.size && entry.modified == stamp.modified) {
+        return;
+    }
+
+    m_queue.append(stamp);
+    m_queued.insert(stamp.path);
+}
+
+void MediaLibrary::processNext()
+{
+    // Cached probes complete inside probeAsync() and finish() comes back here
+    if (m_processing) {
+        return;
+    }
+    m_processing = true;
+
+    while (m_pending.size() < LIBRARY_MAX_PROBES && !m_queue.isEmpty()) {
+        const FileStamp stamp = m_queue.takeFirst();
+        m_queued.remove(stamp.path);
+
+        Pending pending;
+        pending.stamp = stamp;
+        pending.media = nullptr;
+        m_pending.insert(stamp.path, pending);
+
+        m_prober->probeAsync(stamp.path);
+    }
+
+    m_processing = false;
+}
+
+void MediaLibrary::onProbed(const QString &path, const VideoProber::VideoInfo &info)
+{
+    // Probes of the player are reported here too
+    auto it = m_pending.find(path);
+    if (it == m_pending.end() || it->media) {
+        return;
+    }
+
+    if (!QFileInfo(path).isFile()) {
+        m_pending.erase(it);
+        processNext();
+        checkIdle();
+        return;
+    }
+
+    it->info = info;
+    if (it->meta.isValid()) {
+        const VlcMetaSnapshot meta = it->meta;
+        finish(path, &meta);
+        return;
+    }
+    if (!m_instance) {
+        finish(path, nullptr);
+        return;
+    }
+
+    it->media = new VlcMedia(path, true, m_instance);
+    m_metaLoader->load(it->media);
+}
+
+void MediaLibrary::onProbeMeta(const QString &path, const VlcMetaSnapshot &meta)
+{
+    // The probe parsed the file already, no second parse for its tags
+    auto it = m_pending.find(path);
+    if (it != m_pending.end()) {
+        it->meta = meta;
+    }
+}
+
+void MediaLibrary::onMetaLoaded(VlcMedia *media, const VlcMetaSnapshot &meta)
+{
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        if (it->media == media) {
+            finish(it.key(), &meta);
+            return;
+        }
+    }
+}
+
+void MediaLibrary::finish(const QString &path, const VlcMetaSnapshot *meta)
+{
+    const Pending pending = m_pending.take(path);
+    if (pending.media) {
+        pending.media->deleteLater();
+    }
+
+    // Entries are kept for files that could not be probed, so they are
+    // not probed again until they change
+    MediaIndex::Entry entry;
+    entry.path = path;
+    entry.size = pending.stamp.size;
+    entry.modified = pending.stamp.modified;
+    entry.info = pending.info;
+    if (meta) {
+        entry.title = meta->title();
+        entry.artist = meta->artist();
+        entry.album = meta->album();
+    }
+    m_index.insert(entry);
+
+    emit entryChanged(path);
+    scheduleSave();
+
+    processNext();
+    checkIdle();
+}
+
+void MediaLibrary::removePath(const QString &path)
+{
+    if (m_index.remove(path)) {
+        emit entryRemoved(path);
+        scheduleSave();
+    }
+}
+
+void MediaLibrary::removeTree(const QString &dir)
+{
+    const QString prefix = dir + '/';
+
+    const QStringList paths = m_index.paths();
+    for (const QString &path : paths) {
+        if (path.startsWith(prefix)) {
+            removePath(path);
+        }
+    }
+
+    // Deleted and moved directories both drop their watches, a directory
+    // moved inside the roots is scanned and watched again under its new path
+    for (auto it = m_watches.begin(); it != m_watches.end();) {
+        if (it.value() == dir || it.value().startsWith(prefix)) {
+            inotify_rm_watch(m_inotify, it.key());
+            it = m_watches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MediaLibrary::watch(const QString &dir)
+{
+    if (m_inotify < 0) {
+        return;
+    }
+
+    const int wd = inotify_add_watch(m_inotify, QFile::encodeName(dir).constData(), LIBRARY_WATCH_MASK);
+    if (wd < 0) {
+        logLibrary("Cannot watch %s (%d)\n", dir.toStdString().c_str(), errno);
+        return;
+    }
+    m_watches.insert(wd, dir);
+}
+
+void MediaLibrary::onInotify()
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (const char *p = buffer; p < buffer + length;) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            // Events were lost, only a full scan can tell what changed
+            if (event->mask & IN_Q_OVERFLOW) {
+                logLibrary("inotify queue overflow, rescanning\n");
+                scan(m_roots, true);
+                continue;
+            }
+
+            const auto watch = m_watches.constFind(event->wd);
+            if (watch == m_watches.constEnd()) {
+                continue;
+            }
+            const QString dir = watch.value();
+
+            if (event->mask & IN_IGNORED) {
+                m_watches.remove(event->wd);
+                continue;
+            }
+            if (event->mask & IN_DELETE_SELF) {
+                removeTree(dir);
+                continue;
+            }
+            if (!event->len) {
+                continue;
+            }
+
+            const QString path = dir + '/' + QFile::decodeName(event->name);
+            if (isHidden(path)) {
+                continue;
+            }
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    scan(QStringList() << path, false);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    removeTree(path);
+                }
+            } else if (isMediaFile(path)) {
+                // Created files are picked up when the writer closes them
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    m_changedFiles.insert(path);
+                    m_changeTimer->start();
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    m_changedFiles.remove(path);
+                    removePath(path);
+                }
+            }
+        }
+    }
+}
+
+void MediaLibrary::flushChanges()
+{
+    for (const QString &path : m_changedFiles) {
+        const QFileInfo info(path);
+        if (!info.isFile()) {
+            continue;
+        }
+
+        FileStamp stamp;
+        stamp.path = path;
+        stamp.size = info.size();
+        stamp.modified = info.lastModified().toMSecsSinceEpoch();
+        enqueue(stamp);
+    }
+    m_changedFiles.clear();
+
+    processNext();
+}
+
+void MediaLibrary::scheduleSave()
+{
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+void MediaLibrary::save()
+{
+    m_saveTimer->stop();
+    if (!m_index.isDirty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (m_index.save()) {
+        logLibrary("Index saved: %d entries in %lld ms\n", m_index.count(), timer.elapsed());
+    } else {
+        logLibrary("Cannot write index: %s\n", indexPath().toStdString().c_str());
+    }
+}
+
+void MediaLibrary::checkIdle()
+{
+    if (!isBusy()) {
+        save();
+        emit idle();
+    }
+}
+
+QString MediaLibrary::indexPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/library.idx";
+}
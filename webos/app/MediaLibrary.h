@@ -0,0 +1,128 @@
+/**
+ * Media Library - indexes the media files under a set of roots
+ *
+ * start() maps the index saved by the last run, so entries are available
+ * right away, then rescans the roots on an idle priority worker. New and
+ * changed files are probed a few at a time with the VideoProber. Their
+ * tags come from the parse of the probe, VlcMetaLoader only reads them
+ * when the probe did not parse with libvlc, e.g. for a cached result.
+ * inotify keeps the index up to date while the app runs, so later
+ * changes cost one probe per file instead of a rescan.
+ */
+
+#ifndef MEDIALIBRARY_H
+#define MEDIALIBRARY_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+#include "MetaSnapshot.h"
+
+#include "MediaIndex.h"
+#include "VideoProber.h"
+
+class QSocketNotifier;
+class QThreadPool;
+class QTimer;
+
+class VlcInstance;
+class VlcMedia;
+class VlcMetaLoader;
+
+class MediaLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct FileStamp {
+        QString path;
+        qint64 size;
+        qint64 modified;    // ms since epoch
+    };
+
+    struct ScanResult {
+        QStringList dirs;
+        QVector<FileStamp> files;
+    };
+
+    explicit MediaLibrary(VideoProber *prober, QObject *parent = nullptr);
+    ~MediaLibrary();
+
+    // Shared instance for reading tags, entries have no tags without one
+    void setInstance(VlcInstance *instance);
+
+    // Directories to index, e.g. /media/internal
+    void setRoots(const QStringList &roots);
+    QStringList roots() const { return m_roots; }
+
+    // Load the saved index, then rescan and watch the roots
+    void start();
+
+    // True while scanning or probing
+    bool isBusy() const;
+
+    int count() const { return m_index.count(); }
+    bool find(const QString &path, MediaIndex::Entry *entry) const;
+    QVector<MediaIndex::Entry> entries() const { return m_index.entries(); }
+
+    // Files the library picks up
+    static bool isMediaFile(const QString &path);
+
+signals:
+    void entryChanged(const QString &path);
+    void entryRemoved(const QString &path);
+    void scanFinished();
+    void idle();
+
+private slots:
+    void onProbed(const QString &path, const VideoProber::VideoInfo &info);
+    void onProbeMeta(const QString &path, const VlcMetaSnapshot &meta);
+    void onMetaLoaded(VlcMedia *media, const VlcMetaSnapshot &meta);
+    void onInotify();
+    void flushChanges();
+    void save();
+
+private:
+    struct Pending {
+        FileStamp stamp;
+        VideoProber::VideoInfo info;
+        VlcMetaSnapshot meta;   // From the probe, empty if it was not parsed
+        VlcMedia *media;
+    };
+
+    void scan(const QStringList &dirs, bool full);
+    void applyScan(bool full, const ScanResult &result);
+    void enqueue(const FileStamp &stamp);  // Unless the index has it unchanged
+    void processNext();
+    void finish(const QString &path, const VlcMetaSnapshot *meta);
+    void removePath(const QString &path);
+    void removeTree(const QString &dir);
+    void watch(const QString &dir);
+    void scheduleSave();
+    void checkIdle();
+    static QString indexPath();
+
+    VideoProber *m_prober;
+    VlcInstance *m_instance;
+    VlcMetaLoader *m_metaLoader;
+    QThreadPool *m_scanPool;
+    QStringList m_roots;
+    MediaIndex m_index;
+
+    int m_scans;                        // Scans in flight
+    bool m_processing;                  // Guards processNext() against reentry
+    QList<FileStamp> m_queue;           // Waiting for a probe
+    QSet<QString> m_queued;
+    QHash<QString, Pending> m_pending;  // Probing or reading tags, by path
+
+    int m_inotify;
+    QSocketNotifier *m_notifier;
+    QHash<int, QString> m_watches;      // inotify watch descriptor to directory
+    QSet<QString> m_changedFiles;       // Written or moved in, waiting for m_changeTimer
+    QTimer *m_changeTimer;
+    QTimer *m_saveTimer;
+};
+
+#endif // MEDIALIBRARY_H
@@ -0,0 +1,262 @@
+/**
+ * Progressive Transcoder - 480p segments converted ahead of playback
+ */
+
+#include "ProgressiveTranscoder.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Debug logging to file
+static FILE *s_progressiveLogFile = nullptr;
+static void logProgressive(const char *fmt, ...) {
+    if (!s_progressiveLogFile) {
+        s_progressiveLogFile = fopen("/media/internal/vlcplayer.log", "a");
+    }
+    if (s_progressiveLogFile) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(s_progressiveLogFile, "[ProgressiveTranscoder] ");
+        vfprintf(s_progressiveLogFile, fmt, args);
+        va_end(args);
+        fflush(s_progressiveLogFile);
+    }
+}
+
+// Short segments keep the wait before playback and after a seek short
+#define PROGRESSIVE_SEGMENT_MS 10000
+
+// Segments converted ahead of the played one, a minute
+#define PROGRESSIVE_AHEAD 6
+
+// Segments kept behind the played one, five minutes at about 2 MB each
+#define PROGRESSIVE_KEEP_BEHIND 30
+
+ProgressiveTranscoder::ProgressiveTranscoder(VlcInstance *instance, QObject *parent)
+    : QObject(parent),
+      m_instance(instance),
+      m_engine(nullptr),
+      m_durationMs(0),
+      m_position(0),
+      m_running(-1)
+{
+}
+
+ProgressiveTranscoder::~ProgressiveTranscoder()
+{
+    stop();
+}
+
+int ProgressiveTranscoder::segmentDurationMs()
+{
+    return PROGRESSIVE_SEGMENT_MS;
+}
+
+QString ProgressiveTranscoder::segmentDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/progressive";
+}
+
+QString ProgressiveTranscoder::outputPath(int index) const
+{
+    return segmentDir() + QString("/seg%1.mp4").arg(index, 4, 10, QChar('0'));
+}
+
+QString ProgressiveTranscoder::partialPath(const QString &path)
+{
+    const QFileInfo info(path);
+    return info.absolutePath() + "/." + info.fileName();
+}
+
+void ProgressiveTranscoder::start(const QString &inputPath, int durationMs)
+{
+    stop();
+
+    m_inputPath = inputPath;
+    m_durationMs = durationMs;
+    m_position = 0;
+
+    // Without a duration the whole file is one segment
+    const int count = durationMs > 0
+        ? (durationMs + PROGRESSIVE_SEGMENT_MS - 1) / PROGRESSIVE_SEGMENT_MS
+        : 1;
+    m_segments.fill(Missing, count);
+
+    logProgressive("Starting %d segments: %s\n", count, inputPath.toStdString().c_str());
+
+    // Also clears segments left behind by a crash
+    QDir(segmentDir()).removeRecursively();
+    QDir().mkpath(segmentDir());
+
+    schedule();
+}
+
+void ProgressiveTranscoder::stop()
+{
+    releaseEngine(true);
+    m_segments.clear();
+    m_inputPath.clear();
+    m_durationMs = 0;
+    m_position = 0;
+
+    QDir(segmentDir()).removeRecursively();
+}
+
+int ProgressiveTranscoder::segmentAt(int ms) const
+{
+    if (m_segments.isEmpty()) {
+        return 0;
+    }
+    return qBound(0, ms / PROGRESSIVE_SEGMENT_MS, m_segments.size() - 1);
+}
+
+QString ProgressiveTranscoder::segmentPath(int index) const
+{
+    return isReady(index) ? outputPath(index) : QString();
+}
+
+bool ProgressiveTranscoder::isReady(int index) const
+{
+    return index >= 0 && index < m_segments.size() && m_segments[index] == Ready;
+}
+
+bool ProgressiveTranscoder::isFailed(int index) const
+{
+    return index >= 0 && index < m_segments.size() && m_segments[index] == Failed;
+}
+
+void ProgressiveTranscoder::setPosition(int ms)
+{
+    if (m_segments.isEmpty()) {
+        return;
+    }
+
+    const int index = segmentAt(ms);
+    m_position = index;
+
+    // A seek away from the segment being converted, the new position comes first
+    if (m_running >= 0 && (m_running < index || m_running >= index + PROGRESSIVE_AHEAD)) {
+        logProgressive("Dropping segment %d for position %d\n", m_running, index);
+        m_segments[m_running] = Missing;
+        releaseEngine(true);
+    }
+
+    prune();
+    schedule();
+}
+
+void ProgressiveTranscoder::schedule()
+{
+    if (m_engine || m_segments.isEmpty()) {
+        return;
+    }
+
+    const int end = qMin(m_segments.size(), m_position + PROGRESSIVE_AHEAD);
+    for (int i = m_position; i < end; ++i) {
+        if (m_segments[i] == Missing) {
+            run(i);
+            return;
+        }
+    }
+}
+
+void ProgressiveTranscoder::run(int index)
+{
+    const int startMs = index * PROGRESSIVE_SEGMENT_MS;
+    const bool last = index == m_segments.size() - 1;
+
+    // The last one runs to the end, the probed duration may be a bit short
+    const int lengthMs = last ? 0 : PROGRESSIVE_SEGMENT_MS;
+    const int durationMs = last ? qMax(0, m_durationMs - startMs) : PROGRESSIVE_SEGMENT_MS;
+
+    m_running = index;
+    m_segments[index] = Running;
+
+    // A new engine each time, a cancelled ffmpeg takes a while to go away
+    m_engine = TranscodeEngine::create(m_instance, this);
+    m_engine->setRange(startMs, lengthMs);
+    connect(m_engine, &TranscodeEngine::finished, this, [this, index]() {
+        onFinished(index);
+    });
+    connect(m_engine, &TranscodeEngine::error, this,
+            [this, index](TranscodeEngine::Error error, const QString &message) {
+        onError(index, error, message);
+    });
+
+    logProgressive("Converting segment %d at %d ms\n", index, startMs);
+    m_engine->start(m_inputPath, partialPath(outputPath(index)), durationMs);
+}
+
+void ProgressiveTranscoder::releaseEngine(bool cancel)
+{
+    if (!m_engine) {
+        return;
+    }
+
+    // No more signals for this segment, a cancel removes its partial file
+    disconnect(m_engine, nullptr, this, nullptr);
+    if (cancel) {
+        m_engine->cancel();
+    }
+    m_engine->deleteLater();
+    m_engine = nullptr;
+    m_running = -1;
+}
+
+void ProgressiveTranscoder::prune()
+{
+    // Kept from a while behind the position to the end of the converted
+    // range, segments after a seek back are converted again when needed
+    const int first = m_position - PROGRESSIVE_KEEP_BEHIND;
+    const int last = m_position + PROGRESSIVE_AHEAD;
+    for (int i = 0; i < m_segments.size(); ++i) {
+        if ((i < first || i >= last) && m_segments[i] == Ready) {
+            QFile::remove(outputPath(i));
+            m_segments[i] = Missing;
+        }
+    }
+}
+
+void ProgressiveTranscoder::onFinished(int index)
+{
+    if (index != m_running) {
+        return;
+    }
+    releaseEngine(false);
+
+    const QString path = outputPath(index);
+    QFile::remove(path);
+    if (!QFile::rename(partialPath(path), path)) {
+        logProgressive("Cannot move segment %d into place\n", index);
+        m_segments[index] = Failed;
+        emit segmentFailed(index, "Cannot move segment into place");
+    } else {
+        logProgressive("Segment %d ready\n", index);
+        m_segments[index] = Ready;
+        emit segmentReady(index, path);
+    }
+
+    schedule();
+}
+
+void ProgressiveTranscoder::onError(int index, TranscodeEngine::Error error, const QString &message)
+{
+    if (index != m_running) {
+        return;
+    }
+    releaseEngine(false);
+
+    logProgressive("Segment %d failed: %s\n", index, message.toStdString().c_str());
+    QFile::remove(partialPath(outputPath(index)));
+    m_segments[index] = error == TranscodeEngine::Cancelled ? Missing : Failed;
+    if (error != TranscodeEngine::Cancelled) {
+        emit segmentFailed(index, message);
+    }
+
+    schedule();
+}
@@ -0,0 +1,92 @@
+/**
+ * Progressive Transcoder - 480p segments converted ahead of playback
+ *
+ * The input is cut into fixed length segments that are converted one at
+ * a time into a temporary directory, starting at the playback position
+ * and staying a few segments ahead of it. Playback can start as soon as
+ * the first segment is ready instead of after the whole file. Moving the
+ * position, e.g. on a seek, stops a segment that is no longer needed
+ * soon and converts the new position first. Converted segments are kept
+ * a few minutes behind the position, so seeking back a bit needs no work,
+ * and dropped once they are further ahead than the conversion runs.
+ *
+ * Segments live in one cache directory, so only one instance may run.
+ */
+
+#ifndef PROGRESSIVETRANSCODER_H
+#define PROGRESSIVETRANSCODER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include "TranscodeEngine.h"
+
+class VlcInstance;
+
+class ProgressiveTranscoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProgressiveTranscoder(VlcInstance *instance, QObject *parent = nullptr);
+    ~ProgressiveTranscoder();
+
+    // Start converting from the beginning, replaces the previous input
+    void start(const QString &inputPath, int durationMs);
+
+    // Stop converting and remove the segments
+    void stop();
+
+    // Playback position, converts from the segment it falls in
+    void setPosition(int ms);
+
+    QString inputPath() const { return m_inputPath; }
+    int durationMs() const { return m_durationMs; }
+
+    int segmentCount() const { return m_segments.size(); }
+    static int segmentDurationMs();
+    int segmentAt(int ms) const;
+
+    // Path of a converted segment, empty until segmentReady()
+    QString segmentPath(int index) const;
+    bool isReady(int index) const;
+
+    // Conversion of the segment failed, it is not tried again
+    bool isFailed(int index) const;
+
+signals:
+    void segmentReady(int index, const QString &path);
+
+    // A segment could not be converted, it is not tried again
+    void segmentFailed(int index, const QString &message);
+
+private:
+    enum SegmentState {
+        Missing,
+        Running,
+        Ready,
+        Failed
+    };
+
+    void schedule();
+    void run(int index);
+    void releaseEngine(bool cancel);
+    void prune();
+    void onFinished(int index);
+    void onError(int index, TranscodeEngine::Error error, const QString &message);
+    QString outputPath(int index) const;
+    static QString partialPath(const QString &path);
+    static QString segmentDir();
+
+    VlcInstance *m_instance;
+    TranscodeEngine *m_engine;  // Converting m_running, a new one per segment
+
+    QString m_inputPath;
+    int m_durationMs;
+    QVector<SegmentState> m_segments;
+    int m_position;     // Segment being played
+    int m_running;      // Segment being converted, -1 if none
+};
+
+#endif // PROGRESSIVETRANSCODER_H
@@ -0,0 +1,125 @@
+/**
+ * Render Thread - presents video frames off the GUI thread
+ *
+ * Frames are counted in a bounded queue protected by m_mutex. The thread
+ * sleeps on m_wake until a frame is queued, presents it through the
+ * FramePresenter. Frames arriving while the queue is full are dropped,
+ * so a busy decoder never piles up work for the thread.
+ */
+
+#include "RenderThread.h"
+
+#include <QMutexLocker>
+
+// Default number of frames waiting to be presented
+#define RENDER_QUEUE_LIMIT 2
+
+RenderThread::RenderThread(FramePresenter *presenter, QObject *parent)
+    : QThread(parent),
+      m_presenter(presenter),
+      m_pending(0),
+      m_queueLimit(RENDER_QUEUE_LIMIT),
+      m_quit(false),
+      m_firstFrame(true)
+{
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+void RenderThread::setQueueLimit(int frames)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queueLimit = qMax(1, frames);
+}
+
+void RenderThread::frameReady()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pending < m_queueLimit) {
+        m_pending++;
+    }
+    m_wake.wakeOne();
+}
+
+void RenderThread::requestPresent()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_pending) {
+        m_pending = 1;
+    }
+    m_wake.wakeOne();
+}
+
+void RenderThread::framePresented()
+{
+    QMutexLocker locker(&m_mutex);
+    notePresented();
+}
+
+void RenderThread::resetFirstFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    m_firstFrame = true;
+}
+
+void RenderThread::waitForIdle()
+{
+    QMutexLocker locker(&m_presentMutex);
+}
+
+void RenderThread::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    m_mutex.lock();
+    m_quit = true;
+    m_wake.wakeOne();
+    m_mutex.unlock();
+
+    wait();
+}
+
+void RenderThread::notePresented()
+{
+    if (m_firstFrame) {
+        m_firstFrame = false;
+        emit firstFramePresented();
+    }
+}
+
+void RenderThread::run()
+{
+    m_presenter->attachRenderThread();
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (!m_pending) {
+            m_wake.wait(&m_mutex);
+        }
+        if (m_quit) {
+            break;
+        }
+
+        if (m_pending) {
+            m_pending--;
+            locker.unlock();
+
+            m_presentMutex.lock();
+            const bool shown = m_presenter->presentFrame();
+            m_presentMutex.unlock();
+
+            locker.relock();
+            if (shown) {
+                notePresented();
+            }
+        }
+    }
+    locker.unlock();
+
+    m_presenter->detachRenderThread();
+}
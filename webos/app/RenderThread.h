@@ -0,0 +1,89 @@
+/**
+ * Render Thread - presents video frames off the GUI thread
+ *
+ * The libvlc unlock callback calls frameReady(), which queues the frame
+ * and wakes the thread. Conversion, upload and presentation then run
+ * here instead of in a QueuedConnection slot on the GUI thread, so touch
+ * handling does not compete with frame presentation. The GUI thread only
+ * receives firstFramePresented().
+ */
+
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+// Implemented by the video widgets, all methods run on the render thread
+class FramePresenter
+{
+public:
+    virtual ~FramePresenter() {}
+
+    // Called once when the thread starts and before it exits,
+    // e.g. to make a GL context current on the render thread
+    virtual void attachRenderThread() {}
+    virtual void detachRenderThread() {}
+
+    // Present the newest decoded frame, returns false if nothing was shown
+    virtual bool presentFrame() = 0;
+};
+
+class RenderThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RenderThread(FramePresenter *presenter, QObject *parent = nullptr);
+    ~RenderThread();
+
+    // Maximum number of frames waiting to be presented. Frames arriving
+    // while the queue is full are dropped, the widgets always present the
+    // newest decoded buffer so nothing is lost but the extra work.
+    void setQueueLimit(int frames);
+
+    // Any thread (libvlc unlock callback): queue a new frame
+    void frameReady();
+
+    // Any thread: present the current frame again, e.g. after a resize
+    void requestPresent();
+
+    // Any thread: a frame was shown without the render thread (zero-copy)
+    void framePresented();
+
+    // Next presented frame emits firstFramePresented() again
+    void resetFirstFrame();
+
+    // Blocks until no frame is being presented. Callers clear their
+    // playing state first so no new frame starts afterwards.
+    void waitForIdle();
+
+    // Stops the thread and waits for it
+    void stop();
+
+signals:
+    void firstFramePresented();
+
+protected:
+    void run() override;
+
+private:
+    void notePresented();
+
+    FramePresenter *m_presenter;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    int m_pending;
+    int m_queueLimit;
+    bool m_quit;
+
+    // Held while a frame is presented, see waitForIdle()
+    QMutex m_presentMutex;
+
+    // Guarded by m_mutex
+    bool m_firstFrame;
+};
+
+#endif // RENDERTHREAD_H
@@ -0,0 +1,360 @@
+/**
+ * Resolution Governor - picks the decode size negotiated with libvlc
+ *
+ * The decode size is a fraction of the source fitted into the display.
+ * Every evaluation window the governor compares the average render cost
+ * against the frame budget and checks the lost picture count from
+ * VlcMedia::getStats(). Two late windows in a row step the size down,
+ * several idle windows in a row step it back up. A changed size is
+ * applied by restarting the input at the current time, which makes
+ * libvlc call the format callback again. The restart stalls playback,
+ * so there is a minimum interval between two of them.
+ */
+
+#include "ResolutionGovernor.h"
+
+#include <QTimer>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <vlc/vlc.h>
+
+#include "Media.h"
+#include "MediaPlayer.h"
+#include "Stats.h"
+
+// Debug logging to file
+static FILE *s_governorLogFile = nullptr;
+static void logGovernor(const char *fmt, ...) {
+    if (!s_governorLogFile) {
+        s_governorLogFile = fopen("/media/internal/vlcplayer.log", "a");
+    }
+    if (s_governorLogFile) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(s_governorLogFile, "[ResolutionGovernor] ");
+        vfprintf(s_governorLogFile, fmt, args);
+        va_end(args);
+        fflush(s_governorLogFile);
+    }
+}
+
+// Decode size levels, in eighths of the display-fitted source size
+static const int s_levels[] = { 8, 6, 4, 3, 2 };
+static const int s_levelCount = sizeof(s_levels) / sizeof(s_levels[0]);
+
+// Length of one evaluation window
+#define GOVERNOR_WINDOW_MS 2000
+// First level tried is the largest one not above this many pixels
+#define GOVERNOR_START_PIXELS (512 * 288)
+// Step down when more than this percentage of pictures was lost
+#define GOVERNOR_LOST_PERCENT 5
+// Step down when render cost exceeds this percentage of the frame budget
+#define GOVERNOR_LATE_PERCENT 70
+// Windows below this percentage of the frame budget count as idle
+#define GOVERNOR_IDLE_PERCENT 35
+// Idle windows needed before stepping up
+#define GOVERNOR_IDLE_WINDOWS 3
+// Late windows needed before stepping down, one may be a hiccup
+#define GOVERNOR_LATE_WINDOWS 2
+// Minimum time between two input restarts
+#define GOVERNOR_RENEGOTIATE_MS 10000
+// Restart events are ignored for at most this long
+#define GOVERNOR_RESTART_TIMEOUT_MS 5000
+// Do not retry a level that was too slow for this long
+#define GOVERNOR_RETRY_MS 30000
+// Minimum decode size
+#define GOVERNOR_MIN_WIDTH 160
+#define GOVERNOR_MIN_HEIGHT 90
+
+ResolutionGovernor::ResolutionGovernor(QObject *parent)
+    : QObject(parent),
+      m_player(nullptr),
+      m_timer(new QTimer(this)),
+      m_displayWidth(0),
+      m_displayHeight(0),
+      m_sourceWidth(0),
+      m_sourceHeight(0),
+      m_level(0),
+      m_frames(0),
+      m_costUs(0),
+      m_lastLost(-1),
+      m_lastDisplayed(-1),
+      m_goodWindows(0),
+      m_lateWindows(0),
+      m_failedLevel(-1),
+      m_renegotiating(false),
+      m_restartTimer(new QTimer(this)),
+      m_restarting(false)
+{
+    m_timer->setInterval(GOVERNOR_WINDOW_MS);
+    connect(m_timer, &QTimer::timeout, this, &ResolutionGovernor::evaluate);
+
+    // Also ends a restart that never reaches playing
+    m_restartTimer->setSingleShot(true);
+    m_restartTimer->setInterval(GOVERNOR_RESTART_TIMEOUT_MS);
+    connect(m_restartTimer, &QTimer::timeout, this, &ResolutionGovernor::endRestart);
+}
+
+void ResolutionGovernor::setPlayer(VlcMediaPlayer *player)
+{
+    if (m_player) {
+        disconnect(m_player, nullptr, this, nullptr);
+    }
+    endRestart();
+
+    m_player = player;
+
+    if (m_player) {
+        connect(m_player, &VlcMediaPlayer::playing, this, &ResolutionGovernor::onPlaying);
+    }
+}
+
+void ResolutionGovernor::setDisplaySize(unsigned width, unsigned height)
+{
+    QMutexLocker locker(&m_mutex);
+    m_displayWidth = width;
+    m_displayHeight = height;
+}
+
+QSize ResolutionGovernor::negotiate(unsigned sourceWidth, unsigned sourceHeight)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // New source starts from the initial level, a renegotiation keeps the chosen one
+    if (sourceWidth != m_sourceWidth || sourceHeight != m_sourceHeight) {
+        m_sourceWidth = sourceWidth;
+        m_sourceHeight = sourceHeight;
+        m_level = initialLevel();
+        m_goodWindows = 0;
+        m_lateWindows = 0;
+        m_failedLevel = -1;
+        m_renegotiateTimer.invalidate();
+    }
+
+    m_size = sizeForLevel(m_level);
+    m_renegotiating = false;
+    resetWindow();
+    m_lastLost = -1;
+    m_lastDisplayed = -1;
+
+    const int level = m_level;
+    const QSize size = m_size;
+    locker.unlock();
+
+    logGovernor("Source %ux%u -> %dx%d (level %d)\n",
+                sourceWidth, sourceHeight, size.width(), size.height(), level);
+    emit levelChanged(level, size);
+
+    return size;
+}
+
+void ResolutionGovernor::frameRendered(qint64 costUs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_frames++;
+    m_costUs += costUs;
+}
+
+int ResolutionGovernor::level() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_level;
+}
+
+void ResolutionGovernor::start()
+{
+    QMutexLocker locker(&m_mutex);
+    resetWindow();
+    m_lastLost = -1;
+    m_lastDisplayed = -1;
+    m_timer->start();
+}
+
+void ResolutionGovernor::stop()
+{
+    m_timer->stop();
+}
+
+void ResolutionGovernor::evaluate()
+{
+    if (!m_player || !m_player->currentMedia())
+        return;
+
+    VlcStats stats;
+    const bool statsValid = m_player->currentMedia()->getStats(&stats);
+    const int lost = stats.lost_pictures;
+    const int displayed = stats.displayed_pictures;
+
+    const float fps = libvlc_media_player_get_fps(m_player->core());
+
+    QMutexLocker locker(&m_mutex);
+    if (m_renegotiating || m_size.isEmpty())
+        return;
+
+    // First window after start or renegotiation only sets the baseline
+    if (m_lastLost < 0 || !statsValid || lost < m_lastLost || displayed < m_lastDisplayed || !m_frames) {
+        m_lastLost = lost;
+        m_lastDisplayed = displayed;
+        resetWindow();
+        return;
+    }
+
+    const int lostDelta = lost - m_lastLost;
+    const int total = lostDelta + displayed - m_lastDisplayed;
+    m_lastLost = lost;
+    m_lastDisplayed = displayed;
+
+    const qint64 elapsedUs = m_window.nsecsElapsed() / 1000;
+    const qint64 budgetUs = fps > 0 ? qint64(1000000 / fps) : elapsedUs / m_frames;
+    const qint64 averageUs = m_costUs / m_frames;
+    resetWindow();
+
+    const bool late = (total > 0 && lostDelta * 100 > total * GOVERNOR_LOST_PERCENT)
+                      || averageUs * 100 > budgetUs * GOVERNOR_LATE_PERCENT;
+    const bool idle = lostDelta == 0 && averageUs * 100 < budgetUs * GOVERNOR_IDLE_PERCENT;
+
+    // Counters keep running while a restart is too recent, the change
+    // happens in the first window after the interval
+    const bool restartBlocked = m_renegotiateTimer.isValid()
+                                && m_renegotiateTimer.elapsed() < GOVERNOR_RENEGOTIATE_MS;
+
+    int level = m_level;
+    if (late) {
+        m_goodWindows = 0;
+        if (++m_lateWindows >= GOVERNOR_LATE_WINDOWS && m_level + 1 < s_levelCount && !restartBlocked) {
+            level = m_level + 1;
+            m_lateWindows = 0;
+            m_failedLevel = m_level;
+            m_failedTimer.start();
+        }
+    } else if (idle) {
+        m_lateWindows = 0;
+        const bool retryBlocked = m_level - 1 == m_failedLevel
+                                  && m_failedTimer.isValid()
+                                  && m_failedTimer.elapsed() < GOVERNOR_RETRY_MS;
+        if (++m_goodWindows >= GOVERNOR_IDLE_WINDOWS && m_level > 0 && !retryBlocked && !restartBlocked) {
+            level = m_level - 1;
+            m_goodWindows = 0;
+        }
+    } else {
+        m_goodWindows = 0;
+        m_lateWindows = 0;
+    }
+
+    if (level == m_level)
+        return;
+
+    logGovernor("%s: cost %lldus of %lldus budget, lost %d/%d -> level %d\n",
+                late ? "Late" : "Idle", averageUs, budgetUs, lostDelta, total, level);
+
+    const QSize size = sizeForLevel(level);
+    m_level = level;
+    if (size == m_size)
+        return;
+
+    m_renegotiating = true;
+    QMetaObject::invokeMethod(this, "renegotiate", Qt::QueuedConnection);
+}
+
+void ResolutionGovernor::renegotiate()
+{
+    if (!m_player) {
+        return;
+    }
+
+    libvlc_media_player_t *mp = m_player->core();
+    libvlc_media_t *media = libvlc_media_player_get_media(mp);
+    if (!media) {
+        QMutexLocker locker(&m_mutex);
+        m_renegotiating = false;
+        return;
+    }
+
+    // Restart the input where it is, the new vout asks for the format again.
+    // Its events until the new input plays are not shown to the user.
+    const libvlc_time_t time = libvlc_media_player_get_time(mp);
+    logGovernor("Renegotiating format at %lldms\n", (long long)time);
+
+    m_mutex.lock();
+    m_renegotiateTimer.start();
+    m_mutex.unlock();
+
+    m_restarting = true;
+    m_restartTimer->start();
+
+    libvlc_media_player_set_media(mp, media);
+    libvlc_media_release(media);
+    libvlc_media_player_play(mp);
+    if (time > 0) {
+        libvlc_media_player_set_time(mp, time);
+    }
+}
+
+void ResolutionGovernor::onPlaying()
+{
+    if (!m_restarting) {
+        return;
+    }
+
+    // Receivers of this playing event run before the posted call,
+    // so they still see isRestarting()
+    QMetaObject::invokeMethod(this, "endRestart", Qt::QueuedConnection);
+}
+
+void ResolutionGovernor::endRestart()
+{
+    if (!m_restarting) {
+        return;
+    }
+
+    m_restartTimer->stop();
+    m_restarting = false;
+}
+
+QSize ResolutionGovernor::sizeForLevel(int level) const
+{
+    if (!m_sourceWidth || !m_sourceHeight) {
+        return QSize();
+    }
+
+    // Fit the source into the display, never upscale
+    double fit = 1.0;
+    if (m_displayWidth && m_displayHeight) {
+        fit = qMin((double)m_displayWidth / m_sourceWidth, (double)m_displayHeight / m_sourceHeight);
+        fit = qMin(fit, 1.0);
+    }
+
+    const double factor = fit * s_levels[level] / 8.0;
+    unsigned width = (unsigned)(m_sourceWidth * factor);
+    unsigned height = (unsigned)(m_sourceHeight * factor);
+
+    // Keep the minimum size, but do not go above the source
+    width = qMin(qMax(width, (unsigned)GOVERNOR_MIN_WIDTH), m_sourceWidth);
+    height = qMin(qMax(height, (unsigned)GOVERNOR_MIN_HEIGHT), m_sourceHeight);
+
+    // Even dimensions for YUV formats
+    width = qMax(width & ~1u, 2u);
+    height = qMax(height & ~1u, 2u);
+
+    return QSize(width, height);
+}
+
+int ResolutionGovernor::initialLevel() const
+{
+    for (int level = 0; level < s_levelCount; ++level) {
+        const QSize size = sizeForLevel(level);
+        if (size.width() * size.height() <= GOVERNOR_START_PIXELS) {
+            return level;
+        }
+    }
+    return s_levelCount - 1;
+}
+
+void ResolutionGovernor::resetWindow()
+{
+    m_window.start();
+    m_frames = 0;
+    m_costUs = 0;
+}
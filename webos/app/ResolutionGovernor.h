@@ -0,0 +1,100 @@
+/**
+ * Resolution Governor - picks the decode size negotiated with libvlc
+ *
+ * Starts from a size fitted to the display and steps it down or up
+ * at runtime based on measured render cost and lost pictures.
+ *
+ * A new size restarts the input. The player's playing, paused and
+ * stopped events during that restart are not user actions, receivers
+ * check isRestarting() and ignore them.
+ */
+
+#ifndef RESOLUTIONGOVERNOR_H
+#define RESOLUTIONGOVERNOR_H
+
+#include <QObject>
+#include <QMutex>
+#include <QSize>
+#include <QElapsedTimer>
+
+class QTimer;
+class VlcMediaPlayer;
+
+class ResolutionGovernor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ResolutionGovernor(QObject *parent = nullptr);
+
+    void setPlayer(VlcMediaPlayer *player);
+
+    // Size the video is shown at (usually the framebuffer size)
+    void setDisplaySize(unsigned width, unsigned height);
+
+    // Called from the libvlc format callback (vout thread).
+    // Returns the size to request for the given source size.
+    QSize negotiate(unsigned sourceWidth, unsigned sourceHeight);
+
+    // Called after every presented frame with its convert/render cost
+    void frameRendered(qint64 costUs);
+
+    int level() const;
+
+    // GUI thread: the input is being restarted for a new decode size,
+    // from before the old input goes away until the new one plays
+    bool isRestarting() const { return m_restarting; }
+
+public slots:
+    void start();
+    void stop();
+
+    // GUI thread: a user action on the player ends the restart early,
+    // its events are wanted again
+    void endRestart();
+
+signals:
+    void levelChanged(int level, const QSize &size);
+
+private slots:
+    void evaluate();
+    void renegotiate();
+    void onPlaying();
+
+private:
+    QSize sizeForLevel(int level) const;
+    int initialLevel() const;
+    void resetWindow();
+
+    VlcMediaPlayer *m_player;
+    QTimer *m_timer;
+    mutable QMutex m_mutex;
+
+    unsigned m_displayWidth;
+    unsigned m_displayHeight;
+    unsigned m_sourceWidth;
+    unsigned m_sourceHeight;
+    int m_level;
+    QSize m_size;
+
+    // Current evaluation window
+    QElapsedTimer m_window;
+    int m_frames;
+    qint64 m_costUs;
+    int m_lastLost;
+    int m_lastDisplayed;
+
+    // Hysteresis
+    int m_goodWindows;
+    int m_lateWindows;
+    int m_failedLevel;
+    QElapsedTimer m_failedTimer;
+    QElapsedTimer m_renegotiateTimer;  // Since the last restart
+    bool m_renegotiating;              // Until the format callback runs
+
+    // Input restart, GUI thread only
+    QTimer *m_restartTimer;
+    bool m_restarting;
+};
+
+#endif // RESOLUTIONGOVERNOR_H
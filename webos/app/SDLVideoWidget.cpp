@@ -8,12 +8,18 @@
  * - SDL manages the GL context correctly with webOS
  * - Direct EGL usage causes flicker on touch events
  * - PDL must be initialized before SDL
+ *
+ * SDL 1.2 only supports the screen surface on the thread that set the
+ * video mode. The render thread scales into a software surface of its
+ * own, like VideoWidget scales into a QImage, and the GUI thread blits
+ * and flips it.
  */
 
 #include "SDLVideoWidget.h"
 
 #include <QDebug>
 #include <QApplication>
+#include <QElapsedTimer>
 
 #include <SDL.h>
 
@@ -22,6 +28,7 @@
 #include <stdarg.h>
 
 #include "MediaPlayer.h"
+#include "ResolutionGovernor.h"
 
 // Debug logging to file (stderr doesn't go to syslog on webOS)
 static FILE *g_logFile = nullptr;
@@ -43,11 +50,6 @@ static void logMsg(const char *fmt, ...) {
     }
 }
 
-// Scale factors for reduced resolution based on source size
-#define VIDEO_SCALE_FACTOR_SD 2
-#define VIDEO_SCALE_FACTOR_HD 5
-#define VIDEO_SCALE_FACTOR_FHD 8
-
 // Static members
 bool SDLVideoWidget::s_sdlInitialized = false;
 SDL_Surface *SDLVideoWidget::s_screen = nullptr;
@@ -134,19 +136,20 @@ void SDLVideoWidget::shutdownSDL()
 SDLVideoWidget::SDLVideoWidget(QWidget *parent)
     : QWidget(parent),
       m_player(nullptr),
-      m_writeBuffer(0),
-      m_readBuffer(1),
       m_videoWidth(0),
       m_videoHeight(0),
-      m_hasFrame(false),
+      m_hasFrame(0),
+      m_scaled(nullptr),
+      m_scaling(nullptr),
+      m_flipPending(0),
       m_initialized(false),
       m_texture(0),
       m_texWidth(0),
       m_texHeight(0),
-      m_textureNeedsUpdate(false),
-      m_isPlaying(false),
+      m_isPlaying(0),
       m_firstFrameRendered(false),
-      m_renderTimer(nullptr)
+      m_renderThread(new RenderThread(this, this)),
+      m_governor(new ResolutionGovernor(this))
 {
     // Widget attributes - we handle our own painting
     setAttribute(Qt::WA_OpaquePaintEvent);
@@ -158,24 +161,35 @@ SDLVideoWidget::SDLVideoWidget(QWidget *parent)
         initGL();
     }
 
-    // Create render timer for smooth frame updates
-    m_renderTimer = new QTimer(this);
-    m_renderTimer->setInterval(16);  // ~60fps target
-    connect(m_renderTimer, &QTimer::timeout, this, &SDLVideoWidget::renderFrame);
+    // Decode size is picked at runtime from screen size and measured render cost
+    if (s_screen) {
+        m_governor->setDisplaySize(s_screen->w, s_screen->h);
+    }
+
+    // Frames are presented on the render thread as they are decoded,
+    // so an unchanged frame is never blitted again
+    m_renderThread->setQueueLimit(1);
+    connect(m_renderThread, &RenderThread::firstFramePresented,
+            this, &SDLVideoWidget::onFirstFramePresented);
+    m_renderThread->start();
 }
 
 SDLVideoWidget::~SDLVideoWidget()
 {
-    if (m_renderTimer) {
-        m_renderTimer->stop();
-    }
-
     if (m_player) {
         libvlc_video_set_callbacks(m_player->core(), nullptr, nullptr, nullptr, nullptr);
         libvlc_video_set_format_callbacks(m_player->core(), nullptr, nullptr);
     }
+    m_renderThread->stop();
 
     cleanupGL();
+
+    if (m_scaled) {
+        SDL_FreeSurface(m_scaled);
+    }
+    if (m_scaling) {
+        SDL_FreeSurface(m_scaling);
+    }
 }
 
 bool SDLVideoWidget::initGL()
@@ -215,6 +229,7 @@ void SDLVideoWidget::setMediaPlayer(VlcMediaPlayer *player)
     }
 
     m_player = player;
+    m_governor->setPlayer(player);
 
     if (m_player) {
         libvlc_media_player_t *mp = m_player->core();
@@ -249,7 +264,7 @@ void SDLVideoWidget::mousePressEvent(QMouseEvent *event)
     Q_UNUSED(event);
 
     // If playing, user tapped - emit signal so MainWindow can pause and show UI
-    if (m_isPlaying) {
+    if (m_isPlaying.loadAcquire()) {
         logMsg("SDLVideoWidget: Tapped during playback\n");
         emit tapped();
     }
@@ -260,16 +275,16 @@ void SDLVideoWidget::updateTexture()
     // Not used in software rendering mode
 }
 
-void SDLVideoWidget::renderFrame()
+bool SDLVideoWidget::presentFrame()
 {
     static int renderCount = 0;
 
-    if (!m_initialized || !s_screen || !m_isPlaying || !m_hasFrame) {
-        return;
+    if (!m_initialized || !s_screen || !m_isPlaying.loadAcquire() || !m_hasFrame.loadAcquire()) {
+        return false;
     }
 
     if (m_videoWidth == 0 || m_videoHeight == 0) {
-        return;
+        return false;
     }
 
     renderCount++;
@@ -278,10 +293,17 @@ void SDLVideoWidget::renderFrame()
                renderCount, m_videoWidth, m_videoHeight);
     }
 
+    QElapsedTimer renderTimer;
+    renderTimer.start();
+
     m_mutex.lock();
 
+    // Newest decoded frame, older ones were dropped by the ring
+    if (m_ring.acquire()) {
+        m_tracer.presentStarted(m_ring.readSlot());
+    }
     const unsigned char *src = reinterpret_cast<const unsigned char*>(
-        m_buffer[m_readBuffer].constData());
+        m_buffer[m_ring.readSlot()].constData());
 
     // Create SDL surface from video frame data
     SDL_Surface *frameSurface = SDL_CreateRGBSurfaceFrom(
@@ -298,7 +320,7 @@ void SDLVideoWidget::renderFrame()
     if (!frameSurface) {
         m_mutex.unlock();
         logMsg("SDLVideoWidget: Failed to create frame surface: %s\n", SDL_GetError());
-        return;
+        return false;
     }
 
     // Calculate aspect-correct destination rectangle
@@ -320,64 +342,104 @@ void SDLVideoWidget::renderFrame()
         destRect.y = 0;
     }
 
-    // Clear screen to black
-    SDL_FillRect(s_screen, NULL, SDL_MapRGB(s_screen->format, 0, 0, 0));
-
-    // Scale and blit the frame
-    SDL_SoftStretch(frameSurface, NULL, s_screen, &destRect);
+    // Scale into the spare surface, the GUI thread blits the other one.
+    // Same format as the frame, SDL_SoftStretch does not convert.
+    if (!m_scaling || m_scaling->w != destRect.w || m_scaling->h != destRect.h) {
+        if (m_scaling) {
+            SDL_FreeSurface(m_scaling);
+        }
+        m_scaling = SDL_CreateRGBSurface(SDL_SWSURFACE, destRect.w, destRect.h, 32,
+                                         0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+    }
+    if (!m_scaling) {
+        SDL_FreeSurface(frameSurface);
+        m_mutex.unlock();
+        logMsg("SDLVideoWidget: Failed to create scaled surface: %s\n", SDL_GetError());
+        return false;
+    }
 
-    // Flip the display
-    SDL_Flip(s_screen);
+    SDL_SoftStretch(frameSurface, NULL, m_scaling, NULL);
 
     SDL_FreeSurface(frameSurface);
     m_mutex.unlock();
 
-    // Emit firstFrameReady after we've actually rendered
-    if (!m_firstFrameRendered) {
-        m_firstFrameRendered = true;
-        logMsg("SDLVideoWidget: First frame rendered - emitting firstFrameReady\n");
-        emit firstFrameReady();
+    m_imageMutex.lock();
+    qSwap(m_scaled, m_scaling);
+    m_scaledRect = QRect(destRect.x, destRect.y, destRect.w, destRect.h);
+    m_imageMutex.unlock();
+    m_tracer.presentFinished();
+
+    m_governor->frameRendered(renderTimer.nsecsElapsed() / 1000);
+
+    // One flip request in flight at a time
+    if (m_flipPending.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(this, "flipFrame", Qt::QueuedConnection);
     }
+    return true;
 }
 
-void SDLVideoWidget::onFrameReady()
+void SDLVideoWidget::flipFrame()
 {
-    m_textureNeedsUpdate = true;
+    m_flipPending.store(0);
+
+    // A flip queued before playback stopped would cover the black screen
+    if (!m_initialized || !s_screen || !m_isPlaying.loadAcquire()) {
+        return;
+    }
 
-    // Render immediately if playing
-    if (m_isPlaying) {
-        renderFrame();
+    QMutexLocker locker(&m_imageMutex);
+    if (!m_scaled) {
+        return;
+    }
+
+    SDL_Rect destRect;
+    destRect.x = m_scaledRect.x();
+    destRect.y = m_scaledRect.y();
+    destRect.w = m_scaledRect.width();
+    destRect.h = m_scaledRect.height();
+
+    // Clear screen to black, an unscaled blit converts to the screen format
+    SDL_FillRect(s_screen, NULL, SDL_MapRGB(s_screen->format, 0, 0, 0));
+    SDL_BlitSurface(m_scaled, NULL, s_screen, &destRect);
+    SDL_Flip(s_screen);
+}
+
+void SDLVideoWidget::onFirstFramePresented()
+{
+    // Emit firstFrameReady after we've actually rendered
+    if (m_isPlaying.loadAcquire() && !m_firstFrameRendered) {
+        m_firstFrameRendered = true;
+        logMsg("SDLVideoWidget: First frame rendered - emitting firstFrameReady\n");
+        emit firstFrameReady();
     }
 }
 
 void SDLVideoWidget::onPlaybackStarted()
 {
     logMsg("SDLVideoWidget: Playback started\n");
-    m_isPlaying = true;
+    m_isPlaying.storeRelease(1);
     m_firstFrameRendered = false;
 
-    // Start render timer for smooth playback
-    if (m_renderTimer) {
-        m_renderTimer->start();
-    }
+    m_governor->start();
 
     // Render current frame if we have one
-    if (m_hasFrame) {
-        renderFrame();
+    m_renderThread->resetFirstFrame();
+    if (m_hasFrame.loadAcquire()) {
+        m_renderThread->requestPresent();
     }
 }
 
 void SDLVideoWidget::onPlaybackStopped()
 {
     logMsg("SDLVideoWidget: Playback stopped\n");
-    m_isPlaying = false;
+    m_isPlaying.storeRelease(0);
 
-    // Stop render timer
-    if (m_renderTimer) {
-        m_renderTimer->stop();
-    }
+    m_governor->stop();
 
-    // Clear to black
+    // Let a frame that is being scaled finish, it is not flipped afterwards
+    m_renderThread->waitForIdle();
+
+    // Clear to black, on the GUI thread like every other access to s_screen
     if (m_initialized && s_screen) {
         SDL_FillRect(s_screen, NULL, SDL_MapRGB(s_screen->format, 0, 0, 0));
         SDL_Flip(s_screen);
@@ -389,7 +451,8 @@ void SDLVideoWidget::onPlaybackStopped()
 void *SDLVideoWidget::lockCallback(void *opaque, void **planes)
 {
     SDLVideoWidget *self = static_cast<SDLVideoWidget*>(opaque);
-    planes[0] = self->m_buffer[self->m_writeBuffer].data();
+    planes[0] = self->m_buffer[self->m_ring.writeSlot()].data();
+    self->m_tracer.frameLocked(self->m_ring.writeSlot());
     return nullptr;
 }
 
@@ -401,15 +464,14 @@ void SDLVideoWidget::unlockCallback(void *opaque, void *picture, void *const *pl
     SDLVideoWidget *self = static_cast<SDLVideoWidget*>(opaque);
 
     if (self->m_videoWidth > 0 && self->m_videoHeight > 0) {
-        self->m_mutex.lock();
-        int temp = self->m_writeBuffer;
-        self->m_writeBuffer = self->m_readBuffer;
-        self->m_readBuffer = temp;
-        self->m_hasFrame = true;
-        self->m_mutex.unlock();
+        self->m_tracer.frameDecoded(self->m_ring.writeSlot());
+        if (self->m_ring.publish()) {
+            self->m_tracer.frameDropped();
+        }
+        self->m_hasFrame.storeRelease(1);
     }
 
-    QMetaObject::invokeMethod(self, "onFrameReady", Qt::QueuedConnection);
+    self->m_renderThread->frameReady();
 }
 
 void SDLVideoWidget::displayCallback(void *opaque, void *picture)
@@ -427,27 +489,11 @@ unsigned SDLVideoWidget::formatCallback(void **opaque, char *chroma,
     logMsg("SDLVideoWidget::formatCallback %ux%u incoming chroma=%.4s\n",
            *width, *height, chroma);
 
-    // Choose scale factor based on source resolution
+    // Decode size chosen by the resolution governor
     unsigned sourceHeight = *height;
-    unsigned scaleFactor;
-    if (sourceHeight > 900) {
-        scaleFactor = VIDEO_SCALE_FACTOR_FHD;  // 1080p+ -> /8
-    } else if (sourceHeight > 600) {
-        scaleFactor = VIDEO_SCALE_FACTOR_HD;   // 720p -> /5
-    } else {
-        scaleFactor = VIDEO_SCALE_FACTOR_SD;   // 480p and below -> /2
-    }
-
-    unsigned scaledWidth = *width / scaleFactor;
-    unsigned scaledHeight = *height / scaleFactor;
-
-    // Ensure dimensions are even
-    scaledWidth = (scaledWidth / 2) * 2;
-    scaledHeight = (scaledHeight / 2) * 2;
-
-    // Minimum size
-    if (scaledWidth < 160) scaledWidth = 160;
-    if (scaledHeight < 90) scaledHeight = 90;
+    const QSize size = self->m_governor->negotiate(*width, *height);
+    unsigned scaledWidth = size.width();
+    unsigned scaledHeight = size.height();
 
     *width = scaledWidth;
     *height = scaledHeight;
@@ -466,15 +512,17 @@ unsigned SDLVideoWidget::formatCallback(void **opaque, char *chroma,
     *lines = scaledHeight;
 
     unsigned bufferSize = (*pitches) * (*lines);
-    self->m_buffer[0].resize(bufferSize);
-    self->m_buffer[0].fill(0);
-    self->m_buffer[1].resize(bufferSize);
-    self->m_buffer[1].fill(0);
-    self->m_writeBuffer = 0;
-    self->m_readBuffer = 1;
+    // The renderer only reads the buffers under m_mutex
+    self->m_mutex.lock();
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].resize(bufferSize);
+        self->m_buffer[i].fill(0);
+    }
+    self->m_ring.reset();
+    self->m_mutex.unlock();
 
-    logMsg("SDLVideoWidget: Requested RGBA at %ux%u (1/%d for %up), buffer=%u bytes\n",
-           scaledWidth, scaledHeight, scaleFactor, sourceHeight, bufferSize);
+    logMsg("SDLVideoWidget: Requested RGBA at %ux%u (level %d for %up), buffer=%u bytes\n",
+           scaledWidth, scaledHeight, self->m_governor->level(), sourceHeight, bufferSize);
 
     return bufferSize;
 }
@@ -484,9 +532,11 @@ void SDLVideoWidget::formatCleanupCallback(void *opaque)
     SDLVideoWidget *self = static_cast<SDLVideoWidget*>(opaque);
 
     self->m_mutex.lock();
-    self->m_buffer[0].clear();
-    self->m_buffer[1].clear();
-    self->m_hasFrame = false;
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].clear();
+    }
+    self->m_ring.reset();
+    self->m_hasFrame.storeRelease(0);
     self->m_videoWidth = 0;
     self->m_videoHeight = 0;
     self->m_texWidth = 0;
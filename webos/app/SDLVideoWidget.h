@@ -9,6 +9,11 @@
  * - PDL_Init() must be called before SDL_Init()
  * - Link directly to libGLES_CM.so (NOT libEGL.so)
  * - Use SDL_GL_SwapBuffers() (NOT eglSwapBuffers())
+ *
+ * Threading: SDL 1.2 only supports the screen surface on the thread that
+ * set the video mode, the GUI thread here. The render thread scales each
+ * frame into a private software surface; blits and flips of s_screen run
+ * on the GUI thread in flipFrame().
  */
 
 #ifndef SDLVIDEOWIDGET_H
@@ -16,16 +21,22 @@
 
 #include <QWidget>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QByteArray>
-#include <QTimer>
+#include <QRect>
 
 #include <vlc/vlc.h>
 
+#include "FrameRing.h"
+#include "FrameTracer.h"
+#include "RenderThread.h"
+
 // Forward declarations
 class VlcMediaPlayer;
+class ResolutionGovernor;
 struct SDL_Surface;
 
-class SDLVideoWidget : public QWidget
+class SDLVideoWidget : public QWidget, public FramePresenter
 {
     Q_OBJECT
 
@@ -35,6 +46,9 @@ public:
 
     void setMediaPlayer(VlcMediaPlayer *player);
 
+    // Per-frame latency and frame counters
+    VlcFrameStats *frameStats() { return m_tracer.stats(); }
+
     // Check if SDL/GL initialized successfully
     bool isInitialized() const { return m_initialized; }
 
@@ -56,10 +70,15 @@ public slots:
     void onPlaybackStopped();
 
 private slots:
-    void onFrameReady();
-    void renderFrame();
+    void onFirstFramePresented();
+
+    // GUI thread, blits the scaled frame to s_screen and flips
+    void flipFrame();
 
 private:
+    // FramePresenter, scales the frame on the render thread
+    bool presentFrame() override;
+
     bool initGL();
     void cleanupGL();
     void updateTexture();
@@ -76,27 +95,36 @@ private:
     VlcMediaPlayer *m_player;
     QMutex m_mutex;
 
-    // Double buffering for VLC frames (BGRA format)
-    QByteArray m_buffer[2];
-    int m_writeBuffer;
-    int m_readBuffer;
+    // Frame buffers for VLC (BGRA format), one per ring slot
+    QByteArray m_buffer[VlcFrameRing::Slots];
+    VlcFrameRing m_ring;      // Hands frames from the decoder to the renderer
     unsigned m_videoWidth;
     unsigned m_videoHeight;
-    bool m_hasFrame;
+    QAtomicInt m_hasFrame;    // Set by the decoder, read by the render and GUI threads
+
+    // Scaled frames, never the screen, so they may be used off the GUI thread
+    QMutex m_imageMutex;      // Guards m_scaled and m_scaledRect
+    SDL_Surface *m_scaled;    // Scaled frame, blitted by the GUI thread
+    SDL_Surface *m_scaling;   // Frame being scaled on the render thread
+    QRect m_scaledRect;       // Where m_scaled goes on the screen
+    QAtomicInt m_flipPending; // Coalesces flip requests to the GUI thread
 
     // OpenGL state
     bool m_initialized;
     unsigned int m_texture;
     int m_texWidth;   // Power-of-2 texture dimensions
     int m_texHeight;
-    bool m_textureNeedsUpdate;
 
-    // Playback state
-    bool m_isPlaying;
+    // Playback state, m_isPlaying is also read by the render thread
+    QAtomicInt m_isPlaying;
     bool m_firstFrameRendered;
 
-    // Render timer for smooth updates
-    QTimer *m_renderTimer;
+    // Presents new frames as they are decoded
+    RenderThread *m_renderThread;
+    FrameTracer m_tracer;
+
+    // Picks the decode size negotiated in formatCallback
+    ResolutionGovernor *m_governor;
 
     // Static SDL state
     static bool s_sdlInitialized;
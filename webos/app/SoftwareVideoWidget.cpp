@@ -53,7 +53,6 @@ void SoftwareVideoWidget::paintEvent(QPaintEvent *event)
     Q_UNUSED(event);
 
     QPainter painter(this);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform);
 
     m_mutex.lock();
 
@@ -71,9 +70,15 @@ void SoftwareVideoWidget::paintEvent(QPaintEvent *event)
         // Fill letterbox/pillarbox areas with black
         painter.fillRect(rect(), Qt::black);
 
-        // Draw the frame
-        QRect targetRect(x, y, frameSize.width(), frameSize.height());
-        painter.drawImage(targetRect, m_frame);
+        // Scale with VlcVideoScaler, then draw without transformation
+        if (m_scaled.size() != frameSize)
+            m_scaled = QImage(frameSize, QImage::Format_RGBA8888);
+
+        m_scaler.scale(m_frame.constBits(), m_frame.bytesPerLine(),
+                       m_frame.width(), m_frame.height(),
+                       m_scaled.bits(), m_scaled.bytesPerLine(),
+                       m_scaled.width(), m_scaled.height());
+        painter.drawImage(QPoint(x, y), m_scaled);
     } else {
         // No frame yet, fill with black
         painter.fillRect(rect(), Qt::black);
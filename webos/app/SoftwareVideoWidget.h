@@ -11,6 +11,7 @@
 #include <QMutex>
 
 #include "AbstractVideoStream.h"
+#include "VideoScaler.h"
 
 class VlcMediaPlayer;
 
@@ -45,6 +46,8 @@ private:
 
     // Frame buffer
     QImage m_frame;
+    QImage m_scaled;
+    VlcVideoScaler m_scaler;
     QByteArray m_buffer;
     unsigned m_videoWidth;
     unsigned m_videoHeight;
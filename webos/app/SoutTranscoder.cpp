@@ -0,0 +1,347 @@
+/**
+ * Sout Transcoder - re-encodes video to 480p inside the app
+ */
+
+#include "SoutTranscoder.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTimer>
+
+#include "Enums.h"
+#include "Instance.h"
+#include "Media.h"
+#include "MediaPlayer.h"
+
+#include "Transcoder.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Debug logging to file
+static FILE *s_soutLogFile = nullptr;
+static void logSout(const char *fmt, ...) {
+    if (!s_soutLogFile) {
+        s_soutLogFile = fopen("/media/internal/vlcplayer.log", "a");
+    }
+    if (s_soutLogFile) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(s_soutLogFile, "[SoutTranscoder] ");
+        vfprintf(s_soutLogFile, fmt, args);
+        va_end(args);
+        fflush(s_soutLogFile);
+    }
+}
+
+// Same targets as the ffmpeg command line
+#define SOUT_HEIGHT 480
+#define SOUT_VIDEO_KBPS 1500
+#define SOUT_AUDIO_KBPS 128
+#define SOUT_THREADS 2
+
+// A job without a time event for this long is given up
+#define SOUT_STALL_MS 30000
+
+SoutTranscoder::SoutTranscoder(VlcInstance *instance, QObject *parent)
+    : TranscodeEngine(parent),
+      m_instance(instance),
+      m_player(nullptr),
+      m_media(nullptr),
+      m_fallback(nullptr),
+      m_stallTimer(new QTimer(this)),
+      m_durationMs(0),
+      m_timeMs(-1),
+      m_percent(-1),
+      m_lowPriority(false)
+{
+    m_stallTimer->setSingleShot(true);
+    m_stallTimer->setInterval(SOUT_STALL_MS);
+    connect(m_stallTimer, &QTimer::timeout, this, &SoutTranscoder::onStalled);
+}
+
+SoutTranscoder::~SoutTranscoder()
+{
+    // No signals while going away, only drop the partial output
+    if (m_player) {
+        cleanup();
+        QFile::remove(m_outputPath);
+    }
+}
+
+QString SoutTranscoder::soutChain(const QString &outputPath, Mode mode)
+{
+    // Quoted chain value, backslashes and quotes are escaped
+    QString dst = outputPath;
+    dst.replace("\\", "\\\\");
+    dst.replace("'", "\\'");
+
+    const QString output = QString("std{access=file,mux=%1,dst='%2'}")
+        .arg(Vlc::mux()[Vlc::MP4], dst);
+
+    const QString audio = QString("acodec=%1,ab=%2,channels=2")
+        .arg(Vlc::audioCodec()[Vlc::MPEG4Audio])
+        .arg(SOUT_AUDIO_KBPS);
+
+    switch (mode) {
+    case Remux:
+        return ":sout=#" + output;
+    case AudioOnly:
+        // Without vcodec the video elementary stream passes through
+        return QString(":sout=#transcode{%1}:%2").arg(audio, output);
+    case Reencode:
+    default:
+        // Scaled down only, width follows the aspect ratio of the input
+        return QString(":sout=#transcode{vcodec=%1,vb=%2,maxheight=%3,%4,threads=%5}:%6")
+            .arg(Vlc::videoCodec()[Vlc::MPEG4Video])
+            .arg(SOUT_VIDEO_KBPS)
+            .arg(SOUT_HEIGHT)
+            .arg(audio)
+            .arg(SOUT_THREADS)
+            .arg(output);
+    }
+}
+
+void SoutTranscoder::start(const QString &inputPath, const QString &outputPath, int durationMs)
+{
+    if (isRunning()) {
+        logSout("Already transcoding, ignoring new request\n");
+        return;
+    }
+
+    m_inputPath = inputPath;
+    m_outputPath = outputPath;
+    m_durationMs = durationMs;
+    m_timeMs = -1;
+    m_percent = -1;
+    m_timeStr.clear();
+
+    delete m_fallback;
+    m_fallback = nullptr;
+
+    if (!QFileInfo::exists(inputPath)) {
+        logSout("Input not found: %s\n", inputPath.toStdString().c_str());
+        emit error(InputMissing, errorString(InputMissing));
+        return;
+    }
+
+    logSout("Starting transcode:\n");
+    logSout("  Input: %s\n", inputPath.toStdString().c_str());
+    logSout("  Output: %s\n", outputPath.toStdString().c_str());
+    logSout("  Duration: %d ms\n", durationMs);
+    logSout("  Mode: %s\n", modeString(m_mode).toStdString().c_str());
+
+    QFile::remove(outputPath);
+
+    // Subtitles are dropped, the MP4 muxer cannot take most of them.
+    // The AAC encoder of libavcodec is experimental, like -strict -2.
+    m_media = new VlcMedia(inputPath, true, m_instance);
+    QStringList options;
+    options << ":no-sout-spu"
+            << ":sout-avcodec-strict=-2"
+            << soutChain(outputPath, m_mode);
+    if (m_rangeStartMs > 0) {
+        options << QString(":start-time=%1").arg(m_rangeStartMs / 1000.0);
+    }
+    if (m_rangeLengthMs > 0) {
+        options << QString(":stop-time=%1").arg((m_rangeStartMs + m_rangeLengthMs) / 1000.0);
+    }
+    m_media->setOptions(options);
+
+    m_player = new VlcMediaPlayer(m_instance);
+    connect(m_player, &VlcMediaPlayer::timeChanged, this, &SoutTranscoder::onTimeChanged);
+    connect(m_player, &VlcMediaPlayer::positionChanged, this, &SoutTranscoder::onPositionChanged);
+    connect(m_player, &VlcMediaPlayer::end, this, &SoutTranscoder::onEnd);
+    connect(m_player, &VlcMediaPlayer::error, this, &SoutTranscoder::onError);
+    connect(m_player, &VlcMediaPlayer::playing, this, [this]() {
+        // Pausing before the input runs is ignored by libvlc
+        if (m_lowPriority && m_player) {
+            m_player->pause();
+        }
+    });
+
+    m_player->open(m_media);
+    if (!m_lowPriority) {
+        m_stallTimer->start();
+    }
+}
+
+void SoutTranscoder::cancel()
+{
+    if (m_fallback) {
+        m_fallback->cancel();
+        return;
+    }
+    if (!m_player) {
+        return;
+    }
+
+    logSout("Cancelling transcode\n");
+    fail(Cancelled, errorString(Cancelled));
+}
+
+bool SoutTranscoder::isRunning() const
+{
+    return m_player || (m_fallback && m_fallback->isRunning());
+}
+
+void SoutTranscoder::setLowPriority(bool low)
+{
+    m_lowPriority = low;
+
+    if (m_fallback) {
+        m_fallback->setLowPriority(low);
+        return;
+    }
+    if (!m_player) {
+        return;
+    }
+
+    logSout("%s transcode\n", low ? "Pausing" : "Resuming");
+    if (low) {
+        m_stallTimer->stop();
+        m_player->pause();
+    } else {
+        m_player->resume();
+        m_stallTimer->start();
+    }
+}
+
+void SoutTranscoder::onTimeChanged(int time)
+{
+    // Events queued before cleanup
+    if (!m_player) {
+        return;
+    }
+
+    // Player times are input times, progress counts from the range start
+    m_timeMs = qMax(0, time - m_rangeStartMs);
+    if (!m_lowPriority) {
+        m_stallTimer->start();
+    }
+
+    if (m_durationMs > 0) {
+        reportProgress(qBound(0, int(qint64(m_timeMs) * 100 / m_durationMs), 99), m_timeMs);
+    }
+}
+
+void SoutTranscoder::onPositionChanged(float position)
+{
+    // Only needed when the duration was not probed
+    if (!m_player || m_durationMs > 0) {
+        return;
+    }
+
+    reportProgress(qBound(0, int(position * 100), 99), qMax(0, m_timeMs));
+}
+
+void SoutTranscoder::reportProgress(int percent, int timeMs)
+{
+    // Time events come several times per second, the display shows seconds
+    const QString timeStr = formatTime(timeMs);
+    if (percent == m_percent && timeStr == m_timeStr) {
+        return;
+    }
+    m_percent = percent;
+    m_timeStr = timeStr;
+
+    emit progressChanged(percent, timeStr);
+}
+
+void SoutTranscoder::onEnd()
+{
+    if (!m_player) {
+        return;
+    }
+
+    const QFileInfo output(m_outputPath);
+    if (output.exists() && output.size() > 0) {
+        logSout("Transcode complete: %s\n", m_outputPath.toStdString().c_str());
+        cleanup();
+        emit progressChanged(100, formatTime(m_durationMs > 0 ? m_durationMs : qMax(0, m_timeMs)));
+        emit finished(m_outputPath);
+        return;
+    }
+
+    logSout("Output file not created\n");
+    if (m_timeMs < 0) {
+        startFallback();
+    } else {
+        fail(OutputFailed, "Output file not created");
+    }
+}
+
+void SoutTranscoder::onError()
+{
+    if (!m_player) {
+        return;
+    }
+
+    logSout("Stream output error at %d ms\n", m_timeMs);
+
+    // Nothing was converted, the input or the chain could not be opened
+    if (m_timeMs < 0) {
+        startFallback();
+    } else {
+        fail(Failed, "Stream output failed");
+    }
+}
+
+void SoutTranscoder::onStalled()
+{
+    if (!m_player) {
+        return;
+    }
+
+    logSout("No progress for %d ms\n", SOUT_STALL_MS);
+    fail(Stalled, errorString(Stalled));
+}
+
+void SoutTranscoder::startFallback()
+{
+    cleanup();
+    QFile::remove(m_outputPath);
+
+    if (!Transcoder::isAvailable()) {
+        emit error(OpenFailed, errorString(OpenFailed));
+        return;
+    }
+
+    logSout("Falling back to ffmpeg\n");
+
+    m_fallback = new Transcoder(this);
+    m_fallback->setMode(m_mode);
+    m_fallback->setRange(m_rangeStartMs, m_rangeLengthMs);
+    connect(m_fallback, &TranscodeEngine::progressChanged, this, &TranscodeEngine::progressChanged);
+    connect(m_fallback, &TranscodeEngine::finished, this, &TranscodeEngine::finished);
+    connect(m_fallback, &TranscodeEngine::error, this, &TranscodeEngine::error);
+
+    if (m_lowPriority) {
+        m_fallback->setLowPriority(true);
+    }
+    m_fallback->start(m_inputPath, m_outputPath, m_durationMs);
+}
+
+void SoutTranscoder::fail(Error code, const QString &message)
+{
+    cleanup();
+    QFile::remove(m_outputPath);
+    emit error(code, message);
+}
+
+void SoutTranscoder::cleanup()
+{
+    m_stallTimer->stop();
+
+    if (m_player) {
+        // Stopping emits again, those events are not wanted
+        disconnect(m_player, nullptr, this, nullptr);
+        m_player->stop();
+        delete m_player;
+        m_player = nullptr;
+    }
+
+    delete m_media;
+    m_media = nullptr;
+}
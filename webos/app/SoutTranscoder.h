@@ -0,0 +1,73 @@
+/**
+ * Sout Transcoder - re-encodes video to 480p inside the app
+ *
+ * A media player on the shared libvlc instance plays the input into a
+ * stream output chain (transcode to MPEG-4 and AAC, mux to MP4) instead
+ * of a display. Streams the mode allows are copied without a transcode
+ * step. The file access lets the input run as fast as decoding allows,
+ * or at disk speed for a remux. Progress comes from the player time and
+ * position events.
+ *
+ * When the stream output cannot open the input at all the job is handed
+ * to the ffmpeg Transcoder, if it is installed.
+ */
+
+#ifndef SOUTTRANSCODER_H
+#define SOUTTRANSCODER_H
+
+#include <QString>
+
+#include "TranscodeEngine.h"
+
+class QTimer;
+
+class VlcInstance;
+class VlcMedia;
+class VlcMediaPlayer;
+
+class Transcoder;
+
+class SoutTranscoder : public TranscodeEngine
+{
+    Q_OBJECT
+
+public:
+    explicit SoutTranscoder(VlcInstance *instance, QObject *parent = nullptr);
+    ~SoutTranscoder();
+
+    void start(const QString &inputPath, const QString &outputPath, int durationMs) override;
+    void cancel() override;
+    bool isRunning() const override;
+
+    // The decoder threads are shared with playback, so a low priority
+    // job is paused rather than reniced.
+    void setLowPriority(bool low) override;
+
+private:
+    void onTimeChanged(int time);
+    void onPositionChanged(float position);
+    void onEnd();
+    void onError();
+    void onStalled();
+    void reportProgress(int percent, int timeMs);
+    void startFallback();
+    void fail(Error code, const QString &message);
+    void cleanup();
+    static QString soutChain(const QString &outputPath, Mode mode);
+
+    VlcInstance *m_instance;
+    VlcMediaPlayer *m_player;
+    VlcMedia *m_media;
+    Transcoder *m_fallback;     // ffmpeg job when sout failed to open
+    QTimer *m_stallTimer;
+
+    QString m_inputPath;
+    QString m_outputPath;
+    int m_durationMs;
+    int m_timeMs;               // -1 until the first time event
+    int m_percent;              // Last reported
+    QString m_timeStr;
+    bool m_lowPriority;
+};
+
+#endif // SOUTTRANSCODER_H
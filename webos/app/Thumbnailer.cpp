@@ -0,0 +1,497 @@
+/**
+ * Thumbnailer - poster frames of video files
+ */
+
+#include "Thumbnailer.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QImageWriter>
+#include <QMutex>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "Instance.h"
+#include "Media.h"
+#include "MediaPlayer.h"
+#include "VideoStream.h"
+
+#include "VideoProber.h"
+
+#include <functional>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <utime.h>
+
+// Debug logging to file
+static FILE *s_thumbLogFile = nullptr;
+static void logThumb(const char *fmt, ...) {
+    if (!s_thumbLogFile) {
+        s_thumbLogFile = fopen("/media/internal/vlcplayer.log", "a");
+    }
+    if (s_thumbLogFile) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(s_thumbLogFile, "[Thumbnailer] ");
+        vfprintf(s_thumbLogFile, fmt, args);
+        va_end(args);
+        fflush(s_thumbLogFile);
+    }
+}
+
+// Players grabbing at the same time, each one decodes a full video
+#define THUMB_MAX_PLAYERS 2
+
+// Give up on files libvlc cannot open or decode in time
+#define THUMB_TIMEOUT_MS 8000
+
+// Grab position: a tenth of the duration, at most 2 minutes in.
+// Without a known duration the first seconds are skipped.
+#define THUMB_MAX_START_MS 120000
+#define THUMB_DEFAULT_START_MS 5000
+
+// Frames skipped while they are black, fades and title cards
+#define THUMB_MAX_FRAMES 12
+#define THUMB_DARK_LEVEL 24
+
+#define THUMB_MEMORY_LIMIT (8 * 1024 * 1024)
+#define THUMB_DISK_LIMIT (32 * 1024 * 1024)
+
+// Receives frames of thumbnail size from a grabbing player
+class ThumbnailStream : public VlcVideoStream
+{
+public:
+    explicit ThumbnailStream(QObject *parent)
+        : VlcVideoStream(Vlc::RV32Format, parent)
+    {
+    }
+
+    std::function<void()> onFrame;
+
+private:
+    void frameUpdated() override
+    {
+        if (onFrame) {
+            onFrame();
+        }
+    }
+};
+
+// Thumbnail files named by cache key, evicted least recently used first.
+// Used by the I/O pool tasks.
+class ThumbnailDiskCache
+{
+public:
+    ThumbnailDiskCache(const QString &dir, qint64 limit)
+        : m_dir(dir),
+          m_limit(limit),
+          m_size(-1)
+    {
+        // JPEG is a plugin that may be missing, PNG is built in
+        m_format = QImageWriter::supportedImageFormats().contains("jpeg") ? "jpeg" : "png";
+    }
+
+    QImage load(const QString &key)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        const QString path = filePath(key);
+        QImage image;
+        if (image.load(path)) {
+            // The modification time orders eviction
+            utime(QFile::encodeName(path).constData(), nullptr);
+        }
+        return image;
+    }
+
+    void store(const QString &key, const QImage &image)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_size < 0) {
+            m_size = 0;
+            const QFileInfoList files = QDir(m_dir).entryInfoList(QDir::Files);
+            for (const QFileInfo &file : files) {
+                m_size += file.size();
+            }
+        }
+
+        QDir().mkpath(m_dir);
+        const QString path = filePath(key);
+        if (!image.save(path, m_format, 80)) {
+            logThumb("Cannot write %s\n", path.toStdString().c_str());
+            return;
+        }
+        m_size += QFileInfo(path).size();
+
+        if (m_size > m_limit) {
+            evict();
+        }
+    }
+
+private:
+    QString filePath(const QString &key) const
+    {
+        return m_dir + "/" + key;
+    }
+
+    // Down to 3/4 of the limit, so eviction does not run for every store
+    void evict()
+    {
+        const QFileInfoList files = QDir(m_dir).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+        for (const QFileInfo &file : files) {
+            if (m_size <= m_limit / 4 * 3) {
+                break;
+            }
+            if (QFile::remove(file.absoluteFilePath())) {
+                m_size -= file.size();
+            }
+        }
+    }
+
+    QMutex m_mutex;
+    QString m_dir;
+    qint64 m_limit;
+    qint64 m_size;          // -1 until the directory was summed up
+    const char *m_format;
+};
+
+namespace {
+
+class LoadTask : public QRunnable
+{
+public:
+    LoadTask(ThumbnailDiskCache *cache, const QString &key, const QFutureInterface<QImage> &result)
+        : m_cache(cache),
+          m_key(key),
+          m_result(result)
+    {
+    }
+
+    void run() override
+    {
+        m_result.reportResult(m_cache->load(m_key));
+        m_result.reportFinished();
+    }
+
+private:
+    ThumbnailDiskCache *m_cache;
+    QString m_key;
+    QFutureInterface<QImage> m_result;
+};
+
+class StoreTask : public QRunnable
+{
+public:
+    StoreTask(ThumbnailDiskCache *cache, const QString &key, const QImage &image)
+        : m_cache(cache),
+          m_key(key),
+          m_image(image)
+    {
+    }
+
+    void run() override
+    {
+        m_cache->store(m_key, m_image);
+    }
+
+private:
+    ThumbnailDiskCache *m_cache;
+    QString m_key;
+    QImage m_image;
+};
+
+// Average green of a sparse grid, close enough to luma to spot black frames
+bool isDark(const QImage &image)
+{
+    const int step = 8;
+    qint64 sum = 0;
+    int count = 0;
+    for (int y = 0; y < image.height(); y += step) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); x += step) {
+            sum += qGreen(line[x]);
+            ++count;
+        }
+    }
+    return !count || sum / count < THUMB_DARK_LEVEL;
+}
+
+} // namespace
+
+Thumbnailer::Thumbnailer(VlcInstance *instance, VideoProber *prober, QObject *parent)
+    : QObject(parent),
+      m_instance(instance),
+      m_prober(prober),
+      m_size(192, 108),
+      m_memory(THUMB_MEMORY_LIMIT),
+      m_disk(new ThumbnailDiskCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                                    + "/thumbnails", THUMB_DISK_LIMIT)),
+      m_ioPool(new QThreadPool(this))
+{
+    // One thread keeps disk access sequential on the slow flash
+    m_ioPool->setMaxThreadCount(1);
+}
+
+Thumbnailer::~Thumbnailer()
+{
+    for (const Grabber &grabber : m_grabbers) {
+        grabber.player->stop();
+        grabber.stream->deinit();
+        delete grabber.stream;
+        delete grabber.player;
+        delete grabber.media;
+    }
+
+    // Pending stores finish, they are cheap
+    m_ioPool->waitForDone();
+    delete m_disk;
+}
+
+void Thumbnailer::setSize(const QSize &size)
+{
+    m_size = size;
+    m_memory.clear();
+
+    for (const Grabber &grabber : m_grabbers) {
+        grabber.stream->setMaximumSize(m_size);
+    }
+}
+
+QString Thumbnailer::cacheKey(const QFileInfo &file) const
+{
+    // A changed file or size is a new thumbnail, old ones age out of the caches
+    const QString id = QString("%1|%2|%3|%4x%5")
+        .arg(file.absoluteFilePath())
+        .arg(file.size())
+        .arg(file.lastModified().toMSecsSinceEpoch())
+        .arg(m_size.width())
+        .arg(m_size.height());
+    return QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Sha1).toHex();
+}
+
+QImage Thumbnailer::thumbnail(const QString &filePath)
+{
+    const QFileInfo file(filePath);
+    if (!file.isFile()) {
+        return QImage();
+    }
+
+    const QString key = cacheKey(file);
+    if (const QImage *image = m_memory.object(key)) {
+        return *image;
+    }
+    if (m_failed.contains(key) || m_loading.contains(key)) {
+        return QImage();
+    }
+    m_loading.insert(key, filePath);
+
+    Request request;
+    request.path = filePath;
+    request.key = key;
+
+    QFutureInterface<QImage> result;
+    result.reportStarted();
+
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, request]() {
+        const QFuture<QImage> future = watcher->future();
+        watcher->deleteLater();
+        diskLoaded(request, future.resultCount() ? future.result() : QImage());
+    });
+    watcher->setFuture(result.future());
+
+    m_ioPool->start(new LoadTask(m_disk, key, result));
+    return QImage();
+}
+
+void Thumbnailer::cancel()
+{
+    for (const Request &request : m_queue) {
+        m_loading.remove(request.key);
+    }
+    m_queue.clear();
+}
+
+void Thumbnailer::diskLoaded(const Request &request, const QImage &image)
+{
+    if (!image.isNull()) {
+        remember(request.key, image);
+        if (m_loading.remove(request.key)) {
+            emit thumbnailReady(request.path, image);
+        }
+        return;
+    }
+
+    // Cancelled while loading
+    if (!m_loading.contains(request.key)) {
+        return;
+    }
+
+    m_queue.append(request);
+    startNext();
+}
+
+void Thumbnailer::startNext()
+{
+    if (!m_instance) {
+        return;
+    }
+
+    for (int i = 0; i < THUMB_MAX_PLAYERS && !m_queue.isEmpty(); ++i) {
+        if (i == m_grabbers.size()) {
+            Grabber grabber;
+            grabber.player = new VlcMediaPlayer(m_instance);
+            grabber.stream = new ThumbnailStream(nullptr);
+            grabber.stream->setMaximumSize(m_size);
+            grabber.stream->init(grabber.player);
+            grabber.stream->onFrame = [this, i]() { frameReady(i); };
+            grabber.timeout = new QTimer(this);
+            grabber.timeout->setSingleShot(true);
+            grabber.timeout->setInterval(THUMB_TIMEOUT_MS);
+            grabber.media = nullptr;
+            grabber.frames = 0;
+            grabber.sequence = 0;
+            grabber.fromStart = false;
+
+            // Player events come from the libvlc thread and are queued here
+            connect(grabber.player, &VlcMediaPlayer::end, this, [this, i]() { grabFailed(i, false); });
+            connect(grabber.player, &VlcMediaPlayer::error, this, [this, i]() { grabFailed(i, false); });
+            connect(grabber.timeout, &QTimer::timeout, this, [this, i]() { grabFailed(i, true); });
+            m_grabbers.append(grabber);
+        }
+
+        if (m_grabbers[i].media) {
+            continue;
+        }
+
+        m_grabbers[i].request = m_queue.takeFirst();
+        grab(i, false);
+    }
+}
+
+void Thumbnailer::grab(int index, bool fromStart)
+{
+    Grabber &grabber = m_grabbers[index];
+
+    int startMs = 0;
+    if (!fromStart) {
+        VideoProber::VideoInfo info;
+        if (m_prober && m_prober->cachedInfo(grabber.request.path, &info) && info.durationMs > 0) {
+            startMs = qMin(info.durationMs / 10, THUMB_MAX_START_MS);
+        } else {
+            startMs = THUMB_DEFAULT_START_MS;
+        }
+    }
+
+    delete grabber.media;
+    grabber.media = new VlcMedia(grabber.request.path, true, m_instance);
+    grabber.media->setOptions(QStringList()
+        << ":no-audio"
+        << ":no-spu"
+        << ":input-fast-seek"
+        << QString(":start-time=%1").arg(startMs / 1000.0));
+    grabber.frames = 0;
+    grabber.fromStart = fromStart;
+
+    // The player is stopped, frames of the previous request may still be
+    // queued. Anything up to the newest one in the stream is theirs.
+    const std::shared_ptr<const VlcAbstractVideoFrame> last = grabber.stream->acquireFrame();
+    if (last) {
+        grabber.sequence = qMax(grabber.sequence, last->timing.sequence);
+    }
+
+    grabber.player->open(grabber.media);
+    grabber.timeout->start();
+}
+
+void Thumbnailer::frameReady(int index)
+{
+    Grabber &grabber = m_grabbers[index];
+
+    const std::shared_ptr<const VlcAbstractVideoFrame> frame = grabber.stream->acquireFrame();
+    if (!grabber.media || !frame || !frame->width || !frame->height) {
+        return;
+    }
+
+    // Several updates may come for one frame, or one left from the last request
+    if (frame->timing.sequence <= grabber.sequence) {
+        return;
+    }
+    grabber.sequence = frame->timing.sequence;
+
+    // RV32 is BGRA in memory, which is QImage::Format_RGB32 on little endian
+    const int pitch = frame->planeSizes[0] / frame->height;
+    const QImage image = QImage(reinterpret_cast<const uchar *>(frame->planes[0]),
+                                frame->width, frame->height, pitch, QImage::Format_RGB32).copy();
+
+    if (isDark(image) && ++grabber.frames < THUMB_MAX_FRAMES) {
+        return;
+    }
+
+    const Request request = grabber.request;
+    finishGrab(index);
+
+    remember(request.key, image);
+    m_ioPool->start(new StoreTask(m_disk, request.key, image));
+    if (m_loading.remove(request.key)) {
+        emit thumbnailReady(request.path, image);
+    }
+
+    startNext();
+}
+
+void Thumbnailer::grabFailed(int index, bool timedOut)
+{
+    Grabber &grabber = m_grabbers[index];
+    if (!grabber.media) {
+        return;
+    }
+
+    // end() and error() of a stopped request may still be queued
+    if (!timedOut) {
+        const Vlc::State state = grabber.player->state();
+        if (state == Vlc::Opening || state == Vlc::Buffering || state == Vlc::Playing) {
+            return;
+        }
+    }
+
+    // The start position may be past the end of a short clip
+    if (!grabber.fromStart && !timedOut) {
+        grabber.player->stop();
+        grab(index, true);
+        return;
+    }
+
+    const Request request = grabber.request;
+    finishGrab(index);
+
+    logThumb("%s: %s\n", timedOut ? "Timed out" : "No frame", request.path.toStdString().c_str());
+    m_failed.insert(request.key);
+    m_loading.remove(request.key);
+    emit thumbnailFailed(request.path);
+
+    startNext();
+}
+
+void Thumbnailer::finishGrab(int index)
+{
+    Grabber &grabber = m_grabbers[index];
+
+    grabber.timeout->stop();
+    grabber.player->stop();
+    delete grabber.media;
+    grabber.media = nullptr;
+}
+
+void Thumbnailer::remember(const QString &key, const QImage &image)
+{
+    m_memory.insert(key, new QImage(image), image.byteCount());
+}
@@ -0,0 +1,103 @@
+/**
+ * Thumbnailer - poster frames of video files
+ *
+ * Frames are grabbed by a few reusable media players on the shared
+ * libvlc instance. Their video stream asks libvlc for a frame of
+ * thumbnail size, so no full size frame is decoded into memory. A
+ * player starts a tenth into the file, takes the first frame that
+ * is not black and stops.
+ *
+ * Results are kept in an in-memory LRU and a size limited disk cache.
+ * Disk access runs on a worker thread.
+ */
+
+#ifndef THUMBNAILER_H
+#define THUMBNAILER_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+class QFileInfo;
+class QThreadPool;
+class QTimer;
+
+class VlcInstance;
+class VlcMedia;
+class VlcMediaPlayer;
+
+class ThumbnailDiskCache;
+class ThumbnailStream;
+class VideoProber;
+
+class Thumbnailer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // prober is optional, its cached durations pick the grab position
+    Thumbnailer(VlcInstance *instance, VideoProber *prober, QObject *parent = nullptr);
+    ~Thumbnailer();
+
+    // Largest thumbnail size, aspect ratio is kept (default 192x108)
+    QSize size() const { return m_size; }
+    void setSize(const QSize &size);
+
+    // Cached thumbnail, or a null image while it is being made.
+    // thumbnailReady() or thumbnailFailed() follows for the null image.
+    QImage thumbnail(const QString &filePath);
+
+    // Drop requests that are not being grabbed yet, e.g. when leaving a folder
+    void cancel();
+
+signals:
+    void thumbnailReady(const QString &filePath, const QImage &image);
+    void thumbnailFailed(const QString &filePath);
+
+private:
+    struct Request {
+        QString path;
+        QString key;
+    };
+
+    struct Grabber {
+        VlcMediaPlayer *player;
+        ThumbnailStream *stream;
+        QTimer *timeout;
+        VlcMedia *media;        // Null while idle
+        Request request;
+        int frames;             // Frames seen for the current request
+        quint64 sequence;       // Newest frame seen, older ones are stale
+        bool fromStart;         // Retrying at position 0
+    };
+
+    QString cacheKey(const QFileInfo &file) const;
+    void diskLoaded(const Request &request, const QImage &image);
+    void startNext();
+    void grab(int index, bool fromStart);
+    void frameReady(int index);
+    void grabFailed(int index, bool timedOut);
+    void finishGrab(int index);
+    void remember(const QString &key, const QImage &image);
+
+    VlcInstance *m_instance;
+    VideoProber *m_prober;
+    QSize m_size;
+
+    QCache<QString, QImage> m_memory;   // By cache key, cost is bytes
+    ThumbnailDiskCache *m_disk;
+    QThreadPool *m_ioPool;
+
+    QHash<QString, QString> m_loading;  // Cache key to path, loading or grabbing
+    QSet<QString> m_failed;             // Not retried until the file changes
+    QList<Request> m_queue;             // Not found on disk, waiting for a grabber
+    QVector<Grabber> m_grabbers;
+};
+
+#endif // THUMBNAILER_H
@@ -4,13 +4,17 @@
 
 #include "TranscodeDialog.h"
 
+#include <QFileInfo>
 #include <QHBoxLayout>
+#include <QPixmap>
 #include <QMessageBox>
 
 TranscodeDialog::TranscodeDialog(QWidget *parent)
     : QDialog(parent),
+      m_instance(nullptr),
       m_transcoder(nullptr),
-      m_durationMs(0)
+      m_durationMs(0),
+      m_convertOnly(false)
 {
     setWindowTitle("HD Video Detected");
     setModal(true);
@@ -41,19 +45,12 @@ TranscodeDialog::TranscodeDialog(QWidget *parent)
     // Start in offer mode
     m_offerWidget->show();
     m_progressWidget->hide();
-
-    m_transcoder = new Transcoder(this);
-    connect(m_transcoder, &Transcoder::progressChanged,
-            this, &TranscodeDialog::onProgressChanged);
-    connect(m_transcoder, &Transcoder::finished,
-            this, &TranscodeDialog::onTranscodeComplete);
-    connect(m_transcoder, &Transcoder::error,
-            this, &TranscodeDialog::onTranscodeError);
 }
 
 TranscodeDialog::~TranscodeDialog()
 {
     if (m_transcoder && m_transcoder->isRunning()) {
+        disconnect(m_transcoder, nullptr, this, nullptr);
         m_transcoder->cancel();
     }
 }
@@ -65,20 +62,21 @@ void TranscodeDialog::setupOfferUI()
     layout->setSpacing(15);
     layout->setContentsMargins(0, 0, 0, 0);
 
+    m_posterLabel = new QLabel(this);
+    m_posterLabel->setAlignment(Qt::AlignCenter);
+    m_posterLabel->hide();
+    layout->addWidget(m_posterLabel);
+
     m_infoLabel = new QLabel(this);
     m_infoLabel->setWordWrap(true);
     m_infoLabel->setAlignment(Qt::AlignCenter);
     layout->addWidget(m_infoLabel);
 
-    QLabel *warningLabel = new QLabel(
-        "The TouchPad's CPU may struggle with HD video.\n"
-        "Re-encoding to 480p will enable smooth playback.\n\n"
-        "Note: This can take several hours for long videos.",
-        this);
-    warningLabel->setWordWrap(true);
-    warningLabel->setAlignment(Qt::AlignCenter);
-    warningLabel->setStyleSheet("color: #aaa; font-size: 12px;");
-    layout->addWidget(warningLabel);
+    m_warningLabel = new QLabel(this);
+    m_warningLabel->setWordWrap(true);
+    m_warningLabel->setAlignment(Qt::AlignCenter);
+    m_warningLabel->setStyleSheet("color: #aaa; font-size: 12px;");
+    layout->addWidget(m_warningLabel);
 
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     buttonLayout->setSpacing(10);
@@ -92,11 +90,21 @@ void TranscodeDialog::setupOfferUI()
     connect(m_playAnywayButton, &QPushButton::clicked,
             this, &TranscodeDialog::onPlayAnywayClicked);
 
+    m_laterButton = new QPushButton("Re-encode Later", this);
+    connect(m_laterButton, &QPushButton::clicked,
+            this, &TranscodeDialog::onLaterClicked);
+
+    m_progressiveButton = new QPushButton("Play While Converting", this);
+    connect(m_progressiveButton, &QPushButton::clicked,
+            this, &TranscodeDialog::onProgressiveClicked);
+
     m_cancelButton = new QPushButton("Cancel", this);
     connect(m_cancelButton, &QPushButton::clicked,
             this, &TranscodeDialog::onCancelClicked);
 
     buttonLayout->addWidget(m_transcodeButton);
+    buttonLayout->addWidget(m_progressiveButton);
+    buttonLayout->addWidget(m_laterButton);
     buttonLayout->addWidget(m_playAnywayButton);
     buttonLayout->addWidget(m_cancelButton);
 
@@ -153,22 +161,64 @@ void TranscodeDialog::showOffer(const VideoProber::VideoInfo &info, const QStrin
     m_inputPath = filePath;
     m_outputPath = VideoProber::get480pPath(filePath);
     m_durationMs = info.durationMs;
+    m_convertOnly = !VideoProber::isHD(info);
+
+    if (m_convertOnly) {
+        setWindowTitle("Video Conversion");
+        m_infoLabel->setText(QString(
+            "This video is a <b>.%1</b> file (%2x%3).<br><br>"
+            "Would you like to convert it to MP4 for smoother playback?")
+            .arg(QFileInfo(filePath).suffix().toLower())
+            .arg(info.width)
+            .arg(info.height));
+
+        // Copied streams convert at disk speed
+        if (TranscodeEngine::chooseMode(info) == TranscodeEngine::Reencode) {
+            m_warningLabel->setText("The video has to be re-encoded.\n\n"
+                                    "Note: This can take several hours for long videos.");
+        } else {
+            m_warningLabel->setText("The video is copied as it is, this takes a few minutes.");
+        }
 
-    QString resolution = VideoProber::resolutionString(info);
-    QString infoText = QString(
-        "This video is <b>%1</b> (%2x%3).<br><br>"
-        "Would you like to re-encode it to 480p for smoother playback?")
-        .arg(resolution)
-        .arg(info.width)
-        .arg(info.height);
-
-    m_infoLabel->setText(infoText);
+        m_transcodeButton->setText("Convert to MP4");
+        m_laterButton->setText("Convert Later");
+        m_progressiveButton->hide();
+        m_progressLabel->setText("Converting video...");
+    } else {
+        setWindowTitle("HD Video Detected");
+        m_infoLabel->setText(QString(
+            "This video is <b>%1</b> (%2x%3).<br><br>"
+            "Would you like to re-encode it to 480p for smoother playback?")
+            .arg(VideoProber::resolutionString(info))
+            .arg(info.width)
+            .arg(info.height));
+        m_warningLabel->setText("The TouchPad's CPU may struggle with HD video.\n"
+                                "Re-encoding to 480p will enable smooth playback.\n\n"
+                                "Note: This can take several hours for long videos.");
+
+        m_transcodeButton->setText("Re-encode to 480p");
+        m_laterButton->setText("Re-encode Later");
+        m_progressiveButton->show();
+        m_progressLabel->setText("Re-encoding video to 480p...");
+    }
 
     m_offerWidget->show();
     m_progressWidget->hide();
     adjustSize();
 }
 
+void TranscodeDialog::setPoster(const QImage &image)
+{
+    if (image.isNull()) {
+        m_posterLabel->hide();
+        return;
+    }
+
+    m_posterLabel->setPixmap(QPixmap::fromImage(image));
+    m_posterLabel->show();
+    adjustSize();
+}
+
 void TranscodeDialog::startTranscode(const QString &inputPath, const QString &outputPath,
                                      int durationMs)
 {
@@ -176,6 +226,19 @@ void TranscodeDialog::startTranscode(const QString &inputPath, const QString &ou
     m_outputPath = outputPath;
     m_durationMs = durationMs;
 
+    if (!m_transcoder) {
+        m_transcoder = TranscodeEngine::create(m_instance, this);
+        connect(m_transcoder, &TranscodeEngine::progressChanged,
+                this, &TranscodeDialog::onProgressChanged);
+        connect(m_transcoder, &TranscodeEngine::finished,
+                this, &TranscodeDialog::onTranscodeComplete);
+        connect(m_transcoder, &TranscodeEngine::error,
+                this, &TranscodeDialog::onTranscodeError);
+    }
+
+    // Copies what already plays well, only the offered file's info is known
+    m_transcoder->setMode(TranscodeEngine::chooseMode(m_videoInfo));
+
     switchToProgressMode();
     m_transcoder->start(inputPath, outputPath, durationMs);
 }
@@ -218,6 +281,16 @@ void TranscodeDialog::onPlayAnywayClicked()
     done(PlayAnyway);
 }
 
+void TranscodeDialog::onLaterClicked()
+{
+    done(TranscodeLater);
+}
+
+void TranscodeDialog::onProgressiveClicked()
+{
+    done(PlayProgressive);
+}
+
 void TranscodeDialog::onCancelClicked()
 {
     done(Cancelled);
@@ -250,9 +323,9 @@ void TranscodeDialog::onProgressChanged(int percent, const QString &timeStr)
 void TranscodeDialog::onTranscodeComplete(const QString &outputPath)
 {
     m_outputPath = outputPath;
-    m_progressLabel->setText("Re-encoding complete!");
+    m_progressLabel->setText(m_convertOnly ? "Conversion complete!" : "Re-encoding complete!");
     m_progressBar->setValue(100);
-    m_cancelProgressButton->setText("Play 480p Version");
+    m_cancelProgressButton->setText(m_convertOnly ? "Play Converted Version" : "Play 480p Version");
 
     disconnect(m_cancelProgressButton, nullptr, nullptr, nullptr);
     connect(m_cancelProgressButton, &QPushButton::clicked, this, [this]() {
@@ -262,13 +335,22 @@ void TranscodeDialog::onTranscodeComplete(const QString &outputPath)
     emit transcodeFinished(outputPath);
 }
 
-void TranscodeDialog::onTranscodeError(const QString &message)
+void TranscodeDialog::onTranscodeError(TranscodeEngine::Error error, const QString &message)
 {
-    m_progressLabel->setText("Re-encoding failed");
+    // The user asked for it, nothing to report
+    if (error == TranscodeEngine::Cancelled) {
+        if (isVisible()) {
+            reject();
+        }
+        return;
+    }
+
+    m_progressLabel->setText(m_convertOnly ? "Conversion failed" : "Re-encoding failed");
     m_progressLabel->setStyleSheet("font-size: 16px; font-weight: bold; color: #f44;");
 
     QMessageBox::warning(this, "Transcode Failed",
-                         QString("Failed to re-encode video:\n%1").arg(message));
+                         QString("Failed to %1 video:\n%2")
+                             .arg(m_convertOnly ? "convert" : "re-encode", message));
 
     emit transcodeFailed(message);
     reject();
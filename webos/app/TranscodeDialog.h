@@ -6,13 +6,14 @@
 #define TRANSCODEDIALOG_H
 
 #include <QDialog>
+#include <QImage>
 #include <QLabel>
 #include <QPushButton>
 #include <QProgressBar>
 #include <QVBoxLayout>
 
 #include "VideoProber.h"
-#include "Transcoder.h"
+#include "TranscodeEngine.h"
 
 class TranscodeDialog : public QDialog
 {
@@ -23,15 +24,24 @@ public:
         Cancelled = 0,
         Transcode = 1,
         PlayAnyway = 2,
-        TranscodeComplete = 3
+        TranscodeComplete = 3,
+        TranscodeLater = 4,     // Queue it in the background, play the HD file now
+        PlayProgressive = 5     // Play 480p segments while they are converted
     };
 
     explicit TranscodeDialog(QWidget *parent = nullptr);
     ~TranscodeDialog();
 
-    // Show the offer dialog ("This video is 1080p, transcode to 480p?")
+    // Show the offer dialog ("This video is 1080p, transcode to 480p?").
+    // SD video outside an MP4 container gets a conversion offer instead.
     void showOffer(const VideoProber::VideoInfo &info, const QString &filePath);
 
+    // Poster frame shown with the offer, hidden for a null image
+    void setPoster(const QImage &image);
+
+    // Transcode in-process on this instance, ffmpeg is used without one
+    void setInstance(VlcInstance *instance) { m_instance = instance; }
+
     // Start transcoding and show progress
     void startTranscode(const QString &inputPath, const QString &outputPath,
                         int durationMs);
@@ -46,10 +56,12 @@ signals:
 private slots:
     void onTranscodeClicked();
     void onPlayAnywayClicked();
+    void onLaterClicked();
+    void onProgressiveClicked();
     void onCancelClicked();
     void onProgressChanged(int percent, const QString &timeStr);
     void onTranscodeComplete(const QString &outputPath);
-    void onTranscodeError(const QString &message);
+    void onTranscodeError(TranscodeEngine::Error error, const QString &message);
 
 private:
     void setupOfferUI();
@@ -57,9 +69,13 @@ private:
     void switchToProgressMode();
 
     // Offer mode widgets
+    QLabel *m_posterLabel;
     QLabel *m_infoLabel;
+    QLabel *m_warningLabel;
     QPushButton *m_transcodeButton;
     QPushButton *m_playAnywayButton;
+    QPushButton *m_laterButton;
+    QPushButton *m_progressiveButton;
     QPushButton *m_cancelButton;
 
     // Progress mode widgets
@@ -73,14 +89,16 @@ private:
     QWidget *m_progressWidget;
     QVBoxLayout *m_mainLayout;
 
-    // Transcoder
-    Transcoder *m_transcoder;
+    // Transcoder, created when a transcode starts
+    VlcInstance *m_instance;
+    TranscodeEngine *m_transcoder;
 
     // State
     QString m_inputPath;
     QString m_outputPath;
     int m_durationMs;
     VideoProber::VideoInfo m_videoInfo;
+    bool m_convertOnly;     // SD video, only the container needs to change
 };
 
 #endif // TRANSCODEDIALOG_H
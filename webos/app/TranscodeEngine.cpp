@@ -0,0 +1,119 @@
+/**
+ * Transcode Engine - common interface of the 480p transcoders
+ */
+
+#include "TranscodeEngine.h"
+
+#include "SoutTranscoder.h"
+#include "Transcoder.h"
+
+#include <QFileInfo>
+#include <QStringList>
+
+// Video the device decodes smoothly, copied as is. Overall bitrate,
+// the output targets 1500 kbit/s video and 128 kbit/s audio.
+#define COPY_MAX_WIDTH 864
+#define COPY_MAX_HEIGHT 480
+#define COPY_MAX_FPS 30.5f
+#define COPY_MAX_KBPS 2500
+
+TranscodeEngine *TranscodeEngine::create(VlcInstance *instance, QObject *parent)
+{
+    if (instance) {
+        return new SoutTranscoder(instance, parent);
+    }
+    return new Transcoder(parent);
+}
+
+TranscodeEngine::Mode TranscodeEngine::chooseMode(const VideoProber::VideoInfo &info)
+{
+    if (!info.valid) {
+        return Reencode;
+    }
+
+    // Codecs the MP4 muxer takes and the device decodes
+    static const QStringList videoCodecs = QStringList() << "mpeg4" << "h264";
+    static const QStringList audioCodecs = QStringList() << "aac" << "mp3";
+
+    // Frame rate and bitrate are 0 when unknown, that does not rule out a copy
+    const bool copyVideo = videoCodecs.contains(info.codec)
+        && info.width <= COPY_MAX_WIDTH && info.height <= COPY_MAX_HEIGHT
+        && info.frameRate <= COPY_MAX_FPS
+        && info.bitrate <= COPY_MAX_KBPS;
+    if (!copyVideo) {
+        return Reencode;
+    }
+
+    // No audio at all needs no encoder either
+    if (info.audioCodec.isEmpty() || audioCodecs.contains(info.audioCodec)) {
+        return Remux;
+    }
+    return AudioOnly;
+}
+
+bool TranscodeEngine::needsConversion(const QString &path, const VideoProber::VideoInfo &info)
+{
+    if (!info.valid || VideoProber::isHD(info)) {
+        return false;
+    }
+
+    // ISO media files, the device plays them without help
+    static const QStringList mp4Suffixes = QStringList() << "mp4" << "m4v" << "mov" << "3gp";
+    return !mp4Suffixes.contains(QFileInfo(path).suffix().toLower());
+}
+
+QString TranscodeEngine::modeString(Mode mode)
+{
+    switch (mode) {
+    case AudioOnly:
+        return "audio only";
+    case Remux:
+        return "remux";
+    case Reencode:
+    default:
+        return "re-encode";
+    }
+}
+
+QString TranscodeEngine::errorString(Error error)
+{
+    switch (error) {
+    case NoError:
+        return QString();
+    case Cancelled:
+        return "Transcoding cancelled";
+    case InputMissing:
+        return "Input file not found";
+    case EncoderMissing:
+        return "No encoder available";
+    case OpenFailed:
+        return "Cannot open or decode the video";
+    case OutputFailed:
+        return "Cannot write the output file";
+    case Stalled:
+        return "Transcoding stopped making progress";
+    case Failed:
+    default:
+        return "Transcoding failed";
+    }
+}
+
+QString TranscodeEngine::formatTime(int ms)
+{
+    int seconds = ms / 1000;
+    int minutes = seconds / 60;
+    int hours = minutes / 60;
+    seconds = seconds % 60;
+    minutes = minutes % 60;
+
+    if (hours > 0) {
+        return QString("%1:%2:%3")
+            .arg(hours)
+            .arg(minutes, 2, 10, QChar('0'))
+            .arg(seconds, 2, 10, QChar('0'));
+    } else {
+        return QString("%1:%2")
+            .arg(minutes, 2, 10, QChar('0'))
+            .arg(seconds, 2, 10, QChar('0'));
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * Transcode Engine - common interface of the 480p transcoders
+ *
+ * SoutTranscoder converts inside the app with the shared libvlc instance,
+ * Transcoder runs the bundled ffmpeg. create() picks the libvlc one when
+ * an instance is available, it falls back to ffmpeg by itself.
+ *
+ * chooseMode() decides from the probe results how much of a file has to
+ * be re-encoded. Streams the device already plays well are copied, so a
+ * file that only needs another container converts at disk speed.
+ * needsConversion() picks the files below 720p that are worth it.
+ */
+
+#ifndef TRANSCODEENGINE_H
+#define TRANSCODEENGINE_H
+
+#include <QObject>
+#include <QString>
+
+#include "VideoProber.h"
+
+class VlcInstance;
+
+class TranscodeEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Error {
+        NoError,
+        Cancelled,
+        InputMissing,   // Input file does not exist
+        EncoderMissing, // No ffmpeg binary or libvlc stream output
+        OpenFailed,     // Input could not be opened or decoded
+        OutputFailed,   // Output could not be written
+        Stalled,        // No progress for too long
+        Failed          // Encoder failed or crashed while running
+    };
+    Q_ENUM(Error)
+
+    // Saved by the queue, keep the values
+    enum Mode {
+        Reencode = 0,   // Video scaled to 480p and audio re-encoded
+        AudioOnly = 1,  // Video copied, audio re-encoded
+        Remux = 2       // Both copied into the new container
+    };
+    Q_ENUM(Mode)
+
+    explicit TranscodeEngine(QObject *parent = nullptr)
+        : QObject(parent), m_mode(Reencode), m_rangeStartMs(0), m_rangeLengthMs(0) {}
+
+    // Cheapest mode that gives a file the device plays smoothly
+    static Mode chooseMode(const VideoProber::VideoInfo &info);
+
+    // Whether a video below 720p is worth converting. Files in an MP4
+    // container are left alone, others like MKV or AVI are remuxed, with
+    // AC3 or DTS audio re-encoded on the way (see chooseMode()).
+    static bool needsConversion(const QString &path, const VideoProber::VideoInfo &info);
+
+    // Mode of the next start(), full re-encode by default
+    Mode mode() const { return m_mode; }
+    void setMode(Mode mode) { m_mode = mode; }
+
+    // Part of the input the next start() converts, a length of 0 runs to
+    // the end. start() then takes the duration of the part, and progress
+    // times count from its beginning.
+    void setRange(int startMs, int lengthMs) { m_rangeStartMs = startMs; m_rangeLengthMs = lengthMs; }
+
+    // libvlc engine with an instance, ffmpeg without one
+    static TranscodeEngine *create(VlcInstance *instance, QObject *parent = nullptr);
+
+    // Start transcoding from input to output (480p)
+    virtual void start(const QString &inputPath, const QString &outputPath, int durationMs) = 0;
+
+    // Cancel ongoing transcode, reports Cancelled and removes the partial output
+    virtual void cancel() = 0;
+
+    // Check if transcoding is in progress
+    virtual bool isRunning() const = 0;
+
+    // Yield to playback, e.g. while a video plays
+    virtual void setLowPriority(bool low) = 0;
+
+    // Human readable description of an error code
+    static QString errorString(Error error);
+    static QString modeString(Mode mode);
+
+signals:
+    // Progress update (0-100), with current time string
+    void progressChanged(int percent, const QString &timeStr);
+
+    // Transcoding completed successfully
+    void finished(const QString &outputPath);
+
+    // Transcoding failed or was cancelled, message has the details
+    void error(TranscodeEngine::Error error, const QString &message);
+
+protected:
+    // Progress time for progressChanged(), m:ss or h:mm:ss
+    static QString formatTime(int ms);
+
+    Mode m_mode;
+    int m_rangeStartMs;
+    int m_rangeLengthMs;
+};
+
+#endif // TRANSCODEENGINE_H
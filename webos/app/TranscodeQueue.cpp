@@ -0,0 +1,422 @@
+/**
+ * Transcode Queue - background transcode jobs that survive restarts
+ */
+
+#include "TranscodeQueue.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+
+#include "TranscodeEngine.h"
+#include "Transcoder.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Debug logging to file
+static FILE *s_queueLogFile = nullptr;
+static void logQueue(const char *fmt, ...) {
+    if (!s_queueLogFile) {
+        s_queueLogFile = fopen("/media/internal/vlcplayer.log", "a");
+    }
+    if (s_queueLogFile) {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(s_queueLogFile, "[TranscodeQueue] ");
+        vfprintf(s_queueLogFile, fmt, args);
+        va_end(args);
+        fflush(s_queueLogFile);
+    }
+}
+
+#define QUEUE_FILE_VERSION 1
+
+// A job that keeps getting interrupted, e.g. crashing the app, gives up
+#define QUEUE_MAX_ATTEMPTS 3
+
+TranscodeQueue::TranscodeQueue(QObject *parent)
+    : QObject(parent),
+      m_instance(nullptr),
+      m_nextId(1),
+      m_maxRunning(qMax(1, QThread::idealThreadCount() / 2)),
+      m_playbackActive(false),
+      m_useFfmpeg(false),
+      m_started(false)
+{
+}
+
+TranscodeQueue::~TranscodeQueue()
+{
+    // Closing the app is not a failed attempt, running jobs start over next time
+    for (Job &job : m_jobs) {
+        if (job.state == Running) {
+            job.state = Queued;
+            --job.attempts;
+        }
+    }
+    save();
+
+    // Stops the encoders and removes the partial files
+    for (TranscodeEngine *transcoder : m_running) {
+        disconnect(transcoder, nullptr, this, nullptr);
+        delete transcoder;
+    }
+}
+
+QString TranscodeQueue::partialPath(const QString &outputPath)
+{
+    // Same extension, ffmpeg picks the container from it
+    const QFileInfo info(outputPath);
+    return info.absolutePath() + "/." + info.fileName();
+}
+
+void TranscodeQueue::start()
+{
+    if (m_started) {
+        return;
+    }
+    m_started = true;
+
+    load();
+    schedule();
+}
+
+int TranscodeQueue::enqueue(const QString &inputPath, const QString &outputPath, int durationMs, int priority,
+                            TranscodeEngine::Mode mode)
+{
+    for (const Job &job : m_jobs) {
+        if (job.inputPath == inputPath && job.outputPath == outputPath) {
+            return job.id;
+        }
+    }
+
+    Job job;
+    job.id = m_nextId++;
+    job.inputPath = inputPath;
+    job.outputPath = outputPath;
+    job.durationMs = durationMs;
+    job.priority = priority;
+    job.mode = mode;
+    m_jobs.append(job);
+
+    logQueue("Queued job %d: %s\n", job.id, inputPath.toStdString().c_str());
+
+    save();
+    emit jobAdded(job.id);
+    schedule();
+    return job.id;
+}
+
+void TranscodeQueue::remove(int id)
+{
+    const int index = indexOf(id);
+    if (index < 0) {
+        return;
+    }
+
+    TranscodeEngine *transcoder = m_running.take(id);
+    if (transcoder) {
+        disconnect(transcoder, nullptr, this, nullptr);
+        transcoder->cancel();
+        transcoder->deleteLater();
+    }
+
+    m_jobs.removeAt(index);
+    save();
+    emit jobRemoved(id);
+    schedule();
+}
+
+void TranscodeQueue::retry(int id)
+{
+    const int index = indexOf(id);
+    if (index < 0 || m_jobs[index].state != Failed) {
+        return;
+    }
+
+    m_jobs[index].state = Queued;
+    m_jobs[index].attempts = 0;
+    m_jobs[index].error.clear();
+    save();
+    schedule();
+}
+
+void TranscodeQueue::setPriority(int id, int priority)
+{
+    const int index = indexOf(id);
+    if (index < 0) {
+        return;
+    }
+
+    m_jobs[index].priority = priority;
+    save();
+}
+
+bool TranscodeQueue::job(int id, Job *job) const
+{
+    const int index = indexOf(id);
+    if (index < 0) {
+        return false;
+    }
+
+    *job = m_jobs[index];
+    return true;
+}
+
+void TranscodeQueue::setMaxRunning(int count)
+{
+    m_maxRunning = qMax(1, count);
+    schedule();
+}
+
+void TranscodeQueue::setPlaybackActive(bool active)
+{
+    if (m_playbackActive == active) {
+        return;
+    }
+    m_playbackActive = active;
+
+    for (TranscodeEngine *transcoder : m_running) {
+        transcoder->setLowPriority(active);
+    }
+}
+
+int TranscodeQueue::indexOf(int id) const
+{
+    for (int i = 0; i < m_jobs.size(); ++i) {
+        if (m_jobs[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TranscodeQueue::schedule()
+{
+    if (!m_started) {
+        return;
+    }
+
+    while (m_running.size() < m_maxRunning) {
+        // Highest priority first, oldest first among equals
+        Job *next = nullptr;
+        for (Job &job : m_jobs) {
+            if (job.state == Queued && (!next || job.priority > next->priority)) {
+                next = &job;
+            }
+        }
+        if (!next) {
+            return;
+        }
+        run(*next);
+    }
+}
+
+void TranscodeQueue::run(Job &job)
+{
+    const int id = job.id;
+
+    if (!QFileInfo::exists(job.inputPath)) {
+        job.state = Failed;
+        job.error = "Input file not found";
+        save();
+        emit jobFailed(id, job.error);
+        return;
+    }
+
+    job.state = Running;
+    ++job.attempts;
+    save();
+
+    // In-process unless ffmpeg is asked for, it can be reniced and keeps
+    // converting during playback while an in-process job pauses
+    TranscodeEngine *transcoder = m_useFfmpeg && Transcoder::isAvailable()
+        ? static_cast<TranscodeEngine *>(new Transcoder(this))
+        : TranscodeEngine::create(m_instance, this);
+    transcoder->setMode(job.mode);
+    m_running.insert(id, transcoder);
+
+    connect(transcoder, &TranscodeEngine::progressChanged, this, [this, id](int percent, const QString &timeStr) {
+        emit jobProgress(id, percent, timeStr);
+    });
+    connect(transcoder, &TranscodeEngine::finished, this, [this, id]() {
+        jobDone(id, TranscodeEngine::NoError, QString());
+    });
+    connect(transcoder, &TranscodeEngine::error, this,
+            [this, id](TranscodeEngine::Error error, const QString &message) {
+        jobDone(id, error, message);
+    });
+
+    logQueue("Starting job %d (attempt %d, %s): %s\n", id, job.attempts,
+             TranscodeEngine::modeString(job.mode).toStdString().c_str(), job.inputPath.toStdString().c_str());
+
+    const QString partial = partialPath(job.outputPath);
+    transcoder->start(job.inputPath, partial, job.durationMs);
+
+    // A missing input or encoder fails right away
+    if (!m_running.contains(id)) {
+        return;
+    }
+    if (m_playbackActive) {
+        transcoder->setLowPriority(true);
+    }
+
+    emit jobStarted(id);
+}
+
+void TranscodeQueue::jobDone(int id, TranscodeEngine::Error error, const QString &reason)
+{
+    // A crash reports both an error and the exit
+    TranscodeEngine *transcoder = m_running.take(id);
+    if (!transcoder) {
+        return;
+    }
+    transcoder->deleteLater();
+
+    const int index = indexOf(id);
+    if (index < 0) {
+        schedule();
+        return;
+    }
+
+    Job job = m_jobs[index];
+    QString message = reason;
+    if (error == TranscodeEngine::NoError) {
+        // Complete, move it in place of an older output
+        const QString partial = partialPath(job.outputPath);
+        QFile::remove(job.outputPath);
+        if (!QFile::rename(partial, job.outputPath)) {
+            error = TranscodeEngine::OutputFailed;
+            message = "Cannot move output into place";
+        }
+    }
+
+    // A stalled or crashed encoder may do better next time, a missing or
+    // unreadable input will not. Cancelled by someone else is no attempt.
+    const bool cancelled = error == TranscodeEngine::Cancelled;
+    const bool transient = error == TranscodeEngine::Stalled || error == TranscodeEngine::Failed;
+
+    if (error == TranscodeEngine::NoError) {
+        logQueue("Job %d finished: %s\n", id, job.outputPath.toStdString().c_str());
+        m_jobs.removeAt(index);
+        save();
+        emit jobFinished(id, job.outputPath);
+    } else if (cancelled || (transient && job.attempts < QUEUE_MAX_ATTEMPTS)) {
+        logQueue("Job %d stopped (%s), queued again: %s\n", id,
+                 TranscodeEngine::errorString(error).toStdString().c_str(), message.toStdString().c_str());
+        m_jobs[index].state = Queued;
+        if (cancelled) {
+            --m_jobs[index].attempts;
+        }
+        QFile::remove(partialPath(job.outputPath));
+        save();
+    } else {
+        logQueue("Job %d failed: %s\n", id, message.toStdString().c_str());
+        m_jobs[index].state = Failed;
+        m_jobs[index].error = message;
+        QFile::remove(partialPath(job.outputPath));
+        save();
+        emit jobFailed(id, message);
+    }
+
+    schedule();
+}
+
+QString TranscodeQueue::queuePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/transcode-queue.json";
+}
+
+void TranscodeQueue::load()
+{
+    QFile file(queuePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["version"].toInt() != QUEUE_FILE_VERSION) {
+        return;
+    }
+
+    m_nextId = qMax(m_nextId, root["nextId"].toInt(1));
+
+    const QJsonArray jobs = root["jobs"].toArray();
+    for (int i = 0; i < jobs.size(); ++i) {
+        const QJsonObject object = jobs[i].toObject();
+
+        Job job;
+        job.id = object["id"].toInt();
+        job.inputPath = object["input"].toString();
+        job.outputPath = object["output"].toString();
+        job.durationMs = object["durationMs"].toInt();
+        job.priority = object["priority"].toInt();
+        // Missing in older files, those jobs were all full re-encodes
+        job.mode = static_cast<TranscodeEngine::Mode>(object["mode"].toInt(TranscodeEngine::Reencode));
+        job.state = static_cast<State>(object["state"].toInt());
+        job.attempts = object["attempts"].toInt();
+        job.error = object["error"].toString();
+        if (indexOf(job.id) >= 0 || job.inputPath.isEmpty() || job.outputPath.isEmpty()) {
+            continue;
+        }
+
+        // Still running means the app went away without stopping it
+        if (job.state == Running) {
+            QFile::remove(partialPath(job.outputPath));
+            if (job.attempts >= QUEUE_MAX_ATTEMPTS) {
+                job.state = Failed;
+                job.error = "Interrupted too often";
+            } else {
+                job.state = Queued;
+                logQueue("Restarting interrupted job %d: %s\n", job.id, job.inputPath.toStdString().c_str());
+            }
+        }
+
+        m_nextId = qMax(m_nextId, job.id + 1);
+        m_jobs.append(job);
+    }
+
+    logQueue("Loaded %d jobs\n", m_jobs.size());
+}
+
+void TranscodeQueue::save() const
+{
+    QJsonArray jobs;
+    for (const Job &job : m_jobs) {
+        QJsonObject object;
+        object["id"] = job.id;
+        object["input"] = job.inputPath;
+        object["output"] = job.outputPath;
+        object["durationMs"] = job.durationMs;
+        object["priority"] = job.priority;
+        object["mode"] = static_cast<int>(job.mode);
+        object["state"] = static_cast<int>(job.state);
+        object["attempts"] = job.attempts;
+        object["error"] = job.error;
+        jobs.append(object);
+    }
+
+    QJsonObject root;
+    root["version"] = QUEUE_FILE_VERSION;
+    root["nextId"] = m_nextId;
+    root["jobs"] = jobs;
+
+    const QString path = queuePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Written aside and renamed, a crash never leaves a truncated queue
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logQueue("Cannot write queue: %s\n", path.toStdString().c_str());
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
@@ -0,0 +1,123 @@
+/**
+ * Transcode Queue - background transcode jobs that survive restarts
+ *
+ * Jobs are kept in a queue file and run highest priority first, a few at
+ * a time depending on the core count. Each job writes to a hidden partial
+ * file next to its output, renamed only once complete, so players and the
+ * library never see half written files. Jobs interrupted by a crash or
+ * by closing the app run again from the start on the next launch.
+ *
+ * Jobs run in-process on the shared libvlc instance, no extra process
+ * and no second codec stack. They pause while a video plays, since they
+ * share the decoder with it. With setUseFfmpeg() jobs run the bundled
+ * ffmpeg instead when it is installed, which drops to idle CPU and I/O
+ * priority during playback and keeps going. Failures that may pass, like a stalled or crashed encoder,
+ * run the job again a few times, others fail it right away.
+ */
+
+#ifndef TRANSCODEQUEUE_H
+#define TRANSCODEQUEUE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#include "TranscodeEngine.h"
+
+class VlcInstance;
+
+class TranscodeQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Queued,
+        Running,
+        Failed
+    };
+
+    struct Job {
+        int id;
+        QString inputPath;
+        QString outputPath;
+        int durationMs;
+        int priority;       // Higher runs first
+        TranscodeEngine::Mode mode;
+        State state;
+        int attempts;       // Starts, including interrupted ones
+        QString error;      // Last failure
+
+        Job() : id(0), durationMs(0), priority(0), mode(TranscodeEngine::Reencode),
+                state(Queued), attempts(0) {}
+    };
+
+    explicit TranscodeQueue(QObject *parent = nullptr);
+    ~TranscodeQueue();
+
+    // Jobs transcode in-process on this instance, with ffmpeg without one.
+    // Set before start().
+    void setInstance(VlcInstance *instance) { m_instance = instance; }
+
+    // Run new jobs with ffmpeg when it is installed, even with an
+    // instance. Off by default.
+    bool useFfmpeg() const { return m_useFfmpeg; }
+    void setUseFfmpeg(bool use) { m_useFfmpeg = use; }
+
+    // Load the saved queue and start jobs
+    void start();
+
+    // Queue a job, or return the job converting the same files
+    int enqueue(const QString &inputPath, const QString &outputPath, int durationMs, int priority = 0,
+                TranscodeEngine::Mode mode = TranscodeEngine::Reencode);
+
+    // Stop and drop a job, its partial output is removed
+    void remove(int id);
+
+    // Put a failed job back into the queue
+    void retry(int id);
+
+    void setPriority(int id, int priority);
+
+    QList<Job> jobs() const { return m_jobs; }
+    bool job(int id, Job *job) const;
+
+    // Jobs running at the same time, half the cores by default
+    int maxRunning() const { return m_maxRunning; }
+    void setMaxRunning(int count);
+
+    // Playback lowers the priority of running jobs, in-process jobs pause
+    void setPlaybackActive(bool active);
+
+    // Hidden file a job writes before it is complete
+    static QString partialPath(const QString &outputPath);
+
+signals:
+    void jobAdded(int id);
+    void jobStarted(int id);
+    void jobProgress(int id, int percent, const QString &timeStr);
+    void jobFinished(int id, const QString &outputPath);
+    void jobFailed(int id, const QString &error);
+    void jobRemoved(int id);
+
+private:
+    int indexOf(int id) const;
+    void schedule();
+    void run(Job &job);
+    void jobDone(int id, TranscodeEngine::Error error, const QString &reason);
+    void load();
+    void save() const;
+    static QString queuePath();
+
+    QList<Job> m_jobs;
+    VlcInstance *m_instance;
+    QHash<int, TranscodeEngine *> m_running;    // By job id
+    int m_nextId;
+    int m_maxRunning;
+    bool m_playbackActive;
+    bool m_useFfmpeg;
+    bool m_started;
+};
+
+#endif // TRANSCODEQUEUE_H
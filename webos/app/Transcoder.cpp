@@ -5,12 +5,16 @@
 #include "Transcoder.h"
 
 #include <QCoreApplication>
+#include <QDir>
 #include <QFileInfo>
 #include <QFile>
 #include <QRegularExpression>
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 // Debug logging to file
 static FILE *s_transcoderLogFile = nullptr;
@@ -28,11 +32,18 @@ static void logTranscoder(const char *fmt, ...) {
     }
 }
 
+// ioprio_set() has no glibc wrapper
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_WHO_PROCESS 1
+
 Transcoder::Transcoder(QObject *parent)
-    : QObject(parent),
+    : TranscodeEngine(parent),
       m_process(nullptr),
       m_durationMs(0),
-      m_cancelled(false)
+      m_cancelled(false),
+      m_lowPriority(-1)
 {
 }
 
@@ -47,6 +58,12 @@ QString Transcoder::ffmpegPath()
     return appDir + "/ffmpeg";
 }
 
+bool Transcoder::isAvailable()
+{
+    QFileInfo ffmpegFile(ffmpegPath());
+    return ffmpegFile.exists() && ffmpegFile.isExecutable();
+}
+
 QString Transcoder::glibcLdPath()
 {
     // Path to glibc's dynamic linker from com.nizovn.glibc package
@@ -78,7 +95,7 @@ void Transcoder::start(const QString &inputPath, const QString &outputPath, int
     QFileInfo ffmpegFile(ffmpeg);
     if (!ffmpegFile.exists() || !ffmpegFile.isExecutable()) {
         logTranscoder("ffmpeg not found at: %s\n", ffmpeg.toStdString().c_str());
-        emit error("ffmpeg not found");
+        emit error(EncoderMissing, "ffmpeg not found");
         return;
     }
 
@@ -86,6 +103,7 @@ void Transcoder::start(const QString &inputPath, const QString &outputPath, int
     logTranscoder("  Input: %s\n", inputPath.toStdString().c_str());
     logTranscoder("  Output: %s\n", outputPath.toStdString().c_str());
     logTranscoder("  Duration: %d ms\n", durationMs);
+    logTranscoder("  Mode: %s\n", modeString(m_mode).toStdString().c_str());
 
     // Run ffmpeg via glibc's ld.so to use the newer glibc
     QString ldPath = glibcLdPath();
@@ -95,21 +113,42 @@ void Transcoder::start(const QString &inputPath, const QString &outputPath, int
     QStringList args;
     args << "--library-path" << libPath;
     args << ffmpeg;
+
+    // Seeking before -i is fast, output times then start at 0
+    if (m_rangeStartMs > 0) {
+        args << "-ss" << QString::number(m_rangeStartMs / 1000.0, 'f', 3);
+    }
     args << "-i" << inputPath;
+    if (m_rangeLengthMs > 0) {
+        args << "-t" << QString::number(m_rangeLengthMs / 1000.0, 'f', 3);
+    }
+
+    if (m_mode == Reencode) {
+        // Video: scale down to 480p height, smaller sources keep theirs,
+        // auto-calculate width (keep aspect ratio, ensure even)
+        args << "-vf" << "scale=-2:'min(480,ih)'";
 
-    // Video: scale to 480p height, auto-calculate width (keep aspect ratio, ensure even)
-    args << "-vf" << "scale=-2:480";
+        // Video codec: mpeg4 (libx264 not available in this ffmpeg build)
+        // Use moderate bitrate for reasonable quality at 480p
+        args << "-c:v" << "mpeg4";
+        args << "-b:v" << "1500k";    // 1.5 Mbps video bitrate
+        args << "-q:v" << "5";        // Quality scale (2-31, lower is better)
+    } else {
+        // Video already plays well, only the container or audio changes
+        args << "-c:v" << "copy";
+    }
 
-    // Video codec: mpeg4 (libx264 not available in this ffmpeg build)
-    // Use moderate bitrate for reasonable quality at 480p
-    args << "-c:v" << "mpeg4";
-    args << "-b:v" << "1500k";    // 1.5 Mbps video bitrate
-    args << "-q:v" << "5";        // Quality scale (2-31, lower is better)
+    if (m_mode == Remux) {
+        args << "-c:a" << "copy";
+    } else {
+        // Audio: AAC at 128kbps (need -strict -2 for experimental encoder)
+        args << "-c:a" << "aac";
+        args << "-strict" << "-2";
+        args << "-b:a" << "128k";
+    }
 
-    // Audio: AAC at 128kbps (need -strict -2 for experimental encoder)
-    args << "-c:a" << "aac";
-    args << "-strict" << "-2";
-    args << "-b:a" << "128k";
+    // Subtitle codecs mostly do not fit in MP4
+    args << "-sn";
 
     // Output format hints
     args << "-movflags" << "+faststart";  // Enable streaming
@@ -132,6 +171,7 @@ void Transcoder::start(const QString &inputPath, const QString &outputPath, int
             this, &Transcoder::onProcessFinished);
     connect(m_process, &QProcess::errorOccurred,
             this, &Transcoder::onProcessError);
+    connect(m_process, &QProcess::started, this, &Transcoder::applyPriority);
 
     logTranscoder("Running: %s %s\n", ldPath.toStdString().c_str(),
                   args.join(" ").toStdString().c_str());
@@ -164,6 +204,42 @@ bool Transcoder::isRunning() const
     return m_process != nullptr && m_process->state() != QProcess::NotRunning;
 }
 
+void Transcoder::setLowPriority(bool low)
+{
+    m_lowPriority = low ? 1 : 0;
+    applyPriority();
+}
+
+void Transcoder::applyPriority()
+{
+    if (m_lowPriority < 0 || !isRunning()) {
+        return;
+    }
+
+    const int nice = m_lowPriority ? 19 : 0;
+    const int ioprio = m_lowPriority ? (IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT)
+                                     : (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 4;
+
+    // Both priorities are per thread, ffmpeg's encoder threads need their own
+    const qint64 pid = m_process->processId();
+    QStringList tasks = QDir(QString("/proc/%1/task").arg(pid)).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    if (tasks.isEmpty()) {
+        tasks << QString::number(pid);
+    }
+
+    for (const QString &task : tasks) {
+        const int tid = task.toInt();
+        if (setpriority(PRIO_PROCESS, tid, nice) != 0) {
+            logTranscoder("Cannot set nice %d on thread %d\n", nice, tid);
+        }
+#ifdef SYS_ioprio_set
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, ioprio);
+#endif
+    }
+
+    logTranscoder("%s priority for %d threads\n", m_lowPriority ? "Low" : "Normal", tasks.size());
+}
+
 void Transcoder::onReadyReadStandardOutput()
 {
     while (m_process->canReadLine()) {
@@ -187,7 +263,7 @@ void Transcoder::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus
 
     if (m_cancelled) {
         cleanup();
-        emit error("Transcoding cancelled");
+        emit error(Cancelled, "Transcoding cancelled");
         return;
     }
 
@@ -200,11 +276,11 @@ void Transcoder::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus
         } else {
             logTranscoder("Output file not found after transcode\n");
             cleanup();
-            emit error("Output file not created");
+            emit error(OutputFailed, "Output file not created");
         }
     } else {
         cleanup();
-        emit error(QString("ffmpeg failed with exit code %1").arg(exitCode));
+        emit error(Failed, QString("ffmpeg failed with exit code %1").arg(exitCode));
     }
 }
 
@@ -212,22 +288,25 @@ void Transcoder::onProcessError(QProcess::ProcessError processError)
 {
     logTranscoder("ffmpeg process error: %d\n", (int)processError);
     QString errorMsg;
+    Error code = Failed;
     switch (processError) {
     case QProcess::FailedToStart:
         errorMsg = "Failed to start ffmpeg";
+        code = EncoderMissing;
         break;
     case QProcess::Crashed:
         errorMsg = "ffmpeg crashed";
         break;
     case QProcess::Timedout:
         errorMsg = "ffmpeg timed out";
+        code = Stalled;
         break;
     default:
         errorMsg = "ffmpeg error";
         break;
     }
     cleanup();
-    emit error(errorMsg);
+    emit error(code, errorMsg);
 }
 
 void Transcoder::parseProgressLine(const QString &line)
@@ -274,26 +353,6 @@ int Transcoder::parseTimeToMs(const QString &timeStr)
     return -1;
 }
 
-QString Transcoder::formatTime(int ms)
-{
-    int seconds = ms / 1000;
-    int minutes = seconds / 60;
-    int hours = minutes / 60;
-    seconds = seconds % 60;
-    minutes = minutes % 60;
-
-    if (hours > 0) {
-        return QString("%1:%2:%3")
-            .arg(hours)
-            .arg(minutes, 2, 10, QChar('0'))
-            .arg(seconds, 2, 10, QChar('0'));
-    } else {
-        return QString("%1:%2")
-            .arg(minutes, 2, 10, QChar('0'))
-            .arg(seconds, 2, 10, QChar('0'));
-    }
-}
-
 void Transcoder::cleanup()
 {
     if (m_process) {
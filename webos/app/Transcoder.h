@@ -5,11 +5,12 @@
 #ifndef TRANSCODER_H
 #define TRANSCODER_H
 
-#include <QObject>
 #include <QProcess>
 #include <QString>
 
-class Transcoder : public QObject
+#include "TranscodeEngine.h"
+
+class Transcoder : public TranscodeEngine
 {
     Q_OBJECT
 
@@ -17,24 +18,16 @@ public:
     explicit Transcoder(QObject *parent = nullptr);
     ~Transcoder();
 
-    // Start transcoding from input to output (480p)
-    void start(const QString &inputPath, const QString &outputPath, int durationMs);
-
-    // Cancel ongoing transcode
-    void cancel();
-
-    // Check if transcoding is in progress
-    bool isRunning() const;
-
-signals:
-    // Progress update (0-100), with current time string
-    void progressChanged(int percent, const QString &timeStr);
+    void start(const QString &inputPath, const QString &outputPath, int durationMs) override;
+    void cancel() override;
+    bool isRunning() const override;
 
-    // Transcoding completed successfully
-    void finished(const QString &outputPath);
+    // Idle CPU and I/O priority for the ffmpeg process. Normal priority
+    // may not be restored without privileges. Applies to a running job.
+    void setLowPriority(bool low) override;
 
-    // Transcoding failed or was cancelled
-    void error(const QString &message);
+    // Bundled ffmpeg is installed
+    static bool isAvailable();
 
 private slots:
     void onReadyReadStandardOutput();
@@ -43,19 +36,20 @@ private slots:
     void onProcessError(QProcess::ProcessError error);
 
 private:
-    QString ffmpegPath();
+    static QString ffmpegPath();
     QString glibcLdPath();
     QString libraryPath();
     void parseProgressLine(const QString &line);
     int parseTimeToMs(const QString &timeStr);
-    QString formatTime(int ms);
     void cleanup();
+    void applyPriority();
 
     QProcess *m_process;
     QString m_inputPath;
     QString m_outputPath;
     int m_durationMs;
     bool m_cancelled;
+    int m_lowPriority;  // -1 leaves the priority alone
 };
 
 #endif // TRANSCODER_H
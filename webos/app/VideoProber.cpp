@@ -1,5 +1,5 @@
 /**
- * Video Prober - Uses ffprobe to get video metadata
+ * Video Prober - gets video metadata with libvlc, ffprobe as fallback
  */
 
 #include "VideoProber.h"
@@ -8,12 +8,29 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QCoreApplication>
+#include <QFile>
+#include <QFutureInterface>
+#include <QFutureWatcher>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <vlc/vlc.h>
+
+#include "Instance.h"
+#include "Media.h"
+#include "MetaSnapshot.h"
+
+#include <memory>
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 // Debug logging to file
 static FILE *s_proberLogFile = nullptr;
@@ -31,6 +48,366 @@ static void logProber(const char *fmt, ...) {
     }
 }
 
+// Bump when VideoInfo changes so stale caches are dropped
+#define PROBE_CACHE_VERSION 2
+
+// libvlc parsing normally takes a few ms, slower files fall back to ffprobe
+#define PROBE_LIBVLC_TIMEOUT_MS 3000
+
+// The whole cache is rewritten, once probing has been quiet for this long
+#define PROBE_SAVE_DELAY_MS 2000
+
+namespace {
+
+// Runs the blocking probe on a pool thread and completes the future
+class ProbeTask : public QRunnable
+{
+public:
+    ProbeTask(const QString &filePath, const QFutureInterface<VideoProber::VideoInfo> &result)
+        : m_filePath(filePath),
+          m_result(result)
+    {
+    }
+
+    void run() override
+    {
+        const VideoProber::VideoInfo info = VideoProber::probe(m_filePath);
+        m_result.reportResult(info);
+        m_result.reportFinished();
+    }
+
+private:
+    QString m_filePath;
+    QFutureInterface<VideoProber::VideoInfo> m_result;
+};
+
+// ffprobe style name of a libvlc codec fourcc
+QString codecName(quint32 fourcc)
+{
+    static const struct {
+        const char *fourcc;
+        const char *name;
+    } names[] = {
+        { "h264", "h264" }, { "hevc", "hevc" }, { "mp4v", "mpeg4" }, { "mpgv", "mpeg2video" },
+        { "VP80", "vp8" }, { "VP90", "vp9" }, { "WMV3", "wmv3" }, { "WVC1", "vc1" },
+        { "theo", "theora" }, { "MJPG", "mjpeg" }, { "mp4a", "aac" }, { "mpga", "mp3" },
+        { "a52 ", "ac3" }, { "eac3", "eac3" }, { "vorb", "vorbis" }, { "opus", "opus" },
+        { "flac", "flac" }, { "wma2", "wmav2" }
+    };
+
+    const char chars[5] = { char(fourcc & 0xff), char((fourcc >> 8) & 0xff),
+                            char((fourcc >> 16) & 0xff), char((fourcc >> 24) & 0xff), 0 };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (!memcmp(chars, names[i].fourcc, 4)) {
+            return names[i].name;
+        }
+    }
+    return QString::fromLatin1(chars).trimmed().toLower();
+}
+
+// "30000/1001" or "16:9" style ratios from ffprobe
+bool parseRatio(const QString &text, QChar separator, int *num, int *den)
+{
+    const int index = text.indexOf(separator);
+    if (index < 0) {
+        return false;
+    }
+    *num = text.left(index).toInt();
+    *den = text.mid(index + 1).toInt();
+    return *num > 0 && *den > 0;
+}
+
+} // namespace
+
+VideoProber::VideoProber(QObject *parent)
+    : QObject(parent),
+      m_instance(nullptr),
+      m_saveTimer(new QTimer(this))
+{
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(PROBE_SAVE_DELAY_MS);
+    connect(m_saveTimer, &QTimer::timeout, this, &VideoProber::saveCache);
+
+    loadCache();
+}
+
+VideoProber::~VideoProber()
+{
+    // Probes finished since the last write
+    if (m_saveTimer->isActive()) {
+        saveCache();
+    }
+}
+
+void VideoProber::setInstance(VlcInstance *instance)
+{
+    m_instance = instance;
+}
+
+QFuture<VideoProber::VideoInfo> VideoProber::probeAsync(const QString &filePath)
+{
+    const QFileInfo file(filePath);
+    const QString key = file.absoluteFilePath();
+
+    VideoInfo info;
+    if (lookup(file, &info)) {
+        logProber("Cache hit: %s\n", key.toStdString().c_str());
+
+        QFutureInterface<VideoInfo> result;
+        result.reportStarted();
+        result.reportResult(info);
+        result.reportFinished();
+
+        emit probed(filePath, info);
+        return result.future();
+    }
+
+    if (m_pending.contains(key)) {
+        return m_pending.value(key);
+    }
+
+    QFutureInterface<VideoInfo> result;
+    result.reportStarted();
+    const QFuture<VideoInfo> future = result.future();
+    m_pending.insert(key, future);
+
+    // The watcher delivers completion on this thread
+    QFutureWatcher<VideoInfo> *watcher = new QFutureWatcher<VideoInfo>(this);
+    connect(watcher, &QFutureWatcher<VideoInfo>::finished, this, [this, watcher, filePath]() {
+        probeFinished(filePath, watcher->future());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+
+    if (m_instance) {
+        probeWithLibvlc(filePath, result);
+    } else {
+        probeWithFfprobe(filePath, result);
+    }
+    return future;
+}
+
+void VideoProber::probeWithLibvlc(const QString &filePath, const QFutureInterface<VideoInfo> &result)
+{
+    logProber("Parsing with libvlc: %s\n", filePath.toStdString().c_str());
+
+    VlcMedia *media = new VlcMedia(filePath, true, m_instance);
+    QTimer *timeout = new QTimer(media);
+    timeout->setSingleShot(true);
+
+    // Parsed or timed out, whichever comes first
+    std::shared_ptr<bool> done = std::make_shared<bool>(false);
+    auto finish = [this, media, timeout, filePath, result, done](bool parsed) {
+        if (*done) {
+            return;
+        }
+        *done = true;
+
+        QFutureInterface<VideoInfo> future(result);
+        timeout->stop();
+        QObject::disconnect(media, nullptr, nullptr, nullptr);
+        media->deleteLater();
+
+        // Audio files have tags but no video, so this comes first
+        if (parsed) {
+            emit metaRead(filePath, VlcMetaSnapshot(media));
+        }
+
+        const VideoInfo info = parsed ? libvlcInfo(media, filePath) : VideoInfo();
+        if (!info.valid) {
+            logProber("libvlc could not probe %s, trying ffprobe\n", filePath.toStdString().c_str());
+            probeWithFfprobe(filePath, future);
+            return;
+        }
+
+        future.reportResult(info);
+        future.reportFinished();
+    };
+
+    // parsedChanged comes from the libvlc event thread and is queued here.
+    // The lambda uses the prober, so the prober is the context, the media
+    // belongs to the instance and may outlive it.
+    connect(media, static_cast<void (VlcMedia::*)(bool)>(&VlcMedia::parsedChanged), this, [finish](bool parsed) {
+        finish(parsed);
+    });
+    connect(timeout, &QTimer::timeout, this, [finish]() {
+        finish(false);
+    });
+
+    timeout->start(PROBE_LIBVLC_TIMEOUT_MS);
+    media->parse();
+}
+
+void VideoProber::probeWithFfprobe(const QString &filePath, const QFutureInterface<VideoInfo> &result)
+{
+    QThreadPool::globalInstance()->start(new ProbeTask(filePath, result));
+}
+
+VideoProber::VideoInfo VideoProber::libvlcInfo(VlcMedia *media, const QString &filePath)
+{
+    VideoInfo info;
+    int trackBitrate = 0;
+
+    libvlc_media_track_t **tracks;
+    const unsigned count = libvlc_media_tracks_get(media->core(), &tracks);
+    for (unsigned i = 0; i < count; ++i) {
+        const libvlc_media_track_t *track = tracks[i];
+        trackBitrate += track->i_bitrate / 1000;
+
+        if (track->i_type == libvlc_track_video && !info.width) {
+            const libvlc_video_track_t *video = track->video;
+            info.width = video->i_width;
+            info.height = video->i_height;
+            info.codec = codecName(track->i_codec);
+            if (video->i_frame_rate_den) {
+                info.frameRate = float(video->i_frame_rate_num) / video->i_frame_rate_den;
+            }
+            if (video->i_sar_num && video->i_sar_den) {
+                info.sarNum = video->i_sar_num;
+                info.sarDen = video->i_sar_den;
+            }
+        } else if (track->i_type == libvlc_track_audio && info.audioCodec.isEmpty()) {
+            info.audioCodec = codecName(track->i_codec);
+        }
+    }
+    if (count) {
+        libvlc_media_tracks_release(tracks, count);
+    }
+
+    info.durationMs = static_cast<int>(media->duration());
+
+    // Containers rarely store track bitrates, the average is good enough
+    info.bitrate = trackBitrate;
+    if (!info.bitrate && info.durationMs > 0) {
+        info.bitrate = static_cast<int>(QFileInfo(filePath).size() * 8 / info.durationMs);
+    }
+
+    logProber("libvlc: %dx%d %s %.2f fps, %d kbit/s, audio=%s, %d ms\n",
+              info.width, info.height, info.codec.toStdString().c_str(), info.frameRate,
+              info.bitrate, info.audioCodec.toStdString().c_str(), info.durationMs);
+
+    info.valid = (info.width > 0 && info.height > 0);
+    return info;
+}
+
+bool VideoProber::cachedInfo(const QString &filePath, VideoInfo *info) const
+{
+    return lookup(QFileInfo(filePath), info);
+}
+
+void VideoProber::probeFinished(const QString &filePath, const QFuture<VideoInfo> &future)
+{
+    const QFileInfo file(filePath);
+    const QString key = file.absoluteFilePath();
+    m_pending.remove(key);
+
+    const VideoInfo info = future.resultCount() ? future.result() : VideoInfo();
+
+    // Failures are not cached, ffprobe may be missing or the file incomplete
+    if (info.valid) {
+        CacheEntry entry;
+        entry.size = file.size();
+        entry.modified = file.lastModified();
+        entry.info = info;
+        m_cache.insert(key, entry);
+        m_saveTimer->start();
+    }
+
+    emit probed(filePath, info);
+}
+
+bool VideoProber::lookup(const QFileInfo &file, VideoInfo *info) const
+{
+    const auto it = m_cache.constFind(file.absoluteFilePath());
+    if (it == m_cache.constEnd() || !file.exists()) {
+        return false;
+    }
+
+    // Replaced or rewritten files are probed again
+    if (it->size != file.size() || it->modified != file.lastModified()) {
+        return false;
+    }
+
+    *info = it->info;
+    return true;
+}
+
+QString VideoProber::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/probe-cache.json";
+}
+
+void VideoProber::loadCache()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["version"].toInt() != PROBE_CACHE_VERSION) {
+        return;
+    }
+
+    const QJsonObject entries = root["entries"].toObject();
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const QJsonObject object = it.value().toObject();
+
+        CacheEntry entry;
+        entry.size = static_cast<qint64>(object["size"].toDouble());
+        entry.modified = QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(object["modified"].toDouble()));
+        entry.info.width = object["width"].toInt();
+        entry.info.height = object["height"].toInt();
+        entry.info.durationMs = object["durationMs"].toInt();
+        entry.info.codec = object["codec"].toString();
+        entry.info.frameRate = static_cast<float>(object["frameRate"].toDouble());
+        entry.info.bitrate = object["bitrate"].toInt();
+        entry.info.audioCodec = object["audioCodec"].toString();
+        entry.info.sarNum = object["sarNum"].toInt(1);
+        entry.info.sarDen = object["sarDen"].toInt(1);
+        entry.info.valid = true;
+        m_cache.insert(it.key(), entry);
+    }
+
+    logProber("Loaded %d cached probes\n", m_cache.size());
+}
+
+void VideoProber::saveCache() const
+{
+    QJsonObject entries;
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        QJsonObject object;
+        object["size"] = static_cast<double>(it->size);
+        object["modified"] = static_cast<double>(it->modified.toMSecsSinceEpoch());
+        object["width"] = it->info.width;
+        object["height"] = it->info.height;
+        object["durationMs"] = it->info.durationMs;
+        object["codec"] = it->info.codec;
+        object["frameRate"] = it->info.frameRate;
+        object["bitrate"] = it->info.bitrate;
+        object["audioCodec"] = it->info.audioCodec;
+        object["sarNum"] = it->info.sarNum;
+        object["sarDen"] = it->info.sarDen;
+        entries[it.key()] = object;
+    }
+
+    QJsonObject root;
+    root["version"] = PROBE_CACHE_VERSION;
+    root["entries"] = entries;
+
+    const QString path = cachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Written aside and renamed, a crash never leaves a truncated cache
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logProber("Cannot write probe cache: %s\n", path.toStdString().c_str());
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
 QString VideoProber::ffprobePath()
 {
     // ffprobe is bundled in the app's bin directory
@@ -79,7 +456,6 @@ VideoProber::VideoInfo VideoProber::probe(const QString &filePath)
     args << "-print_format" << "json";
     args << "-show_format";
     args << "-show_streams";
-    args << "-select_streams" << "v:0";  // First video stream only
     args << filePath;
 
     logProber("Running: %s %s\n", ldPath.toStdString().c_str(),
@@ -109,24 +485,40 @@ VideoProber::VideoInfo VideoProber::probe(const QString &filePath)
 
     QJsonObject root = doc.object();
 
-    // Get video stream info
+    // First video and audio streams
     QJsonArray streams = root["streams"].toArray();
-    if (!streams.isEmpty()) {
-        QJsonObject videoStream = streams[0].toObject();
-        info.width = videoStream["width"].toInt();
-        info.height = videoStream["height"].toInt();
-        info.codec = videoStream["codec_name"].toString();
-        logProber("Video stream: %dx%d, codec=%s\n",
-                  info.width, info.height, info.codec.toStdString().c_str());
+    for (int i = 0; i < streams.size(); ++i) {
+        QJsonObject stream = streams[i].toObject();
+        const QString type = stream["codec_type"].toString();
+
+        if (type == "video" && !info.width) {
+            info.width = stream["width"].toInt();
+            info.height = stream["height"].toInt();
+            info.codec = stream["codec_name"].toString();
+
+            int num, den;
+            if (parseRatio(stream["r_frame_rate"].toString(), '/', &num, &den)) {
+                info.frameRate = float(num) / den;
+            }
+            if (parseRatio(stream["sample_aspect_ratio"].toString(), ':', &num, &den)) {
+                info.sarNum = num;
+                info.sarDen = den;
+            }
+            logProber("Video stream: %dx%d, codec=%s, %.2f fps\n",
+                      info.width, info.height, info.codec.toStdString().c_str(), info.frameRate);
+        } else if (type == "audio" && info.audioCodec.isEmpty()) {
+            info.audioCodec = stream["codec_name"].toString();
+        }
     }
 
-    // Get duration from format
+    // Get duration and bitrate from format
     QJsonObject format = root["format"].toObject();
     if (format.contains("duration")) {
         double durationSec = format["duration"].toString().toDouble();
         info.durationMs = static_cast<int>(durationSec * 1000.0);
         logProber("Duration: %.2f seconds\n", durationSec);
     }
+    info.bitrate = format["bit_rate"].toString().toInt() / 1000;
 
     info.valid = (info.width > 0 && info.height > 0);
     return info;
@@ -143,10 +535,10 @@ QString VideoProber::get480pPath(const QString &originalPath)
     QFileInfo fileInfo(originalPath);
     QString dir = fileInfo.absolutePath();
     QString baseName = fileInfo.completeBaseName();
-    QString extension = fileInfo.suffix();
 
     // Create path like: /media/internal/movies/Firefly_480p.mp4
-    return dir + "/" + baseName + "_480p." + extension;
+    // The transcoders always write MP4, also for an MKV or AVI input
+    return dir + "/" + baseName + "_480p.mp4";
 }
 
 bool VideoProber::has480pVersion(const QString &originalPath)
@@ -1,34 +1,75 @@
 /**
- * Video Prober - Uses ffprobe to get video metadata
+ * Video Prober - gets video metadata with libvlc, ffprobe as fallback
+ *
+ * probeAsync() parses the file with the shared libvlc instance and reads
+ * its tracks, without spawning a process. When libvlc is not set, times
+ * out or finds no video, ffprobe runs on a worker thread instead. Both
+ * report through the returned future and the probed() signal. Results
+ * are kept in a persistent cache keyed by path, size and modification
+ * time, so an unchanged file is answered without probing again. The cache
+ * file is written once a burst of probes, e.g. a library scan, settles.
  */
 
 #ifndef VIDEOPROBER_H
 #define VIDEOPROBER_H
 
-#include <QString>
+#include <QDateTime>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QHash>
 #include <QObject>
+#include <QString>
+
+class QFileInfo;
+class QTimer;
 
-class VideoProber
+class VlcInstance;
+class VlcMedia;
+class VlcMetaSnapshot;
+
+class VideoProber : public QObject
 {
+    Q_OBJECT
+
 public:
     struct VideoInfo {
         int width;
         int height;
         int durationMs;
         QString codec;
+        float frameRate;     // Frames per second, 0 if unknown
+        int bitrate;         // Overall kbit/s, 0 if unknown
+        QString audioCodec;  // Empty without audio
+        int sarNum;          // Sample aspect ratio
+        int sarDen;
         bool valid;
 
-        VideoInfo() : width(0), height(0), durationMs(0), valid(false) {}
+        VideoInfo() : width(0), height(0), durationMs(0), frameRate(0), bitrate(0),
+                      sarNum(1), sarDen(1), valid(false) {}
     };
 
-    // Probe video file and return metadata
+    explicit VideoProber(QObject *parent = nullptr);
+    ~VideoProber();
+
+    // Shared instance for in-process probing, ffprobe only without one
+    void setInstance(VlcInstance *instance);
+
+    // Probe without blocking. Cached files complete right away and emit
+    // probed() before returning, others emit it on the GUI thread later.
+    // Probing a file that is already in flight shares the same future.
+    QFuture<VideoInfo> probeAsync(const QString &filePath);
+
+    // Cached result of an unchanged file, false if it needs probing
+    bool cachedInfo(const QString &filePath, VideoInfo *info) const;
+
+    // Probe video file with ffprobe and return metadata, blocks while it runs
     static VideoInfo probe(const QString &filePath);
 
     // Check if video is HD (720p or higher)
     static bool isHD(const VideoInfo &info);
 
-    // Get the 480p version path for a video file
-    // e.g., /media/internal/movies/Firefly.mp4 -> /media/internal/movies/Firefly_480p.mp4
+    // Get the 480p version path for a video file, always an MP4 file
+    // e.g., /media/internal/movies/Firefly.mkv -> /media/internal/movies/Firefly_480p.mp4
     static QString get480pPath(const QString &originalPath);
 
     // Check if 480p version already exists
@@ -37,13 +78,41 @@ public:
     // Get human-readable resolution string (e.g., "1080p", "720p", "480p")
     static QString resolutionString(const VideoInfo &info);
 
+signals:
+    void probed(const QString &filePath, const VideoProber::VideoInfo &info);
+
+    // Tags of a file libvlc parsed for the probe, comes before its probed()
+    void metaRead(const QString &filePath, const VlcMetaSnapshot &meta);
+
 private:
+    struct CacheEntry {
+        qint64 size;
+        QDateTime modified;
+        VideoInfo info;
+    };
+
+    void probeFinished(const QString &filePath, const QFuture<VideoInfo> &future);
+
+    void probeWithLibvlc(const QString &filePath, const QFutureInterface<VideoInfo> &result);
+    static void probeWithFfprobe(const QString &filePath, const QFutureInterface<VideoInfo> &result);
+    static VideoInfo libvlcInfo(VlcMedia *media, const QString &filePath);
+
+    bool lookup(const QFileInfo &file, VideoInfo *info) const;
+    void loadCache();
+    void saveCache() const;
+    static QString cachePath();
+
     // Path to ffprobe binary (within app bundle)
     static QString ffprobePath();
     // Path to glibc's ld.so from com.nizovn.glibc
     static QString glibcLdPath();
     // Library path for ld.so --library-path
     static QString libraryPath();
+
+    VlcInstance *m_instance;
+    QTimer *m_saveTimer;                          // Debounces saveCache()
+    QHash<QString, CacheEntry> m_cache;          // By absolute path, GUI thread only
+    QHash<QString, QFuture<VideoInfo>> m_pending; // Probes in flight
 };
 
 #endif // VIDEOPROBER_H
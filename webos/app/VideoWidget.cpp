@@ -1,6 +1,9 @@
 /**
  * Video Widget for webOS - Software Rendering
  * Uses libvlc vmem callbacks directly
+ *
+ * Frames are scaled on the render thread, paintEvent only blits the
+ * finished image.
  */
 
 #include "VideoWidget.h"
@@ -13,12 +16,11 @@
 VideoWidget::VideoWidget(QWidget *parent)
     : QWidget(parent),
       m_player(nullptr),
-      m_writeBuffer(0),
-      m_readBuffer(1),
       m_width(0),
       m_height(0),
-      m_hasFrame(false),
-      m_frameReady(false)
+      m_hasFrame(0),
+      m_frameReady(0),
+      m_renderThread(new RenderThread(this, this))
 {
     setAttribute(Qt::WA_OpaquePaintEvent);
 
@@ -26,6 +28,10 @@ VideoWidget::VideoWidget(QWidget *parent)
     pal.setColor(QPalette::Window, Qt::black);
     setPalette(pal);
     setAutoFillBackground(true);
+
+    // Only the newest frame is scaled, one queued frame is enough
+    m_renderThread->setQueueLimit(1);
+    m_renderThread->start();
 }
 
 VideoWidget::~VideoWidget()
@@ -34,6 +40,7 @@ VideoWidget::~VideoWidget()
         libvlc_video_set_callbacks(m_player->core(), nullptr, nullptr, nullptr, nullptr);
         libvlc_video_set_format_callbacks(m_player->core(), nullptr, nullptr);
     }
+    m_renderThread->stop();
 }
 
 void VideoWidget::setMediaPlayer(VlcMediaPlayer *player)
@@ -69,71 +76,103 @@ void VideoWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
     paintCount++;
+    m_updatePending.store(0);
 
     QPainter painter(this);
 
     // Use fast rendering - no antialiasing or smoothing
     painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
 
-    m_mutex.lock();
-
     if (paintCount <= 5 || paintCount % 100 == 0) {
-        fprintf(stderr, "paintEvent %d: hasFrame=%d widgetSize=%dx%d videoSize=%dx%d readBuf=%d\n",
-                paintCount, m_hasFrame, width(), height(),
-                m_width, m_height, m_readBuffer);
+        fprintf(stderr, "paintEvent %d: hasFrame=%d widgetSize=%dx%d videoSize=%dx%d\n",
+                paintCount, m_hasFrame.loadAcquire(), width(), height(),
+                m_width, m_height);
         fflush(stderr);
     }
 
     // Fill black background
     painter.fillRect(rect(), Qt::black);
 
-    // Draw the frame if available
-    if (m_hasFrame && m_width > 0 && m_height > 0) {
-        // Create QImage directly from the read buffer (no copy needed)
-        QImage frame(
-            reinterpret_cast<const uchar*>(m_buffer[m_readBuffer].constData()),
-            m_width,
-            m_height,
-            m_width * 4,
-            QImage::Format_ARGB32
-        );
-
-        // Calculate target rectangle for aspect-correct display
-        float videoAspect = (float)m_width / (float)m_height;
-        float widgetAspect = (float)width() / (float)height();
-
-        int targetW, targetH, targetX, targetY;
-        if (videoAspect > widgetAspect) {
-            targetW = width();
-            targetH = (int)(width() / videoAspect);
-            targetX = 0;
-            targetY = (height() - targetH) / 2;
-        } else {
-            targetH = height();
-            targetW = (int)(height() * videoAspect);
-            targetX = (width() - targetW) / 2;
-            targetY = 0;
-        }
-
-        // Draw scaled video frame (fast transformation mode)
-        painter.drawImage(QRect(targetX, targetY, targetW, targetH), frame);
+    // Draw the frame scaled by the render thread, an unscaled blit
+    m_imageMutex.lock();
+    if (m_hasFrame.loadAcquire() && !m_scaled.isNull()) {
+        painter.drawImage(m_scaledPos, m_scaled);
     }
+    m_imageMutex.unlock();
+}
+
+void VideoWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
 
-    m_mutex.unlock();
+    m_imageMutex.lock();
+    m_viewSize = size();
+    m_imageMutex.unlock();
+
+    m_renderThread->requestPresent();
 }
 
 static int updateCount = 0;
-void VideoWidget::onFrameReady()
+
+bool VideoWidget::presentFrame()
 {
-    updateCount++;
+    m_imageMutex.lock();
+    const QSize viewSize = m_viewSize;
+    m_imageMutex.unlock();
+
+    QMutexLocker locker(&m_mutex);
+
+    // Newest decoded frame, older ones were dropped by the ring
+    if (m_ring.acquire()) {
+        m_tracer.presentStarted(m_ring.readSlot());
+    }
+    if (!m_hasFrame.loadAcquire() || m_width == 0 || m_height == 0 || viewSize.isEmpty()) {
+        return false;
+    }
 
-    // With half-resolution video (320x240), render every frame for smoother playback
-    // Skip logging most frames to reduce overhead
+    // Calculate target rectangle for aspect-correct display
+    float videoAspect = (float)m_width / (float)m_height;
+    float widgetAspect = (float)viewSize.width() / (float)viewSize.height();
+
+    int targetW, targetH, targetX, targetY;
+    if (videoAspect > widgetAspect) {
+        targetW = viewSize.width();
+        targetH = (int)(viewSize.width() / videoAspect);
+        targetX = 0;
+        targetY = (viewSize.height() - targetH) / 2;
+    } else {
+        targetH = viewSize.height();
+        targetW = (int)(viewSize.height() * videoAspect);
+        targetX = (viewSize.width() - targetW) / 2;
+        targetY = 0;
+    }
+
+    // Filtered scaling into the spare image, the GUI thread paints the other one
+    if (m_scaling.width() != targetW || m_scaling.height() != targetH)
+        m_scaling = QImage(targetW, targetH, QImage::Format_ARGB32);
+
+    m_scaler.scale(reinterpret_cast<const quint8 *>(m_buffer[m_ring.readSlot()].constData()),
+                   m_width * 4, m_width, m_height,
+                   m_scaling.bits(), m_scaling.bytesPerLine(), targetW, targetH);
+    locker.unlock();
+
+    m_imageMutex.lock();
+    m_scaled.swap(m_scaling);
+    m_scaledPos = QPoint(targetX, targetY);
+    m_imageMutex.unlock();
+    m_tracer.presentFinished();
+
+    updateCount++;
     if (updateCount <= 10 || updateCount % 100 == 0) {
-        fprintf(stderr, "onFrameReady: updateCount=%d calling update()\n", updateCount);
+        fprintf(stderr, "presentFrame: updateCount=%d\n", updateCount);
         fflush(stderr);
     }
-    update();
+
+    // One repaint request in flight at a time
+    if (m_updatePending.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+    return true;
 }
 
 // Static callbacks
@@ -144,7 +183,8 @@ void *VideoWidget::lockCallback(void *opaque, void **planes)
 {
     VideoWidget *self = static_cast<VideoWidget*>(opaque);
     // Point VLC to the write buffer - no mutex needed during write
-    planes[0] = self->m_buffer[self->m_writeBuffer].data();
+    planes[0] = self->m_buffer[self->m_ring.writeSlot()].data();
+    self->m_tracer.frameLocked(self->m_ring.writeSlot());
     return nullptr;
 }
 
@@ -160,23 +200,22 @@ void VideoWidget::unlockCallback(void *opaque, void *picture, void *const *plane
 
     // Log first few frames unconditionally
     if (frameCount <= 5) {
-        const unsigned char* data = reinterpret_cast<const unsigned char*>(self->m_buffer[self->m_writeBuffer].constData());
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(self->m_buffer[self->m_ring.writeSlot()].constData());
         fprintf(stderr, "unlockCallback: frame=%d w=%d h=%d bufSize=%d first16bytes: %02x%02x%02x%02x %02x%02x%02x%02x %02x%02x%02x%02x %02x%02x%02x%02x\n",
-                frameCount, self->m_width, self->m_height, self->m_buffer[self->m_writeBuffer].size(),
+                frameCount, self->m_width, self->m_height, self->m_buffer[self->m_ring.writeSlot()].size(),
                 data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7],
                 data[8], data[9], data[10], data[11], data[12], data[13], data[14], data[15]);
         fflush(stderr);
     }
 
     if (self->m_width > 0 && self->m_height > 0) {
-        // Swap buffers atomically
-        self->m_mutex.lock();
-        int temp = self->m_writeBuffer;
-        self->m_writeBuffer = self->m_readBuffer;
-        self->m_readBuffer = temp;
-        self->m_hasFrame = true;
-        self->m_frameReady = true;
-        self->m_mutex.unlock();
+        // Publish to the render thread, no lock needed
+        self->m_tracer.frameDecoded(self->m_ring.writeSlot());
+        if (self->m_ring.publish()) {
+            self->m_tracer.frameDropped();
+        }
+        self->m_hasFrame.storeRelease(1);
+        self->m_frameReady.storeRelease(1);
 
         if (frameCount % 30 == 1) {
             fprintf(stderr, "Frame %d: %dx%d swapped buffers\n",
@@ -185,8 +224,8 @@ void VideoWidget::unlockCallback(void *opaque, void *picture, void *const *plane
         }
     }
 
-    // Schedule repaint
-    QMetaObject::invokeMethod(self, "onFrameReady", Qt::QueuedConnection);
+    // Scale on the render thread
+    self->m_renderThread->frameReady();
 }
 
 void VideoWidget::displayCallback(void *opaque, void *picture)
@@ -235,12 +274,14 @@ unsigned VideoWidget::formatCallback(void **opaque, char *chroma,
 
     unsigned bufferSize = (*pitches) * (*lines);
     // Allocate double buffers
-    self->m_buffer[0].resize(bufferSize);
-    self->m_buffer[0].fill(0);
-    self->m_buffer[1].resize(bufferSize);
-    self->m_buffer[1].fill(0);
-    self->m_writeBuffer = 0;
-    self->m_readBuffer = 1;
+    // The renderer only reads the buffers under m_mutex
+    self->m_mutex.lock();
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].resize(bufferSize);
+        self->m_buffer[i].fill(0);
+    }
+    self->m_ring.reset();
+    self->m_mutex.unlock();
 
     fprintf(stderr, "Requested chroma=BGRA at scaled %ux%u (1/%d), buffer=%u bytes\n",
             scaledWidth, scaledHeight, VIDEO_SCALE_FACTOR, bufferSize);
@@ -254,11 +295,13 @@ void VideoWidget::formatCleanupCallback(void *opaque)
     VideoWidget *self = static_cast<VideoWidget*>(opaque);
 
     self->m_mutex.lock();
-    self->m_buffer[0].clear();
-    self->m_buffer[1].clear();
+    for (int i = 0; i < VlcFrameRing::Slots; ++i) {
+        self->m_buffer[i].clear();
+    }
+    self->m_ring.reset();
     self->m_frame = QImage();
-    self->m_hasFrame = false;
-    self->m_frameReady = false;
+    self->m_hasFrame.storeRelease(0);
+    self->m_frameReady.storeRelease(0);
     self->m_width = 0;
     self->m_height = 0;
     self->m_mutex.unlock();
@@ -9,12 +9,18 @@
 #include <QWidget>
 #include <QImage>
 #include <QMutex>
+#include <QAtomicInt>
 
 #include <vlc/vlc.h>
 
+#include "FrameRing.h"
+#include "FrameTracer.h"
+#include "RenderThread.h"
+#include "VideoScaler.h"
+
 class VlcMediaPlayer;
 
-class VideoWidget : public QWidget
+class VideoWidget : public QWidget, public FramePresenter
 {
     Q_OBJECT
 
@@ -24,13 +30,17 @@ public:
 
     void setMediaPlayer(VlcMediaPlayer *player);
 
+    // Per-frame latency and frame counters
+    VlcFrameStats *frameStats() { return m_tracer.stats(); }
+
 protected:
     void paintEvent(QPaintEvent *event) override;
-
-private slots:
-    void onFrameReady();
+    void resizeEvent(QResizeEvent *event) override;
 
 private:
+    // FramePresenter, scales the frame on the render thread
+    bool presentFrame() override;
+
     // Static callbacks for libvlc
     static void *lockCallback(void *opaque, void **planes);
     static void unlockCallback(void *opaque, void *picture, void *const *planes);
@@ -43,13 +53,22 @@ private:
     VlcMediaPlayer *m_player;
     QMutex m_mutex;
     QImage m_frame;
-    QByteArray m_buffer[2];  // Double buffer
-    int m_writeBuffer;        // Buffer VLC writes to
-    int m_readBuffer;         // Buffer we read from for display
+    QMutex m_imageMutex;      // Guards m_scaled, m_scaledPos and m_viewSize
+    QImage m_scaled;          // Frame scaled to widget size, painted by the GUI thread
+    QImage m_scaling;         // Frame being scaled on the render thread
+    QPoint m_scaledPos;
+    QSize m_viewSize;
+    VlcVideoScaler m_scaler;
+    QByteArray m_buffer[VlcFrameRing::Slots];  // One buffer per ring slot
+    VlcFrameRing m_ring;      // Hands frames from the decoder to the renderer
     unsigned m_width;
     unsigned m_height;
-    bool m_hasFrame;
-    bool m_frameReady;        // New frame available for display
+    QAtomicInt m_hasFrame;    // Set by the decoder, read by the render and GUI threads
+    QAtomicInt m_frameReady;  // New frame available for display
+
+    RenderThread *m_renderThread;
+    FrameTracer m_tracer;
+    QAtomicInt m_updatePending;  // Coalesces repaint requests to the GUI thread
 };
 
 #endif // VIDEOWIDGET_H